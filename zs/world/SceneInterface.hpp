@@ -212,6 +212,9 @@ namespace zs {
 
     virtual void onRender() const {}  // TODO
     virtual std::any getRawScene() const { return std::any(); }
+    /// @brief files of all the layers composed into the scene (root, sublayers, references,
+    /// payloads...), empty if unknown
+    virtual std::vector<std::string> getUsedLayerPaths() const { return {}; }
   };
 
   struct SceneManagerConcept {
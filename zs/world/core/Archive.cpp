@@ -1,34 +1,185 @@
 #include "world/core/Archive.hpp"
 
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <thread>
 
 #include "interface/details/PyHelper.hpp"
-// #include "zensim/zpc_tpls/fmt/format.h"
+#include "world/system/ZsExecSystem.hpp"
+#include "zensim/zpc_tpls/fmt/format.h"
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
 
 namespace zs {
 
-  int Archive::loadFromFile(std::string_view fn, bool isAscii) {
-    std::ios_base::openmode mode = std::ios::in;
-    if (!isAscii) mode |= std::ios::binary;
-    _isAscii = isAscii;
+  namespace fs = std::filesystem;
+
+  namespace {
+    /// @note asynchronous saves of all archives, including those already destroyed
+    struct PendingSaves {
+      Mutex _mutex;  // guards [_count]
+      std::condition_variable_any _cv;
+      u32 _count{0};
+    };
+    PendingSaves &pending_saves() {
+      static PendingSaves s_pending;
+      return s_pending;
+    }
+
+    std::ios_base::openmode file_mode(std::ios_base::openmode mode, bool isAscii) {
+      return isAscii ? mode : mode | std::ios::binary;
+    }
+  }  // namespace
+
+  ///
+  /// ArchiveWriter
+  ///
+  ArchiveWriter::ArchiveWriter(std::string_view fileName, bool isAscii) : _fileName{fileName} {
+    /// @note distinct among threads and processes writing the same target at once
+    const auto salt
+        = std::hash<std::thread::id>{}(std::this_thread::get_id())
+          ^ (u64)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    _tmpName = fmt::format("{}.{:016x}.tmp", _fileName, salt);
+    _os.open(_tmpName, file_mode(std::ios::out | std::ios::trunc, isAscii));
+  }
+
+  bool ArchiveWriter::flushChunk() {
+    if (!_chunk.empty()) {
+      _os.write(_chunk.data(), (std::streamsize)_chunk.size());
+      _chunk.clear();
+      if (!_os.good()) _failed = true;
+    }
+    return !_failed;
+  }
+
+  bool ArchiveWriter::write(const void *data, size_t numBytes) {
+    if (!valid()) return false;
+    auto src = static_cast<const char *>(data);
+    /// @note spans that would fill the chunk go straight to the file, e.g. whole archives
+    if (_chunk.size() + numBytes >= s_chunk_bytes) {
+      if (!flushChunk()) return false;
+      _os.write(src, (std::streamsize)numBytes);
+      if (!_os.good()) {
+        _failed = true;
+        return false;
+      }
+      _bytes += numBytes;
+      return true;
+    }
+    /// @note allocated upon the first small write only
+    if (_chunk.capacity() == 0) _chunk.reserve(s_chunk_bytes);
+    _chunk.insert(_chunk.end(), src, src + numBytes);
+    _bytes += numBytes;
+    return true;
+  }
+
+  std::ostream *ArchiveWriter::stream() {
+    if (!valid() || !flushChunk()) return nullptr;
+    return &_os;
+  }
+
+  int ArchiveWriter::commit() {
+    if (!valid() || !flushChunk()) {
+      abort();
+      return -1;
+    }
+    _os.close();
+    if (_os.fail() || !sync_file(_tmpName)) {
+      abort();
+      return -1;
+    }
+    std::error_code ec;
+    fs::rename(_tmpName, _fileName, ec);
+    if (ec) {
+      abort();
+      return -1;
+    }
+    _tmpName.clear();
+    sync_parent_directory(_fileName);
+    return 0;
+  }
 
+  void ArchiveWriter::abort() noexcept {
+    if (_os.is_open()) _os.close();
+    _chunk.clear();
+    _failed = true;
+    if (!_tmpName.empty()) {
+      std::error_code ec;
+      fs::remove(_tmpName, ec);
+      _tmpName.clear();
+    }
+  }
+
+  bool ArchiveWriter::sync_file(const std::string &path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    const bool ret = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+    return ret;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    const bool ret = ::fsync(fd) == 0;
+    ::close(fd);
+    return ret;
+#endif
+  }
+
+  void ArchiveWriter::sync_parent_directory(const std::string &path) {
+#ifndef _WIN32
+    auto dir = fs::path{path}.parent_path();
+    if (dir.empty()) dir = ".";
+    sync_file(dir.string());
+#endif
+  }
+
+  ///
+  /// Archive
+  ///
+  bool Archive::resolveFileName(std::string_view &fn, const char *action) {
     if (fn.empty()) {
       if (_fileName.has_value())
         fn = *_fileName;
       else {
-        zs_print_err_py_cstr("unable to load from file when no filename is specified.");
-        return -1;
+        zs_print_err_py_cstr(
+            fmt::format("unable to {} file when no filename is specified.", action).c_str());
+        return false;
       }
     } else
       _fileName = fn;
+    return true;
+  }
 
-    std::ifstream inFile(fn.data(), mode);
+  int Archive::loadFromFile(std::string_view fn, bool isAscii) {
+    _isAscii = isAscii;
+    if (!resolveFileName(fn, "load from")) return -1;
+
+    std::ifstream inFile(std::string(fn), file_mode(std::ios::in, isAscii));
     if (inFile.is_open()) {
       inFile.seekg(0, std::ios::end);
       size_t size = inFile.tellg();
       inFile.seekg(0, std::ios::beg);
-      _buffer.resize(size);
-      if (size > 0) inFile.read(&_buffer[0], size);
+      auto buffer = std::make_shared<std::vector<char>>(size);
+      if (size > 0) {
+        inFile.read(buffer->data(), size);
+        /// @note ascii reads may shrink on platforms translating line endings
+        buffer->resize((size_t)inFile.gcount());
+      }
+      _buffer = zs::move(buffer);
+      _mapping.reset();
 
       inFile.close();
       // setChanged();
@@ -37,31 +188,102 @@ namespace zs {
     return -1;
   }
 
+  int Archive::mapFromFile(std::string_view fn, bool isAscii) {
+#ifdef _WIN32
+    /// @note line endings of ascii files are translated upon reading
+    if (isAscii) return loadFromFile(fn, true);
+#endif
+    _isAscii = isAscii;
+    if (!resolveFileName(fn, "map from")) return -1;
+
+    auto mapping = std::make_shared<MappedFile>(fn);
+    if (mapping->valid()) {
+      _mapping = zs::move(mapping);
+      _buffer.reset();
+      return 0;
+    }
+    /// @note empty files cannot be mapped
+    std::error_code ec;
+    const fs::path path{std::string(fn)};
+    if (fs::is_regular_file(path, ec) && fs::file_size(path, ec) == 0 && !ec) {
+      _mapping.reset();
+      _buffer = std::make_shared<const std::vector<char>>();
+      return 0;
+    }
+    return -1;
+  }
+
   int Archive::saveToFile(std::string_view fn, bool isAscii) {
-    std::ios_base::openmode mode = std::ios::out;
-    if (!isAscii) mode |= std::ios::binary;
     if (_isAscii != isAscii && valid()) {
       zs_print_err_py_cstr("try to save to file in a different encoding (ascii/binary).");
       return -1;
     }
+    if (!resolveFileName(fn, "save to")) return -1;
 
-    if (fn.empty()) {
-      if (_fileName.has_value())
-        fn = *_fileName;
-      else {
-        zs_print_err_py_cstr("unable to save to file when no filename is specified.");
-        return -1;
-      }
-    } else
-      _fileName = fn;
+    ArchiveWriter writer{fn, isAscii};
+    writer.write(view());
+    return writer.commit();
+  }
 
-    std::ofstream outFile(fn.data(), mode);
-    if (outFile.is_open()) {
-      outFile.write(_buffer.data(), _buffer.size());
-      outFile.close();
-      return 0;
+  int Archive::saveToFileAsync(std::string_view fn, bool isAscii) {
+    if (_isAscii != isAscii && valid()) {
+      zs_print_err_py_cstr("try to save to file in a different encoding (ascii/binary).");
+      return -1;
     }
-    return -1;
+    if (!resolveFileName(fn, "save to")) return -1;
+
+    if (!_saveState) _saveState = std::make_shared<SaveState>();
+    auto state = _saveState;
+    const auto seq = state->_issued.fetch_add(1) + 1;
+    state->_pending.fetch_add(1);
+    {
+      auto &pending = pending_saves();
+      std::lock_guard lk(pending._mutex);
+      pending._count++;
+    }
+    ZS_BACKGROUND_SCHEDULER().enqueue([state, seq, buffer = _buffer, mapping = _mapping,
+                                       fileName = std::string(fn), isAscii]() {
+      {
+        std::lock_guard lk(state->_mutex);
+        /// @note skipped if a later save already landed
+        if (seq > state->_committed) {
+          std::string_view content{};
+          if (mapping)
+            content = {reinterpret_cast<const char *>(mapping->data()), mapping->size()};
+          else if (buffer)
+            content = {buffer->data(), buffer->size()};
+          ArchiveWriter writer{fileName, isAscii};
+          writer.write(content);
+          const int ret = writer.commit();
+          if (ret != 0) fmt::print("failed to save archive [{}] in the background.\n", fileName);
+          state->_result.store(ret);
+          state->_committed = seq;
+        }
+        state->_pending.fetch_sub(1);
+        state->_done.notify_all();
+      }
+      auto &pending = pending_saves();
+      std::lock_guard lk(pending._mutex);
+      if (--pending._count == 0) pending._cv.notify_all();
+    });
+    ZS_BACKGROUND_SCHEDULER().tick();
+    return 0;
+  }
+
+  bool Archive::saving() const noexcept { return _saveState && _saveState->_pending.load() != 0; }
+
+  int Archive::waitForSave() {
+    if (!_saveState) return 0;
+    auto &state = *_saveState;
+    std::unique_lock lk(state._mutex);
+    state._done.wait(lk, [&state]() { return state._pending.load() == 0; });
+    return state._result.load();
+  }
+
+  void Archive::wait_for_pending_saves() {
+    auto &pending = pending_saves();
+    std::unique_lock lk(pending._mutex);
+    pending._cv.wait(lk, [&pending]() { return pending._count == 0; });
   }
 
-}  // namespace zs
\ No newline at end of file
+}  // namespace zs
@@ -1,17 +1,74 @@
 #pragma once
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include "world/WorldExport.hpp"
+#include "world/core/MappedFile.hpp"
 #include "zensim/ZpcImplPattern.hpp"
+#include "zensim/execution/ConcurrencyPrimitive.hpp"
+#include "zensim/types/ImplPattern.hpp"
 
 namespace zs {
 
+  /**
+  @brief  Streaming writer of a whole file, committed atomically
+  @note   data is written to a temporary file next to the target, which is flushed to stable
+          storage then renamed over the target upon commit(); readers thus see either the
+          previous or the new content, never a torn one
+  @note   small writes are staged in a chunk of s_chunk_bytes, larger spans are written through
+  @note   the temporary is removed if the writer goes away uncommitted
+   */
+  struct ZS_WORLD_EXPORT ArchiveWriter {
+    static constexpr size_t s_chunk_bytes = (size_t)4 << 20;  // 4 MiB
+
+    explicit ArchiveWriter(std::string_view fileName, bool isAscii = true);
+    ~ArchiveWriter() { abort(); }
+    ArchiveWriter(const ArchiveWriter &) = delete;
+    ArchiveWriter &operator=(const ArchiveWriter &) = delete;
+
+    bool valid() const noexcept { return _os.is_open() && !_failed; }
+    std::string_view fileName() const noexcept { return _fileName; }
+    /// @brief bytes written so far
+    size_t bytes() const noexcept { return _bytes; }
+
+    bool write(const void *data, size_t numBytes);
+    bool write(std::string_view str) { return write(str.data(), str.size()); }
+    /// @brief the stream of the temporary, for writers patching earlier bytes (seekp)
+    /// @note staged chunks are flushed first, bytes() does not account for what is written
+    /// through it, nullptr if the writer failed
+    std::ostream *stream();
+    /// @return 0 on success, -1 otherwise (the target is then left untouched)
+    int commit();
+    /// @brief discard everything written so far
+    void abort() noexcept;
+
+    /// @brief flush [path] (a file or, on posix, a directory) to stable storage
+    static bool sync_file(const std::string &path);
+    /// @brief make a rename within the directory of [path] durable
+    static void sync_parent_directory(const std::string &path);
+
+  protected:
+    bool flushChunk();
+
+    std::string _fileName{}, _tmpName{};
+    std::ofstream _os;
+    std::vector<char> _chunk{};
+    size_t _bytes{0};
+    bool _failed{false};
+  };
+
   /**
   @brief  For resource/asset IO and serialization/deserialization
   Building block for cache system
+  @note   content is either owned or, after mapFromFile(), a read-only mapping of the file; any
+          modification detaches it from the mapping
+  @note   saves go through ArchiveWriter; asynchronous ones (including the auto-save upon
+          destruction) share the content instead of copying it, see wait_for_pending_saves()
    */
   struct ZS_WORLD_EXPORT Archive {
     Archive() = default;
@@ -20,7 +77,9 @@ namespace zs {
         : _modified{zs::exchange(o._modified, false)},
           _isAscii{zs::exchange(o._isAscii, true)},
           _fileName{zs::move(o._fileName)},
-          _buffer{zs::move(o._buffer)} {}
+          _buffer{zs::move(o._buffer)},
+          _mapping{zs::move(o._mapping)},
+          _saveState{zs::move(o._saveState)} {}
     Archive &operator=(Archive &&o) noexcept {
       Archive tmp(zs::move(o));
       swap(*this, tmp);
@@ -33,15 +92,13 @@ namespace zs {
       zs_swap(l._isAscii, r._isAscii);
       zs_swap(l._fileName, r._fileName);
       zs_swap(l._buffer, r._buffer);
+      zs_swap(l._mapping, r._mapping);
+      zs_swap(l._saveState, r._saveState);
     }
 
+    /// @note unsaved modifications are saved on ZS_BACKGROUND_SCHEDULER() rather than in place
     ~Archive() {
-      if (valid() && modified()) {
-        if (_isAscii)
-          saveToFileAscii();
-        else
-          saveToFileBinary();
-      }
+      if (valid() && modified()) saveToFileAsync("", _isAscii);
     }
 
     /// @brief set ** modified state ** to true
@@ -53,11 +110,20 @@ namespace zs {
     bool setUnchanged() { return zs::exchange(_modified, false); }
 
     bool setString(std::string_view buffer) {
-      _buffer.resize(buffer.size());
-      _buffer.assign(buffer.begin(), buffer.end());
+      /// @note never write into a buffer an asynchronous save may still be reading
+      _buffer = std::make_shared<const std::vector<char>>(buffer.begin(), buffer.end());
+      _mapping.reset();
       return setChanged();
     }
-    std::string getBuffer() const { return std::string(_buffer.begin(), _buffer.end()); }
+    std::string getBuffer() const { return std::string(view()); }
+    /// @brief the content without copying, valid until the next modification or load
+    std::string_view view() const noexcept {
+      if (_mapping) return {reinterpret_cast<const char *>(_mapping->data()), _mapping->size()};
+      if (_buffer) return {_buffer->data(), _buffer->size()};
+      return {};
+    }
+    size_t size() const noexcept { return view().size(); }
+    bool mapped() const noexcept { return static_cast<bool>(_mapping); }
 
     std::string_view fileName() const noexcept {
       if (_fileName) return *_fileName;
@@ -70,16 +136,44 @@ namespace zs {
     int loadFromFileAscii(std::string_view fn = "") { return loadFromFile(fn, true); }
     int saveToFileAscii(std::string_view fn = "") { return saveToFile(fn, true); }
     int loadFromFileBinary(std::string_view fn = "") { return loadFromFile(fn, false); }
-    int saveToFileBinary(std::string_view fn = "") { return saveToFile(fn, true); }
+    int saveToFileBinary(std::string_view fn = "") { return saveToFile(fn, false); }
+    /// @brief map [fn] read-only instead of reading it
+    /// @note ascii archives are read instead on windows, whose line endings are translated
+    int mapFromFile(std::string_view fn = "", bool isAscii = false);
+    int mapFromFileAscii(std::string_view fn = "") { return mapFromFile(fn, true); }
+
+    /// @brief save on ZS_BACKGROUND_SCHEDULER(), the content is shared with the task
+    /// @note successive saves of an archive are ordered, a stale one never overwrites a newer one
+    int saveToFileAsync(std::string_view fn = "", bool isAscii = true);
+    /// @brief whether asynchronous saves of this archive are still in flight
+    bool saving() const noexcept;
+    /// @brief wait for the asynchronous saves of this archive
+    /// @return result of the last one, 0 on success
+    int waitForSave();
+    /// @brief wait for the asynchronous saves of all archives, e.g. before shutdown
+    static void wait_for_pending_saves();
 
     bool valid() const noexcept { return _fileName.has_value(); }
     bool modified() const noexcept { return _modified; }
-    bool empty() const noexcept { return valid() && _buffer.empty(); }
+    bool empty() const noexcept { return valid() && view().empty(); }
 
   protected:
+    struct SaveState {
+      Mutex _mutex;  // orders the saves of an archive
+      std::condition_variable_any _done;  // signalled under [_mutex] as each save completes
+      std::atomic<u64> _issued{0};
+      u64 _committed{0};
+      std::atomic<u32> _pending{0};  // decremented under [_mutex]
+      std::atomic<int> _result{0};
+    };
+
+    bool resolveFileName(std::string_view &fn, const char *action);
+
     bool _modified{false}, _isAscii{true};
     std::optional<std::string> _fileName{};
-    std::vector<char> _buffer{};  // could be ascii or binary
+    Shared<const std::vector<char>> _buffer{};  // could be ascii or binary
+    Shared<MappedFile> _mapping{};
+    Shared<SaveState> _saveState{};
   };
 
 }  // namespace zs
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "world/core/AssetCache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "world/core/Archive.hpp"
+#include "world/core/MappedFile.hpp"
+#include "zensim/zpc_tpls/fmt/format.h"
+
+namespace zs {
+
+  namespace fs = std::filesystem;
+
+  namespace {
+    /// @note xxh64
+    constexpr u64 g_prime1 = 0x9E3779B185EBCA87ull;
+    constexpr u64 g_prime2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr u64 g_prime3 = 0x165667B19E3779F9ull;
+    constexpr u64 g_prime4 = 0x85EBCA77C2B2AE63ull;
+    constexpr u64 g_prime5 = 0x27D4EB2F165667C5ull;
+
+    /// @note that of ArchiveWriter temporaries
+    constexpr std::string_view g_tmp_suffix = ".tmp";
+    /// @note temporaries younger than this may still be in the works of another process
+    constexpr auto g_stale_tmp_age = std::chrono::hours(1);
+
+    u64 rotl(u64 v, int r) noexcept { return (v << r) | (v >> (64 - r)); }
+    u64 load_u64(const std::byte *p) noexcept {
+      u64 v;
+      std::memcpy(&v, p, sizeof(v));
+      return v;
+    }
+    u32 load_u32(const std::byte *p) noexcept {
+      u32 v;
+      std::memcpy(&v, p, sizeof(v));
+      return v;
+    }
+    u64 hash_round(u64 acc, u64 v) noexcept { return rotl(acc + v * g_prime2, 31) * g_prime1; }
+    u64 hash_merge(u64 acc, u64 v) noexcept {
+      return (acc ^ hash_round(0, v)) * g_prime1 + g_prime4;
+    }
+
+    bool is_tmp(const fs::path &p) {
+      const auto name = p.filename().string();
+      return name.size() >= g_tmp_suffix.size()
+             && name.compare(name.size() - g_tmp_suffix.size(), g_tmp_suffix.size(), g_tmp_suffix)
+                    == 0;
+    }
+
+    struct CacheEntryStat {
+      fs::file_time_type _time;
+      size_t _bytes;
+      fs::path _path;
+    };
+    std::vector<CacheEntryStat> list_entries(const std::string &directory) {
+      std::vector<CacheEntryStat> ret;
+      std::error_code ec;
+      for (fs::directory_iterator it{directory, ec}, ed; !ec && it != ed; it.increment(ec)) {
+        if (!it->is_regular_file(ec) || is_tmp(it->path())) continue;
+        const auto bytes = it->file_size(ec);
+        if (ec) continue;
+        const auto time = it->last_write_time(ec);
+        if (ec) continue;
+        ret.push_back(CacheEntryStat{time, (size_t)bytes, it->path()});
+      }
+      return ret;
+    }
+  }  // namespace
+
+  u64 AssetCache::hash_bytes(const void *data, size_t numBytes, u64 seed) noexcept {
+    auto p = static_cast<const std::byte *>(data);
+    const auto end = p + numBytes;
+    u64 h;
+    if (numBytes >= 32) {
+      u64 v1 = seed + g_prime1 + g_prime2, v2 = seed + g_prime2, v3 = seed, v4 = seed - g_prime1;
+      for (const auto limit = end - 32; p <= limit; p += 32) {
+        v1 = hash_round(v1, load_u64(p));
+        v2 = hash_round(v2, load_u64(p + 8));
+        v3 = hash_round(v3, load_u64(p + 16));
+        v4 = hash_round(v4, load_u64(p + 24));
+      }
+      h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+      h = hash_merge(h, v1);
+      h = hash_merge(h, v2);
+      h = hash_merge(h, v3);
+      h = hash_merge(h, v4);
+    } else
+      h = seed + g_prime5;
+    h += (u64)numBytes;
+    for (; p + 8 <= end; p += 8) h = rotl(h ^ hash_round(0, load_u64(p)), 27) * g_prime1 + g_prime4;
+    if (p + 4 <= end) {
+      h = rotl(h ^ ((u64)load_u32(p) * g_prime1), 23) * g_prime2 + g_prime3;
+      p += 4;
+    }
+    for (; p < end; ++p) h = rotl(h ^ ((u64)(u8)*p * g_prime5), 11) * g_prime1;
+    h ^= h >> 33;
+    h *= g_prime2;
+    h ^= h >> 29;
+    h *= g_prime3;
+    h ^= h >> 32;
+    return h;
+  }
+
+  bool AssetCache::hash_file(std::string_view fileName, u64 &digest) {
+    std::error_code ec;
+    const auto numBytes = fs::file_size(fs::path{std::string(fileName)}, ec);
+    if (ec) return false;
+    /// @note empty files cannot be mapped
+    if (numBytes == 0) {
+      digest = hash_bytes(nullptr, 0);
+      return true;
+    }
+    MappedFile file{fileName};
+    if (!file.valid()) return false;
+    digest = hash_bytes(file.data(), file.size());
+    return true;
+  }
+
+  std::string AssetCache::make_key(std::string_view sourceFile, std::string_view kind,
+                                   u32 converterVersion, std::string_view options) {
+    return make_key(std::vector<std::string>{std::string(sourceFile)}, kind, converterVersion,
+                    options);
+  }
+  std::string AssetCache::make_key(std::vector<std::string> sourceFiles, std::string_view kind,
+                                   u32 converterVersion, std::string_view options) {
+    if (sourceFiles.empty()) return {};
+    std::sort(sourceFiles.begin(), sourceFiles.end());
+    sourceFiles.erase(std::unique(sourceFiles.begin(), sourceFiles.end()), sourceFiles.end());
+    u64 content = 0;
+    for (size_t i = 0; i != sourceFiles.size(); ++i) {
+      u64 digest;
+      if (!hash_file(sourceFiles[i], digest)) return {};
+      content = i ? hash_bytes(&digest, sizeof(digest), content) : digest;
+    }
+    auto params = hash_bytes(kind.data(), kind.size(), converterVersion);
+    params = hash_bytes(options.data(), options.size(), params);
+    return fmt::format("{}-{:016x}{:016x}", kind, content, params);
+  }
+
+  bool AssetCache::open(std::string_view directory, size_t capacity) {
+    _directory.clear();
+    _capacity = capacity;
+    std::error_code ec;
+    const fs::path dir{std::string(directory)};
+    fs::create_directories(dir, ec);
+    if (ec || !fs::is_directory(dir, ec)) return false;
+    _directory = dir.string();
+
+    const auto now = fs::file_time_type::clock::now();
+    for (fs::directory_iterator it{dir, ec}, ed; !ec && it != ed; it.increment(ec)) {
+      if (!is_tmp(it->path())) continue;
+      std::error_code e;
+      if (now - it->last_write_time(e) > g_stale_tmp_age && !e) fs::remove(it->path(), e);
+    }
+    return true;
+  }
+
+  std::string AssetCache::entryPath(std::string_view key) const {
+    return (fs::path{_directory} / fs::path{std::string(key)}).string();
+  }
+
+  bool AssetCache::lookup(std::string_view key) const {
+    if (!valid() || key.empty()) return false;
+    const fs::path p{entryPath(key)};
+    std::error_code ec;
+    if (!fs::is_regular_file(p, ec)) return false;
+    fs::last_write_time(p, fs::file_time_type::clock::now(), ec);
+    return true;
+  }
+
+  bool AssetCache::store(std::string_view key, const void *data, size_t numBytes) {
+    if (!valid() || key.empty()) return false;
+    ArchiveWriter writer{entryPath(key), false};
+    if (!writer.write(data, numBytes) || writer.commit() != 0) return false;
+    commit(key);
+    return true;
+  }
+
+  bool AssetCache::load(std::string_view key, std::vector<std::byte> &data) const {
+    if (!lookup(key)) return false;
+    std::ifstream is(entryPath(key), std::ios::in | std::ios::binary | std::ios::ate);
+    if (!is.is_open()) return false;
+    const auto numBytes = (size_t)is.tellg();
+    is.seekg(0);
+    data.resize(numBytes);
+    is.read(reinterpret_cast<char *>(data.data()), (std::streamsize)numBytes);
+    return (size_t)is.gcount() == numBytes;
+  }
+
+  void AssetCache::commit(std::string_view key) {
+    (void)lookup(key);
+    evict();
+  }
+
+  size_t AssetCache::evict() {
+    if (!valid()) return 0;
+    auto entries = list_entries(_directory);
+    size_t total = 0;
+    for (const auto &entry : entries) total += entry._bytes;
+    if (total <= _capacity) return 0;
+
+    std::sort(entries.begin(), entries.end(),
+              [](const auto &a, const auto &b) { return a._time < b._time; });
+    size_t released = 0;
+    for (const auto &entry : entries) {
+      if (total - released <= _capacity) break;
+      /// @note entries still mapped elsewhere may refuse to go (windows), left for the next round
+      std::error_code ec;
+      if (fs::remove(entry._path, ec)) released += entry._bytes;
+    }
+    return released;
+  }
+
+  size_t AssetCache::bytes() const {
+    if (!valid()) return 0;
+    size_t total = 0;
+    for (const auto &entry : list_entries(_directory)) total += entry._bytes;
+    return total;
+  }
+
+}  // namespace zs
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "world/WorldExport.hpp"
+#include "zensim/ZpcBuiltin.hpp"
+
+namespace zs {
+
+  /**
+  @brief  Content-addressed on-disk store of assets derived from source files (converted
+          primitives, decoded textures, ...)
+  @note   entries are keyed by the hash of the source file contents together with the kind of
+          derived data, the converter version and its options, thus never go stale: editing the
+          source or bumping the converter simply produces another key
+  @note   entries are written through ArchiveWriter (a uniquely named temporary made durable,
+          then renamed into place), readers only ever see complete entries, even if the writer
+          crashed halfway or other processes store the same key at once
+  @note   the least recently used entries are evicted once the directory exceeds the capacity,
+          recency being tracked through the modification time of the entry files so that it
+          survives restarts and is shared among processes using the same directory
+   */
+  struct ZS_WORLD_EXPORT AssetCache {
+    static constexpr size_t s_default_capacity = (size_t)4 << 30;
+
+    AssetCache() = default;
+    AssetCache(std::string_view directory, size_t capacity = s_default_capacity) {
+      open(directory, capacity);
+    }
+
+    /// @brief create [directory] if absent and drop temporaries left over by crashed writers
+    bool open(std::string_view directory, size_t capacity = s_default_capacity);
+    bool valid() const noexcept { return !_directory.empty(); }
+    const std::string &directory() const noexcept { return _directory; }
+    size_t capacity() const noexcept { return _capacity; }
+    void setCapacity(size_t capacity) noexcept { _capacity = capacity; }
+
+    /// @brief 64-bit hash of the whole content of [fileName]
+    /// @return false if the file could not be read
+    static bool hash_file(std::string_view fileName, u64 &digest);
+    static u64 hash_bytes(const void *data, size_t numBytes, u64 seed = 0) noexcept;
+
+    /// @brief key of the [kind] of data derived from [sourceFile] by a converter of the given
+    /// version and options, empty if the source file could not be read
+    static std::string make_key(std::string_view sourceFile, std::string_view kind,
+                                u32 converterVersion, std::string_view options = {});
+    /// @brief same as above for data derived from several [sourceFiles] (e.g. all the layers
+    /// composed into a usd stage), editing any of them produces another key
+    /// @note the order of [sourceFiles] does not matter, a single file yields the key above
+    static std::string make_key(std::vector<std::string> sourceFiles, std::string_view kind,
+                                u32 converterVersion, std::string_view options = {});
+
+    /// @brief file holding the entry of [key], which is where direct writers should commit to
+    /// (through an ArchiveWriter)
+    std::string entryPath(std::string_view key) const;
+    /// @brief whether [key] is present, marking it as recently used if so
+    bool lookup(std::string_view key) const;
+
+    /// @brief write [numBytes] at [data] as the entry of [key]
+    bool store(std::string_view key, const void *data, size_t numBytes);
+    /// @brief read back the entry of [key], marking it as recently used
+    bool load(std::string_view key, std::vector<std::byte> &data) const;
+    /// @brief account for an entry written in place (e.g. through an atomic file writer of its
+    /// own) at entryPath(key), then evict if over capacity
+    void commit(std::string_view key);
+
+    /// @brief remove the least recently used entries until the directory fits in the capacity
+    /// @return number of bytes released
+    size_t evict();
+    /// @brief total bytes currently held by the entries
+    size_t bytes() const;
+
+  protected:
+    std::string _directory{};
+    size_t _capacity{s_default_capacity};
+  };
+
+}  // namespace zs
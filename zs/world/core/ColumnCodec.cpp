@@ -0,0 +1,214 @@
+#include "world/core/ColumnCodec.hpp"
+
+#include <cstring>
+
+namespace zs {
+
+  namespace {
+    enum column_mode_e : u8 { mode_Stored = 0, mode_Lz = 1 };
+
+    constexpr int g_lz_min_match = 4;
+    constexpr int g_lz_hash_bits = 14;
+    constexpr size_t g_lz_max_offset = 65535;
+    /// @note the tail is always emitted as literals, which keeps the match loop free of bound checks
+    constexpr size_t g_lz_tail = 12;
+
+    u32 load_u32(const std::byte *p) noexcept {
+      u32 v;
+      std::memcpy(&v, p, sizeof(v));
+      return v;
+    }
+    u32 lz_hash(u32 seq) noexcept { return (seq * 2654435761u) >> (32 - g_lz_hash_bits); }
+
+    std::byte *write_length(std::byte *op, size_t len) noexcept {
+      for (; len >= 255; len -= 255) *op++ = std::byte{255};
+      *op++ = (std::byte)len;
+      return op;
+    }
+    bool read_length(const std::byte *&ip, const std::byte *end, size_t &len) noexcept {
+      for (;;) {
+        if (ip == end) return false;
+        const auto b = (u8)*ip++;
+        len += b;
+        if (b != 255) return true;
+      }
+    }
+
+    std::byte *emit_sequence(std::byte *op, const std::byte *literals, size_t numLiterals,
+                             size_t offset, size_t matchLen) noexcept {
+      const bool hasMatch = matchLen >= (size_t)g_lz_min_match;
+      const size_t m = hasMatch ? matchLen - g_lz_min_match : 0;
+      auto token = op++;
+      *token = (std::byte)(((numLiterals < 15 ? numLiterals : 15) << 4) | (m < 15 ? m : 15));
+      if (numLiterals >= 15) op = write_length(op, numLiterals - 15);
+      std::memcpy(op, literals, numLiterals);
+      op += numLiterals;
+      if (hasMatch) {
+        *op++ = (std::byte)(offset & 0xff);
+        *op++ = (std::byte)(offset >> 8);
+        if (m >= 15) op = write_length(op, m - 15);
+      }
+      return op;
+    }
+
+    /// @note [planes] receives byte b of value i at [b * numElems + i]
+    template <typename Word>
+    void predict_and_shuffle(const std::byte *src, size_t numElems, column_predictor_e predictor,
+                             std::byte *planes) {
+      Word prev = 0;
+      for (size_t i = 0; i != numElems; ++i) {
+        Word v;
+        std::memcpy(&v, src + i * sizeof(Word), sizeof(Word));
+        Word r = v;
+        if (predictor == column_predictor_e::xor_prev)
+          r = v ^ prev;
+        else if (predictor == column_predictor_e::delta_prev)
+          r = v - prev;
+        prev = v;
+        for (size_t b = 0; b != sizeof(Word); ++b)
+          planes[b * numElems + i] = (std::byte)((r >> (b * 8)) & 0xff);
+      }
+    }
+    template <typename Word>
+    void unshuffle_and_reconstruct(const std::byte *planes, size_t numElems,
+                                   column_predictor_e predictor, std::byte *dst) {
+      Word prev = 0;
+      for (size_t i = 0; i != numElems; ++i) {
+        Word r = 0;
+        for (size_t b = 0; b != sizeof(Word); ++b)
+          r |= (Word)(u8)planes[b * numElems + i] << (b * 8);
+        Word v = r;
+        if (predictor == column_predictor_e::xor_prev)
+          v = r ^ prev;
+        else if (predictor == column_predictor_e::delta_prev)
+          v = r + prev;
+        prev = v;
+        std::memcpy(dst + i * sizeof(Word), &v, sizeof(Word));
+      }
+    }
+
+    /// @note prediction applies to 4 and 8-byte values only, others are merely shuffled
+    void to_planes(const std::byte *src, size_t numElems, size_t elemBytes,
+                   column_predictor_e predictor, std::byte *planes) {
+      if (elemBytes == 4)
+        predict_and_shuffle<u32>(src, numElems, predictor, planes);
+      else if (elemBytes == 8)
+        predict_and_shuffle<u64>(src, numElems, predictor, planes);
+      else
+        for (size_t i = 0; i != numElems; ++i)
+          for (size_t b = 0; b != elemBytes; ++b)
+            planes[b * numElems + i] = src[i * elemBytes + b];
+    }
+    void from_planes(const std::byte *planes, size_t numElems, size_t elemBytes,
+                     column_predictor_e predictor, std::byte *dst) {
+      if (elemBytes == 4)
+        unshuffle_and_reconstruct<u32>(planes, numElems, predictor, dst);
+      else if (elemBytes == 8)
+        unshuffle_and_reconstruct<u64>(planes, numElems, predictor, dst);
+      else
+        for (size_t i = 0; i != numElems; ++i)
+          for (size_t b = 0; b != elemBytes; ++b)
+            dst[i * elemBytes + b] = planes[b * numElems + i];
+    }
+  }  // namespace
+
+  size_t ColumnCodec::lz_compress_bound(size_t numBytes) noexcept {
+    return numBytes + numBytes / 255 + 16;
+  }
+
+  size_t ColumnCodec::lz_compress(const std::byte *src, size_t numBytes, std::byte *dst) {
+    std::byte *op = dst;
+    size_t anchor = 0;
+    if (numBytes > g_lz_tail) {
+      /// @note positions are stored off by one, 0 marks an empty slot
+      std::vector<u32> table((size_t)1 << g_lz_hash_bits, 0);
+      const size_t limit = numBytes - g_lz_tail;
+      for (size_t ip = 0; ip < limit;) {
+        const u32 seq = load_u32(src + ip);
+        auto &slot = table[lz_hash(seq)];
+        const size_t ref = slot;
+        slot = (u32)(ip + 1);
+        if (ref == 0 || ip - (ref - 1) > g_lz_max_offset || load_u32(src + ref - 1) != seq) {
+          ip++;
+          continue;
+        }
+        const size_t from = ref - 1;
+        size_t len = g_lz_min_match;
+        while (ip + len < limit && src[from + len] == src[ip + len]) len++;
+        op = emit_sequence(op, src + anchor, ip - anchor, ip - from, len);
+        ip += len;
+        anchor = ip;
+      }
+    }
+    op = emit_sequence(op, src + anchor, numBytes - anchor, 0, 0);
+    return (size_t)(op - dst);
+  }
+
+  bool ColumnCodec::lz_decompress(const std::byte *src, size_t srcBytes, std::byte *dst,
+                                  size_t numBytes) {
+    const std::byte *ip = src, *end = src + srcBytes;
+    size_t op = 0;
+    while (ip < end) {
+      const auto token = (u8)*ip++;
+      size_t numLiterals = token >> 4;
+      if (numLiterals == 15 && !read_length(ip, end, numLiterals)) return false;
+      if (numLiterals > (size_t)(end - ip) || numLiterals > numBytes - op) return false;
+      std::memcpy(dst + op, ip, numLiterals);
+      ip += numLiterals;
+      op += numLiterals;
+      if (ip == end) break;  // last sequence carries literals only
+
+      if (end - ip < 2) return false;
+      const size_t offset = (size_t)(u8)ip[0] | ((size_t)(u8)ip[1] << 8);
+      ip += 2;
+      if (offset == 0 || offset > op) return false;
+      size_t len = token & 15;
+      if (len == 15 && !read_length(ip, end, len)) return false;
+      len += g_lz_min_match;
+      if (len > numBytes - op) return false;
+      /// @note overlapping copies replicate the pattern, thus byte by byte
+      for (size_t i = 0; i != len; ++i, ++op) dst[op] = dst[op - offset];
+    }
+    return op == numBytes;
+  }
+
+  void ColumnCodec::encode(const std::byte *src, size_t numElems, size_t elemBytes,
+                           column_predictor_e predictor, std::vector<std::byte> &dst) {
+    const size_t numBytes = numElems * elemBytes;
+    std::vector<std::byte> planes(numBytes);
+    to_planes(src, numElems, elemBytes, predictor, planes.data());
+
+    const size_t base = dst.size();
+    dst.resize(base + 1 + lz_compress_bound(numBytes));
+    const size_t compressed = lz_compress(planes.data(), numBytes, dst.data() + base + 1);
+    if (compressed < numBytes) {
+      dst[base] = (std::byte)mode_Lz;
+      dst.resize(base + 1 + compressed);
+    } else {
+      dst[base] = (std::byte)mode_Stored;
+      std::memcpy(dst.data() + base + 1, planes.data(), numBytes);
+      dst.resize(base + 1 + numBytes);
+    }
+  }
+
+  bool ColumnCodec::decode(const std::byte *src, size_t srcBytes, size_t numElems,
+                           size_t elemBytes, column_predictor_e predictor, std::byte *dst) {
+    if (srcBytes == 0) return false;
+    const size_t numBytes = numElems * elemBytes;
+    std::vector<std::byte> planes(numBytes);
+    switch ((u8)src[0]) {
+      case mode_Stored:
+        if (srcBytes - 1 != numBytes) return false;
+        std::memcpy(planes.data(), src + 1, numBytes);
+        break;
+      case mode_Lz:
+        if (!lz_decompress(src + 1, srcBytes - 1, planes.data(), numBytes)) return false;
+        break;
+      default:
+        return false;
+    }
+    from_planes(planes.data(), numElems, elemBytes, predictor, dst);
+    return true;
+  }
+
+}  // namespace zs
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "world/WorldExport.hpp"
+#include "zensim/ZpcBuiltin.hpp"
+
+namespace zs {
+
+  /// @brief how each value of a column is predicted from the previous one
+  /// @note xor suits floating point data (shared sign, exponent and leading mantissa bits cancel
+  /// out), delta suits integers and indices
+  enum class column_predictor_e : u8 { none = 0, xor_prev, delta_prev };
+
+  /**
+  @brief  Lossless codec for columns of fixed-size values (e.g. one attribute channel)
+  @note   values are predicted from their predecessor, split into byte planes (shuffle), then
+          compressed by a byte-oriented LZ stage; columns that do not shrink are stored as is
+  @note   self-contained and stateless, distinct columns may be coded concurrently
+   */
+  struct ZS_WORLD_EXPORT ColumnCodec {
+    /// @brief append the encoding of [numElems] values of [elemBytes] each to [dst]
+    static void encode(const std::byte *src, size_t numElems, size_t elemBytes,
+                       column_predictor_e predictor, std::vector<std::byte> &dst);
+    /// @brief decode [srcBytes] produced by encode() into [numElems] values at [dst]
+    /// @return false upon malformed input
+    static bool decode(const std::byte *src, size_t srcBytes, size_t numElems, size_t elemBytes,
+                       column_predictor_e predictor, std::byte *dst);
+
+    /// @brief LZ stage alone
+    static size_t lz_compress_bound(size_t numBytes) noexcept;
+    /// @return compressed size written to [dst] (at least lz_compress_bound() bytes)
+    static size_t lz_compress(const std::byte *src, size_t numBytes, std::byte *dst);
+    static bool lz_decompress(const std::byte *src, size_t srcBytes, std::byte *dst,
+                              size_t numBytes);
+  };
+
+}  // namespace zs
@@ -0,0 +1,217 @@
+#include "world/core/FileBackedResource.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "world/core/MappedFile.hpp"
+#include "zensim/zpc_tpls/fmt/format.h"
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <stdlib.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#  if defined(__linux__)
+#    include <sys/vfs.h>
+#  endif
+#endif
+
+namespace zs {
+
+  namespace fs = std::filesystem;
+
+  namespace {
+    /// @brief the page-aligned range covering [bytes] from [p]
+    std::pair<std::byte *, size_t> page_range(const void *p, size_t bytes) noexcept {
+      const size_t page = MappedFile::page_size();
+      const auto addr = reinterpret_cast<std::uintptr_t>(p);
+      const auto st = addr / page * page;
+      return {reinterpret_cast<std::byte *>(st), addr + bytes - st};
+    }
+
+#if defined(__linux__)
+    constexpr decltype(statfs::f_type) g_tmpfs_magic = 0x01021994;
+    constexpr decltype(statfs::f_type) g_ramfs_magic = 0x858458f6;
+#endif
+  }  // namespace
+
+  FileBackedResource::FileBackedResource(std::string_view directory, advice_e advice)
+      : _directory{directory}, _advice{advice} {
+    if (_directory.empty()) _directory = default_directory();
+    if (is_memory_backed(_directory))
+      fmt::print(
+          "spill directory [{}] is memory-backed (tmpfs), spilled storage would stay in RAM.\n",
+          _directory);
+  }
+
+  bool FileBackedResource::is_memory_backed(std::string_view directory) noexcept {
+#if defined(__linux__)
+    struct statfs st;
+    if (::statfs(std::string(directory).c_str(), &st) != 0) return false;
+    return st.f_type == g_tmpfs_magic || st.f_type == g_ramfs_magic;
+#else
+    return false;
+#endif
+  }
+
+  std::string FileBackedResource::default_directory() {
+    std::error_code ec;
+    std::string ret = fs::temp_directory_path(ec).string();
+    if (ec) ret = ".";
+#ifndef _WIN32
+    /// @note /tmp is commonly a tmpfs, /var/tmp is meant to be disk-backed
+    if (is_memory_backed(ret) && fs::is_directory("/var/tmp", ec) && !is_memory_backed("/var/tmp"))
+      ret = "/var/tmp";
+#endif
+    return ret;
+  }
+
+  FileBackedResource::~FileBackedResource() {
+    /// @note storage still allocated from here is a leak of its owner, unmapped regardless
+    _mappings.forEach([](const void *p, const Mapping &mapping) {
+      auto m = mapping;
+      unmap(const_cast<void *>(p), m);
+    });
+  }
+
+  size_t FileBackedResource::numMappings() const {
+    std::lock_guard lk(_mutex);
+    return _mappings.size();
+  }
+
+  void *FileBackedResource::map(size_t bytes, Mapping &mapping) {
+    mapping._bytes = bytes;
+#ifdef _WIN32
+    char fileName[MAX_PATH];
+    if (!GetTempFileNameA(_directory.c_str(), "zss", 0, fileName)) return nullptr;
+    HANDLE file = CreateFileA(fileName, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      DeleteFileA(fileName);
+      return nullptr;
+    }
+    HANDLE fileMapping
+        = CreateFileMappingA(file, nullptr, PAGE_READWRITE, (DWORD)((u64)bytes >> 32),
+                             (DWORD)((u64)bytes & 0xffffffffu), nullptr);
+    if (!fileMapping) {
+      CloseHandle(file);
+      return nullptr;
+    }
+    void *ptr = MapViewOfFile(fileMapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!ptr) {
+      CloseHandle(fileMapping);
+      CloseHandle(file);
+      return nullptr;
+    }
+    mapping._file = file;
+    mapping._mapping = fileMapping;
+    return ptr;
+#else
+    std::string fileName = (fs::path{_directory} / "zs_spill_XXXXXX").string();
+    int fd = ::mkstemp(fileName.data());
+    if (fd < 0) return nullptr;
+    /// @note unnamed from now on, the space is reclaimed once unmapped
+    ::unlink(fileName.c_str());
+    if (::ftruncate(fd, (off_t)bytes) != 0) {
+      ::close(fd);
+      return nullptr;
+    }
+    void *ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) return nullptr;
+    if (_advice == advice_sequential)
+      ::madvise(ptr, bytes, MADV_SEQUENTIAL);
+    else if (_advice == advice_random)
+      ::madvise(ptr, bytes, MADV_RANDOM);
+    return ptr;
+#endif
+  }
+
+  void FileBackedResource::unmap(void *p, Mapping &mapping) noexcept {
+#ifdef _WIN32
+    UnmapViewOfFile(p);
+    CloseHandle((HANDLE)mapping._mapping);
+    CloseHandle((HANDLE)mapping._file);
+    mapping._file = mapping._mapping = nullptr;
+#else
+    munmap(p, mapping._bytes);
+#endif
+  }
+
+  void *FileBackedResource::allocateImpl(size_t bytes, size_t alignment) {
+    /// @note mappings are page-aligned
+    if (bytes < s_min_mapped_bytes || alignment > MappedFile::page_size())
+      return ::operator new(bytes, std::align_val_t{alignment});
+    Mapping mapping;
+    void *ptr = map(bytes, mapping);
+    if (!ptr) {
+      recordFallback();
+      fmt::print("unable to map {} bytes in spill directory [{}], falling back to the heap.\n",
+                 bytes, _directory);
+      return ::operator new(bytes, std::align_val_t{alignment});
+    }
+    {
+      std::lock_guard lk(_mutex);
+      _mappings.insert(static_cast<const void *>(ptr), zs::move(mapping));
+    }
+    _mappedBytes.fetch_add(bytes);
+    return ptr;
+  }
+
+  void FileBackedResource::deallocateImpl(void *p, size_t bytes, size_t alignment) {
+    Mapping mapping;
+    bool mapped = false;
+    if (bytes >= s_min_mapped_bytes) {
+      std::lock_guard lk(_mutex);
+      if (auto m = _mappings.find(static_cast<const void *>(p))) {
+        mapping = *m;
+        _mappings.erase(static_cast<const void *>(p));
+        mapped = true;
+      }
+    }
+    if (!mapped) {
+      ::operator delete(p, std::align_val_t{alignment});
+      return;
+    }
+    unmap(p, mapping);
+    _mappedBytes.fetch_sub(mapping._bytes);
+  }
+
+  void FileBackedResource::will_need(const void *p, size_t bytes) noexcept {
+    if (!p || !bytes) return;
+    const auto [st, n] = page_range(p, bytes);
+#ifdef _WIN32
+#  if _WIN32_WINNT >= 0x0602
+    WIN32_MEMORY_RANGE_ENTRY range{st, n};
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#  endif
+#else
+    ::madvise(st, n, MADV_WILLNEED);
+#endif
+  }
+
+  void FileBackedResource::dont_need(const void *p, size_t bytes) noexcept {
+    if (!p || !bytes) return;
+    const auto [st, n] = page_range(p, bytes);
+#ifdef _WIN32
+    /// @note unlocking unlocked pages trims them from the working set
+    VirtualUnlock(st, n);
+#else
+    /// @note unlike MADV_DONTNEED, neither advice discards contents, thus safe upon heap blocks
+#  if defined(MADV_PAGEOUT)
+    ::madvise(st, n, MADV_PAGEOUT);
+#  elif defined(MADV_COLD)
+    ::madvise(st, n, MADV_COLD);
+#  endif
+#endif
+  }
+
+}  // namespace zs
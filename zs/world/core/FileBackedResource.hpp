@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "world/WorldExport.hpp"
+#include "world/core/HashIndex.hpp"
+#include "world/core/MemoryResource.hpp"
+
+namespace zs {
+
+  /**
+  @brief  Host memory resource whose large allocations are shared mappings of unnamed spill
+          files, thus paged out to disk rather than swap, letting tile storage exceed RAM
+  @note   every allocation of at least s_min_mapped_bytes maps a file of its own in the spill
+          directory (removed right away, reclaimed once unmapped), smaller ones come from the heap
+  @note   tile storage is laid out tile by tile ([tile][channel][lane]), kernels walking element
+          ranges thus stream through each mapping front to back, which the default sequential
+          advice favours (aggressive readahead, pages dropped behind)
+  @note   instances are expected to be owned by shared pointers, see allocator()
+   */
+  struct ZS_WORLD_EXPORT FileBackedResource : TrackedResource {
+    static constexpr size_t s_min_mapped_bytes = (size_t)1 << 20;  // 1 MiB
+
+    enum advice_e : u32 { advice_normal = 0, advice_sequential, advice_random };
+
+    /// @note [directory] defaults to default_directory(), a warning is issued if it turns out
+    /// memory-backed
+    explicit FileBackedResource(std::string_view directory = {},
+                                advice_e advice = advice_sequential);
+    ~FileBackedResource() override;
+    FileBackedResource(const FileBackedResource &) = delete;
+    FileBackedResource &operator=(const FileBackedResource &) = delete;
+
+    const std::string &directory() const noexcept { return _directory; }
+    /// @brief bytes currently mapped
+    size_t mappedBytes() const noexcept { return _mappedBytes.load(); }
+    size_t numMappings() const;
+
+    /// @brief whether [directory] lives on a RAM-backed file system (tmpfs, ramfs), where
+    /// spilling saves no memory at all
+    static bool is_memory_backed(std::string_view directory) noexcept;
+    /// @brief the system temporary directory, or /var/tmp if the former is memory-backed
+    static std::string default_directory();
+
+    /// @brief hint that [bytes] from [p] are about to be read
+    static void will_need(const void *p, size_t bytes) noexcept;
+    /// @brief hint that the pages of [bytes] from [p] may be evicted (contents are kept)
+    static void dont_need(const void *p, size_t bytes) noexcept;
+
+  protected:
+    void *allocateImpl(size_t bytes, size_t alignment) override;
+    void deallocateImpl(void *p, size_t bytes, size_t alignment) override;
+
+    struct Mapping {
+      size_t _bytes{0};
+#ifdef _WIN32
+      void *_file{nullptr}, *_mapping{nullptr};
+#endif
+    };
+
+    void *map(size_t bytes, Mapping &mapping);
+    static void unmap(void *p, Mapping &mapping) noexcept;
+
+    std::string _directory;
+    advice_e _advice;
+    mutable Mutex _mutex;  // guards [_mappings]
+    HashIndex<const void *, Mapping> _mappings;
+    std::atomic<size_t> _mappedBytes{0};
+  };
+
+}  // namespace zs
@@ -0,0 +1,179 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "zensim/ZpcBuiltin.hpp"
+#include "zensim/ZpcMeta.hpp"
+
+namespace zs {
+
+  /// @brief avalanches weak std::hash results (e.g. identity for integers)
+  /// @ref murmur3 fmix64
+  constexpr u64 hash_index_mix(u64 h) noexcept {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+  }
+
+  template <typename Key> struct HashIndexHasher {
+    u64 operator()(const Key &k) const noexcept { return hash_index_mix(std::hash<Key>{}(k)); }
+  };
+  /// @note transparent, strings are looked up by string_view without allocation
+  template <> struct HashIndexHasher<std::string> {
+    u64 operator()(std::string_view k) const noexcept {
+      return hash_index_mix(std::hash<std::string_view>{}(k));
+    }
+  };
+
+  /// @brief open-addressing (linear probing) hash index with tombstone deletion
+  /// @note full hashes are kept alongside the slots so that probing rarely compares keys
+  /// @note not thread-safe, references are invalidated upon insertion
+  template <typename Key, typename Value, typename Hasher = HashIndexHasher<Key>,
+            typename KeyEqual = std::equal_to<>>
+  struct HashIndex {
+    static constexpr u64 s_empty = 0;
+    static constexpr u64 s_tombstone = 1;
+
+    HashIndex() = default;
+    HashIndex(HashIndex &&) noexcept = default;
+    HashIndex &operator=(HashIndex &&) noexcept = default;
+    HashIndex(const HashIndex &) = default;
+    HashIndex &operator=(const HashIndex &) = default;
+
+    size_t size() const noexcept { return _size; }
+    bool empty() const noexcept { return _size == 0; }
+    size_t capacity() const noexcept { return _hashes.size(); }
+
+    void clear() {
+      _hashes.clear();
+      _keys.clear();
+      _values.clear();
+      _size = _numTombstones = 0;
+    }
+    void reserve(size_t n) {
+      size_t cap = s_min_capacity;
+      while (cap * s_max_load_num < n * s_max_load_den) cap <<= 1;
+      if (cap > capacity()) rehash(cap);
+    }
+
+    template <typename K> Value *find(const K &key) noexcept {
+      auto slot = locate(key);
+      return slot != -1 ? &_values[slot] : nullptr;
+    }
+    template <typename K> const Value *find(const K &key) const noexcept {
+      auto slot = locate(key);
+      return slot != -1 ? &_values[slot] : nullptr;
+    }
+    template <typename K> bool contains(const K &key) const noexcept { return locate(key) != -1; }
+
+    /// @return false (leaving the present entry untouched) if [key] already exists
+    template <typename K, typename V> bool insert(K &&key, V &&value) {
+      return emplace_(FWD(key), FWD(value), false_c);
+    }
+    /// @return true if newly inserted
+    template <typename K, typename V> bool insert_or_assign(K &&key, V &&value) {
+      return emplace_(FWD(key), FWD(value), true_c);
+    }
+
+    template <typename K> bool erase(const K &key) {
+      auto slot = locate(key);
+      if (slot == -1) return false;
+      _hashes[slot] = s_tombstone;
+      _keys[slot] = Key{};
+      _values[slot] = Value{};
+      _size--;
+      _numTombstones++;
+      return true;
+    }
+
+    /// @brief visit every (key, value) entry, in no particular order
+    template <typename F> void forEach(F &&f) const {
+      for (size_t i = 0; i != _hashes.size(); ++i)
+        if (_hashes[i] > s_tombstone) f(_keys[i], _values[i]);
+    }
+
+  protected:
+    static constexpr size_t s_min_capacity = 16;
+    /// @note max load factor 7/10, tombstones included
+    static constexpr size_t s_max_load_num = 7;
+    static constexpr size_t s_max_load_den = 10;
+
+    template <typename K> static u64 hash_of(const K &key) noexcept {
+      u64 h = Hasher{}(key);
+      /// @note reserve the sentinels
+      return h > s_tombstone ? h : h + 2;
+    }
+
+    template <typename K> i64 locate(const K &key) const noexcept {
+      if (_size == 0) return -1;
+      const auto h = hash_of(key);
+      const size_t mask = _hashes.size() - 1;
+      for (size_t i = h & mask;; i = (i + 1) & mask) {
+        const auto sh = _hashes[i];
+        if (sh == s_empty) return -1;
+        if (sh == h && KeyEqual{}(_keys[i], key)) return (i64)i;
+      }
+    }
+
+    template <typename K, typename V, bool Assign>
+    bool emplace_(K &&key, V &&value, wrapv<Assign>) {
+      if ((_size + _numTombstones + 1) * s_max_load_den > capacity() * s_max_load_num)
+        rehash(_size * 2 * s_max_load_den >= capacity() * s_max_load_num
+                   ? std::max(capacity() * 2, s_min_capacity)
+                   : std::max(capacity(), s_min_capacity));
+      const auto h = hash_of(key);
+      const size_t mask = _hashes.size() - 1;
+      i64 dst = -1;
+      for (size_t i = h & mask;; i = (i + 1) & mask) {
+        const auto sh = _hashes[i];
+        if (sh == s_empty) {
+          if (dst == -1) dst = (i64)i;
+          break;
+        }
+        if (sh == s_tombstone) {
+          if (dst == -1) dst = (i64)i;
+        } else if (sh == h && KeyEqual{}(_keys[i], key)) {
+          if constexpr (Assign) _values[i] = FWD(value);
+          return false;
+        }
+      }
+      if (_hashes[dst] == s_tombstone) _numTombstones--;
+      _hashes[dst] = h;
+      _keys[dst] = Key(FWD(key));
+      _values[dst] = FWD(value);
+      _size++;
+      return true;
+    }
+
+    void rehash(size_t cap) {
+      std::vector<u64> hashes(cap, s_empty);
+      std::vector<Key> keys(cap);
+      std::vector<Value> values(cap);
+      const size_t mask = cap - 1;
+      for (size_t i = 0; i != _hashes.size(); ++i) {
+        const auto h = _hashes[i];
+        if (h <= s_tombstone) continue;
+        size_t j = h & mask;
+        while (hashes[j] != s_empty) j = (j + 1) & mask;
+        hashes[j] = h;
+        keys[j] = zs::move(_keys[i]);
+        values[j] = zs::move(_values[i]);
+      }
+      _hashes = zs::move(hashes);
+      _keys = zs::move(keys);
+      _values = zs::move(values);
+      _numTombstones = 0;
+    }
+
+    std::vector<u64> _hashes;
+    std::vector<Key> _keys;
+    std::vector<Value> _values;
+    size_t _size{0}, _numTombstones{0};
+  };
+
+}  // namespace zs
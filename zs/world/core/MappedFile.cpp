@@ -0,0 +1,110 @@
+#include "world/core/MappedFile.hpp"
+
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace zs {
+
+  MappedFile::MappedFile(MappedFile &&o) noexcept
+      : _data{std::exchange(o._data, nullptr)},
+        _size{std::exchange(o._size, 0)}
+#ifdef _WIN32
+        ,
+        _file{std::exchange(o._file, nullptr)},
+        _mapping{std::exchange(o._mapping, nullptr)}
+#endif
+  {
+  }
+
+  MappedFile &MappedFile::operator=(MappedFile &&o) noexcept {
+    if (this != &o) {
+      close();
+      _data = std::exchange(o._data, nullptr);
+      _size = std::exchange(o._size, 0);
+#ifdef _WIN32
+      _file = std::exchange(o._file, nullptr);
+      _mapping = std::exchange(o._mapping, nullptr);
+#endif
+    }
+    return *this;
+  }
+
+  size_t MappedFile::page_size() noexcept {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+#else
+    return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+  }
+
+  bool MappedFile::open(std::string_view fileName) {
+    close();
+    const std::string fn{fileName};
+#ifdef _WIN32
+    HANDLE file = CreateFileA(fn.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+      CloseHandle(file);
+      return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (!mapping) {
+      CloseHandle(file);
+      return false;
+    }
+    void *ptr = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    if (!ptr) {
+      CloseHandle(mapping);
+      CloseHandle(file);
+      return false;
+    }
+    _file = file;
+    _mapping = mapping;
+    _data = static_cast<std::byte *>(ptr);
+    _size = (size_t)size.QuadPart;
+#else
+    int fd = ::open(fn.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      ::close(fd);
+      return false;
+    }
+    void *ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    /// @note the mapping outlives the descriptor
+    ::close(fd);
+    if (ptr == MAP_FAILED) return false;
+    _data = static_cast<std::byte *>(ptr);
+    _size = (size_t)st.st_size;
+#endif
+    return true;
+  }
+
+  void MappedFile::close() noexcept {
+    if (!_data) return;
+#ifdef _WIN32
+    UnmapViewOfFile(_data);
+    CloseHandle((HANDLE)_mapping);
+    CloseHandle((HANDLE)_file);
+    _file = _mapping = nullptr;
+#else
+    munmap(_data, _size);
+#endif
+    _data = nullptr;
+    _size = 0;
+  }
+
+}  // namespace zs
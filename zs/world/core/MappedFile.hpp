@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+#include "world/WorldExport.hpp"
+
+namespace zs {
+
+  /**
+  @brief  Read-only view of a whole file mapped into memory
+  @note   pages are mapped copy-on-write, writes through data() never reach the file
+   */
+  struct ZS_WORLD_EXPORT MappedFile {
+    MappedFile() = default;
+    explicit MappedFile(std::string_view fileName) { open(fileName); }
+    ~MappedFile() { close(); }
+    MappedFile(MappedFile &&o) noexcept;
+    MappedFile &operator=(MappedFile &&o) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(std::string_view fileName);
+    void close() noexcept;
+
+    bool valid() const noexcept { return _data != nullptr; }
+    std::byte *data() noexcept { return _data; }
+    const std::byte *data() const noexcept { return _data; }
+    size_t size() const noexcept { return _size; }
+
+    /// @brief granularity mapped regions are aligned to
+    static size_t page_size() noexcept;
+
+  protected:
+    std::byte *_data{nullptr};
+    size_t _size{0};
+#ifdef _WIN32
+    void *_file{nullptr}, *_mapping{nullptr};
+#endif
+  };
+
+}  // namespace zs
@@ -0,0 +1,333 @@
+#include "world/core/MemoryResource.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <new>
+#include <string>
+
+#include "world/core/MappedFile.hpp"
+#include "zensim/zpc_tpls/fmt/format.h"
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <sys/mman.h>
+#  include <unistd.h>
+#  if defined(__linux__)
+#    include <sys/syscall.h>
+#  endif
+#endif
+
+namespace zs {
+
+  namespace fs = std::filesystem;
+
+  namespace {
+    size_t round_up(size_t bytes, size_t granularity) noexcept {
+      return (bytes + granularity - 1) / granularity * granularity;
+    }
+
+    /// @note the arena default, cache-line aligned
+    constexpr size_t g_block_alignment = 64;
+
+#if defined(__linux__)
+    /// @note mbind modes, from <linux/mempolicy.h> (libnuma is not required)
+    constexpr int g_mpol_bind = 2;
+    constexpr unsigned g_mpol_mf_move = 1u << 1;
+
+    bool bind_to_node(void *p, size_t bytes, int node) noexcept {
+#  ifdef SYS_mbind
+      constexpr size_t bitsPerWord = sizeof(unsigned long) * 8;
+      std::vector<unsigned long> mask(node / bitsPerWord + 1, 0ul);
+      mask[node / bitsPerWord] |= 1ul << (node % bitsPerWord);
+      return ::syscall(SYS_mbind, p, bytes, g_mpol_bind, mask.data(), mask.size() * bitsPerWord + 1,
+                       g_mpol_mf_move)
+             == 0;
+#  else
+      return false;
+#  endif
+    }
+#endif
+  }  // namespace
+
+  ///
+  /// TrackedResource
+  ///
+  TileVector<f32>::allocator_type TrackedResource::allocator() {
+    auto ret = get_memory_source(memsrc_e::host, -1);
+    ret.res = shared_from_this();
+    return ret;
+  }
+
+  TrackedResource::Stats TrackedResource::getStats() const noexcept {
+    Stats ret;
+    ret._allocations = _allocations.load();
+    ret._deallocations = _deallocations.load();
+    ret._fallbacks = _fallbacks.load();
+    ret._bytesInUse = _bytesInUse.load();
+    ret._peakBytes = _peakBytes.load();
+    return ret;
+  }
+
+  void TrackedResource::resetStats() noexcept {
+    _allocations = 0;
+    _deallocations = 0;
+    _fallbacks = 0;
+    _peakBytes = _bytesInUse.load();
+  }
+
+  void *TrackedResource::do_allocate(size_t bytes, size_t alignment) {
+    void *ret = allocateImpl(bytes, alignment);
+    _allocations.fetch_add(1, std::memory_order_relaxed);
+    const size_t inUse = _bytesInUse.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = _peakBytes.load(std::memory_order_relaxed);
+    while (peak < inUse
+           && !_peakBytes.compare_exchange_weak(peak, inUse, std::memory_order_relaxed));
+    return ret;
+  }
+
+  void TrackedResource::do_deallocate(void *p, size_t bytes, size_t alignment) {
+    deallocateImpl(p, bytes, alignment);
+    _deallocations.fetch_add(1, std::memory_order_relaxed);
+    _bytesInUse.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  ///
+  /// PageResource
+  ///
+  PageResource::PageResource(huge_page_e hugePages, int numaNode)
+      : _hugePages{hugePages}, _numaNode{numaNode} {
+    if (_numaNode >= num_numa_nodes()) {
+      fmt::print("numa node {} out of range ({} nodes), allocations are left unbound.\n", _numaNode,
+                 num_numa_nodes());
+      _numaNode = -1;
+    }
+  }
+
+  PageResource::~PageResource() {
+    /// @note storage still allocated from here is a leak of its owner, unmapped regardless
+    _mappings.forEach([](const void *p, const Mapping &mapping) {
+      unmap(const_cast<void *>(p), mapping);
+    });
+  }
+
+  int PageResource::num_numa_nodes() noexcept {
+#ifdef _WIN32
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest)) return 1;
+    return (int)highest + 1;
+#elif defined(__linux__)
+    static const int numNodes = [] {
+      int n = 0;
+      std::error_code ec;
+      for (const auto &entry : fs::directory_iterator("/sys/devices/system/node", ec)) {
+        const auto name = entry.path().filename().string();
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0
+            && name.find_first_not_of("0123456789", 4) == std::string::npos)
+          n = std::max(n, std::stoi(name.substr(4)) + 1);
+      }
+      return n > 0 ? n : 1;
+    }();
+    return numNodes;
+#else
+    return 1;
+#endif
+  }
+
+  int PageResource::current_numa_node() noexcept {
+#ifdef _WIN32
+    PROCESSOR_NUMBER proc;
+    GetCurrentProcessorNumberEx(&proc);
+    USHORT node = 0;
+    if (!GetNumaProcessorNodeEx(&proc, &node)) return 0;
+    return (int)node;
+#elif defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return 0;
+    return (int)node;
+#else
+    return 0;
+#endif
+  }
+
+  void *PageResource::map(size_t bytes, Mapping &mapping) {
+#ifdef _WIN32
+    const auto process = GetCurrentProcess();
+    const DWORD node = _numaNode >= 0 ? (DWORD)_numaNode : NUMA_NO_PREFERRED_NODE;
+    if (_hugePages == huge_page_explicit) {
+      if (const size_t large = GetLargePageMinimum()) {
+        const size_t n = round_up(bytes, large);
+        if (void *ptr = VirtualAllocExNuma(process, nullptr, n,
+                                           MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                           PAGE_READWRITE, node)) {
+          mapping._bytes = n;
+          mapping._explicitHuge = true;
+          return ptr;
+        }
+      }
+      recordFallback();
+    }
+    /// @note no transparent huge pages on windows
+    mapping._bytes = round_up(bytes, MappedFile::page_size());
+    return VirtualAllocExNuma(process, nullptr, mapping._bytes, MEM_RESERVE | MEM_COMMIT,
+                              PAGE_READWRITE, node);
+#else
+    void *ptr = nullptr;
+#  if defined(MAP_HUGETLB)
+    if (_hugePages == huge_page_explicit) {
+      const size_t n = round_up(bytes, s_huge_page_bytes);
+      ptr = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1,
+                 0);
+      if (ptr != MAP_FAILED) {
+        mapping._bytes = n;
+        mapping._explicitHuge = true;
+      } else {
+        /// @note the reserved pool is exhausted, transparent huge pages take over
+        ptr = nullptr;
+        recordFallback();
+      }
+    }
+#  endif
+    if (!ptr && _hugePages != huge_page_none) {
+      /// @note over-map, then trim to a huge page aligned range
+      const size_t n = round_up(bytes, s_huge_page_bytes);
+      void *raw = mmap(nullptr, n + s_huge_page_bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (raw == MAP_FAILED) return nullptr;
+      const auto addr = reinterpret_cast<std::uintptr_t>(raw);
+      const auto st = round_up(addr, s_huge_page_bytes);
+      if (st != addr) munmap(raw, st - addr);
+      if (const size_t tail = addr + n + s_huge_page_bytes - (st + n))
+        munmap(reinterpret_cast<void *>(st + n), tail);
+      ptr = reinterpret_cast<void *>(st);
+      mapping._bytes = n;
+#  if defined(MADV_HUGEPAGE)
+      ::madvise(ptr, n, MADV_HUGEPAGE);
+#  endif
+    }
+    if (!ptr) {
+      mapping._bytes = round_up(bytes, MappedFile::page_size());
+      ptr = mmap(nullptr, mapping._bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                 0);
+      if (ptr == MAP_FAILED) return nullptr;
+    }
+#  if defined(__linux__)
+    /// @note bound before first touch, pages are then faulted in on [_numaNode]
+    if (_numaNode >= 0 && !bind_to_node(ptr, mapping._bytes, _numaNode)) recordFallback();
+#  endif
+    return ptr;
+#endif
+  }
+
+  void PageResource::unmap(void *p, const Mapping &mapping) noexcept {
+#ifdef _WIN32
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, mapping._bytes);
+#endif
+  }
+
+  void *PageResource::allocateImpl(size_t bytes, size_t alignment) {
+    /// @note mappings are page-aligned
+    if (bytes < s_min_mapped_bytes || alignment > MappedFile::page_size())
+      return ::operator new(bytes, std::align_val_t{alignment});
+    Mapping mapping;
+    void *ptr = map(bytes, mapping);
+    if (!ptr) {
+      recordFallback();
+      return ::operator new(bytes, std::align_val_t{alignment});
+    }
+    {
+      std::lock_guard lk(_mutex);
+      _mappings.insert(static_cast<const void *>(ptr), mapping);
+    }
+    _mappedBytes.fetch_add(mapping._bytes);
+    if (mapping._explicitHuge) _explicitHugeBytes.fetch_add(mapping._bytes);
+    return ptr;
+  }
+
+  void PageResource::deallocateImpl(void *p, size_t bytes, size_t alignment) {
+    Mapping mapping;
+    bool mapped = false;
+    if (bytes >= s_min_mapped_bytes) {
+      std::lock_guard lk(_mutex);
+      if (auto m = _mappings.find(static_cast<const void *>(p))) {
+        mapping = *m;
+        _mappings.erase(static_cast<const void *>(p));
+        mapped = true;
+      }
+    }
+    if (!mapped) {
+      ::operator delete(p, std::align_val_t{alignment});
+      return;
+    }
+    unmap(p, mapping);
+    _mappedBytes.fetch_sub(mapping._bytes);
+    if (mapping._explicitHuge) _explicitHugeBytes.fetch_sub(mapping._bytes);
+  }
+
+  ///
+  /// ArenaResource
+  ///
+  ArenaResource::ArenaResource(size_t blockBytes, std::shared_ptr<mr_t> upstream)
+      : _blockBytes{blockBytes ? blockBytes : s_default_block_bytes},
+        _upstream{zs::move(upstream)} {}
+
+  ArenaResource::~ArenaResource() { release(); }
+
+  std::byte *ArenaResource::allocateBlock(size_t bytes) {
+    void *ptr = _upstream ? _upstream->allocate(bytes, g_block_alignment)
+                          : ::operator new(bytes, std::align_val_t{g_block_alignment});
+    _blocks.push_back(Block{static_cast<std::byte *>(ptr), bytes});
+    return static_cast<std::byte *>(ptr);
+  }
+
+  void *ArenaResource::allocateImpl(size_t bytes, size_t alignment) {
+    std::lock_guard lk(_mutex);
+    if (_cursor) {
+      const auto addr = reinterpret_cast<std::uintptr_t>(_cursor);
+      auto st = reinterpret_cast<std::byte *>(round_up(addr, alignment));
+      if (st <= _end && (size_t)(_end - st) >= bytes) {
+        _cursor = st + bytes;
+        return st;
+      }
+    }
+    /// @note oversized requests get a block of their own, keeping the current one open
+    const size_t blockAlignment = std::max(alignment, g_block_alignment);
+    if (bytes + blockAlignment > _blockBytes / 2) {
+      auto block = allocateBlock(round_up(bytes, blockAlignment) + blockAlignment);
+      return reinterpret_cast<std::byte *>(
+          round_up(reinterpret_cast<std::uintptr_t>(block), blockAlignment));
+    }
+    auto block = allocateBlock(_blockBytes);
+    auto st = reinterpret_cast<std::byte *>(
+        round_up(reinterpret_cast<std::uintptr_t>(block), blockAlignment));
+    _cursor = st + bytes;
+    _end = block + _blockBytes;
+    return st;
+  }
+
+  void ArenaResource::release() {
+    std::lock_guard lk(_mutex);
+    for (const auto &block : _blocks) {
+      if (_upstream)
+        _upstream->deallocate(block._data, block._bytes, g_block_alignment);
+      else
+        ::operator delete(block._data, std::align_val_t{g_block_alignment});
+    }
+    _blocks.clear();
+    _cursor = _end = nullptr;
+  }
+
+  size_t ArenaResource::reservedBytes() const {
+    std::lock_guard lk(_mutex);
+    size_t ret = 0;
+    for (const auto &block : _blocks) ret += block._bytes;
+    return ret;
+  }
+
+}  // namespace zs
@@ -0,0 +1,143 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "world/WorldExport.hpp"
+#include "world/core/HashIndex.hpp"
+#include "zensim/container/TileVector.hpp"
+#include "zensim/execution/ConcurrencyPrimitive.hpp"
+
+namespace zs {
+
+  /**
+  @brief  Host memory resource counting its allocations, base of the resources tile storage
+          (AttrVector) can be relocated onto, see relocate_primitive_storage()
+  @note   derived resources implement allocateImpl/deallocateImpl and report the allocations
+          their preferred path could not serve (served from the heap instead) as fallbacks
+  @note   instances are expected to be owned by shared pointers, see allocator()
+   */
+  struct ZS_WORLD_EXPORT TrackedResource : mr_t, std::enable_shared_from_this<TrackedResource> {
+    struct Stats {
+      u64 _allocations{0}, _deallocations{0}, _fallbacks{0};
+      size_t _bytesInUse{0}, _peakBytes{0};
+    };
+
+    ~TrackedResource() override = default;
+
+    /// @brief host allocator drawing from this resource, which it keeps alive
+    TileVector<f32>::allocator_type allocator();
+
+    Stats getStats() const noexcept;
+    /// @brief reset the counters, except for the bytes in use (the peak restarts from there)
+    void resetStats() noexcept;
+
+  protected:
+    void *do_allocate(size_t bytes, size_t alignment) final;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) final;
+    bool do_is_equal(const mr_t &o) const noexcept override { return this == &o; }
+
+    virtual void *allocateImpl(size_t bytes, size_t alignment) = 0;
+    virtual void deallocateImpl(void *p, size_t bytes, size_t alignment) = 0;
+
+    void recordFallback() noexcept { _fallbacks.fetch_add(1, std::memory_order_relaxed); }
+
+    std::atomic<u64> _allocations{0}, _deallocations{0}, _fallbacks{0};
+    std::atomic<size_t> _bytesInUse{0}, _peakBytes{0};
+  };
+
+  /**
+  @brief  Host memory resource mapping large allocations page by page, optionally upon huge
+          pages and/or bound to a NUMA node, cutting TLB misses and cross-socket traffic of
+          kernels streaming through large tile storage
+  @note   huge_page_transparent aligns mappings to s_huge_page_bytes and advises the kernel to
+          back them with transparent huge pages (Linux, "madvise" or "always" mode)
+  @note   huge_page_explicit draws from the reserved huge page pool (MAP_HUGETLB on Linux, large
+          pages on Windows, the latter requiring the lock-memory privilege), falling back to
+          transparent huge pages once the pool is exhausted (counted as a fallback)
+  @note   a non-negative [numaNode] binds mappings to that node (mbind, VirtualAllocExNuma),
+          current_numa_node() being the natural choice for storage its thread works on
+  @note   allocations below s_min_mapped_bytes come from the heap
+   */
+  struct ZS_WORLD_EXPORT PageResource : TrackedResource {
+    static constexpr size_t s_min_mapped_bytes = (size_t)1 << 20;  // 1 MiB
+    static constexpr size_t s_huge_page_bytes = (size_t)2 << 20;   // 2 MiB
+
+    enum huge_page_e : u32 { huge_page_none = 0, huge_page_transparent, huge_page_explicit };
+
+    explicit PageResource(huge_page_e hugePages = huge_page_transparent, int numaNode = -1);
+    ~PageResource() override;
+    PageResource(const PageResource &) = delete;
+    PageResource &operator=(const PageResource &) = delete;
+
+    huge_page_e hugePages() const noexcept { return _hugePages; }
+    int numaNode() const noexcept { return _numaNode; }
+    /// @brief bytes currently mapped, and those upon explicit huge pages
+    size_t mappedBytes() const noexcept { return _mappedBytes.load(); }
+    size_t explicitHugeBytes() const noexcept { return _explicitHugeBytes.load(); }
+
+    /// @brief number of NUMA nodes of the system, at least 1
+    static int num_numa_nodes() noexcept;
+    /// @brief node of the cpu the calling thread runs on, 0 if unknown
+    static int current_numa_node() noexcept;
+
+  protected:
+    void *allocateImpl(size_t bytes, size_t alignment) override;
+    void deallocateImpl(void *p, size_t bytes, size_t alignment) override;
+
+    struct Mapping {
+      size_t _bytes{0};
+      bool _explicitHuge{false};
+    };
+
+    void *map(size_t bytes, Mapping &mapping);
+    static void unmap(void *p, const Mapping &mapping) noexcept;
+
+    huge_page_e _hugePages;
+    int _numaNode;
+    mutable Mutex _mutex;  // guards [_mappings]
+    HashIndex<const void *, Mapping> _mappings;
+    std::atomic<size_t> _mappedBytes{0}, _explicitHugeBytes{0};
+  };
+
+  /**
+  @brief  Monotonic memory resource for transient storage (e.g. conversion outputs dropped
+          right after use): allocations are carved from large blocks, deallocations are no-ops
+          and everything is reclaimed at once upon release() or destruction
+  @note   blocks come from [upstream] (e.g. a PageResource upon huge pages) if given, from the
+          heap otherwise; oversized requests get a block of their own
+  @note   storage allocated from here must not outlive release()
+   */
+  struct ZS_WORLD_EXPORT ArenaResource : TrackedResource {
+    static constexpr size_t s_default_block_bytes = (size_t)64 << 20;  // 64 MiB
+
+    explicit ArenaResource(size_t blockBytes = s_default_block_bytes,
+                           std::shared_ptr<mr_t> upstream = {});
+    ~ArenaResource() override;
+    ArenaResource(const ArenaResource &) = delete;
+    ArenaResource &operator=(const ArenaResource &) = delete;
+
+    /// @brief return all blocks upstream
+    void release();
+    /// @brief bytes held in blocks, used or not
+    size_t reservedBytes() const;
+
+  protected:
+    void *allocateImpl(size_t bytes, size_t alignment) override;
+    void deallocateImpl(void *, size_t, size_t) override {}
+
+    struct Block {
+      std::byte *_data{nullptr};
+      size_t _bytes{0};
+    };
+
+    std::byte *allocateBlock(size_t bytes);
+
+    size_t _blockBytes;
+    std::shared_ptr<mr_t> _upstream;
+    mutable Mutex _mutex;  // guards the members below
+    std::vector<Block> _blocks;
+    std::byte *_cursor{nullptr}, *_end{nullptr};
+  };
+
+}  // namespace zs
@@ -6,6 +6,8 @@
 
 namespace zs {
 
+  /// @note container sizes within bitsery archives are capped here, large attribute vectors
+  /// go through serialize_attr_vector (see Primitive.hpp) instead
   constexpr size_t g_max_serialization_size_limit = detail::deduce_numeric_max<u32>();
 
   using SerializationBuffer = std::vector<char>;
@@ -46,6 +48,11 @@ namespace zs {
   using BitseryDeserializer
       = bitsery::Deserializer<BitseryReader, bitsery::ext::PointerLinkingContext>;
 
+  /// @brief whether [S] reads into the objects it visits
+  template <typename S> constexpr bool is_bitsery_deserializer_v = false;
+  template <typename Adapter, typename Context>
+  constexpr bool is_bitsery_deserializer_v<bitsery::Deserializer<Adapter, Context>> = true;
+
 }  // namespace zs
 
 #endif
\ No newline at end of file
@@ -0,0 +1,451 @@
+#include "GeometryCache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "SceneContext.hpp"
+#include "interface/details/PyHelper.hpp"
+#include "world/core/AssetCache.hpp"
+
+#if ZS_ENABLE_OPENMP
+#  include "zensim/omp/execution/ExecutionPolicy.hpp"
+#else
+#  include "zensim/execution/ExecutionPolicy.hpp"
+#endif
+
+namespace zs {
+
+  namespace {
+    constexpr char g_geometry_cache_magic[8] = {'Z', 'S', 'G', 'E', 'O', 'C', '\0', '\0'};
+    constexpr u32 g_geometry_cache_version = 1;
+    constexpr size_t g_index_alignment = 64;
+
+    enum geometry_cache_flag_e : u32 { cache_uniform = 1 };
+    /// @note stored at the very end of the file, after the chunks and the index
+    struct GeometryCacheFooter {
+      char _magic[8];
+      u32 _version;
+      u32 _flags;
+      u64 _numFrames;
+      u64 _numStreams;
+      u64 _numChunks;
+      u64 _indexOffset;
+      u64 _indexBytes;
+      u64 _indexChecksum;
+    };
+    static_assert(sizeof(GeometryCacheFooter) == 64, "geometry cache footer layout changed");
+
+    /// @brief index of the sampled frame at [tc], -1 if none
+    /// @note O(1) for uniformly sampled timecodes, a binary search otherwise
+    int find_frame(const std::vector<TimeCode> &tcs, bool uniform, TimeCode tc) noexcept {
+      const auto n = tcs.size();
+      if (n == 0 || std::isnan(tc)) return -1;
+      if (n == 1) return std::abs(tc - tcs[0]) <= 1e-6 * std::max(1., std::abs(tc)) ? 0 : -1;
+      if (uniform) {
+        const auto stride = tcs[1] - tcs[0];
+        const auto i = std::llround((tc - tcs[0]) / stride);
+        if (i < 0 || i >= (long long)n) return -1;
+        return std::abs(tcs[i] - tc) <= std::abs(stride) * 1e-3 ? (int)i : -1;
+      }
+      auto it = std::lower_bound(tcs.begin(), tcs.end(), tc);
+      const auto eps = 1e-6 * std::max(1., std::abs(tc));
+      if (it != tcs.end() && std::abs(*it - tc) <= eps) return (int)(it - tcs.begin());
+      if (it != tcs.begin() && std::abs(*std::prev(it) - tc) <= eps)
+        return (int)(it - tcs.begin()) - 1;
+      return -1;
+    }
+
+    bool is_uniform(const std::vector<TimeCode> &tcs) noexcept {
+      if (tcs.size() < 2) return true;
+      const auto stride = tcs[1] - tcs[0];
+      if (!(stride > 0)) return false;
+      for (size_t i = 2; i < tcs.size(); ++i)
+        if (std::abs((tcs[i] - tcs[i - 1]) - stride) > stride * 1e-6) return false;
+      return true;
+    }
+
+    template <typename T> void append_value(std::vector<std::byte> &out, const T &v) {
+      const auto offset = out.size();
+      out.resize(offset + sizeof(T));
+      std::memcpy(out.data() + offset, &v, sizeof(T));
+    }
+    template <typename Arr> void append_array(std::vector<std::byte> &out, const Arr &arr) {
+      const u64 n = arr.size();
+      append_value(out, n);
+      if (n == 0) return;
+      const auto offset = out.size(), bytes = n * sizeof(arr[0]);
+      out.resize(offset + bytes);
+      std::memcpy(out.data() + offset, &arr[0], bytes);
+    }
+
+    /// @brief bounded cursor over a mapped chunk
+    struct ChunkReader {
+      const std::byte *_p, *_end;
+
+      template <typename T> bool read(T &v) {
+        if ((size_t)(_end - _p) < sizeof(T)) return false;
+        std::memcpy(&v, _p, sizeof(T));
+        _p += sizeof(T);
+        return true;
+      }
+      template <typename Arr> bool readArray(Arr &arr) {
+        u64 n;
+        if (!read(n)) return false;
+        const auto bytes = n * sizeof(arr[0]);
+        if (n && bytes / n != sizeof(arr[0])) return false;
+        if ((size_t)(_end - _p) < bytes) return false;
+        arr.resize(n);
+        if (n) std::memcpy(&arr[0], _p, bytes);
+        _p += bytes;
+        return true;
+      }
+    };
+
+    /// @note positions and normals vary per frame
+    template <typename Mesh> void encode_positions(std::vector<std::byte> &out, const Mesh &mesh) {
+      append_array(out, mesh.nodes);
+      append_array(out, mesh.norms);
+    }
+    template <typename Mesh> void encode_topology(std::vector<std::byte> &out, const Mesh &mesh) {
+      append_array(out, mesh.elems);
+      append_array(out, mesh.uvs);
+      append_array(out, mesh.colors);
+    }
+    template <typename Mesh> bool decode_positions(ChunkReader &reader, Mesh &mesh) {
+      return reader.readArray(mesh.nodes) && reader.readArray(mesh.norms);
+    }
+    template <typename Mesh> bool decode_topology(ChunkReader &reader, Mesh &mesh) {
+      return reader.readArray(mesh.elems) && reader.readArray(mesh.uvs)
+             && reader.readArray(mesh.colors);
+    }
+    template <typename Mesh> void copy_topology(const Mesh &src, Mesh &dst) {
+      dst.elems = src.elems;
+      dst.uvs = src.uvs;
+      dst.colors = src.colors;
+    }
+
+    template <typename F> void for_each_mesh(ZsMeshBundle &meshes, F &&f) {
+      f(meshes._triMesh);
+      f(meshes._lineMesh);
+      f(meshes._pointMesh);
+    }
+    template <typename F> void for_each_mesh(const ZsMeshBundle &meshes, F &&f) {
+      f(meshes._triMesh);
+      f(meshes._lineMesh);
+      f(meshes._pointMesh);
+    }
+  }  // namespace
+
+  std::string GeometryCache::stream_key(const ZsPrimitive &prim) {
+    /// @note duplicated sibling labels would otherwise share (and overwrite) one stream
+    auto ordinal = [](const ZsPrimitive *p) -> size_t {
+      auto parent = p->getParent();
+      /// @note the first child of a label is found through the label index
+      if (!parent || parent->findChild(p->label()) == p) return 0;
+      size_t n = 0;
+      for (const auto &ch : parent->children()) {
+        if (ch.get() == p) break;
+        if (ch->label() == p->label()) n++;
+      }
+      return n;
+    };
+    std::vector<const ZsPrimitive *> prims;
+    for (auto p = &prim; p; p = p->getParent()) prims.push_back(p);
+    std::string ret;
+    for (auto it = prims.rbegin(); it != prims.rend(); ++it) {
+      if (!ret.empty()) ret += '/';
+      ret.append((*it)->label());
+      if (auto n = ordinal(*it)) ret += fmt::format("[{}]", n);
+    }
+    return ret;
+  }
+
+  ///
+  /// reader
+  ///
+  bool GeometryCache::open(std::string_view fileName) {
+    close();
+    if (!_file.open(fileName)) return false;
+    auto fail = [this, fileName](const char *reason) {
+      zs_print_err_py_cstr(
+          fmt::format("geometry cache [{}] rejected: {}.", fileName, reason).c_str());
+      close();
+      return false;
+    };
+    const auto base = _file.data();
+    const auto size = _file.size();
+    GeometryCacheFooter footer;
+    if (size < sizeof(footer)) return fail("truncated");
+    std::memcpy(&footer, base + size - sizeof(footer), sizeof(footer));
+    if (std::memcmp(footer._magic, g_geometry_cache_magic, sizeof(footer._magic)) != 0
+        || footer._version != g_geometry_cache_version)
+      return fail("not a geometry cache (or of an incompatible version)");
+    const auto indexEnd = size - sizeof(footer);
+    if (footer._indexOffset > indexEnd || footer._indexBytes > indexEnd - footer._indexOffset)
+      return fail("index out of bounds");
+    const auto index = base + footer._indexOffset;
+    if (AssetCache::hash_bytes(index, footer._indexBytes) != footer._indexChecksum)
+      return fail("corrupted index");
+
+    const auto tableBytes = footer._numFrames * sizeof(TimeCode)
+                            + footer._numStreams * sizeof(StreamEntry)
+                            + footer._numChunks * sizeof(ChunkEntry);
+    if (footer._numFrames > indexEnd || footer._numStreams > indexEnd
+        || footer._numChunks > indexEnd || tableBytes > footer._indexBytes)
+      return fail("index out of bounds");
+    auto p = index;
+    _tcs.resize(footer._numFrames);
+    std::memcpy(_tcs.data(), p, _tcs.size() * sizeof(TimeCode));
+    p += _tcs.size() * sizeof(TimeCode);
+    _streams.resize(footer._numStreams);
+    std::memcpy(_streams.data(), p, _streams.size() * sizeof(StreamEntry));
+    p += _streams.size() * sizeof(StreamEntry);
+    _chunks.resize(footer._numChunks);
+    std::memcpy(_chunks.data(), p, _chunks.size() * sizeof(ChunkEntry));
+    p += _chunks.size() * sizeof(ChunkEntry);
+    const auto keys = reinterpret_cast<const char *>(p);
+    const auto keyBytes = footer._indexBytes - tableBytes;
+    _uniform = footer._flags & cache_uniform;
+
+    _streamIds.reserve(_streams.size());
+    for (u32 i = 0; i != _streams.size(); ++i) {
+      const auto &stream = _streams[i];
+      if (stream._keyOffset > keyBytes || stream._keyBytes > keyBytes - stream._keyOffset
+          || stream._firstChunk > _chunks.size()
+          || stream._numChunks > _chunks.size() - stream._firstChunk
+          || stream._topologyOffset > indexEnd
+          || stream._topologyBytes > indexEnd - stream._topologyOffset)
+        return fail("stream out of bounds");
+      for (u64 c = 0; c != stream._numChunks; ++c) {
+        const auto &chunk = _chunks[stream._firstChunk + c];
+        if (chunk._offset > indexEnd || chunk._bytes > indexEnd - chunk._offset)
+          return fail("chunk out of bounds");
+      }
+      _streamIds.insert(std::string(keys + stream._keyOffset, stream._keyBytes), i);
+    }
+    _topologies.assign(_streams.size(), {});
+    return true;
+  }
+
+  void GeometryCache::close() {
+    _file.close();
+    _tcs.clear();
+    _uniform = false;
+    _streams.clear();
+    _chunks.clear();
+    _streamIds.clear();
+    std::lock_guard lk(_mutex);
+    _topologies.clear();
+  }
+
+  Shared<const ZsMeshBundle> GeometryCache::topology(u32 streamId) const {
+    std::lock_guard lk(_mutex);
+    auto &ret = _topologies[streamId];
+    if (!ret) {
+      const auto &stream = _streams[streamId];
+      auto meshes = std::make_shared<ZsMeshBundle>();
+      ChunkReader reader{_file.data() + stream._topologyOffset,
+                         _file.data() + stream._topologyOffset + stream._topologyBytes};
+      bool ok = true;
+      for_each_mesh(*meshes, [&](auto &mesh) { ok = ok && decode_topology(reader, mesh); });
+      if (!ok) return {};
+      ret = zs::move(meshes);
+    }
+    return ret;
+  }
+
+  bool GeometryCache::read(const ZsPrimitive &prim, TimeCode tc, ZsMeshBundle &meshes) const {
+    _reads.fetch_add(1);
+    auto miss = [this]() {
+      _misses.fetch_add(1);
+      return false;
+    };
+    if (!valid()) return miss();
+    auto streamId = _streamIds.find(stream_key(prim));
+    if (!streamId) return miss();
+    const auto &stream = _streams[*streamId];
+    const int frame = stream._flags & stream_static ? 0 : find_frame(_tcs, _uniform, tc);
+    if (frame < 0 || frame >= (int)stream._numChunks) return miss();
+    const auto &chunk = _chunks[stream._firstChunk + frame];
+    if (chunk._bytes == 0) return miss();
+
+    ChunkReader reader{_file.data() + chunk._offset, _file.data() + chunk._offset + chunk._bytes};
+    bool ok = true;
+    for_each_mesh(meshes, [&](auto &mesh) {
+      mesh.clear();
+      ok = ok && decode_positions(reader, mesh);
+    });
+    if (chunk._flags & chunk_full)
+      for_each_mesh(meshes, [&](auto &mesh) { ok = ok && decode_topology(reader, mesh); });
+    else if (auto topo = topology(*streamId)) {
+      copy_topology(topo->_triMesh, meshes._triMesh);
+      copy_topology(topo->_lineMesh, meshes._lineMesh);
+      copy_topology(topo->_pointMesh, meshes._pointMesh);
+    } else
+      ok = false;
+    if (!ok) return miss();
+    _bytesRead.fetch_add(chunk._bytes);
+    return true;
+  }
+
+  size_t GeometryCache::stage(const std::vector<ZsPrimitive *> &prims, TimeCode tc) const {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    if (!valid() || prims.empty()) return 0;
+    std::atomic<size_t> numStaged{0};
+    pol(range(prims.size()), [&](size_t i) {
+      auto prim = prims[i];
+      if (prim->details().hasStagedMeshes(tc)) return;
+      auto meshes = std::make_shared<ZsMeshBundle>();
+      if (!read(*prim, tc, *meshes)) return;
+      prim->details().stageMeshes(tc, zs::move(meshes));
+      numStaged.fetch_add(1);
+    });
+    return numStaged.load();
+  }
+
+  GeometryCache::Stats GeometryCache::getStats() const noexcept {
+    Stats ret;
+    ret._reads = _reads.load();
+    ret._misses = _misses.load();
+    ret._bytesRead = _bytesRead.load();
+    return ret;
+  }
+  void GeometryCache::resetStats() noexcept {
+    _reads.store(0);
+    _misses.store(0);
+    _bytesRead.store(0);
+  }
+
+  ///
+  /// writer
+  ///
+  GeometryCacheWriter::GeometryCacheWriter(std::string_view fileName, std::vector<TimeCode> tcs)
+      : _writer{fileName, false}, _tcs{zs::move(tcs)} {
+    _uniform = is_uniform(_tcs);
+    if (!_uniform) std::sort(_tcs.begin(), _tcs.end());
+  }
+
+  u64 GeometryCacheWriter::append(const std::vector<std::byte> &data, size_t alignment) {
+    static const std::vector<std::byte> s_zeros(GeometryCache::s_chunk_alignment);
+    const auto pad = (alignment - _writer.bytes() % alignment) % alignment;
+    if (pad) _writer.write(s_zeros.data(), pad);
+    const u64 offset = _writer.bytes();
+    if (!_writer.write(data.data(), data.size())) _failed = true;
+    return offset;
+  }
+
+  bool GeometryCacheWriter::write(const ZsPrimitive &prim, TimeCode tc,
+                                  const ZsMeshBundle &meshes) {
+    const bool isStatic = !prim.details().isMeshTimeVarying();
+    const int frame = isStatic ? 0 : find_frame(_tcs, _uniform, tc);
+    if (frame < 0) return false;
+    /// @note encoded outside the lock, concurrent writers only serialize upon appending
+    std::vector<std::byte> positions, topology;
+    for_each_mesh(meshes, [&](const auto &mesh) { encode_positions(positions, mesh); });
+    for_each_mesh(meshes, [&](const auto &mesh) { encode_topology(topology, mesh); });
+    auto key = GeometryCache::stream_key(prim);
+
+    std::lock_guard lk(_mutex);
+    if (!valid()) return false;
+    u32 streamId;
+    bool isNew = false;
+    if (auto id = _streamIds.find(key))
+      streamId = *id;
+    else {
+      isNew = true;
+      streamId = (u32)_streams.size();
+      Stream stream;
+      stream._key = key;
+      stream._entry._flags = isStatic ? GeometryCache::stream_static : 0;
+      stream._entry._topologyBytes = topology.size();
+      stream._entry._topologyOffset = append(topology, g_index_alignment);
+      stream._topology = topology;
+      stream._chunks.resize(isStatic ? 1 : _tcs.size());
+      _streams.push_back(zs::move(stream));
+      _streamIds.insert(zs::move(key), streamId);
+    }
+    auto &stream = _streams[streamId];
+    if (frame >= (int)stream._chunks.size()) return false;
+
+    ChunkEntry chunk{};
+    /// @note topology (re)written within the chunk if it differs from the one of the stream
+    if (!isNew && topology != stream._topology) {
+      chunk._flags |= GeometryCache::chunk_full;
+      positions.insert(positions.end(), topology.begin(), topology.end());
+    }
+    chunk._bytes = positions.size();
+    chunk._offset = append(positions, GeometryCache::s_chunk_alignment);
+    stream._chunks[frame] = chunk;
+    return !_failed;
+  }
+
+  BakeSink GeometryCacheWriter::sink() {
+    return [this](const ZsPrimitive &prim, TimeCode tc, ZsMeshBundle &&meshes) {
+      write(prim, tc, meshes);
+    };
+  }
+
+  int GeometryCacheWriter::commit() {
+    std::lock_guard lk(_mutex);
+    if (!valid()) {
+      _writer.abort();
+      return -1;
+    }
+    std::vector<std::byte> index, keys;
+    for (const auto tc : _tcs) append_value(index, tc);
+    u64 numChunks = 0;
+    for (auto &stream : _streams) {
+      stream._entry._keyOffset = keys.size();
+      stream._entry._keyBytes = stream._key.size();
+      keys.insert(keys.end(), reinterpret_cast<const std::byte *>(stream._key.data()),
+                  reinterpret_cast<const std::byte *>(stream._key.data()) + stream._key.size());
+      stream._entry._firstChunk = numChunks;
+      stream._entry._numChunks = (u32)stream._chunks.size();
+      numChunks += stream._chunks.size();
+      append_value(index, stream._entry);
+    }
+    for (const auto &stream : _streams)
+      for (const auto &chunk : stream._chunks) append_value(index, chunk);
+    index.insert(index.end(), keys.begin(), keys.end());
+
+    GeometryCacheFooter footer{};
+    std::memcpy(footer._magic, g_geometry_cache_magic, sizeof(footer._magic));
+    footer._version = g_geometry_cache_version;
+    footer._flags = _uniform ? cache_uniform : 0;
+    footer._numFrames = _tcs.size();
+    footer._numStreams = _streams.size();
+    footer._numChunks = numChunks;
+    footer._indexBytes = index.size();
+    footer._indexChecksum = AssetCache::hash_bytes(index.data(), index.size());
+    footer._indexOffset = append(index, g_index_alignment);
+    _writer.write(&footer, sizeof(footer));
+    return _failed ? (_writer.abort(), -1) : _writer.commit();
+  }
+
+  BakeStats bake_geometry_cache(const std::vector<ZsPrimitive *> &prims,
+                                const std::vector<TimeCode> &tcs, std::string_view fileName,
+                                int numThreads) {
+    GeometryCacheWriter writer{fileName, tcs};
+    if (!writer.valid()) {
+      zs_print_err_py_cstr(fmt::format("unable to write geometry cache [{}].", fileName).c_str());
+      return {};
+    }
+    auto stats = bake_primitives(prims, tcs, writer.sink(), numThreads);
+    if (writer.commit() != 0) {
+      zs_print_err_py_cstr(fmt::format("unable to commit geometry cache [{}].", fileName).c_str());
+      stats._numFailed = stats._numTasks;
+    }
+    return stats;
+  }
+
+  BakeStats bake_scene_geometry_cache(const SceneContext &scene, const std::vector<TimeCode> &tcs,
+                                      std::string_view fileName, int numThreads) {
+    return bake_geometry_cache(scene.getPrimitivesRecurse(), tcs, fileName, numThreads);
+  }
+
+}  // namespace zs
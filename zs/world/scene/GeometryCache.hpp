@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../WorldExport.hpp"
+#include "Primitive.hpp"
+#include "SceneBake.hpp"
+#include "world/core/Archive.hpp"
+#include "world/core/HashIndex.hpp"
+#include "world/core/MappedFile.hpp"
+
+namespace zs {
+
+  /**
+  @brief  Baked zs meshes of prims over a range of timecodes, read back in place of keyframe
+          evaluation (e.g. upon scrubbing)
+  @note   every prim owns a stream: its topology (elements, uvs, colors) is stored once, while
+          each frame only stores positions and normals in a chunk of its own; frames whose
+          topology differs fall back to a full chunk
+  @note   chunks are aligned to s_chunk_alignment and located through a frame table, seeking is
+          O(1) for uniformly sampled timecodes and a frame reads exactly one chunk per prim, the
+          decoded topologies being kept in memory
+  @note   streams are keyed by the labels of the prim and its ancestors joined by '/'
+  @note   caches are not invalidated by later edits of the prims, bake again instead
+   */
+  struct ZS_WORLD_EXPORT GeometryCache {
+    static constexpr size_t s_chunk_alignment = 4096;
+
+    /// @note on-disk layout
+    struct ChunkEntry {
+      u64 _offset{0}, _bytes{0};  // no chunk if empty
+      u32 _flags{0}, _reserved{0};
+    };
+    enum chunk_flag_e : u32 { chunk_full = 1 };
+    enum stream_flag_e : u32 { stream_static = 1 };
+    struct StreamEntry {
+      u64 _keyOffset{0}, _keyBytes{0};  // within the key blob
+      u64 _topologyOffset{0}, _topologyBytes{0};
+      u64 _firstChunk{0};  // within the chunk table
+      u32 _numChunks{0}, _flags{0};
+    };
+
+    struct Stats {
+      u64 _reads{0}, _misses{0};
+      size_t _bytesRead{0};
+    };
+
+    GeometryCache() = default;
+    explicit GeometryCache(std::string_view fileName) { open(fileName); }
+    GeometryCache(const GeometryCache &) = delete;
+    GeometryCache &operator=(const GeometryCache &) = delete;
+
+    bool open(std::string_view fileName);
+    void close();
+    bool valid() const noexcept { return _file.valid(); }
+    const std::vector<TimeCode> &timeCodes() const noexcept { return _tcs; }
+    size_t numStreams() const noexcept { return _streams.size(); }
+    bool contains(const ZsPrimitive &prim) const { return _streamIds.contains(stream_key(prim)); }
+
+    /// @brief decode the meshes of [prim] baked at [tc]
+    /// @return false if [prim] or the frame was not baked
+    /// @note thread-safe, [meshes] carries no geometry (see ZsMeshBundle)
+    bool read(const ZsPrimitive &prim, TimeCode tc, ZsMeshBundle &meshes) const;
+    /// @brief stage the frames at [tc] into [prims] without staged meshes yet, in parallel
+    /// @note eager, scenes read their cache lazily on the converting workers instead (see
+    /// SceneContext::takeMeshes)
+    /// @return number of prims staged
+    size_t stage(const std::vector<ZsPrimitive *> &prims, TimeCode tc) const;
+
+    Stats getStats() const noexcept;
+    void resetStats() noexcept;
+
+    /// @brief '/'-joined label path of [prim], children sharing the label of an earlier
+    /// sibling get their ordinal among those appended, e.g. "scene/mesh[1]"
+    static std::string stream_key(const ZsPrimitive &prim);
+
+  protected:
+    Shared<const ZsMeshBundle> topology(u32 streamId) const;
+
+    MappedFile _file;
+    std::vector<TimeCode> _tcs;
+    bool _uniform{false};
+    std::vector<StreamEntry> _streams;
+    std::vector<ChunkEntry> _chunks;
+    HashIndex<std::string, u32> _streamIds;
+
+    mutable Mutex _mutex;  // guards [_topologies]
+    mutable std::vector<Shared<const ZsMeshBundle>> _topologies;
+    mutable std::atomic<u64> _reads{0}, _misses{0}, _bytesRead{0};
+  };
+
+  /// @brief streams baked frames into a geometry cache file, committed atomically
+  struct ZS_WORLD_EXPORT GeometryCacheWriter {
+    /// @note frames are expected at [tcs] only
+    GeometryCacheWriter(std::string_view fileName, std::vector<TimeCode> tcs);
+    GeometryCacheWriter(const GeometryCacheWriter &) = delete;
+    GeometryCacheWriter &operator=(const GeometryCacheWriter &) = delete;
+
+    bool valid() const noexcept { return _writer.valid() && !_failed; }
+    /// @note thread-safe, frames may come in any order, prims without time-varying meshes are
+    /// stored once
+    bool write(const ZsPrimitive &prim, TimeCode tc, const ZsMeshBundle &meshes);
+    /// @brief adapter feeding bake_primitives()
+    BakeSink sink();
+    /// @brief append the frame table, then atomically replace the target file
+    /// @return 0 on success, -1 otherwise
+    int commit();
+
+  protected:
+    using StreamEntry = GeometryCache::StreamEntry;
+    using ChunkEntry = GeometryCache::ChunkEntry;
+    struct Stream {
+      std::string _key;
+      StreamEntry _entry;
+      std::vector<std::byte> _topology;  // encoded, compared against incoming frames
+      std::vector<ChunkEntry> _chunks;
+    };
+
+    u64 append(const std::vector<std::byte> &data, size_t alignment);
+
+    Mutex _mutex;
+    ArchiveWriter _writer;
+    std::vector<TimeCode> _tcs;
+    bool _uniform{false}, _failed{false};
+    std::vector<Stream> _streams;
+    HashIndex<std::string, u32> _streamIds;
+  };
+
+  /// @brief bake [prims] at [tcs] (see bake_primitives) into the geometry cache [fileName]
+  ZS_WORLD_EXPORT BakeStats bake_geometry_cache(const std::vector<ZsPrimitive *> &prims,
+                                                const std::vector<TimeCode> &tcs,
+                                                std::string_view fileName, int numThreads = 0);
+  ZS_WORLD_EXPORT BakeStats bake_scene_geometry_cache(const SceneContext &scene,
+                                                      const std::vector<TimeCode> &tcs,
+                                                      std::string_view fileName,
+                                                      int numThreads = 0);
+
+}  // namespace zs
@@ -0,0 +1,384 @@
+#include "PointSpatialIndex.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+
+#if ZS_ENABLE_OPENMP
+#  include "zensim/omp/execution/ExecutionPolicy.hpp"
+#else
+#  include "zensim/execution/ExecutionPolicy.hpp"
+#endif
+
+namespace zs {
+
+  namespace {
+    /// @note per-thread scratch, reused across queries
+    std::vector<u32> &local_bucket_scratch() {
+      thread_local std::vector<u32> buckets;
+      return buckets;
+    }
+    std::vector<std::pair<f32, PrimIndex>> &local_heap_scratch() {
+      thread_local std::vector<std::pair<f32, PrimIndex>> heap;
+      return heap;
+    }
+
+    /// @brief the buckets a query has scanned, by open addressing over the bucket indices
+    /// (already hashed, and below 2^31 so that ~0u marks an empty slot)
+    /// @note cleared through the list of occupied slots, so the cost of a query stays in
+    /// proportion to the cells it visits even after the table grew for a far reaching one
+    struct VisitedBuckets {
+      void clear() {
+        for (auto s : _used) _slots[s] = s_empty;
+        _used.clear();
+      }
+      /// @brief false if [b] was already visited
+      bool insert(u32 b) {
+        if (2 * (_used.size() + 1) > _slots.size()) grow();
+        const size_t mask = _slots.size() - 1;
+        for (size_t s = b & mask;; s = (s + 1) & mask) {
+          if (_slots[s] == b) return false;
+          if (_slots[s] == s_empty) {
+            _slots[s] = b;
+            _used.push_back(s);
+            return true;
+          }
+        }
+      }
+
+    private:
+      static constexpr u32 s_empty = ~(u32)0;
+      void grow() {
+        std::vector<u32> buckets;
+        buckets.reserve(_used.size());
+        for (auto s : _used) buckets.push_back(_slots[s]);
+        _slots.assign(std::max<size_t>(64, 2 * _slots.size()), s_empty);
+        _used.clear();
+        for (auto b : buckets) insert(b);
+      }
+      std::vector<u32> _slots;
+      std::vector<size_t> _used;
+    };
+    VisitedBuckets &local_visited_scratch() {
+      thread_local VisitedBuckets visited;
+      return visited;
+    }
+  }  // namespace
+
+  void PointSpatialIndex::reset() noexcept {
+    _sortedPos.clear();
+    _sortedIds.clear();
+    _bucketOffsets.clear();
+    _numCells = glm::ivec3{0};
+    _cellSize = _invCellSize = 0.f;
+    _bucketMask = 0;
+  }
+
+  template <typename GetPos>
+  bool PointSpatialIndex::buildImpl(GetPos &&getPos, size_t numPoints, f32 cellSize) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    reset();
+    if (numPoints == 0 || numPoints > s_max_points) return false;
+
+    /// bounds, reduced per chunk
+    constexpr size_t chunkSize = (size_t)1 << 14;
+    const size_t numChunks = (numPoints + chunkSize - 1) / chunkSize;
+    std::vector<glm::vec3> chunkLo(numChunks), chunkHi(numChunks);
+    pol(range(numChunks), [&](size_t c) {
+      glm::vec3 lo = getPos(c * chunkSize), hi = lo;
+      for (size_t i = c * chunkSize + 1, ed = std::min(numPoints, (c + 1) * chunkSize); i < ed;
+           ++i) {
+        const auto p = getPos(i);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+      }
+      chunkLo[c] = lo;
+      chunkHi[c] = hi;
+    });
+    _lo = chunkLo[0];
+    _hi = chunkHi[0];
+    for (size_t c = 1; c < numChunks; ++c) {
+      _lo = glm::min(_lo, chunkLo[c]);
+      _hi = glm::max(_hi, chunkHi[c]);
+    }
+
+    /// @note by default, a few points per cell over the non-degenerate extents
+    if (!(cellSize > 0.f)) {
+      constexpr f32 s_points_per_cell = 4.f;
+      const auto ext = _hi - _lo;
+      const f32 maxExt = std::max(std::max(ext.x, ext.y), ext.z);
+      f32 measure = 1.f;
+      int dim = 0;
+      for (int d = 0; d != 3; ++d)
+        if (ext[d] > maxExt * 1e-3f) {
+          measure *= ext[d];
+          dim++;
+        }
+      cellSize = dim ? std::pow(measure * s_points_per_cell / (f32)numPoints, 1.f / dim) : 1.f;
+    }
+    _cellSize = cellSize;
+    _invCellSize = 1.f / cellSize;
+    _origin = _lo;
+    _numCells = cellCoord(_hi) + 1;
+
+    /// bucketing (counting sort)
+    /// @note twice as many buckets as points, capped so that the mask still fits in u32
+    const size_t numBuckets
+        = std::min<size_t>(std::bit_ceil(2 * numPoints), (size_t)1 << 31);
+    _bucketMask = (u32)(numBuckets - 1);
+    std::vector<u32> buckets(numPoints), counts(numBuckets + 1, 0);
+    pol(range(numPoints), [&](size_t i) {
+      const auto b = bucketIndex(cellCoord(getPos(i)));
+      buckets[i] = b;
+      std::atomic_ref<u32>(counts[b]).fetch_add(1, std::memory_order_relaxed);
+    });
+    _bucketOffsets.resize(numBuckets + 1);
+    exclusive_scan(pol, zs::begin(counts), zs::end(counts), zs::begin(_bucketOffsets));
+
+    std::vector<u32> cursors(_bucketOffsets.begin(), _bucketOffsets.end() - 1);
+    _sortedPos.resize(numPoints);
+    _sortedIds.resize(numPoints);
+    pol(range(numPoints), [&](size_t i) {
+      const auto dst
+          = std::atomic_ref<u32>(cursors[buckets[i]]).fetch_add(1, std::memory_order_relaxed);
+      _sortedPos[dst] = getPos(i);
+      _sortedIds[dst] = (PrimIndex)i;
+    });
+    return true;
+  }
+
+  bool PointSpatialIndex::build(const AttrVector &points, f32 cellSize, const char *posTag) {
+    if (!points.hasProperty(posTag)) return false;
+    auto posView = view<execspace_e::host>({}, points.attr32());
+    const auto offset = points.getPropertyOffset(posTag);
+    return buildImpl(
+        [&posView, offset](size_t i) {
+          auto p = posView.pack(dim_c<3>, offset, (PrimIndex)i);
+          return glm::vec3(p[0], p[1], p[2]);
+        },
+        points.size(), cellSize);
+  }
+  bool PointSpatialIndex::build(const glm::vec3 *positions, size_t numPoints, f32 cellSize) {
+    return buildImpl([positions](size_t i) { return positions[i]; }, numPoints, cellSize);
+  }
+
+  template <typename GetPos>
+  void PointSpatialIndex::radiusSearchImpl(GetPos &&getPos, size_t numQueries, f32 radius,
+                                           NeighborList &ret, bool sortByDistance) const {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    ret._offsets.assign(numQueries + 1, 0);
+    ret._indices.clear();
+    ret._distances.clear();
+    if (numQueries == 0 || numPoints() == 0 || !(radius >= 0.f)) return;
+
+    const f32 r2 = radius * radius;
+    /// @note capped so that cell coordinates offset by it stay within int, see cellCoord
+    const f32 reachf = std::ceil(radius * _invCellSize);
+    const int reach = reachf < 2 * s_max_cell_coord ? (int)reachf : (int)(2 * s_max_cell_coord);
+    /// @note distinct buckets of the cells overlapping the query ball, clamped to the grid
+    auto visit = [&](const glm::vec3 &q, auto &&f) {
+      const auto c = cellCoord(q);
+      const auto lo = glm::max(c - reach, glm::ivec3{0});
+      const auto hi = glm::min(c + reach, _numCells - 1);
+      auto &buckets = local_bucket_scratch();
+      buckets.clear();
+      for (int x = lo.x; x <= hi.x; ++x)
+        for (int y = lo.y; y <= hi.y; ++y)
+          for (int z = lo.z; z <= hi.z; ++z) buckets.push_back(bucketIndex(glm::ivec3{x, y, z}));
+      std::sort(buckets.begin(), buckets.end());
+      buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+      for (auto b : buckets)
+        scanBucket(b, [&](PrimIndex id, const glm::vec3 &p) {
+          const auto d = p - q;
+          if (auto d2 = glm::dot(d, d); d2 <= r2) f(id, d2);
+        });
+    };
+
+    // count
+    std::vector<size_t> counts(numQueries + 1, 0);
+    pol(range(numQueries), [&](size_t i) {
+      size_t cnt = 0;
+      visit(getPos(i), [&cnt](PrimIndex, f32) { cnt++; });
+      counts[i] = cnt;
+    });
+    // scan
+    exclusive_scan(pol, zs::begin(counts), zs::end(counts), zs::begin(ret._offsets));
+    // fill
+    const auto total = ret._offsets.back();
+    ret._indices.resize(total);
+    ret._distances.resize(total);
+    pol(range(numQueries), [&](size_t i) {
+      auto dst = ret._offsets[i];
+      visit(getPos(i), [&](PrimIndex id, f32 d2) {
+        ret._indices[dst] = id;
+        ret._distances[dst++] = std::sqrt(d2);
+      });
+      if (sortByDistance) {
+        auto &heap = local_heap_scratch();
+        heap.clear();
+        for (auto j = ret._offsets[i]; j != dst; ++j)
+          heap.emplace_back(ret._distances[j], ret._indices[j]);
+        std::sort(heap.begin(), heap.end());
+        for (size_t j = 0; j != heap.size(); ++j) {
+          ret._distances[ret._offsets[i] + j] = heap[j].first;
+          ret._indices[ret._offsets[i] + j] = heap[j].second;
+        }
+      }
+    });
+  }
+
+  template <typename GetPos>
+  void PointSpatialIndex::knnSearchImpl(GetPos &&getPos, size_t numQueries, int k,
+                                        NeighborList &ret) const {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    ret._offsets.assign(numQueries + 1, 0);
+    ret._indices.clear();
+    ret._distances.clear();
+    if (numQueries == 0 || numPoints() == 0 || k <= 0) return;
+
+    /// @note every query finds exactly kk neighbors, as all cells get visited eventually
+    const size_t kk = std::min((size_t)k, numPoints());
+    pol(range(numQueries + 1), [&](size_t i) { ret._offsets[i] = i * kk; });
+    ret._indices.resize(numQueries * kk);
+    ret._distances.resize(numQueries * kk);
+
+    pol(range(numQueries), [&](size_t i) {
+      const auto q = getPos(i);
+      /// @note queries outside the grid start from the nearest cell within
+      const auto c = glm::clamp(cellCoord(q), glm::ivec3{0}, _numCells - 1);
+      int maxRing = 0;
+      for (int d = 0; d != 3; ++d)
+        maxRing = std::max(maxRing, std::max(c[d], _numCells[d] - 1 - c[d]));
+      /// @note squared distance from the query to the unvisited cells once rings [0, r) are
+      /// visited, i.e. to the nearest of the (up to 6) grid slabs around the visited block
+      const f32 slack = 1e-4f * _cellSize;  // for the rounding of the cell assignment
+      auto unvisitedDistance2 = [&](int r) {
+        f32 ret = detail::deduce_numeric_max<f32>();
+        for (int d = 0; d != 3; ++d)
+          for (int side = 0; side != 2; ++side) {
+            glm::ivec3 lo{0}, hi = _numCells;  // in cells, [lo, hi)
+            if (side == 0) {
+              hi[d] = c[d] - r + 1;
+              if (hi[d] <= 0) continue;
+            } else {
+              lo[d] = c[d] + r;
+              if (lo[d] >= _numCells[d]) continue;
+            }
+            f32 d2 = 0.f;
+            for (int e = 0; e != 3; ++e) {
+              const f32 l = _origin[e] + lo[e] * _cellSize - slack;
+              const f32 h = _origin[e] + hi[e] * _cellSize + slack;
+              const f32 t = q[e] < l ? l - q[e] : (q[e] > h ? q[e] - h : 0.f);
+              d2 += t * t;
+            }
+            ret = std::min(ret, d2);
+          }
+        return ret;
+      };
+
+      /// max-heap of the best candidates so far
+      auto &heap = local_heap_scratch();
+      heap.clear();
+      auto consider = [&](PrimIndex id, const glm::vec3 &p) {
+        const auto d = p - q;
+        const f32 d2 = glm::dot(d, d);
+        if (heap.size() == kk && d2 >= heap.front().first) return;
+        if (heap.size() == kk) {
+          std::pop_heap(heap.begin(), heap.end());
+          heap.pop_back();
+        }
+        heap.emplace_back(d2, id);
+        std::push_heap(heap.begin(), heap.end());
+      };
+      /// @note cells colliding in one bucket are all covered by its first scan, thus the
+      /// bucket is scanned once per query and no point is considered twice
+      auto &visited = local_visited_scratch();
+      visited.clear();
+      auto visitCell = [&](const glm::ivec3 &cell) {
+        for (int d = 0; d != 3; ++d)
+          if (cell[d] < 0 || cell[d] >= _numCells[d]) return;
+        if (const auto b = bucketIndex(cell); visited.insert(b)) scanBucket(b, consider);
+      };
+
+      for (int r = 0; r <= maxRing; ++r) {
+        /// @note unvisited points lie beyond ring r - 1, which also accounts for the distance
+        /// of queries outside the grid
+        if (heap.size() == kk && r > 0 && heap.front().first <= unvisitedDistance2(r)) break;
+        if (r == 0) {
+          visitCell(c);
+          continue;
+        }
+        for (int dx = -r; dx <= r; ++dx)
+          for (int dy = -r; dy <= r; ++dy) {
+            if (std::abs(dx) == r || std::abs(dy) == r) {
+              for (int dz = -r; dz <= r; ++dz) visitCell(c + glm::ivec3{dx, dy, dz});
+            } else {
+              visitCell(c + glm::ivec3{dx, dy, -r});
+              visitCell(c + glm::ivec3{dx, dy, r});
+            }
+          }
+      }
+
+      std::sort_heap(heap.begin(), heap.end());
+      const auto base = i * kk;
+      for (size_t j = 0; j != heap.size(); ++j) {
+        ret._distances[base + j] = std::sqrt(heap[j].first);
+        ret._indices[base + j] = heap[j].second;
+      }
+    });
+  }
+
+  void PointSpatialIndex::radiusSearch(const glm::vec3 *queries, size_t numQueries, f32 radius,
+                                       NeighborList &ret, bool sortByDistance) const {
+    radiusSearchImpl([queries](size_t i) { return queries[i]; }, numQueries, radius, ret,
+                     sortByDistance);
+  }
+  void PointSpatialIndex::radiusSearch(const AttrVector &queries, f32 radius, NeighborList &ret,
+                                       bool sortByDistance, const char *posTag) const {
+    if (!queries.hasProperty(posTag)) {
+      radiusSearchImpl([](size_t) { return glm::vec3{}; }, 0, radius, ret, sortByDistance);
+      return;
+    }
+    auto posView = view<execspace_e::host>({}, queries.attr32());
+    const auto offset = queries.getPropertyOffset(posTag);
+    radiusSearchImpl(
+        [&posView, offset](size_t i) {
+          auto p = posView.pack(dim_c<3>, offset, (PrimIndex)i);
+          return glm::vec3(p[0], p[1], p[2]);
+        },
+        queries.size(), radius, ret, sortByDistance);
+  }
+  void PointSpatialIndex::knnSearch(const glm::vec3 *queries, size_t numQueries, int k,
+                                    NeighborList &ret) const {
+    knnSearchImpl([queries](size_t i) { return queries[i]; }, numQueries, k, ret);
+  }
+  void PointSpatialIndex::knnSearch(const AttrVector &queries, int k, NeighborList &ret,
+                                    const char *posTag) const {
+    if (!queries.hasProperty(posTag)) {
+      knnSearchImpl([](size_t) { return glm::vec3{}; }, 0, k, ret);
+      return;
+    }
+    auto posView = view<execspace_e::host>({}, queries.attr32());
+    const auto offset = queries.getPropertyOffset(posTag);
+    knnSearchImpl(
+        [&posView, offset](size_t i) {
+          auto p = posView.pack(dim_c<3>, offset, (PrimIndex)i);
+          return glm::vec3(p[0], p[1], p[2]);
+        },
+        queries.size(), k, ret);
+  }
+
+}  // namespace zs
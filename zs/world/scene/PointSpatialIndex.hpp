@@ -0,0 +1,91 @@
+#pragma once
+#include "../WorldExport.hpp"
+#include "Primitive.hpp"
+
+namespace zs {
+
+  /// @brief query results in compressed sparse row form
+  /// @note neighbors of query i are _indices[_offsets[i], _offsets[i + 1])
+  struct NeighborList {
+    size_t numQueries() const noexcept { return _offsets.size() ? _offsets.size() - 1 : 0; }
+    size_t numNeighbors(size_t i) const noexcept { return _offsets[i + 1] - _offsets[i]; }
+    size_t size() const noexcept { return _indices.size(); }
+
+    std::vector<size_t> _offsets;
+    std::vector<PrimIndex> _indices;  // into the indexed points
+    std::vector<f32> _distances;
+  };
+
+  /// @brief spatially hashed uniform grid over the positions of a point set
+  /// @note points are reordered (counting sort) by bucket so that each cell is scanned
+  /// contiguously, cells colliding in the same bucket are told apart by exact distance tests
+  /// @note built and queried in parallel, queries are read-only thus may run concurrently
+  struct ZS_WORLD_EXPORT PointSpatialIndex {
+    /// @brief index [posTag] of [points]
+    /// @note [cellSize] of 0 picks one that holds a few points per cell on average, radius
+    /// queries are the most efficient with a cell size close to the radius
+    /// @note fails for more than s_max_points points, i.e. INT32_MAX with 32-bit PrimIndex and
+    /// UINT32_MAX (the reach of the 32-bit bucket offsets) with 64-bit PrimIndex
+    bool build(const AttrVector& points, f32 cellSize = 0.f, const char* posTag = ATTRIB_POS_TAG);
+    bool build(const glm::vec3* positions, size_t numPoints, f32 cellSize = 0.f);
+
+    /// @brief all indexed points within [radius] of each query
+    /// @note [sortByDistance] orders each neighborhood by ascending distance
+    void radiusSearch(const glm::vec3* queries, size_t numQueries, f32 radius, NeighborList& ret,
+                      bool sortByDistance = false) const;
+    void radiusSearch(const AttrVector& queries, f32 radius, NeighborList& ret,
+                      bool sortByDistance = false, const char* posTag = ATTRIB_POS_TAG) const;
+    /// @brief the [k] nearest indexed points of each query, in ascending order of distance
+    /// @note fewer than [k] are returned only if fewer points are indexed
+    void knnSearch(const glm::vec3* queries, size_t numQueries, int k, NeighborList& ret) const;
+    void knnSearch(const AttrVector& queries, int k, NeighborList& ret,
+                   const char* posTag = ATTRIB_POS_TAG) const;
+
+    static constexpr size_t s_max_points = std::min<size_t>(
+        detail::deduce_numeric_max<PrimIndex>(), detail::deduce_numeric_max<u32>());
+
+    size_t numPoints() const noexcept { return _sortedIds.size(); }
+    f32 getCellSize() const noexcept { return _cellSize; }
+    void reset() noexcept;
+
+  protected:
+    /// @note [getPos] maps an index to a position, either read from an array or an AttrVector
+    template <typename GetPos> bool buildImpl(GetPos&& getPos, size_t numPoints, f32 cellSize);
+    template <typename GetPos> void radiusSearchImpl(GetPos&& getPos, size_t numQueries,
+                                                     f32 radius, NeighborList& ret,
+                                                     bool sortByDistance) const;
+    template <typename GetPos>
+    void knnSearchImpl(GetPos&& getPos, size_t numQueries, int k, NeighborList& ret) const;
+
+    /// @note clamped before the conversion to int, as far away (or non-finite) positions would
+    /// overflow it, the bound leaves room for cell offsets up to the grid extents
+    static constexpr f32 s_max_cell_coord = (f32)(1 << 29);
+    glm::ivec3 cellCoord(const glm::vec3& p) const noexcept {
+      const auto c = glm::floor((p - _origin) * _invCellSize);
+      glm::ivec3 ret;
+      for (int d = 0; d != 3; ++d) {
+        const f32 v = c[d] > -s_max_cell_coord ? c[d] : -s_max_cell_coord;
+        ret[d] = (int)(v < s_max_cell_coord ? v : s_max_cell_coord);
+      }
+      return ret;
+    }
+    u32 bucketIndex(const glm::ivec3& c) const noexcept {
+      return (((u32)c.x * 73856093u) ^ ((u32)c.y * 19349663u) ^ ((u32)c.z * 83492791u))
+             & _bucketMask;
+    }
+    template <typename F> void scanBucket(u32 bucket, F&& f) const {
+      for (u32 j = _bucketOffsets[bucket], ed = _bucketOffsets[bucket + 1]; j != ed; ++j)
+        f(_sortedIds[j], _sortedPos[j]);
+    }
+
+    /// @note bucket-ordered
+    std::vector<glm::vec3> _sortedPos;
+    std::vector<PrimIndex> _sortedIds;
+    std::vector<u32> _bucketOffsets;  // numBuckets + 1
+    glm::vec3 _origin{0.f}, _lo{0.f}, _hi{0.f};
+    glm::ivec3 _numCells{0};
+    f32 _cellSize{0.f}, _invCellSize{0.f};
+    u32 _bucketMask{0};
+  };
+
+}  // namespace zs
@@ -1,11 +1,17 @@
 #include "Primitive.hpp"
 
+#include <algorithm>
+#include <numeric>
 // #include <latch>
 
 #include "PrimitiveConversion.hpp"
+#include "PrimitiveBlendShape.hpp"
+#include "PrimitiveInstancing.hpp"
+#include "PrimitiveSkinning.hpp"
 #include "PrimitiveTransform.hpp"
 #include "interface/details/PyHelper.hpp"
 #include "world/World.hpp"
+#include "world/core/MemoryResource.hpp"
 #include "world/system/ResourceSystem.hpp"
 #include "world/system/ZsExecSystem.hpp"
 
@@ -66,10 +72,111 @@ namespace zs {
   ///
   /// PrimitiveDetail
   ///
+  namespace {
+    std::atomic<u64> g_edit_epoch{0};
+    std::atomic<u64> g_hierarchy_epoch{0};
+
+    Mutex g_keyframe_memory_mutex;
+    Shared<TrackedResource> g_keyframe_memory;
+
+    constexpr const char *g_keyframe_channel_labels[PrimitiveDetail::num_keyframe_channels]
+        = {KEYFRAME_ATTRIB_POS_LABEL,     KEYFRAME_ATTRIB_COLOR_LABEL,
+           KEYFRAME_ATTRIB_UV_LABEL,      KEYFRAME_ATTRIB_NORMAL_LABEL,
+           KEYFRAME_ATTRIB_TANGENT_LABEL, KEYFRAME_ATTRIB_FACE_INDEX_LABEL,
+           KEYFRAME_ATTRIB_FACE_LABEL};
+    constexpr PrimitiveDetail::DirtyFlag
+        g_keyframe_channel_flags[PrimitiveDetail::num_keyframe_channels]
+        = {PrimitiveDetail::dirty_Pos,     PrimitiveDetail::dirty_Color,
+           PrimitiveDetail::dirty_UV,      PrimitiveDetail::dirty_Normal,
+           PrimitiveDetail::dirty_Tangent, PrimitiveDetail::dirty_Topo,
+           PrimitiveDetail::dirty_Topo};
+
+    bool is_same_timecode(TimeCode a, TimeCode b) noexcept {
+      return a == b || (std::isnan(a) && std::isnan(b));
+    }
+  }  // namespace
+
+  void PrimitiveDetail::updateTimeVaryingCache() const {
+    auto &cache = _timeVaryingCache;
+    const auto &keyframes = this->keyframes();
+    if (cache._keyframes == &keyframes && cache._revision == keyframes.getRevision()) return;
+
+    const auto &attribKeyFrames = keyframes.refAttribsKeyFrames();
+    DirtyFlag mask = 0;
+    for (int ch = 0; ch != num_keyframe_channels; ++ch) {
+      cache._channels[ch] = nullptr;
+      if (auto it = attribKeyFrames.find(g_keyframe_channel_labels[ch]);
+          it != attribKeyFrames.end() && (*it).second.isTimeDependent()) {
+        cache._channels[ch] = &(*it).second;
+        mask |= g_keyframe_channel_flags[ch];
+      }
+    }
+    if (keyframes.hasSkelAnim()) mask |= dirty_Pos;
+    cache._mask = mask;
+    cache._segmentsValid[0] = cache._segmentsValid[1] = false;
+    cache._positionsBoxValid = false;
+    cache._keyframes = &keyframes;
+    cache._revision = keyframes.getRevision();
+  }
+  void PrimitiveDetail::fetchSegmentIndices(TimeCode tc, int *segmentNos) const {
+    auto &cache = _timeVaryingCache;
+    int slot = 0;
+    for (; slot != 2; ++slot)
+      if (cache._segmentsValid[slot] && is_same_timecode(cache._tcs[slot], tc)) break;
+    if (slot == 2) {
+      /// @note evict the slot not touched most recently
+      slot = cache._lastSlot ^ 1;
+      for (int ch = 0; ch != num_keyframe_channels; ++ch)
+        cache._segmentNos[slot][ch]
+            = cache._channels[ch] ? cache._channels[ch]->getTimeCodeSegmentIndex(tc) : -1;
+      cache._tcs[slot] = tc;
+      cache._segmentsValid[slot] = true;
+    }
+    cache._lastSlot = slot;
+    for (int ch = 0; ch != num_keyframe_channels; ++ch)
+      segmentNos[ch] = cache._segmentNos[slot][ch];
+  }
+  PrimitiveDetail::DirtyFlag PrimitiveDetail::getTimeVaryingMask() const {
+    updateTimeVaryingCache();
+    return _timeVaryingCache._mask;
+  }
+  bool PrimitiveDetail::timelineBoundingBox(PrimitiveBoundingBox &box) const {
+    box = localBoundingBox();
+    if (!(getTimeVaryingMask() & dirty_Pos)) return true;
+    if (keyframes().hasSkelAnim() || skinningBinding() || blendShapes()) return false;
+    auto &cache = _timeVaryingCache;
+    if (!cache._positionsBoxValid) {
+      const auto posFrames = cache._channels[channel_Pos];
+      if (!posFrames) return false;
+      bool empty = true;
+      for (int i = 0; i != posFrames->getNumFrames(); ++i) {
+        auto pos = posFrames->getSegmentFrame(i).lock();
+        if (!pos || !pos->hasProperty(ATTRIB_POS_TAG)) return false;
+        auto posView = view<execspace_e::host>({}, pos->attr32());
+        const auto offset = pos->getPropertyOffset(ATTRIB_POS_TAG);
+        for (PrimIndex j = 0; j != pos->size(); ++j) {
+          glm::vec3 p{posView(offset, j), posView(offset + 1, j), posView(offset + 2, j)};
+          if (empty)
+            cache._positionsBox.init(p);
+          else
+            cache._positionsBox.merge(p);
+          empty = false;
+        }
+      }
+      if (empty) return false;
+      cache._positionsBoxValid = true;
+    }
+    box.merge(cache._positionsBox.minPos);
+    box.merge(cache._positionsBox.maxPos);
+    return true;
+  }
+
   bool PrimitiveDetail::meshRequireUpdate(TimeCode newTc) const {
     auto &keyframes = this->keyframes();
     auto originalTc = getCurrentTimeCode();
-    if (originalTc == newTc || (std::isnan(originalTc) && std::isnan(newTc))) return false;
+    if (is_same_timecode(originalTc, newTc)) return false;
+    /// @note static prims are done here, without touching any keyframe
+    if (getTimeVaryingMask() == 0) return false;
     bool ret = false;
     bool updatePos = false;
 
@@ -79,49 +186,24 @@ namespace zs {
       if (std::isnan(originalTc) != std::isnan(newTc)
           || !((originalTc < skinSt && newTc < skinSt)
                || (originalTc > skinEd && newTc > skinEd))) {
-        // fmt::print("[nan to tc] comparing origin tc: {} to new tc: {}\n",
-        // originalTc, newTc); fmt::print("[skin] comparing origin tc: {} to new
-        // tc: {}\n", originalTc, newTc);
-        const_cast<PrimitiveDetail *>(this)->setPosDirty();  // setDirty(dirty_Pos);
+        /// @note sampling another timecode is no edit, thus the flag is raised directly
+        const_cast<PrimitiveDetail *>(this)->_dirtyFlag |= dirty_Pos;
         updatePos = true;
         ret = true;
       }
     }
 
     /// other attribs
-    auto checkAttribStatus = [&](const auto &keyframe, auto flag) {
-      if (keyframe.isTimeDependent()) {
-        auto originalSegmentNo = keyframe.getTimeCodeSegmentIndex(originalTc);
-        auto newSegmentNo = keyframe.getTimeCodeSegmentIndex(newTc);
-        // fmt::print("comparing attrib [{}] origin segment: {} to new segment:
-        // {}\n", label,
-        //            originalSegmentNo, newSegmentNo);
-        if (originalSegmentNo != newSegmentNo) {
-          const_cast<PrimitiveDetail *>(this)->setDirty(flag);
-          // fmt::print("comparing origin tc: {} to new tc: {}\n", originalTc,
-          // newTc);
-        }
+    int originalSegmentNos[num_keyframe_channels], newSegmentNos[num_keyframe_channels];
+    fetchSegmentIndices(originalTc, originalSegmentNos);
+    fetchSegmentIndices(newTc, newSegmentNos);
+    for (int ch = 0; ch != num_keyframe_channels; ++ch) {
+      if (!_timeVaryingCache._channels[ch] || (ch == channel_Pos && updatePos)) continue;
+      if (originalSegmentNos[ch] != newSegmentNos[ch]) {
+        const_cast<PrimitiveDetail *>(this)->_dirtyFlag |= g_keyframe_channel_flags[ch];
+        ret = true;
       }
-    };
-    const auto &attribKeyFrames = keyframes.refAttribsKeyFrames();
-    if (!updatePos)
-      if (auto it = attribKeyFrames.find(KEYFRAME_ATTRIB_POS_LABEL); it != attribKeyFrames.end())
-        checkAttribStatus((*it).second, dirty_Pos);
-    if (auto it = attribKeyFrames.find(KEYFRAME_ATTRIB_COLOR_LABEL); it != attribKeyFrames.end())
-      checkAttribStatus((*it).second, dirty_Color);
-    if (auto it = attribKeyFrames.find(KEYFRAME_ATTRIB_UV_LABEL); it != attribKeyFrames.end())
-      checkAttribStatus((*it).second, dirty_UV);
-    if (auto it = attribKeyFrames.find(KEYFRAME_ATTRIB_NORMAL_LABEL); it != attribKeyFrames.end())
-      checkAttribStatus((*it).second, dirty_Normal);
-    if (auto it = attribKeyFrames.find(KEYFRAME_ATTRIB_TANGENT_LABEL); it != attribKeyFrames.end())
-      checkAttribStatus((*it).second, dirty_Tangent);
-
-    if (auto it = attribKeyFrames.find(KEYFRAME_ATTRIB_FACE_INDEX_LABEL);
-        it != attribKeyFrames.end())
-      checkAttribStatus((*it).second, dirty_Topo);
-    if (auto it = attribKeyFrames.find(KEYFRAME_ATTRIB_FACE_LABEL); it != attribKeyFrames.end())
-      checkAttribStatus((*it).second, dirty_Topo);
-
+    }
     return ret;
   }
   bool PrimitiveDetail::transformRequireUpdate(TimeCode newTc) const {
@@ -182,6 +264,7 @@ namespace zs {
       auto originalTransform = glm::inverse(originalZpcTransform) * getTransform(tc);
     }
     _transform = m;
+    markModified();
     return;
 #else
     // auto usdPrim = reinterpret_cast<ScenePrimConcept *>(_usdPrim);
@@ -276,6 +359,22 @@ namespace zs {
   void PrimitiveDetail::setDirty(DirtyFlag f) noexcept {
     // zs::atomic_or(exec_omp, &_dirtyFlag, f);
     _dirtyFlag |= f;
+    if (f & ~(DirtyFlag)dirty_TimeCode) {
+      _modifications++;
+      bump_edit_epoch();
+    }
+  }
+  u64 PrimitiveDetail::edit_epoch() noexcept {
+    return g_edit_epoch.load(std::memory_order_acquire);
+  }
+  void PrimitiveDetail::bump_edit_epoch() noexcept {
+    g_edit_epoch.fetch_add(1, std::memory_order_acq_rel);
+  }
+  u64 PrimitiveDetail::hierarchy_epoch() noexcept {
+    return g_hierarchy_epoch.load(std::memory_order_acquire);
+  }
+  void PrimitiveDetail::bump_hierarchy_epoch() noexcept {
+    g_hierarchy_epoch.fetch_add(1, std::memory_order_acq_rel);
   }
   void PrimitiveDetail::unsetDirty(DirtyFlag f) noexcept {
     // zs::atomic_and(exec_omp, &_dirtyFlag, ~f);
@@ -297,19 +396,29 @@ namespace zs {
   ///
   /// PrimitiveStorage
   ///
-  bool PrimitiveStorage::applySkinning(TimeCode tc) {
+  bool PrimitiveStorage::applySkinning(const PrimitiveDetail &srcDetail, TimeCode tc) {
+    const auto &blendShapes = srcDetail.blendShapes();
+    const auto &binding = srcDetail.skinningBinding();
+    if (blendShapes || binding) {
+      bool deformed = blendShapes && apply_blend_shapes(*blendShapes, tc, points());
+      if (binding)
+        deformed = apply_skinning(*binding, tc, points(),
+                                  deformed ? ATTRIB_SKINNING_POS_TAG : ATTRIB_POS_TAG)
+                   || deformed;
+      return deformed;
+    }
 #if ZS_ENABLE_USD
     auto sceneMgr = zs_get_scene_manager(zs_get_world());
-    auto scene = sceneMgr->getScene(details().getUsdSceneName().data());
+    auto scene = sceneMgr->getScene(srcDetail.getUsdSceneName().data());
     if (!scene) return false;
-    auto prim = scene->getPrim(details().getUsdPrimPath().data());
+    auto prim = scene->getPrim(srcDetail.getUsdPrimPath().data());
     return apply_usd_skinning(points(), prim.get(), tc);
 #else
     return false;
 #endif
   }
 
-  void PrimitiveStorage::updatePrimFromKeyFrames(TimeCode tc) {
+  void PrimitiveStorage::updatePrimFromKeyFrames(const PrimKeyFrames &keyframes, TimeCode tc) {
 #if ZS_ENABLE_OPENMP
     auto pol = omp_exec();
     constexpr auto space = execspace_e::openmp;
@@ -325,11 +434,10 @@ namespace zs {
     AttrVector &polys = localPolyPrims()->prims();
     // necessary properties
     points.appendProperties32(pol, ptProps);
-    verts.appendProperties32(pol, vtProps);
-    polys.appendProperties32(pol, polyProps);
+    verts.appendIndexProperties(pol, vtProps);
+    polys.appendIndexProperties(pol, polyProps);
 
     /// position
-    auto &keyframes = details().keyframes();
     const auto &srcPos
         = keyframes.getAttribKeyFrame(KEYFRAME_ATTRIB_POS_LABEL, tc).lock()->attr32();
     points.resize(srcPos.size());
@@ -339,16 +447,16 @@ namespace zs {
         [](auto &dst, auto src) { dst = src; });
     /// verts
     const auto &srcVerts
-        = keyframes.getAttribKeyFrame(KEYFRAME_ATTRIB_FACE_INDEX_LABEL, tc).lock()->attr32();
+        = keyframes.getAttribKeyFrame(KEYFRAME_ATTRIB_FACE_INDEX_LABEL, tc).lock()->attrIndex();
     verts.resize(srcVerts.size());
-    pol(zip(range(verts.attr32(), POINT_ID_TAG, dim_c<1>, prim_id_c),
+    pol(zip(range(verts.attrIndex(), POINT_ID_TAG, dim_c<1>, prim_id_c),
             range(srcVerts, POINT_ID_TAG, dim_c<1>, prim_id_c)),
         [](auto &dst, auto src) { dst = src; });
     /// poly
     auto &polyKeyframe
-        = keyframes.getAttribKeyFrame(KEYFRAME_ATTRIB_FACE_LABEL, tc).lock()->attr32();
+        = keyframes.getAttribKeyFrame(KEYFRAME_ATTRIB_FACE_LABEL, tc).lock()->attrIndex();
     polys.resize(polyKeyframe.size());
-    pol(range(polys.size()), [dstPolys = view<space>({}, polys.attr32()),
+    pol(range(polys.size()), [dstPolys = view<space>({}, polys.attrIndex()),
                               srcPolys = view<space>({}, polyKeyframe)](PrimIndex polyId) mutable {
       dstPolys(POLY_SIZE_TAG, polyId, prim_id_c) = srcPolys(POLY_SIZE_TAG, polyId, prim_id_c);
       dstPolys(POLY_OFFSET_TAG, polyId, prim_id_c) = srcPolys(POLY_OFFSET_TAG, polyId, prim_id_c);
@@ -392,6 +500,148 @@ namespace zs {
                     *keyframes.getAttribKeyFrame(KEYFRAME_ATTRIB_COLOR_LABEL, tc).lock());
   }
 
+  size_t attr_vector_bytes(const AttrVector &attr) noexcept {
+    size_t numChns32 = 0, numChns64 = 0;
+    for (const auto &prop : attr.getProperties()) numChns32 += prop.numChannels;
+    for (const auto &prop : attr.getProperties64()) numChns64 += prop.numChannels;
+    return (size_t)attr.size() * (numChns32 * sizeof(f32) + numChns64 * sizeof(u64));
+  }
+
+  size_t primitive_storage_bytes(const PrimitiveStorage &geom) noexcept {
+    size_t ret = attr_vector_bytes(geom.points()) + attr_vector_bytes(geom.verts());
+    for (const auto &[_, prims] : geom._localPrims)
+      if (auto meshPrims = std::dynamic_pointer_cast<MeshPrimContainer>(prims))
+        ret += attr_vector_bytes(meshPrims->prims());
+    return ret;
+  }
+
+  size_t ZsMeshBundle::bytes() const noexcept {
+    auto meshBytes = [](const auto &mesh) {
+      return mesh.nodes.size() * sizeof(mesh.nodes[0]) + mesh.uvs.size() * sizeof(mesh.uvs[0])
+             + mesh.norms.size() * sizeof(mesh.norms[0])
+             + mesh.colors.size() * sizeof(mesh.colors[0])
+             + mesh.elems.size() * sizeof(mesh.elems[0]);
+    };
+    size_t ret = meshBytes(_triMesh) + meshBytes(_lineMesh) + meshBytes(_pointMesh);
+    if (_geometry) ret += primitive_storage_bytes(*_geometry);
+    return ret;
+  }
+
+  void set_keyframe_memory(Shared<TrackedResource> resource) {
+    std::lock_guard lk(g_keyframe_memory_mutex);
+    g_keyframe_memory = zs::move(resource);
+  }
+  Shared<TrackedResource> get_keyframe_memory() {
+    std::lock_guard lk(g_keyframe_memory_mutex);
+    return g_keyframe_memory;
+  }
+  void place_attrib_keyframe(AttrVector &attrib) {
+    if (auto resource = get_keyframe_memory()) attrib.relocate(resource->allocator());
+  }
+
+  void evaluate_primitive_to_zsmesh(const PrimitiveStorage &src, TimeCode tc,
+                                    PrimitiveStorage &scratch, ZsTriMesh *pTriMesh,
+                                    ZsLineMesh *pLineMesh, ZsPointMesh *pPointMesh) {
+    const auto &keyframes = src.keyframes();
+    scratch.updatePrimFromKeyFrames(keyframes, tc);
+    if (keyframes.hasSkelAnim()) scratch.applySkinning(src.details(), tc);
+
+    setup_simple_mesh_for_poly_mesh(scratch);
+    assign_simple_mesh_to_zsmesh(scratch, pTriMesh, pLineMesh, pPointMesh);
+  }
+  void evaluate_primitive_to_zsmesh(const PrimitiveStorage &src, TimeCode tc,
+                                    ArenaResource &arena, ZsTriMesh *pTriMesh,
+                                    ZsLineMesh *pLineMesh, ZsPointMesh *pPointMesh) {
+    {
+      PrimitiveStorage scratch;
+      relocate_primitive_storage(scratch, arena.allocator());
+      evaluate_primitive_to_zsmesh(src, tc, scratch, pTriMesh, pLineMesh, pPointMesh);
+    }
+    /// @note nothing drawn from the arena is alive past this point
+    arena.release();
+  }
+
+  namespace {
+    u32 expand_morton_bits(u32 v) noexcept {
+      v = (v * 0x00010001u) & 0xFF0000FFu;
+      v = (v * 0x00000101u) & 0x0F00F00Fu;
+      v = (v * 0x00000011u) & 0xC30C30C3u;
+      v = (v * 0x00000005u) & 0x49249249u;
+      return v;
+    }
+    /// @note 10 bits per axis within the box of the mesh
+    void sort_triangles_by_morton_code(ZsTriMesh &mesh) {
+      const auto numTris = mesh.elems.size();
+      if (numTris < 2) return;
+      glm::vec3 lo{detail::deduce_numeric_max<f32>()}, hi{-detail::deduce_numeric_max<f32>()};
+      for (const auto &p : mesh.nodes) {
+        lo = glm::min(lo, glm::vec3{p[0], p[1], p[2]});
+        hi = glm::max(hi, glm::vec3{p[0], p[1], p[2]});
+      }
+      const auto extent = hi - lo;
+      std::vector<u32> codes(numTris);
+      for (size_t i = 0; i != numTris; ++i) {
+        auto tri = mesh.elems[i];
+        u32 code = 0;
+        for (int d = 0; d != 3; ++d) {
+          const f32 c = (mesh.nodes[tri[0]][d] + mesh.nodes[tri[1]][d] + mesh.nodes[tri[2]][d])
+                        / 3.f;
+          const f32 t = extent[d] > 0.f ? (c - lo[d]) / extent[d] : 0.f;
+          code |= expand_morton_bits((u32)zs::min(zs::max(t * 1024.f, 0.f), 1023.f)) << (2 - d);
+        }
+        codes[i] = code;
+      }
+      std::vector<u32> order(numTris);
+      std::iota(order.begin(), order.end(), 0u);
+      std::stable_sort(order.begin(), order.end(),
+                       [&codes](u32 a, u32 b) { return codes[a] < codes[b]; });
+      auto elems = mesh.elems;
+      for (size_t i = 0; i != numTris; ++i) mesh.elems[i] = elems[order[i]];
+    }
+  }  // namespace
+
+  size_t stage_static_meshes(ZsPrimitive &root) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    std::vector<ZsPrimitive *> prims;
+    std::vector<ZsPrimitive *> stack{&root};
+    while (stack.size()) {
+      auto prim = stack.back();
+      stack.pop_back();
+      const auto &keyframes = prim->keyframes();
+      if (keyframes.hasAttrib(KEYFRAME_ATTRIB_POS_LABEL)
+          && keyframes.hasAttrib(KEYFRAME_ATTRIB_FACE_INDEX_LABEL)
+          && keyframes.hasAttrib(KEYFRAME_ATTRIB_FACE_LABEL) && !prim->meshSource()
+          && !prim->details().isMeshTimeVarying())
+        prims.push_back(prim);
+      for (const auto &ch : prim->children()) stack.push_back(ch.get());
+    }
+
+    /// @note what zsMeshAsync does, ahead of time
+    std::atomic<size_t> ret{0};
+    pol(range(prims.size()), [&](size_t i) {
+      auto &prim = *prims[i];
+      const auto tc = g_default_timecode();
+      auto meshes = std::make_shared<ZsMeshBundle>();
+      try {
+        prim.updatePrimFromKeyFrames(tc);
+        setup_simple_mesh_for_poly_mesh(prim);
+        assign_simple_mesh_to_zsmesh(prim, &meshes->_triMesh, &meshes->_lineMesh,
+                                     &meshes->_pointMesh);
+      } catch (const std::exception &e) {
+        fmt::print("staging the meshes of prim [{}] failed. [{}]\n", prim.label(), e.what());
+        return;
+      }
+      sort_triangles_by_morton_code(meshes->_triMesh);
+      prim.details().stageMeshes(tc, zs::move(meshes));
+      ret++;
+    });
+    return ret.load();
+  }
+
   /// @note general mesh -> simple mesh -> visual mesh -> zs (vk) mesh
 
   Shared<ZsPrimitive> &PrimitiveStorage::visualMesh() {
@@ -443,7 +693,61 @@ namespace zs {
   }
   void ZsPrimitive::appendChildPrimitve(ZsPrimitive *prim) {
     prim->_parent = this;
+    _childIndex.insert(prim->label(), (u32)_childs.size());
     _childs.emplace_back(prim);
+    PrimitiveDetail::bump_edit_epoch();
+    PrimitiveDetail::bump_hierarchy_epoch();
+  }
+  void ZsPrimitive::appendChildPrimitve(Shared<ZsPrimitive> prim) {
+    prim->_parent = this;
+    _childIndex.insert(prim->label(), (u32)_childs.size());
+    _childs.emplace_back(zs::move(prim));
+    PrimitiveDetail::bump_edit_epoch();
+    PrimitiveDetail::bump_hierarchy_epoch();
+  }
+  Shared<ZsPrimitive> ZsPrimitive::meshSource() const noexcept {
+    auto source = _meshSource.lock();
+    if (!source) return {};
+    if (keyframes().getRevision() != _meshSourceSelfRevision
+        || source->keyframes().getRevision() != _meshSourceRevision
+        || details().isMeshTimeVarying())
+      return {};
+    return source;
+  }
+  void ZsPrimitive::setMeshSource(Weak<ZsPrimitive> source) noexcept {
+    _meshSource = zs::move(source);
+    if (auto p = _meshSource.lock()) {
+      _meshSourceRevision = p->keyframes().getRevision();
+      _meshSourceSelfRevision = keyframes().getRevision();
+    }
+    PrimitiveDetail::bump_edit_epoch();
+  }
+  void ZsPrimitive::setLabel(std::string label) {
+    if (!_parent) {
+      this->label() = zs::move(label);
+      return;
+    }
+    /// @note only the entries of the old and the new label are touched
+    const auto &siblings = _parent->_childs;
+    auto &index = _parent->_childIndex;
+    u32 pos = 0;
+    if (auto idx = index.find(this->label());
+        idx && *idx < siblings.size() && siblings[*idx].get() == this) {
+      pos = *idx;
+      index.erase(this->label());
+    } else
+      while (pos != siblings.size() && siblings[pos].get() != this) ++pos;
+    this->label() = zs::move(label);
+    /// @note the first child of a duplicated label wins, siblings left without an entry are
+    /// found by the linear fallback of getChild
+    auto idx = index.find(this->label());
+    if (!idx || *idx > pos || *idx >= siblings.size() || siblings[*idx]->label() != this->label())
+      index.insert_or_assign(this->label(), pos);
+  }
+  void ZsPrimitive::reindexChildren() {
+    _childIndex.clear();
+    _childIndex.reserve(_childs.size());
+    for (u32 i = 0; i != _childs.size(); ++i) _childIndex.insert(_childs[i]->label(), i);
   }
 
   VkModel &ZsPrimitive::vkTriMesh(VulkanContext &ctx) {
@@ -466,6 +770,17 @@ namespace zs {
     co_return ret;
   }
   zs::Future<void> ZsPrimitive::zsMeshAsync(TimeCode tc) {
+    /// @note meshes evaluated ahead of time (e.g. by TimelinePrefetcher)
+    auto staged = details().takeStagedMeshes(tc);
+    if (!staged)
+      if (auto provider = meshProvider()) staged = provider->takeMeshes(*this, tc);
+    if (staged) {
+      if (staged->_geometry) assignGeometry(zs::move(*staged->_geometry));
+      details().triMesh() = zs::move(staged->_triMesh);
+      details().lineMesh() = zs::move(staged->_lineMesh);
+      details().pointMesh() = zs::move(staged->_pointMesh);
+      co_return;
+    }
     updatePrimFromKeyFrames(tc);
     if (keyframes().hasSkelAnim()) applySkinning(tc);
 
@@ -475,44 +790,93 @@ namespace zs {
     co_return;
   }
 
-  zs::Future<void> ZsPrimitive::vkTriMeshAsync(VulkanContext &ctx, TimeCode tc) {
-    zs_resources().inc_inflight_prim_cnt();
+  f32 bvh_sah_cost(const PrimBvh &bvh) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    const size_t numNodes = bvh.getNumNodes();
+    if (numNodes == 0) return 0.f;
+    auto area = [](const AABBBox<3, f32> &bv) {
+      const f32 dx = bv._max[0] - bv._min[0], dy = bv._max[1] - bv._min[1],
+                dz = bv._max[2] - bv._min[2];
+      return 2.f * (dx * dy + dy * dz + dz * dx);
+    };
+    const f32 rootArea = area(bvh.getTotalBox(pol));
+    if (!(rootArea > 0.f)) return 0.f;
+
+    /// @note reduced per chunk
+    constexpr size_t chunkSize = (size_t)1 << 12;
+    const size_t numChunks = (numNodes + chunkSize - 1) / chunkSize;
+    std::vector<f64> partials(numChunks);
+    pol(range(numChunks), [&](size_t c) {
+      f64 sum = 0;
+      for (size_t i = c * chunkSize, ed = std::min(numNodes, (c + 1) * chunkSize); i < ed; ++i)
+        sum += area(bvh.orderedBvs[i]);
+      partials[c] = sum;
+    });
+    f64 total = 0;
+    for (auto v : partials) total += v;
+    return (f32)(total / rootArea);
+  }
 
-    co_await schedule_on(ZS_TASK_SCHEDULER(), zsMeshAsync(tc));
+  void ZsPrimitive::updateTriBvh(bool rebuild) {
     auto &triMesh = details().triMesh();
-
-    /// @brief acceleration structure maintenance (including total box)
-    if (details().isShapeDirty()) {
+    if (triMesh.elems.size() == 0) return;
 #if ZS_ENABLE_OPENMP
-      auto pol = omp_exec();
+    auto pol = omp_exec();
 #else
-      auto pol = seq_exec();
+    auto pol = seq_exec();
 #endif
-      Vector<AABBBox<3, f32>> bvs{triMesh.elems.size()};
-      pol(enumerate(bvs), [&triMesh](int ei, auto &bv) {
-        auto tri = triMesh.elems[ei];
-        const auto &poses = triMesh.nodes;
-        auto mi = zs::vec<f32, 3>{
-            zs::min(zs::min(poses[tri[0]][0], poses[tri[1]][0]), poses[tri[2]][0]),
-            zs::min(zs::min(poses[tri[0]][1], poses[tri[1]][1]), poses[tri[2]][1]),
-            zs::min(zs::min(poses[tri[0]][2], poses[tri[1]][2]), poses[tri[2]][2])};
-        auto ma = zs::vec<f32, 3>{
-            zs::max(zs::max(poses[tri[0]][0], poses[tri[1]][0]), poses[tri[2]][0]),
-            zs::max(zs::max(poses[tri[0]][1], poses[tri[1]][1]), poses[tri[2]][1]),
-            zs::max(zs::max(poses[tri[0]][2], poses[tri[1]][2]), poses[tri[2]][2])};
-        bv = AABBBox<3, f32>{mi, ma};
-      });
-      auto &bvh = details().triBvh();
-      if (details().isTopoDirty()) {
+    Vector<AABBBox<3, f32>> bvs{triMesh.elems.size()};
+    pol(enumerate(bvs), [&triMesh](PrimIndex ei, auto &bv) {
+      auto tri = triMesh.elems[ei];
+      const auto &poses = triMesh.nodes;
+      auto mi = zs::vec<f32, 3>{
+          zs::min(zs::min(poses[tri[0]][0], poses[tri[1]][0]), poses[tri[2]][0]),
+          zs::min(zs::min(poses[tri[0]][1], poses[tri[1]][1]), poses[tri[2]][1]),
+          zs::min(zs::min(poses[tri[0]][2], poses[tri[1]][2]), poses[tri[2]][2])};
+      auto ma = zs::vec<f32, 3>{
+          zs::max(zs::max(poses[tri[0]][0], poses[tri[1]][0]), poses[tri[2]][0]),
+          zs::max(zs::max(poses[tri[0]][1], poses[tri[1]][1]), poses[tri[2]][1]),
+          zs::max(zs::max(poses[tri[0]][2], poses[tri[1]][2]), poses[tri[2]][2])};
+      bv = AABBBox<3, f32>{mi, ma};
+    });
+    auto &bvh = details().triBvh();
+    auto &quality = details().triBvhQuality();
+    if (rebuild) {
+      bvh.buildRefit(pol, bvs);
+      quality.onBuild(bvh_sah_cost(bvh));
+    } else {  // positions changed only
+      bvh.refit(pol, bvs);
+      quality.onRefit(bvh_sah_cost(bvh));
+      /// @note the rebuild is synchronous and in place, just like the refit above, so queries on
+      /// triBvh() must not overlap the mesh update of this prim (it is marked processing then)
+      if (quality.requiresRebuild()) {
         bvh.buildRefit(pol, bvs);
-      } else {  // isDirty(dirty_Pos) == true
-        bvh.refit(pol, bvs);
+        quality.onBuild(bvh_sah_cost(bvh));
+        quality._numRebuilds++;
       }
-      auto rootBv = bvh.getTotalBox(pol);
-      details().localBoundingBox()
-          = PrimitiveBoundingBox{glm::vec3{rootBv._min[0], rootBv._min[1], rootBv._min[2]},
-                                 glm::vec3{rootBv._max[0], rootBv._max[1], rootBv._max[2]}};
     }
+    /// @note the scene bvh picks up the new leaves and box
+    PrimitiveDetail::bump_edit_epoch();
+    /// @note instancing prims also enclose their instances
+    if (update_instanced_bounding_box(*this)) return;
+    auto rootBv = bvh.getTotalBox(pol);
+    details().localBoundingBox()
+        = PrimitiveBoundingBox{glm::vec3{rootBv._min[0], rootBv._min[1], rootBv._min[2]},
+                               glm::vec3{rootBv._max[0], rootBv._max[1], rootBv._max[2]}};
+  }
+
+  zs::Future<void> ZsPrimitive::vkTriMeshAsync(VulkanContext &ctx, TimeCode tc) {
+    zs_resources().inc_inflight_prim_cnt();
+
+    co_await schedule_on(ZS_TASK_SCHEDULER(), zsMeshAsync(tc));
+    auto &triMesh = details().triMesh();
+
+    /// @brief acceleration structure maintenance (including total box)
+    if (details().isShapeDirty()) updateTriBvh(details().isTopoDirty());
 
     VkModel &ret = details().vkTriMesh();
     // for batch processing later
@@ -587,6 +951,7 @@ namespace zs {
   }
 
   ZsPrimitive *ZsPrimitive::queryVisualMesh(TimeCode tc) {
+    if (auto source = meshSource()) return source->queryVisualMesh(tc);
     if (_visualMeshAsync.isDone()) {
       try {
         return _visualMeshAsync.ref().get();
@@ -601,6 +966,7 @@ namespace zs {
     return nullptr;
   }
   ZsTriMesh *ZsPrimitive::queryTriMesh(TimeCode tc) {
+    if (auto source = meshSource()) return source->queryTriMesh(tc);
     if (_zsMeshAsync.isDone()) {
       try {
         return &details().triMesh();
@@ -615,9 +981,12 @@ namespace zs {
     return nullptr;
   }
   VkModel *ZsPrimitive::queryVkTriMesh(VulkanContext &ctx, TimeCode tc) {
+    /// @note the gpu mesh is uploaded once for all prims sharing it
+    if (auto source = meshSource()) return source->queryVkTriMesh(ctx, tc);
     if (isStatusIdle()) {
       try {
-        bool tcNeedUpd = details().meshRequireUpdate(tc);
+        /// @note off-screen prims keep their last mesh until they become visible again
+        bool tcNeedUpd = !details().isCulled() && details().meshRequireUpdate(tc);
         if (!_vkTriMeshAsync.getHandle() || tcNeedUpd) {
           markStatusProcessing();
           if (tcNeedUpd) details().setTimeCodeDirty();
@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
 #include <deque>
 #include <set>
 
@@ -7,6 +9,7 @@
 #include "../async/Coro.hpp"
 #include "Timeline.hpp"
 #include "world/core/Concepts.hpp"
+#include "world/core/HashIndex.hpp"
 #include "world/core/Serialization.hpp"
 #include "world/core/Signal.hpp"
 #include "zensim/container/Bvh.hpp"
@@ -17,10 +20,18 @@
 
 namespace zs {
 
+  /// @note ZS_WORLD_ENABLE_64BIT_INDEX lifts the 2^31 cap on points, verts and prims, at the
+  /// cost of twice the index storage and bandwidth
+  /// @note experimental, this mode has not been built and exercised end to end yet
+#if ZS_WORLD_ENABLE_64BIT_INDEX
+  using PrimIndex = i64;
+#else
   using PrimIndex = i32;
+#endif
   using PrimTypeIndex = i32;
 
   constexpr auto prim_id_c = wrapt<PrimIndex>{};
+  constexpr bool g_wide_prim_index = sizeof(PrimIndex) == sizeof(u64);
 
 /**
  * @brief reserved prefix
@@ -28,6 +39,8 @@ namespace zs {
  * @note __i: entry reinterpreted as int
  * @note __u: entry reinterpreted as unsigned int
  * @note zs_: indication of a preserved keyword
+ * @note the index channels below (ELEM_VERT_ID_TAG etc.) hold PrimIndex entries and live in
+ * AttrVector::attrIndex(), i.e. [attr64] in the 64-bit index mode
  */
 
 /// @note used in [verts]
@@ -43,6 +56,7 @@ namespace zs {
 #define ATTRIB_POS_TAG "zs_pos"
 #define ATTRIB_SKINNING_POS_TAG "zs_pos_skinning"
 #define ATTRIB_NORMAL_TAG "zs_nrm"
+#define ATTRIB_SKINNING_NORMAL_TAG "zs_nrm_skinning"
 #define ATTRIB_COLOR_TAG "zs_clr"
 #define ATTRIB_TANGENT_TAG "zs_tan"
 #define ATTRIB_TEXTURE_ID_TAG "__i_zs_texid"
@@ -75,7 +89,7 @@ namespace zs {
   /// group
   template <Container ContainerT> struct GeoGroup {
     static_assert(is_same_v<typename ContainerT::value_type, PrimIndex>,
-                  "container value_type should be the same as PrimIndex (i.e. int)");
+                  "container value_type should be the same as PrimIndex");
     ContainerT _ids;
   };
 
@@ -84,8 +98,10 @@ namespace zs {
 
   struct ZS_WORLD_EXPORT AttrVector {
     using size_type = TileVector<f32>::size_type;
+    using allocator_type = TileVector<f32>::allocator_type;
     // query
     size_type size() const noexcept { return _attr32.size(); }
+    const allocator_type& get_allocator() const noexcept { return _attr32.get_allocator(); }
     // modifiers
     template <typename Policy>
     void appendProperties32(Policy&& pol, const std::vector<PropertyTag>& tags,
@@ -105,6 +121,15 @@ namespace zs {
       resize(0);
       _strings.clear();
     }
+    /// @brief append index channels (ELEM_VERT_ID_TAG, POINT_ID_TAG, etc.) to attrIndex()
+    template <typename Policy>
+    void appendIndexProperties(Policy&& pol, const std::vector<PropertyTag>& tags,
+                               const source_location& loc = source_location::current()) {
+      attrIndex().append_channels(pol, tags, loc);
+    }
+    /// @brief move the tile storage onto [allocator] (e.g. FileBackedResource::allocator()),
+    /// later (re)allocations upon resize or new channels are served from it as well
+    inline void relocate(const allocator_type& allocator);
     // lookup
     auto& attr32() noexcept { return _attr32; }
     auto& attr64() noexcept { return _attr64; }
@@ -112,6 +137,19 @@ namespace zs {
     const auto& attr32() const noexcept { return _attr32; }
     const auto& attr64() const noexcept { return _attr64; }
     const auto& strings() const noexcept { return _strings; }
+    /// @brief the tile vector of the index channels, accessed through prim_id_c
+    auto& attrIndex() noexcept {
+      if constexpr (g_wide_prim_index)
+        return _attr64;
+      else
+        return _attr32;
+    }
+    const auto& attrIndex() const noexcept {
+      if constexpr (g_wide_prim_index)
+        return _attr64;
+      else
+        return _attr32;
+    }
     bool hasProperty(const SmallString& tag) const { return _attr32.hasProperty(tag); }
     bool hasProperty64(const SmallString& tag) const { return _attr64.hasProperty(tag); }
     auto getPropertyOffset(const SmallString& tag) const { return _attr32.getPropertyOffset(tag); }
@@ -120,6 +158,10 @@ namespace zs {
     }
     auto getPropertySize(const SmallString& tag) const { return _attr32.getPropertySize(tag); }
     auto getPropertySize64(const SmallString& tag) const { return _attr64.getPropertySize(tag); }
+    bool hasIndexProperty(const SmallString& tag) const { return attrIndex().hasProperty(tag); }
+    auto getIndexPropertyOffset(const SmallString& tag) const {
+      return attrIndex().getPropertyOffset(tag);
+    }
     auto getProperties() const { return _attr32.getPropertyTags(); }
     auto getProperties64() const { return _attr64.getPropertyTags(); }
 
@@ -132,8 +174,48 @@ namespace zs {
     prim_attrib_owner_e _owner{prim_attrib_owner_e::prim};
   };
 
+  /// @brief append [attr] to [buffer] as independently coded chunks of up to 64K values per
+  /// channel, located through a table of 64-bit offsets (not capped by the bitsery size limit)
+  /// @note chunks are gathered (and coded if [compress], the same way as primitive cache
+  /// columns) in parallel (OpenMP), then stitched in parallel
+  ZS_WORLD_EXPORT bool serialize_attr_vector(const AttrVector& attr, SerializationBuffer& buffer,
+                                             bool compress = false);
+  /// @brief read back what serialize_attr_vector wrote, decoding chunks in parallel
+  /// @note [attr] is left untouched upon failure
+  ZS_WORLD_EXPORT bool deserialize_attr_vector(const void* data, size_t bytes, AttrVector& attr);
+
 #if ZS_ENABLE_SERIALIZATION
+  /// @note attribute vectors of more entries than this are archived as one serialize_attr_vector
+  /// blob, so that they are neither capped by g_max_serialization_size_limit nor gathered by a
+  /// single thread
+  constexpr size_t g_chunked_attr_vector_size = (size_t)1 << 16;
+  /// @note the blob is read in pieces of this size, so that a corrupted length fails on the
+  /// input bounds instead of allocating upfront
+  constexpr size_t g_attr_vector_blob_piece = (size_t)1 << 26;
+
   template <typename S> void serialize(S& s, AttrVector& attrVector) {
+    u8 chunked = 0;
+    SerializationBuffer blob;
+    if constexpr (!is_bitsery_deserializer_v<S>)
+      if (attrVector.size() > g_chunked_attr_vector_size)
+        chunked = serialize_attr_vector(attrVector, blob) ? 1 : 0;
+    s.value1b(chunked);
+    if (chunked) {
+      u64 numBytes = blob.size();
+      s.value8b(numBytes);
+      if constexpr (is_bitsery_deserializer_v<S>) {
+        for (u64 offset = 0; offset < numBytes; offset += g_attr_vector_blob_piece) {
+          const auto piece = std::min<u64>(g_attr_vector_blob_piece, numBytes - offset);
+          blob.resize(offset + piece);
+          s.adapter().template readBuffer<1>(blob.data() + offset, piece);
+          if (s.adapter().error() != bitsery::ReaderError::NoError) return;
+        }
+        if (!deserialize_attr_vector(blob.data(), blob.size(), attrVector))
+          s.adapter().error(bitsery::ReaderError::InvalidData);
+      } else
+        s.adapter().template writeBuffer<1>(blob.data(), blob.size());
+      return;
+    }
     serialize(s, attrVector.attr32());
     serialize(s, attrVector.attr64());
     s.container(attrVector._strings, g_max_serialization_size_limit, [](S& s, String& string) {
@@ -251,6 +333,10 @@ namespace zs {
     Weak<Value> getByTimeCode(TimeCode tc) const {
       return getSegmentFrame(getTimeCodeSegmentIndex(tc));
     }
+    /// @brief the frame in effect at [tc] for in-place modification
+    /// @note a frame also held elsewhere (e.g. by another prim, see share_duplicate_meshes) is
+    /// copied first, frames obtained through getByTimeCode must not be modified in place
+    inline Shared<Value> getWritableByTimeCode(TimeCode tc);
 
     template <typename Float, typename T = Value,
               typename Ret = decltype((declval<T>() + declval<T>()) * (Float)0.5)>
@@ -286,14 +372,43 @@ namespace zs {
     keyframes.refDirty() = false;
   }
 #endif
+  struct TrackedResource;
+  /// @brief resource attrib keyframes are placed upon as they are emplaced or loaded from the
+  /// primitive cache, e.g. a FileBackedResource for scenes exceeding RAM
+  /// @note null (the default) keeps them on the default host allocator
+  ZS_WORLD_EXPORT void set_keyframe_memory(Shared<TrackedResource> resource);
+  ZS_WORLD_EXPORT Shared<TrackedResource> get_keyframe_memory();
+  /// @brief move [attrib] onto get_keyframe_memory() if set
+  ZS_WORLD_EXPORT void place_attrib_keyframe(AttrVector& attrib);
+
   struct PrimKeyFrames {
+    PrimKeyFrames() = default;
+    PrimKeyFrames(PrimKeyFrames&&) noexcept = default;
+    /// @note the revision keeps increasing, so that caches keyed on this object (see
+    /// PrimitiveDetail::TimeVaryingCache) notice the new content
+    PrimKeyFrames& operator=(PrimKeyFrames&& o) noexcept {
+      const auto revision = zs::max(_revision, o._revision) + 1;
+      _attribs = zs::move(o._attribs);
+      _visibility = zs::move(o._visibility);
+      _transform = zs::move(o._transform);
+      _globalTimeCodes = zs::move(o._globalTimeCodes);
+      _skelStartTimeCode = zs::move(o._skelStartTimeCode);
+      _skelEndTimeCode = zs::move(o._skelEndTimeCode);
+      _revision = revision;
+      return *this;
+    }
+
     /// @brief key frame insertion
 
     // bool emplacePrimKeyFrame(TimeCode tc, ZsPrimitive* prim) { return _prims.emplace(tc, prim); }
     bool emplaceAttribKeyFrame(const std::string& label, TimeCode tc, AttrVector&& attrib) {
+      _revision++;
+      place_attrib_keyframe(attrib);
       return _attribs[label].emplace(tc, zs::move(attrib));
     }
     bool emplaceAttribDefault(const std::string& label, AttrVector&& attrib) {
+      _revision++;
+      place_attrib_keyframe(attrib);
       return _attribs[label].emplace(zs::move(attrib));
     }
     bool emplaceVisibilityKeyFrame(TimeCode tc, bool v) { return _visibility.emplace(tc, v); }
@@ -316,6 +431,11 @@ namespace zs {
       // return const_cast<PrimKeyFrames*>(this)->_attribs[label].getByTimeCode(tc);
       return _attribs.at(label).getByTimeCode(tc);
     }
+    /// @brief copy-on-write access to an attrib keyframe, see KeyFrames::getWritableByTimeCode
+    Shared<AttrVector> getWritableAttribKeyFrame(const std::string& label, TimeCode tc) {
+      _revision++;
+      return _attribs.at(label).getWritableByTimeCode(tc);
+    }
     Weak<bool> getVisibilityKeyFrame(TimeCode tc) { return _visibility.getByTimeCode(tc); }
 
     /// @brief timecodes query
@@ -341,19 +461,19 @@ namespace zs {
     inline bool queryStartEndTimeCodes(TimeCode& start, TimeCode& end) const noexcept;
     bool hasAttrib(const std::string& label) const { return _attribs.contains(label); }
 
-    int getNumPoints(TimeCode tc) const {
+    PrimIndex getNumPoints(TimeCode tc) const {
       auto ptsPtr = getAttribKeyFrame(KEYFRAME_ATTRIB_POS_LABEL, tc);
       if (ptsPtr.expired()) return 0;
       if (auto p = ptsPtr.lock()) return p->size();
       return 0;
     }
-    int getNumVerts(TimeCode tc) const {
+    PrimIndex getNumVerts(TimeCode tc) const {
       auto vertPtr = getAttribKeyFrame(KEYFRAME_ATTRIB_FACE_INDEX_LABEL, tc);
       if (vertPtr.expired()) return 0;
       if (auto p = vertPtr.lock()) return p->size();
       return 0;
     }
-    int getNumFaces(TimeCode tc) const {
+    PrimIndex getNumFaces(TimeCode tc) const {
       auto facePtr = getAttribKeyFrame(KEYFRAME_ATTRIB_FACE_LABEL, tc);
       if (facePtr.expired()) return 0;
       if (auto p = facePtr.lock()) return p->size();
@@ -363,6 +483,7 @@ namespace zs {
     void setSkelAnimTimeCodeInterval(TimeCode st, TimeCode ed) noexcept {
       _skelStartTimeCode = st;
       _skelEndTimeCode = ed;
+      _revision++;
     }
     auto getSkelAnimTimeCodeInterval() const noexcept {
       if (hasSkelAnim())
@@ -393,6 +514,18 @@ namespace zs {
     const auto& refTransformKeyFrames() const noexcept { return _transform; }
     const auto& refGlobalTimeCodes() const noexcept { return _globalTimeCodes; }
 
+    /// @brief bumped whenever attrib keyframes (or skeleton animation) are inserted
+    /// @note direct modifications to [_attribs] should call markModified() accordingly
+    u64 getRevision() const noexcept { return _revision; }
+    void markModified() noexcept { _revision++; }
+
+    /// @brief eagerly refresh the lazily ordered keyframe sequences
+    /// @note call this before reading keyframes from multiple threads
+    void updateSequences() {
+      for (auto& [_, keyframes] : _attribs)
+        if (keyframes.refDirty()) keyframes.updateSequence();
+    }
+
     // protected:
     struct PlaceHolder {};
 
@@ -404,6 +537,8 @@ namespace zs {
     std::deque<TimeCode> _globalTimeCodes{};
 
     std::optional<TimeCode> _skelStartTimeCode, _skelEndTimeCode;
+
+    u64 _revision{0};
   };
 
 #if ZS_ENABLE_SERIALIZATION
@@ -416,6 +551,8 @@ namespace zs {
           });
     serialize(s, primKeyframes._visibility);
     serialize(s, primKeyframes._transform);
+    /// @note the attribs were replaced
+    if constexpr (is_bitsery_deserializer_v<S>) primKeyframes.markModified();
   }
 #endif
 
@@ -565,6 +702,10 @@ namespace zs {
   template <> constexpr prim_type_e get_prim_container_type_index<LightPrimContainer>() noexcept {
     return prim_type_e::Light_;
   }
+/// @note used in PackPrimContainer::_instances [instances], column-major 4x4
+#define ATTRIB_INSTANCE_TRANSFORM_TAG "zs_inst_xform"
+  /// @note either packs individual prims, or instances a single prototype (see
+  /// PrimitiveInstancing.hpp)
   struct ZS_WORLD_EXPORT PackPrimContainer : PrimContainerInterface<PackPrimContainer> {
     bool isPack() const override { return true; }
 
@@ -572,7 +713,22 @@ namespace zs {
     auto& packedPrims() noexcept { return _packedPrims; }
     const auto& packedPrims() const noexcept { return _packedPrims; }
 
+    bool isInstanced() const noexcept { return _prototype != nullptr; }
+    auto& prototype() noexcept { return _prototype; }
+    const auto& prototype() const noexcept { return _prototype; }
+    /// @note per-instance transforms (ATTRIB_INSTANCE_TRANSFORM_TAG) along with optional
+    /// per-instance attributes
+    auto& instances() noexcept { return _instances; }
+    const auto& instances() const noexcept { return _instances; }
+    PrimIndex numInstances() const noexcept { return _instances.size(); }
+
     std::vector<PackGeometry> _packedPrims;
+    /// @note shared among all instances, never registered to the scene itself
+    Shared<ZsPrimitive> _prototype;
+    AttrVector _instances;  // owner: prim
+    /// @note the owner's local bounding box may no longer enclose all instances, set by the
+    /// pack-level set_instance_transform, cleared by update_instanced_bounding_box
+    bool _boundsStale{false};
   };
 
   template <> constexpr prim_type_e get_prim_container_type_index<PackPrimContainer>() noexcept {
@@ -587,8 +743,16 @@ namespace zs {
   constexpr prim_type_e get_prim_container_type_index<AnalyticPrimContainer>() noexcept {
     return prim_type_e::Analytic_;
   }
+  struct SparseSdfVolume;
+  /// @note the volume is built from the triangle mesh of the owning prim (see PrimitiveSdf.hpp)
   struct ZS_WORLD_EXPORT SdfPrimContainer : PrimContainerInterface<SdfPrimContainer> {
     bool isSdf() const override { return true; }
+
+    bool hasVolume() const noexcept { return _volume != nullptr; }
+    auto& volume() noexcept { return _volume; }
+    const auto& volume() const noexcept { return _volume; }
+
+    Shared<SparseSdfVolume> _volume;  // in the local space of the prim
   };
 
   template <> constexpr prim_type_e get_prim_container_type_index<SdfPrimContainer>() noexcept {
@@ -669,6 +833,21 @@ namespace zs {
   using ZsTriMesh = Mesh<float, 3, u32, 3>;
   using ZsLineMesh = Mesh<float, 3, u32, 2>;
   using ZsPointMesh = Mesh<float, 3, u32, 1>;
+  /// @brief bvh over the elements of a prim
+  using PrimBvh = LBvh<3, PrimIndex>;
+
+  struct ZsMeshBundle;
+  struct SkinningBinding;
+  struct BlendShapeSet;
+  struct ArenaResource;
+
+  /// @brief supplies meshes evaluated ahead of time (e.g. prefetched or baked), consulted by
+  /// ZsPrimitive::zsMeshAsync before evaluating keyframes
+  struct ZS_WORLD_EXPORT ZsMeshProvider {
+    virtual ~ZsMeshProvider() = default;
+    /// @note invoked from conversion tasks, returns nullptr if nothing is at hand for [tc]
+    virtual Shared<ZsMeshBundle> takeMeshes(const ZsPrimitive& prim, TimeCode tc) = 0;
+  };
 
   struct ZS_WORLD_EXPORT PrimitiveId {
     PrimitiveId() noexcept;
@@ -713,6 +892,32 @@ namespace zs {
     void merge(const glm::vec3& pos) noexcept;
   };
 
+  /// @brief surface area heuristic cost of [bvh], i.e. the total area of its nodes over the area
+  /// of its root box, 0 if empty or flat
+  ZS_WORLD_EXPORT f32 bvh_sah_cost(const PrimBvh& bvh);
+
+  /// @brief quality of a refitted bvh relative to its last full build
+  /// @note refits keep the tree structure while nodes grow with the deformation, thus the cost
+  /// (and the expected number of nodes visited per query) drifts upwards
+  struct BvhQualityMonitor {
+    f32 degradation() const noexcept { return _buildCost > 0.f ? _cost / _buildCost : 1.f; }
+    bool requiresRebuild() const noexcept { return degradation() > _rebuildRatio; }
+    void onBuild(f32 cost) noexcept {
+      _buildCost = _cost = cost;
+      _numRefits = 0;
+    }
+    void onRefit(f32 cost) noexcept {
+      _cost = cost;
+      _numRefits++;
+    }
+
+    f32 _buildCost{0.f};
+    f32 _cost{0.f};
+    f32 _rebuildRatio{1.5f};
+    u32 _numRefits{0};    // since the last build
+    u32 _numRebuilds{0};  // triggered by degradation
+  };
+
   struct ZS_WORLD_EXPORT PrimitiveDetail {
     using DirtyFlag = u32;
     enum dirty_flag_e : DirtyFlag {
@@ -746,9 +951,31 @@ namespace zs {
 
     bool isDirty(DirtyFlag f) const noexcept;
     void clearDirtyFlag() noexcept;
+    /// @note counts as a modification (see getModificationCount) unless only the timecode
     void setDirty(DirtyFlag f) noexcept;
     void unsetDirty(DirtyFlag f) noexcept;
 
+    /// @brief bumped upon every edit of the prim: dirty flags raised (other than by timecode
+    /// changes), transforms set or markModified() called, unlike dirty flags never cleared
+    /// @note persistence (e.g. SceneJournal) compares it against the value last saved
+    u64 getModificationCount() const noexcept { return _modifications; }
+    /// @brief report edits made through mutable references that raise no dirty flag (e.g.
+    /// light or sdf parameters)
+    void markModified() noexcept {
+      _modifications++;
+      bump_edit_epoch();
+    }
+    /// @brief process-wide counter bumped upon any edit of any prim (see above), appended
+    /// children and rebuilt triBvhs
+    /// @note lets scene-level structures (e.g. SceneBvh) skip their refresh while it is unchanged
+    static u64 edit_epoch() noexcept;
+    static void bump_edit_epoch() noexcept;
+    /// @brief process-wide counter bumped whenever children are appended to or removed from any
+    /// prim
+    /// @note lets layouts of the hierarchy (e.g. SceneTransformCache) notice they are outdated
+    static u64 hierarchy_epoch() noexcept;
+    static void bump_hierarchy_epoch() noexcept;
+
     bool isTopoDirty() const noexcept;
     bool isShapeDirty() const noexcept;
     bool isAttribDirty() const noexcept;
@@ -809,6 +1036,8 @@ namespace zs {
 
     auto& triBvh() noexcept { return _triBvh; }
     const auto& triBvh() const noexcept { return _triBvh; }
+    auto& triBvhQuality() noexcept { return _triBvhQuality; }
+    const auto& triBvhQuality() const noexcept { return _triBvhQuality; }
     auto& lineBvh() noexcept { return _lineBvh; }
     const auto& lineBvh() const noexcept { return _lineBvh; }
     auto& pointBvh() noexcept { return _pointBvh; }
@@ -846,6 +1075,27 @@ namespace zs {
     TimeCode getCurrentTransformTimeCode() const noexcept { return _transformTimeCode; }
     void setCurrentTransformTimeCode(TimeCode tc) noexcept { _transformTimeCode = tc; }
 
+    /// @brief keyframed attrib channels inspected upon timecode changes
+    enum keyframe_channel_e : int {
+      channel_Pos = 0,
+      channel_Color,
+      channel_UV,
+      channel_Normal,
+      channel_Tangent,
+      channel_FaceIndex,
+      channel_Face,
+      num_keyframe_channels
+    };
+    /// @brief dirty flags that might be raised by a timecode change (skinning included)
+    /// @note lazily rebuilt once the keyframes' revision changes, 0 for static prims
+    DirtyFlag getTimeVaryingMask() const;
+    bool isMeshTimeVarying() const { return getTimeVaryingMask() != 0; }
+    /// @brief local box bounding the positions over the whole timeline, i.e. the local box merged
+    /// with all position keyframes, the local box alone if positions do not vary
+    /// @note false if varying positions get deformed (skinning, blend shapes), which their
+    /// keyframes then do not bound
+    bool timelineBoundingBox(PrimitiveBoundingBox& box) const;
+
     /// @brief check if mesh requires an update (pos, nrm, clr, skinning)
     bool meshRequireUpdate(TimeCode newTc) const;
     bool transformRequireUpdate(TimeCode newTc) const;
@@ -859,12 +1109,71 @@ namespace zs {
     auto& refIsOpaque() noexcept { return _isOpaque; }
     const auto& refIsOpaque() const noexcept { return _isOpaque; }
 
+    /// @brief outside the view frustum as of the last culling pass, mesh updates are deferred
+    bool isCulled() const noexcept { return _culled; }
+    void setCulled(bool culled) noexcept { _culled = culled; }
+
+    /// @brief meshes evaluated ahead of time (e.g. prefetched), consumed by the next
+    /// conversion at the same timecode
+    /// @note only stage while the prim is idle
+    /// @note meshes staged at g_default_timecode() are taken at any timecode, which only suits
+    /// meshes that do not vary (see stage_static_meshes), until the keyframes are modified
+    void stageMeshes(TimeCode tc, Shared<ZsMeshBundle> meshes) noexcept {
+      _stagedTimeCode = tc;
+      _stagedRevision = _keyframes.getRevision();
+      _stagedMeshes = zs::move(meshes);
+    }
+    /// @note timecodes are matched up to a relative 1e-6, as baked frames are (see GeometryCache)
+    bool hasStagedMeshes(TimeCode tc) const noexcept {
+      if (!_stagedMeshes) return false;
+      if (std::isnan(_stagedTimeCode)) return _stagedRevision == _keyframes.getRevision();
+      return std::abs(_stagedTimeCode - tc) <= 1e-6 * std::max(1., std::abs(tc));
+    }
+    Shared<ZsMeshBundle> takeStagedMeshes(TimeCode tc) noexcept {
+      if (!hasStagedMeshes(tc)) return {};
+      return zs::exchange(_stagedMeshes, {});
+    }
+    /// @brief meshes staged for any timecode, nullptr if none
+    const ZsMeshBundle* staticMeshes() const noexcept {
+      if (!std::isnan(_stagedTimeCode) || !hasStagedMeshes(_stagedTimeCode)) return nullptr;
+      return _stagedMeshes.get();
+    }
+
+    /// @brief native skinning data, preferred over usd skinning queries when present
+    auto& skinningBinding() noexcept { return _skinningBinding; }
+    const auto& skinningBinding() const noexcept { return _skinningBinding; }
+    /// @brief native blend shapes, evaluated prior to skinning
+    auto& blendShapes() noexcept { return _blendShapes; }
+    const auto& blendShapes() const noexcept { return _blendShapes; }
+
   protected:
+    void updateTimeVaryingCache() const;
+    void fetchSegmentIndices(TimeCode tc, int* segmentNos) const;
+
+    /// @brief per-prim cache replacing string-keyed keyframe lookups upon timecode changes
+    struct TimeVaryingCache {
+      const KeyFrames<AttrVector>* _channels[num_keyframe_channels]{};
+      /// @note segment indices of the two most recently queried timecodes
+      int _segmentNos[2][num_keyframe_channels]{};
+      TimeCode _tcs[2]{g_default_timecode(), g_default_timecode()};
+      bool _segmentsValid[2]{false, false};
+      int _lastSlot{0};
+      DirtyFlag _mask{0};
+      /// @note the revision alone would let a copied detail reuse the channels of its source,
+      /// the keyframes the cache was built upon are thus compared as well
+      const PrimKeyFrames* _keyframes{nullptr};
+      u64 _revision{~(u64)0};
+      /// @note union of the position keyframes, lazily gathered, see timelineBoundingBox
+      PrimitiveBoundingBox _positionsBox;
+      bool _positionsBoxValid{false};
+    };
+
     PrimitiveMeta _metas;
     std::string _label;
     glm::mat4 _transform{glm::mat4(1.f)};  // local transform
     bool _transformVarying{false};
     bool _isOpaque{true};
+    bool _culled{false};
 
     volatile u32 _processingFlag{0};
 
@@ -875,15 +1184,22 @@ namespace zs {
     // VkModel should be made persistent
 
     PrimKeyFrames _keyframes;
+    mutable TimeVaryingCache _timeVaryingCache;
     TimeCode _curTimeCode{g_default_timecode()}, _transformTimeCode{g_default_timecode()};
     PrimitiveBoundingBox _localBoundingBox;
     PrimitiveBoundingBox _worldBoundingBox;
     Shared<ZsPrimitive> _visualMesh;
+    Shared<ZsMeshBundle> _stagedMeshes;
+    TimeCode _stagedTimeCode{g_default_timecode()};
+    u64 _stagedRevision{0};
+    Shared<SkinningBinding> _skinningBinding;
+    Shared<BlendShapeSet> _blendShapes;
     ZsTriMesh _triMesh;
     ZsLineMesh _lineMesh;
     ZsPointMesh _pointMesh;
     VkModel _vkTriMesh, _vkLineMesh, _vkPointMesh;
-    LBvh<3> _triBvh, _lineBvh, _pointBvh;
+    PrimBvh _triBvh, _lineBvh, _pointBvh;
+    BvhQualityMonitor _triBvhQuality;
 
     std::string _texturePath;
 
@@ -892,6 +1208,7 @@ namespace zs {
     std::string _usdSceneName{""}, _usdPrimPath{""};
 
     DirtyFlag _dirtyFlag{dirty_All};
+    u64 _modifications{0};
 
     PrimitiveId _id;
     asset_origin_e _assetOrigin{asset_origin_e::native};
@@ -974,10 +1291,25 @@ namespace zs {
     Shared<ZsPrimitive>& visualMesh();
     ZsTriMesh& triMesh();
 
-    void updatePrimFromKeyFrames(TimeCode tc);
+    void updatePrimFromKeyFrames(TimeCode tc) { updatePrimFromKeyFrames(keyframes(), tc); }
+    /// @note evaluate other keyframes into this storage (e.g. a scratch one)
+    void updatePrimFromKeyFrames(const PrimKeyFrames& keyframes, TimeCode tc);
 
     /// @brief compute the transformed position based upon the original pos (points())
-    bool applySkinning(TimeCode tc);
+    bool applySkinning(TimeCode tc) { return applySkinning(details(), tc); }
+    /// @note skinning setup is taken from [srcDetail]
+    bool applySkinning(const PrimitiveDetail& srcDetail, TimeCode tc);
+
+    /// @brief steal the geometry (groups, points, verts, prims) of another storage
+    /// @note details are left untouched
+    void assignGeometry(PrimitiveStorage&& o) {
+      _groups = zs::move(o._groups);
+      _points = zs::move(o._points);
+      _verts = zs::move(o._verts);
+      _localPrims = zs::move(o._localPrims);
+      _primTagIndex = zs::move(o._primTagIndex);
+      _globalPrimMapping = zs::move(o._globalPrimMapping);
+    }
 
 #define ZS_DECLARE_LOCAL_PRIM(TYPE)                        \
   inline Shared<TYPE##PrimContainer> local##TYPE##Prims(); \
@@ -993,7 +1325,7 @@ namespace zs {
     ZS_DECLARE_LOCAL_PRIM(Light)
 #undef ZS_DECLARE_LOCAL_PRIM
 
-    std::vector<GeoGroup<std::set<i32>>> _groups;
+    std::vector<GeoGroup<std::set<PrimIndex>>> _groups;
     AttrVector _points;
     AttrVector _verts;
     std::map<PrimTypeIndex, Shared<PrimContainerConcept>> _localPrims;
@@ -1002,6 +1334,49 @@ namespace zs {
     PrimitiveDetail _details;
   };
 
+  /// @brief zs meshes of a primitive evaluated at a certain timecode
+  /// @note [geometry] is the (scratch) storage these meshes are converted from
+  struct ZS_WORLD_EXPORT ZsMeshBundle {
+    size_t bytes() const noexcept;
+
+    ZsTriMesh _triMesh;
+    ZsLineMesh _lineMesh;
+    ZsPointMesh _pointMesh;
+    UniquePtr<PrimitiveStorage> _geometry;
+  };
+
+  /// @brief evaluate the meshes of the prims under [root] that do not vary over time in parallel,
+  /// staged for any timecode (see PrimitiveDetail::stageMeshes)
+  /// @note triangles are sorted into the leaf order of the triBvh built over them (morton order
+  /// of their centers), and persisted along with the prims (see save_primitive_cache), so that
+  /// warm loads skip evaluation and triangulation
+  /// @note call before [root] is registered to a scene, prims drawing the mesh of another (see
+  /// share_duplicate_meshes) are skipped
+  /// @return number of prims staged
+  ZS_WORLD_EXPORT size_t stage_static_meshes(ZsPrimitive& root);
+
+  /// @brief number of bytes held by the attribute channels
+  ZS_WORLD_EXPORT size_t attr_vector_bytes(const AttrVector& attr) noexcept;
+  /// @brief number of bytes held by the points, verts and mesh prims of [geom]
+  ZS_WORLD_EXPORT size_t primitive_storage_bytes(const PrimitiveStorage& geom) noexcept;
+
+  /// @brief evaluate [src]'s keyframes at [tc] into [scratch], then convert to zs meshes
+  /// @note [src]'s live buffers are untouched, thus safe to run concurrently with a fresh
+  /// [scratch] per task
+  ZS_WORLD_EXPORT void evaluate_primitive_to_zsmesh(const PrimitiveStorage& src, TimeCode tc,
+                                                    PrimitiveStorage& scratch,
+                                                    ZsTriMesh* pTriMesh = nullptr,
+                                                    ZsLineMesh* pLineMesh = nullptr,
+                                                    ZsPointMesh* pPointMesh = nullptr);
+  /// @brief same as above with the intermediate storage drawn from [arena] (owned by a shared
+  /// pointer), which is released before returning, thus reusable (e.g. one per worker thread)
+  /// @note only the zs meshes outlive the call, they are allocated as usual
+  ZS_WORLD_EXPORT void evaluate_primitive_to_zsmesh(const PrimitiveStorage& src, TimeCode tc,
+                                                    ArenaResource& arena,
+                                                    ZsTriMesh* pTriMesh = nullptr,
+                                                    ZsLineMesh* pLineMesh = nullptr,
+                                                    ZsPointMesh* pPointMesh = nullptr);
+
   /// @note general mesh: poly mesh
   /// @note simple mesh: point/line/tri, allow [verts], easy for simulations
   /// @note simple and general mesh only differs in prim representation, [verts] are shared
@@ -1019,12 +1394,24 @@ namespace zs {
     };
 
     /// @note this STEALs the reference to childPrim
+    /// @note the child label is expected to be settled beforehand (see reindexChildren)
     void appendChildPrimitve(ZsPrimitive* childPrim);
+    void appendChildPrimitve(Shared<ZsPrimitive> childPrim);
     inline bool removeChild(ZsPrimitive* p);
     inline Weak<ZsPrimitive> getChild(int i);
+    /// @note O(1) through the label index, the first child of a duplicated label wins
+    /// @note read-only, thus safe to call concurrently; misses fall back to a linear scan, which
+    /// finds children renamed through label() rather than setLabel()
     inline Weak<ZsPrimitive> getChild(std::string_view label);
+    /// @brief same as above
+    inline const ZsPrimitive* findChild(std::string_view label) const;
+    /// @brief rename, keeping the label index of the parent current
+    void setLabel(std::string label);
+    /// @brief rebuild the label index, done upon removal
+    void reindexChildren();
     inline Weak<ZsPrimitive> getChildByIdRecurse(PrimIndex id_);
     size_t numChildren() const noexcept { return _childs.size(); }
+    const std::vector<Shared<ZsPrimitive>>& children() const noexcept { return _childs; }
     inline std::vector<std::string> getChildLabels() const;
 
     bool queryStartEndTimeCodes(TimeCode& start, TimeCode& end) const noexcept;
@@ -1032,11 +1419,32 @@ namespace zs {
     ZsPrimitive* getParent() noexcept { return _parent; }
     const ZsPrimitive* getParent() const noexcept { return _parent; }
 
+    /// @brief prim whose meshes (visual, tri, gpu) and triBvh stand for those of this prim, see
+    /// link_mesh_sources()
+    /// @note only meant for static prims with identical keyframes, the transform of this prim
+    /// still applies
+    /// @note the link counts as dropped once the keyframes of either prim are modified (see
+    /// PrimKeyFrames::getRevision) or this prim turns time-varying
+    Shared<ZsPrimitive> meshSource() const noexcept;
+    void setMeshSource(Weak<ZsPrimitive> source) noexcept;
+    /// @brief provider consulted by zsMeshAsync, inherited from the closest ancestor having one
+    /// @note set on registered prims by their SceneContext
+    ZsMeshProvider* meshProvider() const noexcept {
+      for (auto p = this; p; p = p->_parent)
+        if (p->_meshProvider) return p->_meshProvider;
+      return nullptr;
+    }
+    void setMeshProvider(ZsMeshProvider* provider) noexcept { _meshProvider = provider; }
+
     /// @note this path usually refers to other resources (e.g. usd),
     /// @note not necessarily the one composed from label hierarchy
     std::string_view getPath() const noexcept { return _path; }
 
     VkModel& vkTriMesh(VulkanContext& ctx);
+    /// @brief (re)build or refit the triBvh over details().triMesh(), local bounding box included
+    /// @note a refit whose quality degraded past triBvhQuality()._rebuildRatio turns into a
+    /// rebuild, both run synchronously and modify the tree in place
+    void updateTriBvh(bool rebuild = true);
 
     /// @note asynchrounous resources
     Future<Shared<ZsPrimitive>> visualMeshAsync(TimeCode tc);
@@ -1079,6 +1487,13 @@ namespace zs {
       else
         _visualTransform = visualTransform(details().getCurrentTimeCode());
     }
+    /// @brief with the world transform at [tc] already resolved (e.g. by a transform cache)
+    /// @return false if deferred since the prim is still being processed at another timecode
+    bool updateTransform(TimeCode tc, const glm::mat4& worldMat) noexcept {
+      if (!isStatusIdle() && tc != details().getCurrentTimeCode()) return false;
+      _visualTransform = details().toNativeCoordTransform() * worldMat;
+      return true;
+    }
     void updateTransform() noexcept {
       // fmt::print("name: {}, path: {}\n", details().label(), path());
       _visualTransform = visualTransform(details().getCurrentTimeCode());
@@ -1102,6 +1517,10 @@ namespace zs {
     ZsPrimitive* _parent{nullptr};
     /// @note although shared being used here, but never share-owned, mostly for observers
     std::vector<Shared<ZsPrimitive>> _childs;  // usually built first then moved to parent
+    HashIndex<std::string, u32> _childIndex;   // label -> index into _childs
+    Weak<ZsPrimitive> _meshSource;
+    u64 _meshSourceRevision{0}, _meshSourceSelfRevision{0};  // keyframe revisions upon linking
+    ZsMeshProvider* _meshProvider{nullptr};
 
     /// @brief async resources
     Future<Shared<ZsPrimitive>> _visualMeshAsync;
@@ -1147,6 +1566,18 @@ namespace zs {
       return _orderedFrames[_keyframes.size() - 1];
     return _orderedFrames[segmentNo];
   }
+  template <typename Value> Shared<Value> KeyFrames<Value>::getWritableByTimeCode(TimeCode tc) {
+    auto slot = &_defaultValue;
+    if (_keyframes.size()) {
+      auto it = _keyframes.find(getSegmentTimeCode(getTimeCodeSegmentIndex(tc)));
+      slot = &(*it).second;
+    }
+    if (*slot && slot->use_count() > 1) {
+      *slot = std::make_shared<Value>(**slot);
+      _dirty = true;
+    }
+    return *slot;
+  }
   template <typename Value> const std::vector<TimeCode>& KeyFrames<Value>::getTimeCodes() const {
     if (_dirty) const_cast<KeyFrames*>(this)->updateSequence();
     return _orderedKeys;
@@ -1248,6 +1679,20 @@ namespace zs {
                  getPropertyOffset(prop.name));
     }
   }
+  void AttrVector::relocate(const allocator_type& allocator) {
+    assert(attr32().memspace() == memsrc_e::host);
+    auto relocated = [&allocator](const auto& tv) {
+      using TV = RM_CVREF_T(tv);
+      constexpr size_t lane = TV::lane_width;
+      TV ret{allocator, tv.getPropertyTags(), tv.size()};
+      const size_t bytes = (tv.size() + lane - 1) / lane * lane * tv.numChannels()
+                           * sizeof(typename TV::value_type);
+      if (bytes) std::memcpy((void*)ret.data(), (const void*)tv.data(), bytes);
+      return ret;
+    };
+    _attr32 = relocated(_attr32);
+    _attr64 = relocated(_attr64);
+  }
   template <typename T> void AttrVector::printAttrib(const SmallString& prop, wrapt<T>) {
     assert(attr32().memspace() == memsrc_e::host);
 
@@ -1298,11 +1743,11 @@ namespace zs {
 
   bool PrimitiveStorage::isSimpleMeshEstablished() const {
     return (localPointPrims()->prims().size() > 0
-            && localPointPrims()->prims().hasProperty(TO_POLY_ID_TAG))
+            && localPointPrims()->prims().hasIndexProperty(TO_POLY_ID_TAG))
            || (localLinePrims()->prims().size() > 0
-               && localLinePrims()->prims().hasProperty(TO_POLY_ID_TAG))
+               && localLinePrims()->prims().hasIndexProperty(TO_POLY_ID_TAG))
            || (localTriPrims()->prims().size() > 0
-               && localTriPrims()->prims().hasProperty(TO_POLY_ID_TAG));
+               && localTriPrims()->prims().hasIndexProperty(TO_POLY_ID_TAG));
   }
 
   Weak<ZsPrimitive> ZsPrimitive::getChild(int i) {
@@ -1311,10 +1756,20 @@ namespace zs {
   }
 
   Weak<ZsPrimitive> ZsPrimitive::getChild(std::string_view label) {
-    for (int i = 0; i < numChildren(); ++i)
-      if (_childs[i]->label() == label) return _childs[i];
+    if (auto idx = _childIndex.find(label))
+      if (*idx < _childs.size() && _childs[*idx]->label() == label) return _childs[*idx];
+    /// @note missed or stale, child labels may have been altered after appended
+    for (const auto& ch : _childs)
+      if (ch->label() == label) return ch;
     return {};
   }
+  const ZsPrimitive* ZsPrimitive::findChild(std::string_view label) const {
+    if (auto idx = _childIndex.find(label))
+      if (*idx < _childs.size() && _childs[*idx]->label() == label) return _childs[*idx].get();
+    for (const auto& ch : _childs)
+      if (ch->label() == label) return ch.get();
+    return nullptr;
+  }
   Weak<ZsPrimitive> ZsPrimitive::getChildByIdRecurse(PrimIndex id_) {
     for (int i = 0; i < numChildren(); ++i)
       if (_childs[i]->id() == id_) return _childs[i];
@@ -1333,6 +1788,10 @@ namespace zs {
     for (auto it = _childs.begin(); it != _childs.end(); ++it) {
       if ((*it).get() == pr) {
         _childs.erase(it);
+        /// @note subsequent children are shifted
+        reindexChildren();
+        PrimitiveDetail::bump_edit_epoch();
+        PrimitiveDetail::bump_hierarchy_epoch();
         return true;
       }
     }
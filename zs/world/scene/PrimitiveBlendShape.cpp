@@ -0,0 +1,170 @@
+#include "PrimitiveBlendShape.hpp"
+
+#include <algorithm>
+
+#if ZS_ENABLE_OPENMP
+#  include "zensim/omp/execution/ExecutionPolicy.hpp"
+#else
+#  include "zensim/execution/ExecutionPolicy.hpp"
+#endif
+
+namespace zs {
+
+  bool add_blend_shape_target(BlendShapeSet &set, const std::string &name, PrimIndex numOffsets,
+                              const glm::vec3 *offsets, const int *pointIndices,
+                              const glm::vec3 *normalOffsets) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+    constexpr auto space = execspace_e::openmp;
+#else
+    auto pol = seq_exec();
+    constexpr auto space = execspace_e::host;
+#endif
+    if (!pointIndices && numOffsets != set._numPoints) return false;
+    if (pointIndices)
+      for (PrimIndex i = 0; i != numOffsets; ++i)
+        if (pointIndices[i] < 0 || pointIndices[i] >= set._numPoints) return false;
+
+    BlendShapeTarget target;
+    target._name = name;
+    auto &attrib = target._offsets;
+    attrib._owner = prim_attrib_owner_e::point;
+    std::vector<PropertyTag> props{{ATTRIB_BLENDSHAPE_OFFSET_TAG, 3}};
+    if (normalOffsets) props.push_back({ATTRIB_BLENDSHAPE_NORMAL_OFFSET_TAG, 3});
+    attrib.appendProperties32(pol, props);
+    if (pointIndices) attrib.appendIndexProperties(pol, {{ATTRIB_BLENDSHAPE_POINT_INDEX_TAG, 1}});
+    attrib.resize(numOffsets);
+
+    pol(range(numOffsets),
+        [offsetView = view<space>({}, attrib.attr32()),
+         pidView = view<space>({}, attrib.attrIndex()),
+         offsetOffset = attrib.getPropertyOffset(ATTRIB_BLENDSHAPE_OFFSET_TAG),
+         pidOffset = attrib.getIndexPropertyOffset(ATTRIB_BLENDSHAPE_POINT_INDEX_TAG),
+         nrmOffset = attrib.getPropertyOffset(ATTRIB_BLENDSHAPE_NORMAL_OFFSET_TAG), offsets,
+         pointIndices, normalOffsets](PrimIndex i) mutable {
+          for (int d = 0; d != 3; ++d) offsetView(offsetOffset + d, i) = offsets[i][d];
+          if (pointIndices) pidView(pidOffset, i, prim_id_c) = pointIndices[i];
+          if (normalOffsets)
+            for (int d = 0; d != 3; ++d) offsetView(nrmOffset + d, i) = normalOffsets[i][d];
+        });
+    set._targets.push_back(zs::move(target));
+    return true;
+  }
+
+  void emplace_blend_shape_weights(BlendShapeSet &set, TimeCode tc,
+                                   const std::vector<float> &weights) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    AttrVector frame;
+    frame._owner = prim_attrib_owner_e::prim;
+    frame.appendProperties32(pol, {{ATTRIB_BLENDSHAPE_WEIGHT_TAG, 1}});
+    frame.resize(weights.size());
+    pol(zip(range(frame.attr32(), ATTRIB_BLENDSHAPE_WEIGHT_TAG, dim_c<1>), weights),
+        [](auto &dst, float w) { dst = w; });
+    if (std::isnan(tc))
+      set._weights.emplace(zs::move(frame));
+    else
+      set._weights.emplace(tc, zs::move(frame));
+  }
+
+  void compute_blend_shape_weights(const BlendShapeSet &set, TimeCode tc,
+                                   std::vector<float> &weights) {
+    const auto numTargets = set.numTargets();
+    weights.assign(numTargets, 0.f);
+    const auto &kfs = set._weights;
+
+    auto segNo = kfs.getTimeCodeSegmentIndex(tc);
+    auto frame = kfs.getSegmentFrame(segNo).lock();
+    if (!frame) return;
+    Shared<AttrVector> nextFrame{};
+    f32 t = 0;
+    if (kfs.isTimeDependent() && !std::isnan(tc) && segNo >= 0 && segNo + 1 < kfs.getNumFrames()) {
+      auto st = kfs.getSegmentTimeCode(segNo);
+      auto ed = kfs.getSegmentTimeCode(segNo + 1);
+      if (ed > st && tc > st) {
+        nextFrame = kfs.getSegmentFrame(segNo + 1).lock();
+        t = static_cast<f32>((tc - st) / (ed - st));
+      }
+    }
+
+    auto frameView = view<execspace_e::host>({}, frame->attr32());
+    const auto offset = frame->getPropertyOffset(ATTRIB_BLENDSHAPE_WEIGHT_TAG);
+    const int n = std::min((int)frame->size(), numTargets);
+    for (int k = 0; k != n; ++k) weights[k] = frameView(offset, k);
+    if (nextFrame) {
+      auto nextView = view<execspace_e::host>({}, nextFrame->attr32());
+      const int m = std::min((int)nextFrame->size(), numTargets);
+      for (int k = 0; k != m; ++k)
+        weights[k] = weights[k] * (1.f - t) + nextView(offset, k) * t;
+    }
+  }
+
+  bool apply_blend_shapes(const BlendShapeSet &set, const std::vector<float> &weights,
+                          AttrVector &points, const char *srcTag, const source_location &loc) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+    constexpr auto space = execspace_e::openmp;
+#else
+    auto pol = seq_exec();
+    constexpr auto space = execspace_e::host;
+#endif
+    const PrimIndex numPts = points.size();
+    if (numPts == 0 || numPts != set._numPoints || !points.hasProperty(srcTag)) return false;
+
+    /// @note only a handful of targets are typically active at a time
+    std::vector<std::pair<f32, int>> activeTargets;
+    const int numTargets = std::min((int)weights.size(), set.numTargets());
+    for (int k = 0; k != numTargets; ++k)
+      if (weights[k] != 0.f && set._targets[k].numOffsets() > 0)
+        activeTargets.emplace_back(weights[k], k);
+    std::sort(activeTargets.begin(), activeTargets.end(), [](const auto &a, const auto &b) {
+      return std::abs(a.first) > std::abs(b.first);
+    });
+
+    points.appendProperties32(pol, {{ATTRIB_SKINNING_POS_TAG, 3}}, loc);
+    const auto srcOffset = points.getPropertyOffset(srcTag);
+    const auto dstOffset = points.getPropertyOffset(ATTRIB_SKINNING_POS_TAG);
+    const auto nrmOffset = points.getPropertyOffset(ATTRIB_NORMAL_TAG);
+    if (srcOffset != dstOffset)
+      pol(range(numPts), [ptsView = view<space>({}, points.attr32()), srcOffset,
+                          dstOffset](PrimIndex i) mutable {
+        ptsView.tuple(dim_c<3>, dstOffset, i) = ptsView.pack(dim_c<3>, srcOffset, i);
+      });
+
+    /// @note point indices within a target are unique, thus targets scatter race-free, one at a
+    /// time
+    for (const auto &[w, k] : activeTargets) {
+      const auto &attrib = set._targets[k]._offsets;
+      const bool applyNormals = nrmOffset != -1 && set._targets[k].hasNormalOffsets();
+      pol(range(attrib.size()),
+          [ptsView = view<space>({}, points.attr32()),
+           offsetView = view<space>({}, attrib.attr32()),
+           pidView = view<space>({}, attrib.attrIndex()),
+           offsetOffset = attrib.getPropertyOffset(ATTRIB_BLENDSHAPE_OFFSET_TAG),
+           pidOffset = attrib.getIndexPropertyOffset(ATTRIB_BLENDSHAPE_POINT_INDEX_TAG),
+           nrmOffsetOffset = attrib.getPropertyOffset(ATTRIB_BLENDSHAPE_NORMAL_OFFSET_TAG),
+           dstOffset, nrmOffset, applyNormals, w = w](PrimIndex i) mutable {
+            const PrimIndex pid = pidOffset != -1 ? pidView(pidOffset, i, prim_id_c) : i;
+            ptsView.tuple(dim_c<3>, dstOffset, pid)
+                = ptsView.pack(dim_c<3>, dstOffset, pid)
+                  + w * offsetView.pack(dim_c<3>, offsetOffset, i);
+            if (applyNormals)
+              ptsView.tuple(dim_c<3>, nrmOffset, pid)
+                  = ptsView.pack(dim_c<3>, nrmOffset, pid)
+                    + w * offsetView.pack(dim_c<3>, nrmOffsetOffset, i);
+          });
+    }
+    return true;
+  }
+
+  bool apply_blend_shapes(const BlendShapeSet &set, TimeCode tc, AttrVector &points,
+                          const char *srcTag, const source_location &loc) {
+    std::vector<float> weights;
+    compute_blend_shape_weights(set, tc, weights);
+    return apply_blend_shapes(set, weights, points, srcTag, loc);
+  }
+
+}  // namespace zs
@@ -0,0 +1,64 @@
+#pragma once
+#include "../WorldExport.hpp"
+#include "Primitive.hpp"
+
+namespace zs {
+
+/// @note used in BlendShapeTarget::_offsets [affected points]
+#define ATTRIB_BLENDSHAPE_POINT_INDEX_TAG "__i_zs_bs_pid"
+#define ATTRIB_BLENDSHAPE_OFFSET_TAG "zs_bs_offset"
+#define ATTRIB_BLENDSHAPE_NORMAL_OFFSET_TAG "zs_bs_nrm_offset"
+/// @note used in BlendShapeSet::_weights [targets]
+#define ATTRIB_BLENDSHAPE_WEIGHT_TAG "zs_bs_w"
+
+  /// @brief sparse offsets of a single target
+  /// @note dense targets (covering all points in order) carry no point indices
+  struct ZS_WORLD_EXPORT BlendShapeTarget {
+    bool isSparse() const { return _offsets.hasIndexProperty(ATTRIB_BLENDSHAPE_POINT_INDEX_TAG); }
+    bool hasNormalOffsets() const {
+      return _offsets.hasProperty(ATTRIB_BLENDSHAPE_NORMAL_OFFSET_TAG);
+    }
+    PrimIndex numOffsets() const noexcept { return _offsets.size(); }
+
+    std::string _name;
+    AttrVector _offsets;
+  };
+
+  /// @brief blend shape targets of a prim along with their animated weights
+  struct ZS_WORLD_EXPORT BlendShapeSet {
+    int numTargets() const noexcept { return _targets.size(); }
+
+    std::vector<BlendShapeTarget> _targets;
+    /// @note one entry per target, sampled per timecode
+    KeyFrames<AttrVector> _weights;
+    PrimIndex _numPoints{0};
+  };
+
+  /// @brief append a target of [numOffsets] offsets to [set]
+  /// @note [pointIndices] being null indicates a dense target (numOffsets == set._numPoints)
+  ZS_WORLD_EXPORT bool add_blend_shape_target(BlendShapeSet& set, const std::string& name,
+                                              PrimIndex numOffsets, const glm::vec3* offsets,
+                                              const int* pointIndices = nullptr,
+                                              const glm::vec3* normalOffsets = nullptr);
+
+  /// @brief cache target weights of a timecode (default value if tc is NaN)
+  ZS_WORLD_EXPORT void emplace_blend_shape_weights(BlendShapeSet& set, TimeCode tc,
+                                                   const std::vector<float>& weights);
+
+  /// @brief target weights at [tc], linearly interpolated between the cached samples
+  ZS_WORLD_EXPORT void compute_blend_shape_weights(const BlendShapeSet& set, TimeCode tc,
+                                                   std::vector<float>& weights);
+
+  /// @brief deform [srcTag] of [points] into ATTRIB_SKINNING_POS_TAG
+  /// @note targets are accumulated in descending order of weight magnitude, zero-weight ones are
+  /// skipped altogether
+  /// @note normal offsets are added to ATTRIB_NORMAL_TAG in place if present
+  ZS_WORLD_EXPORT bool apply_blend_shapes(const BlendShapeSet& set,
+                                          const std::vector<float>& weights, AttrVector& points,
+                                          const char* srcTag = ATTRIB_POS_TAG,
+                                          const source_location& loc = source_location::current());
+  ZS_WORLD_EXPORT bool apply_blend_shapes(const BlendShapeSet& set, TimeCode tc,
+                                          AttrVector& points, const char* srcTag = ATTRIB_POS_TAG,
+                                          const source_location& loc = source_location::current());
+
+}  // namespace zs
@@ -122,6 +122,17 @@ namespace zs {
   ZS_WORLD_EXPORT bool apply_usd_skinning(AttrVector& posAttrib, const ScenePrimConcept* scenePrim,
                                           double time,
                                           const source_location& loc = source_location::current());
+  /// @brief extract native (sparse) BlendShapeSet targets and their animated weights
+  ZS_WORLD_EXPORT bool setup_usd_blend_shapes(const ScenePrimConcept* scenePrim,
+                                              PrimitiveStorage& geom,
+                                              const source_location& loc
+                                              = source_location::current());
+  /// @brief extract a native SkinningBinding (influences, bind and animated joint transforms)
+  /// @note skinning then no longer goes through usd queries upon every timecode change
+  ZS_WORLD_EXPORT bool setup_usd_skinning_binding(const ScenePrimConcept* scenePrim,
+                                                  PrimitiveStorage& geom,
+                                                  const source_location& loc
+                                                  = source_location::current());
 #endif
 
 }  // namespace zs
\ No newline at end of file
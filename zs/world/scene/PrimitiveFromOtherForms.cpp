@@ -1,5 +1,9 @@
+#include <unordered_map>
+
 #include "Primitive.hpp"
+#include "PrimitiveBlendShape.hpp"
 #include "PrimitiveConversion.hpp"
+#include "PrimitiveSkinning.hpp"
 #include "Timeline.hpp"
 #include "world/system/ResourceSystem.hpp"
 #if ZS_ENABLE_USD
@@ -30,12 +34,14 @@
 #  include "pxr/usd/usdSkel/animQuery.h"
 #  include "pxr/usd/usdSkel/animation.h"
 #  include "pxr/usd/usdSkel/bindingAPI.h"
+#  include "pxr/usd/usdSkel/blendShape.h"
 #  include "pxr/usd/usdSkel/blendShapeQuery.h"
 #  include "pxr/usd/usdSkel/cache.h"
 #  include "pxr/usd/usdSkel/root.h"
 #  include "pxr/usd/usdSkel/skeleton.h"
 #  include "pxr/usd/usdSkel/skeletonQuery.h"
 #  include "pxr/usd/usdSkel/skinningQuery.h"
+#  include "pxr/usd/usdSkel/topology.h"
 #  include "pxr/usd/usdSkel/utils.h"
 // lighting
 #  include <pxr/usd/usdLux/cylinderLight.h>
@@ -91,11 +97,11 @@ namespace zs {
       ptProps.push_back(PropertyTag{ATTRIB_UV_TAG, 2});
     }
     geom.points().appendProperties32(pol, ptProps, loc);
-    geom.verts().appendProperties32(pol, vtProps, loc);
+    geom.verts().appendIndexProperties(pol, vtProps, loc);
     geom.points().resize(numPts);
     geom.verts().resize(numPts);
 
-    pol(enumerate(range(geom.verts().attr32(), POINT_ID_TAG, dim_c<1>, prim_id_c)),
+    pol(enumerate(range(geom.verts().attrIndex(), POINT_ID_TAG, dim_c<1>, prim_id_c)),
         [&triMesh, &nrmVals, pts = view<space>({}, geom.points().attr32())](
             u32 id, PrimIndex& pid) mutable {
           pid = id;
@@ -120,12 +126,12 @@ namespace zs {
     // copy tris (local prim), global prim
     const auto numTris = triMesh.elems.size();
     TriPrimContainer& geomTris = *geom.localTriPrims();
-    geomTris.prims().appendProperties32(pol, {{ELEM_VERT_ID_TAG, 3}}, loc);
+    geomTris.prims().appendIndexProperties(pol, {{ELEM_VERT_ID_TAG, 3}}, loc);
     geomTris.resize(numTris);
     auto& geomPrims = geom.globalPrims();
     geomPrims.resize(numTris);
 
-    pol(enumerate(range(geomTris.prims().attr32(), ELEM_VERT_ID_TAG, dim_c<3>, prim_id_c),
+    pol(enumerate(range(geomTris.prims().attrIndex(), ELEM_VERT_ID_TAG, dim_c<3>, prim_id_c),
                   geomPrims),
         [&triMesh, &geomPrims](PrimIndex eid, auto& ids,
                                zs::tuple<PrimTypeIndex, PrimIndex>& entryNo) mutable {
@@ -198,21 +204,22 @@ namespace zs {
       const auto numTris = triMesh.elems.size();
       const auto numVerts = numTris * 3;
       AttrVector vertAttrib, faceAttrib;
-      vertAttrib.appendProperties32(pol, {{POINT_ID_TAG, 1}}, loc);
+      vertAttrib.appendIndexProperties(pol, {{POINT_ID_TAG, 1}}, loc);
       vertAttrib.resize(numVerts);
       vertAttrib._owner = prim_attrib_owner_e::vert;
-      pol(enumerate(triMesh.elems), [vertAttrib = view<space>(vertAttrib.attr32()),
-                                     pidChnOffset = vertAttrib.getPropertyOffset(POINT_ID_TAG)](
-                                        PrimIndex i, const auto& tri) mutable {
-        vertAttrib(pidChnOffset, i * 3 + 0, prim_id_c) = tri[0];
-        vertAttrib(pidChnOffset, i * 3 + 1, prim_id_c) = tri[1];
-        vertAttrib(pidChnOffset, i * 3 + 2, prim_id_c) = tri[2];
-      });
-      faceAttrib.appendProperties32(pol, {{POLY_SIZE_TAG, 1}, {POLY_OFFSET_TAG, 1}}, loc);
+      pol(enumerate(triMesh.elems),
+          [vertAttrib = view<space>(vertAttrib.attrIndex()),
+           pidChnOffset = vertAttrib.getIndexPropertyOffset(POINT_ID_TAG)](
+              PrimIndex i, const auto& tri) mutable {
+            vertAttrib(pidChnOffset, i * 3 + 0, prim_id_c) = tri[0];
+            vertAttrib(pidChnOffset, i * 3 + 1, prim_id_c) = tri[1];
+            vertAttrib(pidChnOffset, i * 3 + 2, prim_id_c) = tri[2];
+          });
+      faceAttrib.appendIndexProperties(pol, {{POLY_SIZE_TAG, 1}, {POLY_OFFSET_TAG, 1}}, loc);
       faceAttrib.resize(numTris);
       faceAttrib._owner = prim_attrib_owner_e::face;
-      pol(enumerate(range(faceAttrib.attr32(), POLY_SIZE_TAG, dim_c<1>, prim_id_c),
-                    range(faceAttrib.attr32(), POLY_OFFSET_TAG, dim_c<1>, prim_id_c)),
+      pol(enumerate(range(faceAttrib.attrIndex(), POLY_SIZE_TAG, dim_c<1>, prim_id_c),
+                    range(faceAttrib.attrIndex(), POLY_OFFSET_TAG, dim_c<1>, prim_id_c)),
           [&](PrimIndex triI, PrimIndex& polySize, PrimIndex& polyOffset) {
             polySize = 3;
             polyOffset = 3 * triI;
@@ -690,7 +697,7 @@ namespace zs {
       bool clrOnPoint = false, nrmOnPoint = false, uvOnPoint = false, uvOnVert = false,
            uvOnFace = false;
       std::vector<PropertyTag> ptProps{{ATTRIB_POS_TAG, 3}};
-      std::vector<PropertyTag> polyProps{{POLY_SIZE_TAG, 1}, {POLY_OFFSET_TAG, 1}};
+      std::vector<PropertyTag> polyProps{};
       // Colors
       auto usdColorAttrib = usdMesh.GetDisplayColorAttr();
       if (usdColorAttrib.HasValue()) {
@@ -767,13 +774,16 @@ namespace zs {
 
       // copy tris (local prim), global prim
       const auto numIndices = polyOffsets.back();
-      std::vector<PropertyTag> loopProps{{POINT_ID_TAG, 1}};
+      std::vector<PropertyTag> loopProps{};
       if (uvOnVert || uvOnFace) loopProps.push_back({ATTRIB_UV_TAG, 2});
+      geom.verts().appendIndexProperties(pol, {{POINT_ID_TAG, 1}}, loc);
       geom.verts().appendProperties32(pol, loopProps, loc);
       geom.verts().resize(numIndices);
 
       PolyPrimContainer& geomPolys = *geom.localPolyPrims();
       const auto numPolys = polySizes.size();
+      geomPolys.prims().appendIndexProperties(pol, {{POLY_SIZE_TAG, 1}, {POLY_OFFSET_TAG, 1}},
+                                              loc);
       geomPolys.prims().appendProperties32(pol, polyProps, loc);
       geomPolys.resize(numPolys);
       auto& geomPrims = geom.globalPrims();
@@ -782,15 +792,17 @@ namespace zs {
       pol(enumerate(polySizes, geomPrims),
           [&polyOffsets, &loopIndices, &usdClrs, &usdNrms, &usdUVs, &usdUVIndices,
            polys = view<space>({}, geomPolys.prims().attr32()),
-           loops = view<space>({}, geom.verts().attr32()), clrOnPoint, nrmOnPoint, uvOnVert,
-           uvOnFace, isReversedFaceOrder](u32 polyId, PrimIndex polySize,
+           polyIds = view<space>({}, geomPolys.prims().attrIndex()),
+           loops = view<space>({}, geom.verts().attr32()),
+           loopIds = view<space>({}, geom.verts().attrIndex()), clrOnPoint, nrmOnPoint, uvOnVert,
+           uvOnFace, isReversedFaceOrder](PrimIndex polyId, PrimIndex polySize,
                                           zs::tuple<PrimTypeIndex, PrimIndex>& entryNo) mutable {
             PrimIndex st = 0;
             if (polyId) st = polyOffsets[polyId - 1];
             PrimIndex ed = st + polySize;
 
-            polys(POLY_OFFSET_TAG, polyId, prim_id_c) = st;
-            polys(POLY_SIZE_TAG, polyId, prim_id_c) = polySize;
+            polyIds(POLY_OFFSET_TAG, polyId, prim_id_c) = st;
+            polyIds(POLY_SIZE_TAG, polyId, prim_id_c) = polySize;
             if (!clrOnPoint && !usdClrs.empty())
               polys.tuple(dim_c<3>, ATTRIB_COLOR_TAG, polyId)
                   = zs::vec<float, 3>{usdClrs[polyId][0], usdClrs[polyId][1], usdClrs[polyId][2]};
@@ -798,21 +810,21 @@ namespace zs {
               polys.tuple(dim_c<3>, ATTRIB_NORMAL_TAG, polyId)
                   = zs::vec<float, 3>{usdNrms[polyId][0], usdNrms[polyId][1], usdNrms[polyId][2]};
             if (uvOnVert || uvOnFace) {
-              for (int i = st; i < ed; ++i) {
+              for (PrimIndex i = st; i < ed; ++i) {
                 const auto& indexedUV = usdUVs[usdUVIndices[uvOnVert ? i : polyId]];
                 loops.tuple(dim_c<2>, ATTRIB_UV_TAG, i)
                     = zs::vec<float, 2>{indexedUV[0], indexedUV[1]};
               }
             }
-            loops(POINT_ID_TAG, st, prim_id_c) = loopIndices[st];
+            loopIds(POINT_ID_TAG, st, prim_id_c) = loopIndices[st];
             if (isReversedFaceOrder) {
-              for (int i = 1; i < polySize; ++i) {
-                loops(POINT_ID_TAG, st + i, prim_id_c) = loopIndices[ed - i];
+              for (PrimIndex i = 1; i < polySize; ++i) {
+                loopIds(POINT_ID_TAG, st + i, prim_id_c) = loopIndices[ed - i];
               }
               st = ed;
             } else {
               for (++st; st != ed; ++st) {
-                loops(POINT_ID_TAG, st, prim_id_c) = loopIndices[st];
+                loopIds(POINT_ID_TAG, st, prim_id_c) = loopIndices[st];
               }
             }
 
@@ -980,28 +992,29 @@ namespace zs {
           retrieve_usdprim_attrib_face(prim, tc, &numVerts, &numFaces, verts.data(),
                                        faceSizes.data(), loc);
           vertAttrib._owner = prim_attrib_owner_e::vert;
-          vertAttrib.appendProperties32(pol, {{POINT_ID_TAG, 1}}, loc);
+          vertAttrib.appendIndexProperties(pol, {{POINT_ID_TAG, 1}}, loc);
           vertAttrib.resize(numVerts);
           faceAttrib._owner = prim_attrib_owner_e::face;
-          faceAttrib.appendProperties32(pol, {{POLY_SIZE_TAG, 1}, {POLY_OFFSET_TAG, 1}}, loc);
+          faceAttrib.appendIndexProperties(pol, {{POLY_SIZE_TAG, 1}, {POLY_OFFSET_TAG, 1}}, loc);
           faceAttrib.resize(numFaces);
 
           // assign faces
-          pol(enumerate(faceSizes), [faceSizes = view<space>(faceAttrib.attr32()),
-                                     szChnOffset = faceAttrib.getPropertyOffset(POLY_SIZE_TAG)](
-                                        int i, int faceSize) mutable {
-            faceSizes(szChnOffset, i, prim_id_c) = faceSize;
-          });
-          exclusive_scan(pol, faceAttrib.attr32().begin(POLY_SIZE_TAG, dim_c<1>, prim_id_c),
-                         faceAttrib.attr32().end(POLY_SIZE_TAG, dim_c<1>, prim_id_c),
-                         faceAttrib.attr32().begin(POLY_OFFSET_TAG, dim_c<1>, prim_id_c));
+          pol(enumerate(faceSizes),
+              [faceSizes = view<space>(faceAttrib.attrIndex()),
+               szChnOffset = faceAttrib.getIndexPropertyOffset(POLY_SIZE_TAG)](
+                  PrimIndex i, int faceSize) mutable {
+                faceSizes(szChnOffset, i, prim_id_c) = faceSize;
+              });
+          exclusive_scan(pol, faceAttrib.attrIndex().begin(POLY_SIZE_TAG, dim_c<1>, prim_id_c),
+                         faceAttrib.attrIndex().end(POLY_SIZE_TAG, dim_c<1>, prim_id_c),
+                         faceAttrib.attrIndex().begin(POLY_OFFSET_TAG, dim_c<1>, prim_id_c));
 
           // assign verts
           if (faceOrderLeftHanded) {
-            pol(zip(range(faceAttrib.attr32(), POLY_OFFSET_TAG, dim_c<1>, prim_id_c),
-                    range(faceAttrib.attr32(), POLY_SIZE_TAG, dim_c<1>, prim_id_c)),
-                [&verts, vertAttrib = view<space>(vertAttrib.attr32()),
-                 pidChnOffset = vertAttrib.getPropertyOffset(POINT_ID_TAG)](
+            pol(zip(range(faceAttrib.attrIndex(), POLY_OFFSET_TAG, dim_c<1>, prim_id_c),
+                    range(faceAttrib.attrIndex(), POLY_SIZE_TAG, dim_c<1>, prim_id_c)),
+                [&verts, vertAttrib = view<space>(vertAttrib.attrIndex()),
+                 pidChnOffset = vertAttrib.getIndexPropertyOffset(POINT_ID_TAG)](
                     PrimIndex polyOffset, PrimIndex polySize) mutable {
                   PrimIndex ed = polyOffset + polySize;
                   vertAttrib(pidChnOffset, polyOffset, prim_id_c) = verts[polyOffset];
@@ -1010,9 +1023,11 @@ namespace zs {
                 });
           } else
             pol(enumerate(verts),
-                [vertAttrib = view<space>(vertAttrib.attr32()),
-                 pidChnOffset = vertAttrib.getPropertyOffset(POINT_ID_TAG)](
-                    int i, int vert) mutable { vertAttrib(pidChnOffset, i, prim_id_c) = vert; });
+                [vertAttrib = view<space>(vertAttrib.attrIndex()),
+                 pidChnOffset = vertAttrib.getIndexPropertyOffset(POINT_ID_TAG)](
+                    PrimIndex i, int vert) mutable {
+                  vertAttrib(pidChnOffset, i, prim_id_c) = vert;
+                });
           keyframes.emplaceAttribKeyFrame(KEYFRAME_ATTRIB_FACE_LABEL, tc, zs::move(faceAttrib));
           keyframes.emplaceAttribKeyFrame(KEYFRAME_ATTRIB_FACE_INDEX_LABEL, tc,
                                           zs::move(vertAttrib));
@@ -1030,26 +1045,28 @@ namespace zs {
                                      faceSizes.data(), loc);
         vertAttrib._owner = prim_attrib_owner_e::vert;
         vertAttrib.resize(numVerts);
-        vertAttrib.appendProperties32(pol, {{POINT_ID_TAG, 1}}, loc);
+        vertAttrib.appendIndexProperties(pol, {{POINT_ID_TAG, 1}}, loc);
         faceAttrib._owner = prim_attrib_owner_e::face;
         faceAttrib.resize(numFaces);
-        faceAttrib.appendProperties32(pol, {{POLY_SIZE_TAG, 1}, {POLY_OFFSET_TAG, 1}}, loc);
+        faceAttrib.appendIndexProperties(pol, {{POLY_SIZE_TAG, 1}, {POLY_OFFSET_TAG, 1}}, loc);
 
         // assign faces
         pol(enumerate(faceSizes),
-            [faceSizes = view<space>(faceAttrib.attr32()),
-             szChnOffset = faceAttrib.getPropertyOffset(POLY_SIZE_TAG)](
-                int i, int faceSize) mutable { faceSizes(szChnOffset, i, prim_id_c) = faceSize; });
-        exclusive_scan(pol, faceAttrib.attr32().begin(POLY_SIZE_TAG, dim_c<1>, prim_id_c),
-                       faceAttrib.attr32().end(POLY_SIZE_TAG, dim_c<1>, prim_id_c),
-                       faceAttrib.attr32().begin(POLY_OFFSET_TAG, dim_c<1>, prim_id_c));
+            [faceSizes = view<space>(faceAttrib.attrIndex()),
+             szChnOffset = faceAttrib.getIndexPropertyOffset(POLY_SIZE_TAG)](
+                PrimIndex i, int faceSize) mutable {
+              faceSizes(szChnOffset, i, prim_id_c) = faceSize;
+            });
+        exclusive_scan(pol, faceAttrib.attrIndex().begin(POLY_SIZE_TAG, dim_c<1>, prim_id_c),
+                       faceAttrib.attrIndex().end(POLY_SIZE_TAG, dim_c<1>, prim_id_c),
+                       faceAttrib.attrIndex().begin(POLY_OFFSET_TAG, dim_c<1>, prim_id_c));
 
         // assign verts
         if (faceOrderLeftHanded) {
-          pol(zip(range(faceAttrib.attr32(), POLY_OFFSET_TAG, dim_c<1>, prim_id_c),
-                  range(faceAttrib.attr32(), POLY_SIZE_TAG, dim_c<1>, prim_id_c)),
-              [&verts, vertAttrib = view<space>(vertAttrib.attr32()),
-               pidChnOffset = vertAttrib.getPropertyOffset(POINT_ID_TAG)](
+          pol(zip(range(faceAttrib.attrIndex(), POLY_OFFSET_TAG, dim_c<1>, prim_id_c),
+                  range(faceAttrib.attrIndex(), POLY_SIZE_TAG, dim_c<1>, prim_id_c)),
+              [&verts, vertAttrib = view<space>(vertAttrib.attrIndex()),
+               pidChnOffset = vertAttrib.getIndexPropertyOffset(POINT_ID_TAG)](
                   PrimIndex polyOffset, PrimIndex polySize) mutable {
                 PrimIndex ed = polyOffset + polySize;
                 vertAttrib(pidChnOffset, polyOffset, prim_id_c) = verts[polyOffset];
@@ -1058,8 +1075,9 @@ namespace zs {
               });
         } else
           pol(enumerate(verts),
-              [vertAttrib = view<space>(vertAttrib.attr32()),
-               pidChnOffset = vertAttrib.getPropertyOffset(POINT_ID_TAG)](int i, int vert) mutable {
+              [vertAttrib = view<space>(vertAttrib.attrIndex()),
+               pidChnOffset = vertAttrib.getIndexPropertyOffset(POINT_ID_TAG)](
+                  PrimIndex i, int vert) mutable {
                 vertAttrib(pidChnOffset, i, prim_id_c) = vert;
               });
         keyframes.emplaceAttribDefault(KEYFRAME_ATTRIB_FACE_LABEL, zs::move(faceAttrib));
@@ -1070,25 +1088,26 @@ namespace zs {
         std::iota(verts.begin(), verts.end(), 0);
         faceSizes.resize(numVerts, 1);
         vertAttrib._owner = prim_attrib_owner_e::vert;
-        vertAttrib.appendProperties32(pol, {{POINT_ID_TAG, 1}}, loc);
+        vertAttrib.appendIndexProperties(pol, {{POINT_ID_TAG, 1}}, loc);
         vertAttrib.resize(numVerts);
         faceAttrib._owner = prim_attrib_owner_e::face;
-        faceAttrib.appendProperties32(pol, {{POLY_SIZE_TAG, 1}, {POLY_OFFSET_TAG, 1}}, loc);
+        faceAttrib.appendIndexProperties(pol, {{POLY_SIZE_TAG, 1}, {POLY_OFFSET_TAG, 1}}, loc);
         faceAttrib.resize(numVerts);
         // assign verts/faceSizes to topoAttrib
         pol(enumerate(verts),
-            [verts = view<space>(vertAttrib.attr32()),
-             pidChnOffset = vertAttrib.getPropertyOffset(POINT_ID_TAG)](int i, int vert) mutable {
-              verts(pidChnOffset, i, prim_id_c) = vert;
-            });
+            [verts = view<space>(vertAttrib.attrIndex()),
+             pidChnOffset = vertAttrib.getIndexPropertyOffset(POINT_ID_TAG)](
+                PrimIndex i, int vert) mutable { verts(pidChnOffset, i, prim_id_c) = vert; });
         keyframes.emplaceAttribDefault(KEYFRAME_ATTRIB_FACE_INDEX_LABEL, zs::move(vertAttrib));
         pol(enumerate(faceSizes),
-            [faceSizes = view<space>(faceAttrib.attr32()),
-             szChnOffset = faceAttrib.getPropertyOffset(POLY_SIZE_TAG)](
-                int i, int faceSize) mutable { faceSizes(szChnOffset, i, prim_id_c) = faceSize; });
-        exclusive_scan(pol, faceAttrib.attr32().begin(POLY_SIZE_TAG, dim_c<1>, prim_id_c),
-                       faceAttrib.attr32().end(POLY_SIZE_TAG, dim_c<1>, prim_id_c),
-                       faceAttrib.attr32().begin(POLY_OFFSET_TAG, dim_c<1>, prim_id_c));
+            [faceSizes = view<space>(faceAttrib.attrIndex()),
+             szChnOffset = faceAttrib.getIndexPropertyOffset(POLY_SIZE_TAG)](
+                PrimIndex i, int faceSize) mutable {
+              faceSizes(szChnOffset, i, prim_id_c) = faceSize;
+            });
+        exclusive_scan(pol, faceAttrib.attrIndex().begin(POLY_SIZE_TAG, dim_c<1>, prim_id_c),
+                       faceAttrib.attrIndex().end(POLY_SIZE_TAG, dim_c<1>, prim_id_c),
+                       faceAttrib.attrIndex().begin(POLY_OFFSET_TAG, dim_c<1>, prim_id_c));
         keyframes.emplaceAttribDefault(KEYFRAME_ATTRIB_FACE_LABEL, zs::move(faceAttrib));
       }
     }
@@ -1205,7 +1224,12 @@ namespace zs {
     // skeleton animation
     {
       TimeCode st, ed;
-      if (prim->getSkelAnimTimeCodeInterval(st, ed)) keyframes.setSkelAnimTimeCodeInterval(st, ed);
+      if (prim->getSkelAnimTimeCodeInterval(st, ed)) {
+        keyframes.setSkelAnimTimeCodeInterval(st, ed);
+        /// @note native deformers only take over once all of them are set up
+        setup_usd_blend_shapes(prim, *ret, loc);
+        if (!setup_usd_skinning_binding(prim, *ret, loc)) ret->details().blendShapes().reset();
+      }
     }
 
     /// @note setup usd prim link
@@ -1522,6 +1546,216 @@ namespace zs {
     }
     return false;
   }
+
+  bool setup_usd_blend_shapes(const ScenePrimConcept* scenePrim, PrimitiveStorage& geom,
+                              const source_location& loc) {
+    if (!scenePrim) return false;
+    try {
+      auto usdPrim = std::any_cast<pxr::UsdPrim>(scenePrim->getRawPrim());
+      if (!usdPrim.IsValid()) return false;
+
+      pxr::UsdSkelCache skelCache;
+      pxr::UsdSkelBindingAPI skelBinding(usdPrim);
+      auto skelRoot = pxr::UsdSkelRoot::Find(usdPrim);
+      if (!skelRoot) return false;
+
+      skelCache.Populate(skelRoot, pxr::UsdTraverseInstanceProxies());
+      pxr::UsdSkelSkeletonQuery skelQuery
+          = skelCache.GetSkelQuery(skelBinding.GetInheritedSkeleton());
+      pxr::UsdSkelSkinningQuery skinQuery = skelCache.GetSkinningQuery(usdPrim);
+      if (!skelQuery || !skinQuery || !skinQuery.HasBlendShapes()) return false;
+      const auto& animQuery = skelQuery.GetAnimQuery();
+      if (!animQuery) return false;
+
+      auto posFrame = geom.keyframes().getAttribKeyFrame(KEYFRAME_ATTRIB_POS_LABEL,
+                                                         g_default_timecode());
+      if (posFrame.expired()) return false;
+
+      auto blendShapes = std::make_shared<BlendShapeSet>();
+      blendShapes->_numPoints = posFrame.lock()->size();
+
+      /// targets
+      /// @note inbetween shapes are not supported natively
+      pxr::UsdSkelBlendShapeQuery blendShapeQuery(skelBinding);
+      for (size_t i = 0; i != blendShapeQuery.GetNumBlendShapes(); ++i) {
+        const auto& shape = blendShapeQuery.GetBlendShape(i);
+        if (!shape.GetInbetweens().empty()) return false;
+        pxr::VtVec3fArray offsets, normalOffsets;
+        pxr::VtIntArray pointIndices;
+        shape.GetOffsetsAttr().Get(&offsets);
+        shape.GetNormalOffsetsAttr().Get(&normalOffsets);
+        shape.GetPointIndicesAttr().Get(&pointIndices);
+        if (!pointIndices.empty() && pointIndices.size() != offsets.size()) return false;
+        if (!normalOffsets.empty() && normalOffsets.size() != offsets.size()) normalOffsets.clear();
+        if (!add_blend_shape_target(
+                *blendShapes, shape.GetPrim().GetName().GetString(), offsets.size(),
+                reinterpret_cast<const glm::vec3*>(offsets.cdata()),
+                pointIndices.empty() ? nullptr : pointIndices.cdata(),
+                normalOffsets.empty() ? nullptr
+                                      : reinterpret_cast<const glm::vec3*>(normalOffsets.cdata())))
+          return false;
+      }
+
+      /// weights, remapped from the animation order to the order of the targets above
+      auto retrieveWeights = [&](pxr::UsdTimeCode time, std::vector<float>& ret) {
+        pxr::VtFloatArray weights, remapped;
+        if (!animQuery.ComputeBlendShapeWeights(&weights, time)) return false;
+        const pxr::VtFloatArray* src = &weights;
+        if (auto mapper = skinQuery.GetBlendShapeMapper(); mapper && !mapper->IsIdentity()) {
+          if (!mapper->Remap(weights, &remapped)) return false;
+          src = &remapped;
+        }
+        ret.assign(src->cbegin(), src->cend());
+        return true;
+      };
+      std::vector<double> times;
+      animQuery.GetBlendShapeWeightTimeSamples(&times);
+      std::vector<float> weights;
+      if (times.empty()) {
+        if (!retrieveWeights(pxr::UsdTimeCode::Default(), weights)) return false;
+        emplace_blend_shape_weights(*blendShapes, g_default_timecode(), weights);
+      } else {
+        for (auto time : times) {
+          if (!retrieveWeights(time, weights)) return false;
+          emplace_blend_shape_weights(*blendShapes, time, weights);
+        }
+      }
+
+      blendShapes->_weights.updateSequence();
+      geom.details().blendShapes() = zs::move(blendShapes);
+      geom.keyframes().markModified();
+      return true;
+    } catch (const std::exception& e) {
+      fmt::print("setup_usd_blend_shapes: {}\n", e.what());
+    }
+    return false;
+  }
+
+  bool setup_usd_skinning_binding(const ScenePrimConcept* scenePrim, PrimitiveStorage& geom,
+                                  const source_location& loc) {
+    if (!scenePrim) return false;
+    try {
+      auto usdPrim = std::any_cast<pxr::UsdPrim>(scenePrim->getRawPrim());
+      if (!usdPrim.IsValid()) return false;
+
+      pxr::UsdSkelCache skelCache;
+      pxr::UsdSkelBindingAPI skelBinding(usdPrim);
+      auto skelRoot = pxr::UsdSkelRoot::Find(usdPrim);
+      if (!skelRoot) return false;
+
+      skelCache.Populate(skelRoot, pxr::UsdTraverseInstanceProxies());
+      pxr::UsdSkelSkeletonQuery skelQuery
+          = skelCache.GetSkelQuery(skelBinding.GetInheritedSkeleton());
+      pxr::UsdSkelSkinningQuery skinQuery = skelCache.GetSkinningQuery(usdPrim);
+      if (!skelQuery || !skinQuery) return false;
+      if (skinQuery.HasBlendShapes() && !geom.details().blendShapes()) return false;
+
+      /// influences
+      pxr::VtIntArray jointIndices;
+      pxr::VtFloatArray jointWeights;
+      if (!skinQuery.ComputeJointInfluences(&jointIndices, &jointWeights)) return false;
+      const int numInfluences = skinQuery.GetNumInfluencesPerComponent();
+      if (numInfluences <= 0) return false;
+
+      auto posFrame = geom.keyframes().getAttribKeyFrame(KEYFRAME_ATTRIB_POS_LABEL,
+                                                         g_default_timecode());
+      if (posFrame.expired()) return false;
+      const int numPoints = posFrame.lock()->size();
+      if (skinQuery.IsRigidlyDeformed()) {
+        /// @note constant influences shared by all points
+        pxr::VtIntArray indices(numPoints * numInfluences);
+        pxr::VtFloatArray weights(numPoints * numInfluences);
+        for (int i = 0; i != numPoints; ++i)
+          for (int k = 0; k != numInfluences; ++k) {
+            indices[i * numInfluences + k] = jointIndices[k];
+            weights[i * numInfluences + k] = jointWeights[k];
+          }
+        jointIndices = zs::move(indices);
+        jointWeights = zs::move(weights);
+      }
+      if (jointIndices.size() != (size_t)numPoints * numInfluences) return false;
+
+      /// @note joint transforms are ordered by the skeleton, whereas influences by the skin
+      auto toGlm = [](const pxr::GfMatrix4d& m) {
+        glm::mat4 ret;
+        for (int i = 0; i != 4; ++i)
+          for (int j = 0; j != 4; ++j) ret[i][j] = (float)m[i][j];
+        return ret;
+      };
+      auto toSkinOrder = [&skinQuery, &toGlm](const pxr::VtMatrix4dArray& xforms,
+                                              std::vector<glm::mat4>& ret) {
+        pxr::VtMatrix4dArray remapped;
+        const pxr::VtMatrix4dArray* src = &xforms;
+        if (auto mapper = skinQuery.GetJointMapper(); mapper && !mapper->IsIdentity()) {
+          if (!mapper->RemapTransforms(xforms, &remapped)) return false;
+          src = &remapped;
+        }
+        ret.resize(src->size());
+        for (size_t j = 0; j != src->size(); ++j) ret[j] = toGlm((*src)[j]);
+        return true;
+      };
+
+      pxr::VtMatrix4dArray bindXforms;
+      if (!skelQuery.GetJointWorldBindTransforms(&bindXforms)) return false;
+      std::vector<glm::mat4> jointBindTransforms;
+      if (!toSkinOrder(bindXforms, jointBindTransforms)) return false;
+
+      auto binding = build_skinning_binding(numPoints, numInfluences, jointIndices.cdata(),
+                                            jointWeights.cdata(), jointBindTransforms,
+                                            toGlm(skinQuery.GetGeomBindTransform()));
+
+      /// @note the parent of a skin joint is its nearest skeleton ancestor bound by the skin
+      {
+        const auto skelJoints = skelQuery.GetJointOrder();
+        pxr::VtTokenArray skinJoints;
+        if (!skinQuery.GetJointOrder(&skinJoints)) skinJoints = skelJoints;
+        std::unordered_map<pxr::TfToken, int, pxr::TfToken::HashFunctor> skinIndices;
+        for (size_t j = 0; j != skinJoints.size(); ++j) skinIndices.emplace(skinJoints[j], (int)j);
+        std::unordered_map<pxr::TfToken, int, pxr::TfToken::HashFunctor> skelIndices;
+        for (size_t j = 0; j != skelJoints.size(); ++j) skelIndices.emplace(skelJoints[j], (int)j);
+        const auto& topology = skelQuery.GetTopology();
+        std::vector<int> jointParents(skinJoints.size(), -1);
+        for (size_t j = 0; j != skinJoints.size(); ++j) {
+          auto it = skelIndices.find(skinJoints[j]);
+          if (it == skelIndices.end()) continue;
+          for (int k = topology.GetParent(it->second); k != -1; k = topology.GetParent(k))
+            if (auto jt = skinIndices.find(skelJoints[k]); jt != skinIndices.end()) {
+              jointParents[j] = jt->second;
+              break;
+            }
+        }
+        if (!set_skinning_joint_parents(*binding, zs::move(jointParents)))
+          fmt::print("setup_usd_skinning_binding: joints of [{}] interpolated in skeleton space\n",
+                     usdPrim.GetPath().GetString());
+      }
+
+      /// animated joint transforms, sampled once here
+      std::vector<double> times;
+      if (const auto& animQuery = skelQuery.GetAnimQuery(); animQuery)
+        animQuery.GetJointTransformTimeSamples(&times);
+      pxr::VtMatrix4dArray xforms;
+      std::vector<glm::mat4> jointTransforms;
+      if (times.empty()) {
+        if (!skelQuery.ComputeJointSkelTransforms(&xforms, pxr::UsdTimeCode::Default())
+            || !toSkinOrder(xforms, jointTransforms))
+          return false;
+        emplace_joint_transforms(*binding, g_default_timecode(), jointTransforms);
+      } else {
+        for (auto time : times) {
+          if (!skelQuery.ComputeJointSkelTransforms(&xforms, time)
+              || !toSkinOrder(xforms, jointTransforms))
+            return false;
+          emplace_joint_transforms(*binding, time, jointTransforms);
+        }
+      }
+
+      attach_skinning_binding(geom, zs::move(binding));
+      return true;
+    } catch (const std::exception& e) {
+      fmt::print("setup_usd_skinning_binding: {}\n", e.what());
+    }
+    return false;
+  }
 #endif
 
 }  // namespace zs
\ No newline at end of file
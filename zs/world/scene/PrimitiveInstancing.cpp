@@ -0,0 +1,491 @@
+#include "PrimitiveInstancing.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+#include "PrimitiveBlendShape.hpp"
+#include "PrimitiveConversion.hpp"
+#include "PrimitiveSkinning.hpp"
+#include "world/core/HashIndex.hpp"
+
+#if ZS_ENABLE_OPENMP
+#  include "zensim/omp/execution/ExecutionPolicy.hpp"
+#else
+#  include "zensim/execution/ExecutionPolicy.hpp"
+#endif
+
+namespace zs {
+
+  namespace {
+    u64 hash_combine(u64 h, u64 v) noexcept {
+      return hash_index_mix(h ^ (v + 0x9e3779b97f4a7c15ull));
+    }
+    u64 hash_tags(u64 h, const std::vector<PropertyTag> &tags) {
+      for (const auto &tag : tags) {
+        h = hash_combine(h, std::hash<std::string>{}(tag.name.asString()));
+        h = hash_combine(h, tag.numChannels);
+      }
+      return h;
+    }
+    u64 hash_attr_vector(u64 h, const AttrVector &attr) {
+      const auto props = attr.getProperties(), props64 = attr.getProperties64();
+      h = hash_combine(h, (u64)attr._owner);
+      h = hash_combine(h, attr.size());
+      h = hash_tags(h, props);
+      h = hash_tags(h, props64);
+      auto v32 = view<execspace_e::host>({}, attr.attr32());
+      auto v64 = view<execspace_e::host>({}, attr.attr64());
+      const int numChns32 = attr.attr32().numChannels(), numChns64 = attr.attr64().numChannels();
+      for (PrimIndex i = 0; i != attr.size(); ++i) {
+        for (int d = 0; d != numChns32; ++d) {
+          u32 bits;
+          f32 v = v32(d, i);
+          std::memcpy(&bits, &v, sizeof(bits));
+          h = hash_combine(h, bits);
+        }
+        for (int d = 0; d != numChns64; ++d) h = hash_combine(h, v64(d, i));
+      }
+      return hash_combine(h, attr.strings().size());
+    }
+    bool identical_attr_vectors(const AttrVector &a, const AttrVector &b) {
+      if (&a == &b) return true;
+      if (a._owner != b._owner || a.size() != b.size()) return false;
+      const auto pa = a.getProperties(), pb = b.getProperties();
+      const auto pa64 = a.getProperties64(), pb64 = b.getProperties64();
+      if (pa.size() != pb.size() || pa64.size() != pb64.size()) return false;
+      for (size_t k = 0; k != pa.size(); ++k)
+        if (pa[k].name.asString() != pb[k].name.asString()
+            || pa[k].numChannels != pb[k].numChannels)
+          return false;
+      for (size_t k = 0; k != pa64.size(); ++k)
+        if (pa64[k].name.asString() != pb64[k].name.asString()
+            || pa64[k].numChannels != pb64[k].numChannels)
+          return false;
+      /// @note strings are never shared
+      if (a.strings().size() || b.strings().size()) return false;
+      auto a32 = view<execspace_e::host>({}, a.attr32());
+      auto b32 = view<execspace_e::host>({}, b.attr32());
+      auto a64 = view<execspace_e::host>({}, a.attr64());
+      auto b64 = view<execspace_e::host>({}, b.attr64());
+      const int numChns32 = a.attr32().numChannels(), numChns64 = a.attr64().numChannels();
+      for (PrimIndex i = 0; i != a.size(); ++i) {
+        for (int d = 0; d != numChns32; ++d) {
+          f32 va = a32(d, i), vb = b32(d, i);
+          if (std::memcmp(&va, &vb, sizeof(f32))) return false;
+        }
+        for (int d = 0; d != numChns64; ++d)
+          if (a64(d, i) != b64(d, i)) return false;
+      }
+      return true;
+    }
+
+    /// @note a prim qualifies if its geometry comes solely from (undeformed) attrib keyframes
+    bool deduplication_eligible(const ZsPrimitive &prim) {
+      const auto &keyframes = prim.keyframes();
+      const auto &details = prim.details();
+      if (keyframes.hasSkelAnim() || details.skinningBinding() || details.blendShapes())
+        return false;
+      if (!keyframes.hasAttrib(KEYFRAME_ATTRIB_POS_LABEL)) return false;
+      return true;
+    }
+    template <typename F> void for_each_attrib_frame(const KeyFrames<AttrVector> &kfs, F &&f) {
+      auto &frames = const_cast<KeyFrames<AttrVector> &>(kfs);
+      if (auto &v = frames.refDefaultValue()) f(NAN, v);
+      for (auto &[tc, v] : frames.refKeyframes()) f(tc, v);
+    }
+    u64 hash_keyframes(const PrimKeyFrames &keyframes) {
+      u64 h = 0;
+      for (const auto &[label, kfs] : keyframes._attribs) {
+        h = hash_combine(h, std::hash<std::string>{}(label));
+        for_each_attrib_frame(kfs, [&h](TimeCode tc, const Shared<AttrVector> &frame) {
+          u64 bits;
+          std::memcpy(&bits, &tc, sizeof(bits));
+          h = hash_combine(h, bits);
+          if (frame) h = hash_attr_vector(h, *frame);
+        });
+      }
+      return h;
+    }
+    bool identical_keyframes(const PrimKeyFrames &a, const PrimKeyFrames &b) {
+      if (a._attribs.size() != b._attribs.size()) return false;
+      for (auto ita = a._attribs.begin(), itb = b._attribs.begin(); ita != a._attribs.end();
+           ++ita, ++itb) {
+        if ((*ita).first != (*itb).first) return false;
+        auto &ka = const_cast<KeyFrames<AttrVector> &>((*ita).second);
+        auto &kb = const_cast<KeyFrames<AttrVector> &>((*itb).second);
+        auto &da = ka.refDefaultValue(), &db = kb.refDefaultValue();
+        if (!da != !db || (da && !identical_attr_vectors(*da, *db))) return false;
+        auto &fa = ka.refKeyframes(), &fb = kb.refKeyframes();
+        if (fa.size() != fb.size()) return false;
+        for (auto ia = fa.begin(), ib = fb.begin(); ia != fa.end(); ++ia, ++ib) {
+          if ((*ia).first != (*ib).first) return false;
+          if (!(*ia).second != !(*ib).second) return false;
+          if ((*ia).second && !identical_attr_vectors(*(*ia).second, *(*ib).second)) return false;
+        }
+      }
+      return true;
+    }
+    /// @brief box of the positions of a static prim, read from its keyframes
+    bool keyframe_bounding_box(const PrimKeyFrames &keyframes, PrimitiveBoundingBox &box) {
+      auto pos
+          = keyframes.getAttribKeyFrame(KEYFRAME_ATTRIB_POS_LABEL, g_default_timecode()).lock();
+      if (!pos || pos->size() == 0 || !pos->hasProperty(ATTRIB_POS_TAG)) return false;
+      auto posView = view<execspace_e::host>({}, pos->attr32());
+      const auto offset = pos->getPropertyOffset(ATTRIB_POS_TAG);
+      for (PrimIndex i = 0; i != pos->size(); ++i) {
+        glm::vec3 p{posView(offset, i), posView(offset + 1, i), posView(offset + 2, i)};
+        if (i == 0)
+          box.init(p);
+        else
+          box.merge(p);
+      }
+      return true;
+    }
+    size_t tri_mesh_bytes(const ZsTriMesh &mesh) noexcept {
+      return mesh.nodes.size() * sizeof(mesh.nodes[0]) + mesh.uvs.size() * sizeof(mesh.uvs[0])
+             + mesh.norms.size() * sizeof(mesh.norms[0])
+             + mesh.colors.size() * sizeof(mesh.colors[0])
+             + mesh.elems.size() * sizeof(mesh.elems[0]);
+    }
+  }  // namespace
+
+  bool setup_instancing(PrimitiveStorage &prim, Shared<ZsPrimitive> prototype,
+                        const std::vector<glm::mat4> &instanceTransforms,
+                        const std::vector<PropertyTag> &instanceProps, const source_location &loc) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+    constexpr auto space = execspace_e::openmp;
+#else
+    auto pol = seq_exec();
+    constexpr auto space = execspace_e::host;
+#endif
+    if (!prototype) return false;
+
+    /// @note bottom-level structure shared by all instances for picking
+    auto &protoDetails = prototype->details();
+    if (protoDetails.triBvh().getNumLeaves() == 0) {
+      if (protoDetails.triMesh().nodes.size() == 0)
+        assign_primitive_to_trimesh(*prototype, protoDetails.triMesh(), loc);
+      prototype->updateTriBvh(true);
+    }
+
+    auto pack = prim.localPackPrims();
+    pack->_prototype = zs::move(prototype);
+    auto &instances = pack->instances();
+    instances = AttrVector{};
+    instances._owner = prim_attrib_owner_e::prim;
+    std::vector<PropertyTag> props{{ATTRIB_INSTANCE_TRANSFORM_TAG, 16}};
+    props.insert(props.end(), instanceProps.begin(), instanceProps.end());
+    instances.appendProperties32(pol, props, loc);
+    instances.resize(instanceTransforms.size());
+
+    std::vector<int> extraOffsets;
+    for (const auto &prop : instanceProps)
+      for (int d = 0; d != prop.numChannels; ++d)
+        extraOffsets.push_back(instances.getPropertyOffset(prop.name) + d);
+    pol(range(instanceTransforms.size()),
+        [instView = view<space>({}, instances.attr32()),
+         offset = instances.getPropertyOffset(ATTRIB_INSTANCE_TRANSFORM_TAG), &instanceTransforms,
+         &extraOffsets](PrimIndex i) mutable {
+          const auto &m = instanceTransforms[i];
+          for (int c = 0; c != 4; ++c)
+            for (int r = 0; r != 4; ++r) instView(offset + c * 4 + r, i) = m[c][r];
+          for (auto chn : extraOffsets) instView(chn, i) = 0.f;
+        });
+
+    update_instanced_bounding_box(prim);
+    return true;
+  }
+
+  const PackPrimContainer *get_instancing(const PrimitiveStorage &prim) noexcept {
+    if (auto it = prim._localPrims.find(PrimitiveStorage::Pack_); it != prim._localPrims.end())
+      if (auto pack = dynamic_cast<const PackPrimContainer *>((*it).second.get());
+          pack && pack->isInstanced())
+        return pack;
+    return nullptr;
+  }
+
+  glm::mat4 get_instance_transform(const PackPrimContainer &pack, PrimIndex i) {
+    const auto &instances = pack.instances();
+    auto instView = view<execspace_e::host>({}, instances.attr32());
+    const auto offset = instances.getPropertyOffset(ATTRIB_INSTANCE_TRANSFORM_TAG);
+    glm::mat4 ret;
+    for (int c = 0; c != 4; ++c)
+      for (int r = 0; r != 4; ++r) ret[c][r] = instView(offset + c * 4 + r, i);
+    return ret;
+  }
+  void set_instance_transform(PackPrimContainer &pack, PrimIndex i, const glm::mat4 &xform) {
+    auto &instances = pack.instances();
+    auto instView = view<execspace_e::host>({}, instances.attr32());
+    const auto offset = instances.getPropertyOffset(ATTRIB_INSTANCE_TRANSFORM_TAG);
+    for (int c = 0; c != 4; ++c)
+      for (int r = 0; r != 4; ++r) instView(offset + c * 4 + r, i) = xform[c][r];
+    pack._boundsStale = true;
+  }
+  bool set_instance_transform(PrimitiveStorage &prim, PrimIndex i, const glm::mat4 &xform) {
+    auto pack = const_cast<PackPrimContainer *>(get_instancing(prim));
+    if (!pack || i < 0 || i >= pack->numInstances()) return false;
+    /// @note the box grown below encloses this instance, not those moved through the pack alone
+    const bool stale = pack->_boundsStale;
+    set_instance_transform(*pack, i, xform);
+    pack->_boundsStale = stale;
+    auto &details = prim.details();
+    const auto &protoDetails = pack->prototype()->details();
+    if (protoDetails.triBvh().getNumLeaves() != 0) {
+      const auto box = transform_bounding_box(protoDetails.localBoundingBox(), xform);
+      details.localBoundingBox().merge(box.minPos);
+      details.localBoundingBox().merge(box.maxPos);
+    }
+    details.markModified();
+    return true;
+  }
+
+  PrimitiveBoundingBox transform_bounding_box(const PrimitiveBoundingBox &box,
+                                              const glm::mat4 &xform) noexcept {
+    PrimitiveBoundingBox ret;
+    for (int i = 0; i != 8; ++i) {
+      glm::vec3 corner{i & 1 ? box.maxPos.x : box.minPos.x, i & 2 ? box.maxPos.y : box.minPos.y,
+                       i & 4 ? box.maxPos.z : box.minPos.z};
+      auto p = glm::vec3(xform * glm::vec4(corner, 1.f));
+      if (i == 0)
+        ret.init(p);
+      else
+        ret.merge(p);
+    }
+    return ret;
+  }
+
+  bool update_instanced_bounding_box(PrimitiveStorage &prim) {
+    auto pack = get_instancing(prim);
+    PrimitiveBoundingBox box;
+    if (!pack || !compute_instanced_bounding_box(*pack, box)) return false;
+    auto &details = prim.details();
+    /// @note the prim's own geometry, if any
+    if (const auto &bvh = details.triBvh(); bvh.getNumLeaves() != 0) {
+      auto pol = seq_exec();
+      auto rootBv = bvh.getTotalBox(pol);
+      box.merge(glm::vec3{rootBv._min[0], rootBv._min[1], rootBv._min[2]});
+      box.merge(glm::vec3{rootBv._max[0], rootBv._max[1], rootBv._max[2]});
+    }
+    details.localBoundingBox() = box;
+    const_cast<PackPrimContainer *>(pack)->_boundsStale = false;
+    return true;
+  }
+
+  bool compute_instanced_bounding_box(const PackPrimContainer &pack, PrimitiveBoundingBox &box) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    const PrimIndex numInstances = pack.numInstances();
+    if (!pack.isInstanced() || numInstances == 0) return false;
+    const auto &protoDetails = pack.prototype()->details();
+    if (protoDetails.triBvh().getNumLeaves() == 0) return false;
+    const auto &protoBox = protoDetails.localBoundingBox();
+
+    std::vector<PrimitiveBoundingBox> boxes(numInstances);
+    pol(range(numInstances), [&](PrimIndex i) {
+      boxes[i] = transform_bounding_box(protoBox, get_instance_transform(pack, i));
+    });
+    box = boxes[0];
+    for (PrimIndex i = 1; i < numInstances; ++i) {
+      box.merge(boxes[i].minPos);
+      box.merge(boxes[i].maxPos);
+    }
+    return true;
+  }
+
+  InstancingMemoryUsage get_instancing_memory_usage(const PackPrimContainer &pack) {
+    InstancingMemoryUsage ret;
+    if (pack.isInstanced()) ret._prototypeBytes = primitive_storage_bytes(*pack.prototype());
+    ret._instanceBytes = attr_vector_bytes(pack.instances());
+    return ret;
+  }
+
+  MeshDeduplicationStats share_duplicate_meshes(ZsPrimitive &root) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    MeshDeduplicationStats stats;
+    std::vector<ZsPrimitive *> prims;
+    std::vector<ZsPrimitive *> stack{&root};
+    while (stack.size()) {
+      auto prim = stack.back();
+      stack.pop_back();
+      if (deduplication_eligible(*prim)) prims.push_back(prim);
+      for (const auto &ch : prim->children()) stack.push_back(ch.get());
+    }
+    const auto numPrims = prims.size();
+    stats._numCandidates = numPrims;
+    if (numPrims < 2) return stats;
+
+    // hash
+    std::vector<u64> hashes(numPrims);
+    pol(range(numPrims), [&](size_t i) { hashes[i] = hash_keyframes(prims[i]->keyframes()); });
+
+    // group, the first occurrence (in traversal order) becomes the prototype
+    std::unordered_map<u64, size_t> firstOccurrence;
+    std::vector<std::pair<size_t, size_t>> candidates;  // (duplicate, prototype)
+    for (size_t i = 0; i != numPrims; ++i) {
+      auto [it, fresh] = firstOccurrence.emplace(hashes[i], i);
+      if (!fresh) candidates.emplace_back(i, (*it).second);
+    }
+    if (candidates.empty()) return stats;
+
+    // verify (rule out hash collisions)
+    std::vector<u8> identical(candidates.size());
+    pol(range(candidates.size()), [&](size_t k) {
+      const auto [dup, proto] = candidates[k];
+      identical[k] = identical_keyframes(prims[dup]->keyframes(), prims[proto]->keyframes());
+    });
+
+    // share
+    std::vector<u8> isPrototype(numPrims, 0);
+    for (size_t k = 0; k != candidates.size(); ++k) {
+      if (!identical[k]) continue;
+      const auto [dup, proto] = candidates[k];
+      auto &dstKeyframes = prims[dup]->keyframes();
+      auto &srcKeyframes = prims[proto]->keyframes();
+      for (auto &[label, kfs] : dstKeyframes._attribs) {
+        for_each_attrib_frame(kfs, [&stats](TimeCode, const Shared<AttrVector> &frame) {
+          if (frame && frame.use_count() == 1) stats._bytesSaved += attr_vector_bytes(*frame);
+        });
+        auto &src = srcKeyframes._attribs.at(label);
+        kfs.refDefaultValue() = src.refDefaultValue();
+        kfs.refKeyframes() = src.refKeyframes();
+        kfs.refDirty() = true;
+      }
+      dstKeyframes.updateSequences();
+      dstKeyframes.markModified();
+      if (!isPrototype[proto]) {
+        isPrototype[proto] = 1;
+        stats._numGroups++;
+      }
+      stats._numShared++;
+    }
+    stats._numMeshSources = link_mesh_sources(root);
+    return stats;
+  }
+
+  size_t link_mesh_sources(ZsPrimitive &root) {
+    /// @note the owning pointers of the prims (none for [root]) serve as mesh sources
+    std::vector<std::pair<ZsPrimitive *, Shared<ZsPrimitive>>> prims;
+    std::vector<std::pair<ZsPrimitive *, Shared<ZsPrimitive>>> stack{{&root, {}}};
+    while (stack.size()) {
+      auto entry = zs::move(stack.back());
+      stack.pop_back();
+      auto prim = entry.first;
+      if (deduplication_eligible(*prim) && !prim->details().isMeshTimeVarying())
+        prims.push_back(entry);
+      for (const auto &ch : prim->children()) stack.emplace_back(ch.get(), ch);
+    }
+
+    /// @note keyed on the identity of the frames, not on their content
+    auto frames_of = [](const ZsPrimitive &prim) {
+      std::vector<const void *> ret;
+      for (const auto &[label, kfs] : prim.keyframes()._attribs)
+        for_each_attrib_frame(kfs, [&ret](TimeCode, const Shared<AttrVector> &frame) {
+          ret.push_back(frame.get());
+        });
+      return ret;
+    };
+    std::map<std::vector<const void *>, Shared<ZsPrimitive>> sources;
+    size_t ret = 0;
+    for (auto &[prim, owner] : prims) {
+      auto [it, fresh] = sources.emplace(frames_of(*prim), owner);
+      if (fresh) continue;
+      /// @note the first owned occurrence becomes the source
+      auto &source = (*it).second;
+      if (!source) {
+        source = owner;
+        continue;
+      }
+      if (!keyframe_bounding_box(prim->keyframes(), prim->details().localBoundingBox())) continue;
+      prim->setMeshSource(source);
+      ret++;
+    }
+    return ret;
+  }
+
+  size_t get_mesh_sharing_savings(const ZsPrimitive &root) {
+    size_t ret = 0;
+    std::vector<const ZsPrimitive *> stack{&root};
+    while (stack.size()) {
+      auto prim = stack.back();
+      stack.pop_back();
+      if (auto source = prim->meshSource()) {
+        const auto &details = source->details();
+        ret += tri_mesh_bytes(details.triMesh());
+        ret += details.triBvh().getNumNodes() * sizeof(details.triBvh().orderedBvs[0]);
+        if (const auto &visualMesh = details.visualMesh())
+          ret += primitive_storage_bytes(*visualMesh);
+      }
+      for (const auto &ch : prim->children()) stack.push_back(ch.get());
+    }
+    return ret;
+  }
+
+  bool flatten_instances(const PackPrimContainer &pack, ZsTriMesh &triMesh,
+                         const source_location &loc) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    if (!pack.isInstanced()) return false;
+    const auto &prototype = *pack.prototype();
+    ZsTriMesh protoMesh;
+    const ZsTriMesh *src = &prototype.details().triMesh();
+    if (src->nodes.size() == 0) {
+      assign_primitive_to_trimesh(prototype, protoMesh, loc);
+      src = &protoMesh;
+    }
+    const size_t numNodes = src->nodes.size(), numElems = src->elems.size();
+    const size_t numInstances = pack.numInstances();
+    /// @note element indices are 32-bit
+    if (numNodes * numInstances > std::numeric_limits<u32>::max()) return false;
+
+    triMesh.clear();
+    triMesh.nodes.resize(numNodes * numInstances);
+    triMesh.elems.resize(numElems * numInstances);
+    const bool hasNormals = src->norms.size() == numNodes;
+    const bool hasUVs = src->uvs.size() == numNodes;
+    const bool hasColors = src->colors.size() == numNodes;
+    if (hasNormals) triMesh.norms.resize(numNodes * numInstances);
+    if (hasUVs) triMesh.uvs.resize(numNodes * numInstances);
+    if (hasColors) triMesh.colors.resize(numNodes * numInstances);
+
+    pol(range(numInstances), [&](size_t i) {
+      const auto xform = get_instance_transform(pack, (PrimIndex)i);
+      const auto nrmXform = glm::transpose(glm::inverse(glm::mat3(xform)));
+      const size_t nodeBase = i * numNodes, elemBase = i * numElems;
+      for (size_t k = 0; k != numNodes; ++k) {
+        const auto &n = src->nodes[k];
+        auto p = glm::vec3(xform * glm::vec4(n[0], n[1], n[2], 1.f));
+        auto &dst = triMesh.nodes[nodeBase + k];
+        for (int d = 0; d != 3; ++d) dst[d] = p[d];
+        if (hasNormals) {
+          const auto &nrm = src->norms[k];
+          auto v = glm::normalize(nrmXform * glm::vec3(nrm[0], nrm[1], nrm[2]));
+          auto &dstNrm = triMesh.norms[nodeBase + k];
+          for (int d = 0; d != 3; ++d) dstNrm[d] = v[d];
+        }
+        if (hasUVs) triMesh.uvs[nodeBase + k] = src->uvs[k];
+        if (hasColors) triMesh.colors[nodeBase + k] = src->colors[k];
+      }
+      for (size_t k = 0; k != numElems; ++k) {
+        auto e = src->elems[k];
+        for (int d = 0; d != 3; ++d) e[d] += (u32)nodeBase;
+        triMesh.elems[elemBase + k] = e;
+      }
+    });
+    return true;
+  }
+
+}  // namespace zs
@@ -0,0 +1,88 @@
+#pragma once
+#include "../WorldExport.hpp"
+#include "Primitive.hpp"
+
+namespace zs {
+
+  struct MeshDeduplicationStats {
+    size_t _numCandidates{0};   // prims inspected
+    size_t _numGroups{0};       // distinct meshes occurring more than once
+    size_t _numShared{0};       // prims now referencing the geometry of a prototype
+    size_t _numMeshSources{0};  // static ones among them drawing the meshes of the prototype
+    size_t _bytesSaved{0};      // keyframe bytes released
+  };
+
+  struct InstancingMemoryUsage {
+    size_t total() const noexcept { return _prototypeBytes + _instanceBytes; }
+
+    size_t _prototypeBytes{0};  // paid once
+    size_t _instanceBytes{0};   // transforms and per-instance attributes
+  };
+
+  /// @brief place [prototype] at [instanceTransforms] within [prim] (its local space)
+  /// @note [instanceProps] are additional per-instance channels, left zero-initialized
+  /// @note the prototype triBvh is built if absent, and the local bounding box of [prim] is set to
+  /// the union of all instance boxes (see update_instanced_bounding_box)
+  /// @note instances are not drawn, there is no gpu instancing yet, they are seen by the scene
+  /// bvh (ray casts, culling) and flatten_instances() only
+  ZS_WORLD_EXPORT bool setup_instancing(PrimitiveStorage& prim, Shared<ZsPrimitive> prototype,
+                                        const std::vector<glm::mat4>& instanceTransforms,
+                                        const std::vector<PropertyTag>& instanceProps = {},
+                                        const source_location& loc = source_location::current());
+
+  /// @brief the pack container of [prim] if it instances a prototype, nullptr otherwise
+  /// @note unlike localPackPrims(), no container is created on demand
+  ZS_WORLD_EXPORT const PackPrimContainer* get_instancing(const PrimitiveStorage& prim) noexcept;
+
+  ZS_WORLD_EXPORT glm::mat4 get_instance_transform(const PackPrimContainer& pack, PrimIndex i);
+  /// @note the owner's bounds are only marked stale (its prim is then never culled), call
+  /// update_instanced_bounding_box() on the owner after a batch of edits
+  ZS_WORLD_EXPORT void set_instance_transform(PackPrimContainer& pack, PrimIndex i,
+                                              const glm::mat4& xform);
+  /// @brief same as above on the instancing of [prim], whose local bounding box is grown to
+  /// enclose the moved instance
+  /// @note the box only grows (stays conservative for culling), it is tightened by
+  /// update_instanced_bounding_box()
+  ZS_WORLD_EXPORT bool set_instance_transform(PrimitiveStorage& prim, PrimIndex i,
+                                              const glm::mat4& xform);
+
+  /// @brief box enclosing [box] transformed by [xform]
+  ZS_WORLD_EXPORT PrimitiveBoundingBox transform_bounding_box(const PrimitiveBoundingBox& box,
+                                                              const glm::mat4& xform) noexcept;
+  /// @brief union of the prototype box placed at every instance transform
+  /// @return false if there is no instance or the prototype bounds are unknown
+  ZS_WORLD_EXPORT bool compute_instanced_bounding_box(const PackPrimContainer& pack,
+                                                      PrimitiveBoundingBox& box);
+  /// @brief set the local bounding box of [prim] to the union of its own geometry (if its
+  /// triBvh is built) and all of its instances
+  /// @return false if [prim] instances nothing or the prototype bounds are unknown
+  ZS_WORLD_EXPORT bool update_instanced_bounding_box(PrimitiveStorage& prim);
+
+  ZS_WORLD_EXPORT InstancingMemoryUsage get_instancing_memory_usage(const PackPrimContainer& pack);
+
+  /// @brief detect byte-identical meshes within the hierarchy of [root], then let the duplicates
+  /// share the keyframe geometry of their first occurrence (the prototype)
+  /// @note static duplicates further take the prototype as their mesh source, see
+  /// link_mesh_sources()
+  /// @note each prim keeps its own transform, label and children
+  /// @note shared frames are copied upon modification, see PrimKeyFrames::getWritableAttribKeyFrame
+  /// @note skinned or blend-shaped prims are left untouched, as their keyframes get deformed
+  ZS_WORLD_EXPORT MeshDeduplicationStats share_duplicate_meshes(ZsPrimitive& root);
+  /// @brief let static prims under [root] whose keyframes are the very same attribute vectors
+  /// (as left by share_duplicate_meshes and kept by the primitive cache) take the first of them
+  /// as their mesh source (see ZsPrimitive::meshSource), thus building no visual, tri or gpu
+  /// mesh nor triBvh of their own
+  /// @note cheap, frames are compared by identity
+  /// @return number of prims given a mesh source
+  ZS_WORLD_EXPORT size_t link_mesh_sources(ZsPrimitive& root);
+  /// @brief bytes of the derived meshes (visual, tri, triBvh) prims under [root] would hold on
+  /// their own but for their mesh sources, as of the meshes built so far
+  /// @note the gpu copies are spared alike
+  ZS_WORLD_EXPORT size_t get_mesh_sharing_savings(const ZsPrimitive& root);
+
+  /// @brief expand all instances into a single triangle mesh, e.g. for export
+  /// @note nodes, normals, uvs and colors are replicated per instance
+  ZS_WORLD_EXPORT bool flatten_instances(const PackPrimContainer& pack, ZsTriMesh& triMesh,
+                                         const source_location& loc = source_location::current());
+
+}  // namespace zs
@@ -1,5 +1,7 @@
 #include "PrimitiveQuery.hpp"
 
+#include <bit>
+
 #if ZS_ENABLE_OPENMP
 #  include "zensim/omp/execution/ExecutionPolicy.hpp"
 #else
@@ -18,39 +20,220 @@ constexpr auto space = execspace_e::host;
 #endif
 */
 
+  /// @note [s_ray_tri_lanes] ray-triangle pairs are tested at a time in SoA layout, which
+  /// compilers readily vectorize, either one ray against several triangles or a packet of rays
+  /// against one triangle
+  static constexpr int s_ray_tri_lanes = 8;
+  using RayTriLanes = f32[3][s_ray_tri_lanes];
+
+  static void ray_tri_intersect_lanes(const RayTriLanes &ro, const RayTriLanes &rd,
+                                      const RayTriLanes &v0, const RayTriLanes &e1,
+                                      const RayTriLanes &e2, f32 (&ts)[s_ray_tri_lanes]) {
+    /// @note tolerances of zpc's ray_tri_intersect, which picking tested candidates with before
+    constexpr f32 eps = detail::deduce_numeric_epsilon<f32>() * 10;
+    constexpr f32 miss = detail::deduce_numeric_max<f32>();
+    for (int l = 0; l != s_ray_tri_lanes; ++l) {
+      // p = rd x e2
+      const f32 px = rd[1][l] * e2[2][l] - rd[2][l] * e2[1][l];
+      const f32 py = rd[2][l] * e2[0][l] - rd[0][l] * e2[2][l];
+      const f32 pz = rd[0][l] * e2[1][l] - rd[1][l] * e2[0][l];
+      const f32 det = e1[0][l] * px + e1[1][l] * py + e1[2][l] * pz;
+      const f32 invDet = 1.f / (zs::abs(det) > eps ? det : 1.f);
+      // s = ro - v0
+      const f32 sx = ro[0][l] - v0[0][l], sy = ro[1][l] - v0[1][l], sz = ro[2][l] - v0[2][l];
+      const f32 u = (sx * px + sy * py + sz * pz) * invDet;
+      // q = s x e1
+      const f32 qx = sy * e1[2][l] - sz * e1[1][l];
+      const f32 qy = sz * e1[0][l] - sx * e1[2][l];
+      const f32 qz = sx * e1[1][l] - sy * e1[0][l];
+      const f32 v = (rd[0][l] * qx + rd[1][l] * qy + rd[2][l] * qz) * invDet;
+      const f32 t = (e2[0][l] * qx + e2[1][l] * qy + e2[2][l] * qz) * invDet;
+      const bool hit = zs::abs(det) > eps && u >= -eps && v >= -eps && u + v <= 1.f + eps * 2
+                       && t > eps;
+      ts[l] = hit ? t : miss;
+    }
+  }
+
+  static void load_tri_lane(const ZsTriMesh &triMesh, PrimIndex triNo, int l, RayTriLanes &v0,
+                            RayTriLanes &e1, RayTriLanes &e2) {
+    auto tri = triMesh.elems[triNo];
+    const auto &p0 = triMesh.nodes[tri[0]];
+    const auto &p1 = triMesh.nodes[tri[1]];
+    const auto &p2 = triMesh.nodes[tri[2]];
+    for (int d = 0; d != 3; ++d) {
+      v0[d][l] = p0[d];
+      e1[d][l] = p1[d] - p0[d];
+      e2[d][l] = p2[d] - p0[d];
+    }
+  }
+
+  /// @brief closest hit in the local space of the mesh, max if none
+  /// @note [candidates] is scratch space reused across rays
+  template <typename BvhView>
+  static f32 closest_ray_tri_hit(const BvhView &bvhv, const ZsTriMesh &triMesh,
+                                 const zs::vec<f32, 3> &ro, const zs::vec<f32, 3> &rd,
+                                 std::vector<PrimIndex> &candidates, PrimIndex *triNo) {
+    candidates.clear();
+    bvhv.ray_intersect(ro, rd, [&candidates](PrimIndex triNo) { candidates.push_back(triNo); });
+
+    f32 dist = detail::deduce_numeric_max<f32>();
+    RayTriLanes ros, rds, v0, e1, e2;
+    f32 ts[s_ray_tri_lanes];
+    for (int d = 0; d != 3; ++d)
+      for (int l = 0; l != s_ray_tri_lanes; ++l) {
+        ros[d][l] = ro[d];
+        rds[d][l] = rd[d];
+      }
+    const auto numCandidates = candidates.size();
+    for (size_t base = 0; base < numCandidates; base += s_ray_tri_lanes) {
+      const int n = std::min((size_t)s_ray_tri_lanes, numCandidates - base);
+      for (int l = 0; l != s_ray_tri_lanes; ++l) {
+        /// @note padded lanes are degenerate, thus rejected
+        if (l >= n) {
+          for (int d = 0; d != 3; ++d) v0[d][l] = e1[d][l] = e2[d][l] = 0.f;
+          continue;
+        }
+        load_tri_lane(triMesh, candidates[base + l], l, v0, e1, e2);
+      }
+      ray_tri_intersect_lanes(ros, rds, v0, e1, e2, ts);
+      for (int l = 0; l != n; ++l)
+        if (ts[l] < dist) {
+          dist = ts[l];
+          if (triNo) *triNo = candidates[base + l];
+        }
+    }
+    return dist;
+  }
+
+  /// @brief closest hits of a packet of up to [s_ray_tri_lanes] rays in the local space of the
+  /// mesh, traversing the triBvh once for all of them
+  /// @note a node is entered as long as any ray of the packet may still find a closer hit within,
+  /// each leaf triangle is then tested against the packet at once
+  /// @note [stack] is scratch space reused across packets
+  static void closest_ray_tri_hits_packet(const PrimBvh &bvh, const ZsTriMesh &triMesh,
+                                          const RayTriLanes &ro, const RayTriLanes &rd,
+                                          int numRays, f32 (&dists)[s_ray_tri_lanes],
+                                          PrimIndex (&triNos)[s_ray_tri_lanes],
+                                          std::vector<std::pair<PrimIndex, u32>> &stack) {
+    RayTriLanes invDir, v0, e1, e2;
+    f32 ts[s_ray_tri_lanes];
+    for (int l = 0; l != s_ray_tri_lanes; ++l) {
+      dists[l] = detail::deduce_numeric_max<f32>();
+      triNos[l] = -1;
+      for (int d = 0; d != 3; ++d) invDir[d][l] = 1.f / rd[d][l];
+    }
+    auto ray_box = [&](const AABBBox<3, f32> &bv, int l) {
+      f32 tmin = 0.f, tmax = dists[l];
+      for (int d = 0; d != 3; ++d) {
+        const f32 ta = (bv._min[d] - ro[d][l]) * invDir[d][l];
+        const f32 tb = (bv._max[d] - ro[d][l]) * invDir[d][l];
+        tmin = zs::max(tmin, zs::min(ta, tb));
+        tmax = zs::min(tmax, zs::max(ta, tb));
+      }
+      return tmin <= tmax;
+    };
+    /// @note rays of the packet whose slabs overlap [bv] before their closest hit so far. The
+    /// first active ray is tested alone beforehand, the whole [mask] is kept if it overlaps, which
+    /// is conservative (leaves are tested against the closest hits again) but cheap for coherent
+    /// rays.
+    auto hit_mask = [&](const AABBBox<3, f32> &bv, u32 mask) -> u32 {
+      if (ray_box(bv, std::countr_zero(mask))) return mask;
+      if (std::has_single_bit(mask)) return 0;
+      f32 tmin[s_ray_tri_lanes], tmax[s_ray_tri_lanes];
+      for (int l = 0; l != s_ray_tri_lanes; ++l) {
+        tmin[l] = 0.f;
+        tmax[l] = dists[l];
+      }
+      for (int d = 0; d != 3; ++d)
+        for (int l = 0; l != s_ray_tri_lanes; ++l) {
+          const f32 ta = (bv._min[d] - ro[d][l]) * invDir[d][l];
+          const f32 tb = (bv._max[d] - ro[d][l]) * invDir[d][l];
+          tmin[l] = zs::max(tmin[l], zs::min(ta, tb));
+          tmax[l] = zs::min(tmax[l], zs::max(ta, tb));
+        }
+      u32 ret = 0;
+      for (int l = 0; l != s_ray_tri_lanes; ++l) ret |= (u32)(tmin[l] <= tmax[l]) << l;
+      return ret & mask;
+    };
+    auto test_leaf = [&](PrimIndex triNo, u32 mask) {
+      load_tri_lane(triMesh, triNo, 0, v0, e1, e2);
+      for (int d = 0; d != 3; ++d)
+        for (int l = 1; l != s_ray_tri_lanes; ++l) {
+          v0[d][l] = v0[d][0];
+          e1[d][l] = e1[d][0];
+          e2[d][l] = e2[d][0];
+        }
+      ray_tri_intersect_lanes(ro, rd, v0, e1, e2, ts);
+      for (int l = 0; l != s_ray_tri_lanes; ++l)
+        if ((mask >> l & 1) && ts[l] < dists[l]) {
+          dists[l] = ts[l];
+          triNos[l] = triNo;
+        }
+    };
+
+    const u32 active = numRays >= 32 ? ~(u32)0 : ((u32)1 << numRays) - 1;
+    const auto numLeaves = bvh.getNumLeaves();
+    /// @note no internal nodes then, see LBvh
+    if (numLeaves <= 2) {
+      for (PrimIndex i = 0; i != (PrimIndex)numLeaves; ++i)
+        if (auto mask = hit_mask(bvh.orderedBvs[i], active)) test_leaf(bvh.auxIndices[i], mask);
+      return;
+    }
+    /// @note nodes are laid out in preorder, the left child follows its parent and the right one
+    /// follows the subtree of the left one (the escape index of an internal node, see LBvh)
+    stack.clear();
+    stack.emplace_back(0, active);
+    while (stack.size()) {
+      auto [node, mask] = stack.back();
+      stack.pop_back();
+      if (!(mask = hit_mask(bvh.orderedBvs[node], mask))) continue;
+      if (bvh.levels[node] == 0) {
+        test_leaf(bvh.auxIndices[node], mask);
+        continue;
+      }
+      PrimIndex left = node + 1;
+      PrimIndex right = bvh.levels[left] ? bvh.auxIndices[left] : left + 1;
+      /// @note the nearer child (along the first active ray) goes first, so that the closest hits
+      /// found there prune the other one
+      const auto &lb = bvh.orderedBvs[left];
+      const auto &rb = bvh.orderedBvs[right];
+      const int l = std::countr_zero(mask);
+      f32 ahead = 0.f;
+      for (int d = 0; d != 3; ++d)
+        ahead += (lb._min[d] + lb._max[d] - rb._min[d] - rb._max[d]) * rd[d][l];
+      if (ahead > 0.f) std::swap(left, right);
+      stack.emplace_back(right, mask);
+      stack.emplace_back(left, mask);
+    }
+  }
+
   bool get_ray_intersection_with_prim(const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection,
                                       const ZsPrimitive &prim, glm::vec3 *hitPt) {
+    /// @note primitive should not be in the process of update
+    const auto &primTransform = prim.currentTimeVisualTransform();
+    return get_ray_intersection_with_prim(rayOrigin, rayDirection, prim, primTransform,
+                                          glm::inverse(primTransform), hitPt);
+  }
+
+  bool get_ray_intersection_with_prim(const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection,
+                                      const ZsPrimitive &prim, const glm::mat4 &primTransform,
+                                      const glm::mat4 &primTransformInv, glm::vec3 *hitPt) {
     const auto &bvh = prim.details().triBvh();
     /// @note if triBvh is empty, then no intersection is expected
     if (bvh.getNumLeaves() == 0) return false;
 
     const auto &triMesh = prim.details().triMesh();
-    f32 dist = detail::deduce_numeric_max<f32>();
     auto bvhv = proxy<execspace_e::host>(bvh);
-    /// @note primitive should not be in the process of update
-    const auto &primTransform = prim.currentTimeVisualTransform();
-    const auto primTransformInv = glm::inverse(primTransform);
     auto toZsVec = [](const auto &v) { return zs::vec<f32, 3>{v[0], v[1], v[2]}; };
     auto toGlmVec = [](const auto &v) { return glm::vec3{v[0], v[1], v[2]}; };
     auto ro = toZsVec(primTransformInv * glm::vec4(rayOrigin, 1.f));
     auto rd = toZsVec(
         glm::normalize(primTransformInv * glm::vec4(rayDirection, 0.f)));  // ignore translation
 
-    bvhv.ray_intersect(ro, rd, [&triMesh, &ro, &rd, &dist](PrimIndex triNo) {
-      auto tri = triMesh.elems[triNo];
-      auto t0 = zs::vec<f32, 3>{triMesh.nodes[tri[0]][0], triMesh.nodes[tri[0]][1],
-                                triMesh.nodes[tri[0]][2]};
-      auto t1 = zs::vec<f32, 3>{triMesh.nodes[tri[1]][0], triMesh.nodes[tri[1]][1],
-                                triMesh.nodes[tri[1]][2]};
-      auto t2 = zs::vec<f32, 3>{triMesh.nodes[tri[2]][0], triMesh.nodes[tri[2]][1],
-                                triMesh.nodes[tri[2]][2]};
-      if (auto d = ray_tri_intersect(ro, rd, t0, t1, t2); d < dist) {
-        dist = d;
-        // fmt::print("printing ray intersected with {}, (tri {})\n", dist, triNo);
-      }
-    });
+    /// @note scratch space kept per thread, picking is issued per frame
+    thread_local std::vector<PrimIndex> candidates;
+    auto dist = closest_ray_tri_hit(bvhv, triMesh, ro, rd, candidates, nullptr);
     if (dist != detail::deduce_numeric_max<f32>()) {
-      // fmt::print("ray intersected with {}, bvh leaf size: {}\n", dist, bvh.getNumLeaves());
       if (hitPt) {
         *hitPt = glm::vec3(primTransform * glm::vec4(toGlmVec(ro + rd * dist), 1.f));
       }
@@ -59,4 +242,59 @@ constexpr auto space = execspace_e::host;
     return false;
   }
 
-}  // namespace zs
\ No newline at end of file
+  size_t get_ray_intersections_with_prim(const glm::vec3 *rayOrigins,
+                                         const glm::vec3 *rayDirections, size_t numRays,
+                                         const ZsPrimitive &prim, PrimitiveRayHit *hits) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    const auto &bvh = prim.details().triBvh();
+    if (bvh.getNumLeaves() == 0 || numRays == 0) return 0;
+
+    const auto &triMesh = prim.details().triMesh();
+    /// @note primitive should not be in the process of update
+    const auto &primTransform = prim.currentTimeVisualTransform();
+    const auto primTransformInv = glm::inverse(primTransform);
+
+    /// @note consecutive rays form packets, which pay off for coherent rays (e.g. those of
+    /// neighboring pixels)
+    std::atomic<size_t> numHits{0};
+    pol(range((numRays + s_ray_tri_lanes - 1) / s_ray_tri_lanes), [&](size_t packetNo) {
+      thread_local std::vector<std::pair<PrimIndex, u32>> stack;
+      const auto st = packetNo * s_ray_tri_lanes;
+      const int n = std::min(numRays - st, (size_t)s_ray_tri_lanes);
+      RayTriLanes ro, rd;
+      for (int l = 0; l != s_ray_tri_lanes; ++l) {
+        /// @note padded lanes repeat the first ray, they are masked out anyway
+        const auto i = st + (l < n ? l : 0);
+        auto o = primTransformInv * glm::vec4(rayOrigins[i], 1.f);
+        auto d = glm::normalize(glm::vec3(primTransformInv * glm::vec4(rayDirections[i], 0.f)));
+        for (int k = 0; k != 3; ++k) {
+          ro[k][l] = o[k];
+          rd[k][l] = d[k];
+        }
+      }
+      f32 ts[s_ray_tri_lanes];
+      PrimIndex triNos[s_ray_tri_lanes];
+      closest_ray_tri_hits_packet(bvh, triMesh, ro, rd, n, ts, triNos, stack);
+      size_t numUpdated = 0;
+      for (int l = 0; l != n; ++l) {
+        if (triNos[l] == -1) continue;
+        const auto t = ts[l];
+        auto pos = glm::vec3(primTransform * glm::vec4(ro[0][l] + rd[0][l] * t,
+                                                       ro[1][l] + rd[1][l] * t,
+                                                       ro[2][l] + rd[2][l] * t, 1.f));
+        const auto i = st + l;
+        if (auto dist = glm::length(pos - rayOrigins[i]); dist < hits[i]._dist) {
+          hits[i] = PrimitiveRayHit{dist, triNos[l], pos};
+          numUpdated++;
+        }
+      }
+      if (numUpdated) numHits.fetch_add(numUpdated);
+    });
+    return numHits.load();
+  }
+
+}  // namespace zs
@@ -3,9 +3,34 @@
 
 namespace zs {
 
+  struct PrimitiveRayHit {
+    f32 _dist{detail::deduce_numeric_max<f32>()};  // world-space distance from the ray origin
+    PrimIndex _triNo{-1};
+    glm::vec3 _pos{};
+    explicit operator bool() const noexcept { return _triNo != -1; }
+  };
+
+  ZS_WORLD_EXPORT bool get_ray_intersection_with_prim(const glm::vec3 &rayOrigin,
+                                                      const glm::vec3 &rayDirection,
+                                                      const ZsPrimitive &prim,
+                                                      glm::vec3 *hitPt = nullptr);
+  /// @brief same as above, with the (visual) transform of [prim] provided by the caller
   ZS_WORLD_EXPORT bool get_ray_intersection_with_prim(const glm::vec3 &rayOrigin,
                                                       const glm::vec3 &rayDirection,
                                                       const ZsPrimitive &prim,
+                                                      const glm::mat4 &primTransform,
+                                                      const glm::mat4 &primTransformInv,
                                                       glm::vec3 *hitPt = nullptr);
 
-}
\ No newline at end of file
+  /// @brief batched closest-hit queries of [numRays] rays against [prim], in parallel
+  /// @note hits[i] is only overwritten by a closer hit, so the same [hits] may be accumulated
+  /// across prims
+  /// @note consecutive rays are traced together as packets, so coherent rays (e.g. those of
+  /// neighboring pixels) should be passed next to each other
+  /// @return number of hits updated
+  ZS_WORLD_EXPORT size_t get_ray_intersections_with_prim(const glm::vec3 *rayOrigins,
+                                                         const glm::vec3 *rayDirections,
+                                                         size_t numRays, const ZsPrimitive &prim,
+                                                         PrimitiveRayHit *hits);
+
+}
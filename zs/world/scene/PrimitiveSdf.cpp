@@ -0,0 +1,357 @@
+#include "PrimitiveSdf.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#if ZS_ENABLE_OPENMP
+#  include "zensim/omp/execution/ExecutionPolicy.hpp"
+#else
+#  include "zensim/execution/ExecutionPolicy.hpp"
+#endif
+
+namespace zs {
+
+  namespace {
+    glm::vec3 tri_vertex(const ZsTriMesh &triMesh, u32 vi) {
+      const auto &p = triMesh.nodes[vi];
+      return glm::vec3{p[0], p[1], p[2]};
+    }
+
+    /// @ref Ericson, Real-Time Collision Detection, 5.1.5
+    glm::vec3 closest_point_on_triangle(const glm::vec3 &p, const glm::vec3 &a,
+                                        const glm::vec3 &b, const glm::vec3 &c) {
+      const auto ab = b - a, ac = c - a, ap = p - a;
+      const f32 d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+      if (d1 <= 0.f && d2 <= 0.f) return a;
+      const auto bp = p - b;
+      const f32 d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+      if (d3 >= 0.f && d4 <= d3) return b;
+      const f32 vc = d1 * d4 - d3 * d2;
+      if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) return a + ab * (d1 / (d1 - d3));
+      const auto cp = p - c;
+      const f32 d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+      if (d6 >= 0.f && d5 <= d6) return c;
+      const f32 vb = d5 * d2 - d1 * d6;
+      if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) return a + ac * (d2 / (d2 - d6));
+      const f32 va = d3 * d6 - d5 * d4;
+      if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+      const f32 sum = va + vb + vc;
+      if (sum == 0.f) return a;  // degenerate
+      return a + ab * (vb / sum) + ac * (vc / sum);
+    }
+
+    /// @note among (nearly) equidistant triangles, e.g. when the closest point lies on a shared
+    /// edge or vertex, the one whose normal is best aligned with the offset decides the sign
+    struct ClosestTriangle {
+      bool valid() const noexcept { return _triNo >= 0; }
+      f32 signedDistance() const noexcept { return _sign * std::sqrt(_d2); }
+
+      f32 _d2{detail::deduce_numeric_max<f32>()};
+      f32 _alignment{0.f};
+      glm::vec3 _pos{0.f};
+      f32 _sign{1.f};
+      PrimIndex _triNo{-1};
+    };
+
+    void consider_triangle(const ZsTriMesh &triMesh, PrimIndex triNo, const glm::vec3 &p,
+                           ClosestTriangle &best) {
+      const auto &tri = triMesh.elems[triNo];
+      const auto a = tri_vertex(triMesh, tri[0]), b = tri_vertex(triMesh, tri[1]),
+                 c = tri_vertex(triMesh, tri[2]);
+      const auto q = closest_point_on_triangle(p, a, b, c);
+      const auto off = p - q;
+      const f32 d2 = glm::dot(off, off);
+      constexpr f32 tol = 1e-6f;
+      if (d2 > best._d2 * (1.f + tol) + tol * tol) return;
+
+      const auto n = glm::cross(b - a, c - a);
+      const f32 nl = glm::length(n), ol = std::sqrt(d2);
+      const f32 proj = nl > 0.f && ol > 0.f ? glm::dot(off, n) / (nl * ol) : 0.f;
+      if (d2 >= best._d2 * (1.f - tol) - tol * tol && std::abs(proj) <= best._alignment) return;
+
+      best._d2 = d2;
+      best._alignment = std::abs(proj);
+      best._pos = q;
+      best._sign = proj < 0.f ? -1.f : 1.f;
+      best._triNo = triNo;
+    }
+
+    zs::AABBBox<3, f32> make_box(const glm::vec3 &lo, const glm::vec3 &hi) {
+      return zs::AABBBox<3, f32>{zs::vec<f32, 3>{lo.x, lo.y, lo.z},
+                                 zs::vec<f32, 3>{hi.x, hi.y, hi.z}};
+    }
+
+    f32 box_distance2(const zs::AABBBox<3, f32> &bv, const glm::vec3 &p) {
+      f32 ret = 0.f;
+      for (int d = 0; d != 3; ++d) {
+        const f32 g = zs::max(zs::max(bv._min[d] - p[d], p[d] - bv._max[d]), 0.f);
+        ret += g * g;
+      }
+      return ret;
+    }
+
+    /// @brief exact closest triangle, best-first over the triBvh
+    /// @note nodes are visited in the order of their box distance to [p] and the search stops once
+    /// the nearest pending box lies beyond the closest triangle so far (with the tolerance of
+    /// consider_triangle, so that equidistant triangles still get to decide the sign)
+    ClosestTriangle closest_triangle_exact(const PrimBvh &bvh, const ZsTriMesh &triMesh,
+                                           const glm::vec3 &p) {
+      ClosestTriangle best;
+      constexpr f32 tol = 1e-6f;
+      auto beyond = [&best](f32 d2) { return d2 > best._d2 * (1.f + tol) + tol * tol; };
+      const auto numLeaves = bvh.getNumLeaves();
+      /// @note no internal nodes then, see LBvh
+      if (numLeaves <= 2) {
+        for (PrimIndex i = 0; i != (PrimIndex)numLeaves; ++i)
+          consider_triangle(triMesh, bvh.auxIndices[i], p, best);
+        return best;
+      }
+      using Entry = std::pair<f32, PrimIndex>;
+      thread_local std::vector<Entry> heap;
+      heap.clear();
+      /// @note min-heap on the box distance
+      const auto further = [](const Entry &a, const Entry &b) { return a.first > b.first; };
+      heap.emplace_back(box_distance2(bvh.orderedBvs[0], p), 0);
+      while (heap.size()) {
+        std::pop_heap(heap.begin(), heap.end(), further);
+        const auto [d2, node] = heap.back();
+        heap.pop_back();
+        if (beyond(d2)) break;
+        if (bvh.levels[node] == 0) {
+          consider_triangle(triMesh, bvh.auxIndices[node], p, best);
+          continue;
+        }
+        /// @note preorder layout, the right child follows the subtree of the left one
+        const PrimIndex left = node + 1;
+        const PrimIndex right = bvh.levels[left] ? bvh.auxIndices[left] : left + 1;
+        for (const auto child : {left, right}) {
+          const f32 cd2 = box_distance2(bvh.orderedBvs[child], p);
+          if (beyond(cd2)) continue;
+          heap.emplace_back(cd2, child);
+          std::push_heap(heap.begin(), heap.end(), further);
+        }
+      }
+      return best;
+    }
+
+    /// @note per-thread scratch, reused across bricks
+    std::vector<PrimIndex> &local_candidate_scratch() {
+      thread_local std::vector<PrimIndex> candidates;
+      return candidates;
+    }
+  }  // namespace
+
+  size_t SparseSdfVolume::bytes() const noexcept {
+    return _values.capacity() * sizeof(f32) + _brickCoords.capacity() * sizeof(glm::ivec3)
+           + _brickIndex.capacity() * (sizeof(u64) * 2 + sizeof(u32));
+  }
+
+  bool SparseSdfVolume::sample(const glm::vec3 &p, f32 &dist, glm::vec3 *grad) const noexcept {
+    if (_brickCoords.empty()) return false;
+    const auto brick = brickCoord(p);
+    const auto slot = _brickIndex.find(brick_key(brick));
+    if (!slot) return false;
+
+    const auto local = (p - _origin) / _voxelSize - glm::vec3(brick * s_brick_cells);
+    const auto cell = glm::clamp(glm::ivec3(glm::floor(local)), 0, s_brick_cells - 1);
+    const auto t = glm::clamp(local - glm::vec3(cell), 0.f, 1.f);
+    const f32 *vs = _values.data() + (size_t)*slot * s_brick_size;
+    f32 c[2][2][2];
+    for (int i = 0; i != 2; ++i)
+      for (int j = 0; j != 2; ++j)
+        for (int k = 0; k != 2; ++k)
+          c[i][j][k] = vs[sample_offset(cell.x + i, cell.y + j, cell.z + k)];
+
+    const f32 c00 = c[0][0][0] + (c[0][0][1] - c[0][0][0]) * t.z;
+    const f32 c01 = c[0][1][0] + (c[0][1][1] - c[0][1][0]) * t.z;
+    const f32 c10 = c[1][0][0] + (c[1][0][1] - c[1][0][0]) * t.z;
+    const f32 c11 = c[1][1][0] + (c[1][1][1] - c[1][1][0]) * t.z;
+    const f32 c0 = c00 + (c01 - c00) * t.y;
+    const f32 c1 = c10 + (c11 - c10) * t.y;
+    dist = c0 + (c1 - c0) * t.x;
+
+    if (grad) {
+      const f32 dz00 = c[0][0][1] - c[0][0][0], dz01 = c[0][1][1] - c[0][1][0];
+      const f32 dz10 = c[1][0][1] - c[1][0][0], dz11 = c[1][1][1] - c[1][1][0];
+      const f32 dz0 = dz00 + (dz01 - dz00) * t.y, dz1 = dz10 + (dz11 - dz10) * t.y;
+      *grad = glm::vec3{c1 - c0, (c01 - c00) + ((c11 - c10) - (c01 - c00)) * t.x,
+                        dz0 + (dz1 - dz0) * t.x}
+              / _voxelSize;
+    }
+    return true;
+  }
+
+  bool build_primitive_sdf(ZsPrimitive &prim, f32 voxelSize, f32 bandwidth) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    if (!(voxelSize > 0.f)) return false;
+    if (!(bandwidth > 0.f)) bandwidth = 3.f * voxelSize;
+
+    auto &details = prim.details();
+    const auto &triMesh = details.triMesh();
+    const size_t numTris = triMesh.elems.size();
+    if (numTris == 0) return false;
+    if (details.triBvh().getNumLeaves() == 0) prim.updateTriBvh(true);
+    const auto &bvh = details.triBvh();
+    if (bvh.getNumLeaves() == 0) return false;
+
+    using Volume = SparseSdfVolume;
+    auto volume = std::make_shared<Volume>();
+    const auto &meshBox = details.localBoundingBox();
+    volume->_voxelSize = voxelSize;
+    volume->_bandwidth = bandwidth;
+    volume->_origin = meshBox.minPos - glm::vec3(bandwidth + voxelSize);
+    const f32 brickExtent = voxelSize * Volume::s_brick_cells;
+    const f32 brickHalfDiag = 0.5f * std::sqrt(3.f) * brickExtent;
+
+    /// 1. bricks within the band of each triangle (count, scan, fill)
+    /// @note bricks overlapping the dilated triangle box are further tested by the distance from
+    /// their center, so that long diagonal triangles do not allocate their whole box
+    auto visitTriangleBricks = [&](size_t triNo, auto &&f) {
+      const auto &tri = triMesh.elems[triNo];
+      const auto a = tri_vertex(triMesh, tri[0]), b = tri_vertex(triMesh, tri[1]),
+                 c = tri_vertex(triMesh, tri[2]);
+      const auto lo = volume->brickCoord(glm::min(glm::min(a, b), c) - glm::vec3(bandwidth));
+      const auto hi = volume->brickCoord(glm::max(glm::max(a, b), c) + glm::vec3(bandwidth));
+      for (int x = lo.x; x <= hi.x; ++x)
+        for (int y = lo.y; y <= hi.y; ++y)
+          for (int z = lo.z; z <= hi.z; ++z) {
+            const glm::ivec3 brick{x, y, z};
+            const auto center = volume->_origin + (glm::vec3(brick) + 0.5f) * brickExtent;
+            const auto q = closest_point_on_triangle(center, a, b, c);
+            if (glm::length(center - q) <= bandwidth + brickHalfDiag) f(brick);
+          }
+    };
+    std::vector<size_t> counts(numTris + 1, 0), offsets(numTris + 1);
+    pol(range(numTris), [&](size_t triNo) {
+      size_t cnt = 0;
+      visitTriangleBricks(triNo, [&cnt](const glm::ivec3 &) { ++cnt; });
+      counts[triNo] = cnt;
+    });
+    exclusive_scan(pol, zs::begin(counts), zs::end(counts), zs::begin(offsets));
+    std::vector<u64> keys(offsets.back());
+    pol(range(numTris), [&](size_t triNo) {
+      auto dst = offsets[triNo];
+      visitTriangleBricks(triNo,
+                          [&](const glm::ivec3 &brick) { keys[dst++] = Volume::brick_key(brick); });
+    });
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    /// 2. brick slots
+    const size_t numBricks = keys.size();
+    volume->_brickIndex.reserve(numBricks);
+    volume->_brickCoords.resize(numBricks);
+    pol(range(numBricks), [&](size_t i) {
+      constexpr u64 bias = (u64)1 << 20, mask = ((u64)1 << 21) - 1;
+      const auto k = keys[i];
+      volume->_brickCoords[i] = glm::ivec3{(int)((k >> 42) & mask) - (int)bias,
+                                           (int)((k >> 21) & mask) - (int)bias,
+                                           (int)(k & mask) - (int)bias};
+    });
+    for (size_t i = 0; i != numBricks; ++i) volume->_brickIndex.insert(keys[i], (u32)i);
+
+    /// 3. samples, with the candidate triangles gathered once per brick
+    /// @note every brick overlaps the dilated box of some triangle, thus has candidates
+    volume->_values.resize(numBricks * Volume::s_brick_size);
+    auto bvhv = proxy<execspace_e::host>(bvh);
+    pol(range(numBricks), [&, bvhv](size_t i) {
+      const auto &brick = volume->_brickCoords[i];
+      const auto lo = volume->samplePos(brick, 0, 0, 0) - glm::vec3(bandwidth);
+      const auto hi = lo + glm::vec3(brickExtent + 2.f * bandwidth);
+      auto &candidates = local_candidate_scratch();
+      candidates.clear();
+      bvhv.iter_neighbors(make_box(lo, hi),
+                          [&candidates](PrimIndex triNo) { candidates.push_back(triNo); });
+
+      f32 *vs = volume->_values.data() + i * Volume::s_brick_size;
+      for (int x = 0; x != Volume::s_brick_dim; ++x)
+        for (int y = 0; y != Volume::s_brick_dim; ++y)
+          for (int z = 0; z != Volume::s_brick_dim; ++z) {
+            const auto p = volume->samplePos(brick, x, y, z);
+            ClosestTriangle best;
+            for (auto triNo : candidates) consider_triangle(triMesh, triNo, p, best);
+            const f32 d = best.valid() ? best.signedDistance() : bandwidth;
+            vs[Volume::sample_offset(x, y, z)] = std::clamp(d, -bandwidth, bandwidth);
+          }
+    });
+
+    prim.localSdfPrims()->volume() = std::move(volume);
+    return true;
+  }
+
+  const SparseSdfVolume *get_primitive_sdf(const PrimitiveStorage &prim) noexcept {
+    if (auto it = prim._localPrims.find(PrimitiveStorage::Sdf_); it != prim._localPrims.end())
+      if (auto sdf = dynamic_cast<const SdfPrimContainer *>((*it).second.get()); sdf)
+        return sdf->volume().get();
+    return nullptr;
+  }
+
+  size_t query_primitive_sdf(const ZsPrimitive &prim, const glm::vec3 *pts, size_t numPts,
+                             f32 *dists, glm::vec3 *closestPts) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    const auto volume = get_primitive_sdf(prim);
+    const auto &details = prim.details();
+    const auto &triMesh = details.triMesh();
+    const auto &bvh = details.triBvh();
+    const bool hasMesh = bvh.getNumLeaves() != 0;
+
+    std::vector<u8> fromVolume(numPts, 0);
+    pol(range(numPts), [&](size_t i) {
+      const auto &p = pts[i];
+      /// @note samples at the band limit are clamped, thus inexact
+      if (volume) {
+        f32 d;
+        glm::vec3 g;
+        if (volume->sample(p, d, closestPts ? &g : nullptr)
+            && std::abs(d) < volume->getBandwidth() - volume->getVoxelSize()) {
+          dists[i] = d;
+          if (closestPts) {
+            const f32 gl = glm::length(g);
+            closestPts[i] = gl > 0.f ? p - g * (d / gl) : p;
+          }
+          fromVolume[i] = 1;
+          return;
+        }
+      }
+      if (!hasMesh) {
+        dists[i] = detail::deduce_numeric_max<f32>();
+        if (closestPts) closestPts[i] = p;
+        return;
+      }
+      const auto best = closest_triangle_exact(bvh, triMesh, p);
+      dists[i] = best.valid() ? best.signedDistance() : detail::deduce_numeric_max<f32>();
+      if (closestPts) closestPts[i] = best.valid() ? best._pos : p;
+    });
+    size_t ret = 0;
+    for (auto v : fromVolume) ret += v;
+    return ret;
+  }
+
+  bool is_inside_primitive(const ZsPrimitive &prim, const glm::vec3 &p) {
+    if (auto volume = get_primitive_sdf(prim)) {
+      f32 d;
+      if (volume->sample(p, d)) return d < 0.f;
+    }
+    const auto &details = prim.details();
+    const auto &bvh = details.triBvh();
+    if (bvh.getNumLeaves() == 0) return false;
+    const auto &meshBox = details.localBoundingBox();
+    if (glm::any(glm::lessThan(p, meshBox.minPos))
+        || glm::any(glm::greaterThan(p, meshBox.maxPos)))
+      return false;
+    const auto best = closest_triangle_exact(bvh, details.triMesh(), p);
+    return best.valid() && best._sign < 0.f;
+  }
+
+}  // namespace zs
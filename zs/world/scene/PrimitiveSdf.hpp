@@ -0,0 +1,69 @@
+#pragma once
+#include "../WorldExport.hpp"
+#include "Primitive.hpp"
+
+namespace zs {
+
+  /// @brief narrow-band signed distance volume, sampled on a sparse set of bricks
+  /// @note only bricks within the band of the surface are allocated, thus the footprint scales
+  /// with the surface area rather than the enclosed volume
+  /// @note adjacent bricks share their boundary layer of samples, so that trilinear interpolation
+  /// never reaches across bricks
+  /// @note negative inside, positive outside, distances are clamped to the band
+  struct ZS_WORLD_EXPORT SparseSdfVolume {
+    static constexpr int s_brick_dim = 8;                  // samples per axis
+    static constexpr int s_brick_cells = s_brick_dim - 1;  // voxels per axis
+    static constexpr int s_brick_size = s_brick_dim * s_brick_dim * s_brick_dim;
+
+    /// @brief trilinear interpolation at local position [p]
+    /// @return false if [p] lies outside all allocated bricks
+    /// @note [grad] receives the gradient of the interpolant
+    bool sample(const glm::vec3& p, f32& dist, glm::vec3* grad = nullptr) const noexcept;
+
+    size_t numBricks() const noexcept { return _brickCoords.size(); }
+    f32 getVoxelSize() const noexcept { return _voxelSize; }
+    f32 getBandwidth() const noexcept { return _bandwidth; }
+    size_t bytes() const noexcept;
+
+    static u64 brick_key(const glm::ivec3& c) noexcept {
+      constexpr u64 bias = (u64)1 << 20, mask = ((u64)1 << 21) - 1;
+      return (((u64)(c.x + bias) & mask) << 42) | (((u64)(c.y + bias) & mask) << 21)
+             | ((u64)(c.z + bias) & mask);
+    }
+    glm::ivec3 brickCoord(const glm::vec3& p) const noexcept {
+      return glm::ivec3(glm::floor((p - _origin) / (_voxelSize * s_brick_cells)));
+    }
+    glm::vec3 samplePos(const glm::ivec3& brick, int x, int y, int z) const noexcept {
+      return _origin + _voxelSize * glm::vec3(brick * s_brick_cells + glm::ivec3{x, y, z});
+    }
+    static int sample_offset(int x, int y, int z) noexcept {
+      return (x * s_brick_dim + y) * s_brick_dim + z;
+    }
+
+    HashIndex<u64, u32> _brickIndex;       // brick key -> brick slot
+    std::vector<glm::ivec3> _brickCoords;  // per slot
+    std::vector<f32> _values;              // s_brick_size per slot
+    glm::vec3 _origin{0.f};
+    f32 _voxelSize{0.f}, _bandwidth{0.f};
+  };
+
+  /// @brief build the sdf volume of [prim] (SdfPrimContainer) from its triangle mesh in parallel
+  /// @note closest triangles are looked up through the triBvh, which is built if absent
+  /// @note [bandwidth] of 0 defaults to 3 voxels
+  /// @note signs are resolved with the face normal of the closest triangle, hence are only
+  /// meaningful for closed and consistently oriented meshes
+  ZS_WORLD_EXPORT bool build_primitive_sdf(ZsPrimitive& prim, f32 voxelSize, f32 bandwidth = 0.f);
+
+  /// @brief the sdf volume of [prim] if built, nullptr otherwise
+  ZS_WORLD_EXPORT const SparseSdfVolume* get_primitive_sdf(const PrimitiveStorage& prim) noexcept;
+
+  /// @brief signed distances (and closest surface points) of local positions [pts] in parallel
+  /// @note queries within the band are interpolated from the volume, the others are resolved
+  /// exactly against the triangle mesh
+  /// @return number of queries answered from the volume
+  ZS_WORLD_EXPORT size_t query_primitive_sdf(const ZsPrimitive& prim, const glm::vec3* pts,
+                                             size_t numPts, f32* dists,
+                                             glm::vec3* closestPts = nullptr);
+  ZS_WORLD_EXPORT bool is_inside_primitive(const ZsPrimitive& prim, const glm::vec3& p);
+
+}  // namespace zs
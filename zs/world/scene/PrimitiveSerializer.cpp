@@ -1,8 +1,1096 @@
 #include "PrimitiveSerializer.hpp"
 
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+
+#include "PrimitiveSdf.hpp"
+#include "interface/details/PyHelper.hpp"
+#include "world/core/Archive.hpp"
+#include "world/core/ColumnCodec.hpp"
+#include "world/core/MappedFile.hpp"
+#include "world/core/MemoryResource.hpp"
+
+#if ZS_ENABLE_OPENMP
+#  include "zensim/omp/execution/ExecutionPolicy.hpp"
+#else
+#  include "zensim/execution/ExecutionPolicy.hpp"
+#endif
+
 namespace zs {
 
-  ;
-  ;
+  namespace {
+    constexpr char g_primitive_cache_magic[8] = {'Z', 'S', 'P', 'R', 'I', 'M', 'C', '\0'};
+
+    struct PrimitiveCacheHeader {
+      char _magic[8];
+      u32 _version;
+      u32 _alignment;
+      u64 _manifestOffset;
+      u64 _manifestBytes;
+      u32 _indexBytes;  // sizeof(PrimIndex) of the writer, 0 (i.e. 4) in earlier caches
+      u32 _reserved0;
+      u64 _reserved[3];
+    };
+    static_assert(sizeof(PrimitiveCacheHeader) == 64, "cache header layout changed");
+
+    /// @note tiles covering the first [size] entries, any reserved tile beyond is not persisted
+    template <typename T> size_t tile_vector_bytes(const TileVector<T> &tv, size_t size) {
+      constexpr size_t lane = TileVector<T>::lane_width;
+      return (size + lane - 1) / lane * lane * tv.numChannels() * sizeof(T);
+    }
+    /// @note tile storage interleaves channels per tile, i.e. [tile][channel][lane]
+    template <typename T> size_t tile_vector_slot(size_t i, size_t chn, size_t numChannels) {
+      constexpr size_t lane = TileVector<T>::lane_width;
+      return (i / lane * numChannels + chn) * lane + i % lane;
+    }
+    /// @brief the number of entries from [i] (at most [count]) contiguous within one tile channel
+    template <typename T> size_t lane_run(size_t i, size_t count) {
+      constexpr size_t lane = TileVector<T>::lane_width;
+      return std::min(lane - i % lane, count);
+    }
+
+    enum block_codec_e : u8 { codec_Raw = 0, codec_Column = 1 };
+    /// @brief values per independently coded chunk of a channel
+    constexpr size_t g_column_chunk_size = (size_t)1 << 16;
+    /// @note attr32 channels mostly hold floats, attr64 ones integers and handles
+    template <typename T> constexpr column_predictor_e column_predictor_of() noexcept {
+      return sizeof(T) == sizeof(u64) ? column_predictor_e::delta_prev
+                                      : column_predictor_e::xor_prev;
+    }
+
+    /// @brief hands the mapped block of a tile vector out as its storage, exactly once
+    /// @note other (re)allocations, e.g. upon resize or copy, are served from the heap
+    struct MappedBlockResource : mr_t {
+      MappedBlockResource(Shared<MappedFile> file, std::byte *block, size_t bytes) noexcept
+          : _file{zs::move(file)}, _block{block}, _bytes{bytes} {}
+
+      void *do_allocate(size_t bytes, size_t alignment) override {
+        if (bytes == _bytes && !_handedOut.exchange(true)) return _block;
+        return ::operator new(bytes, std::align_val_t{alignment});
+      }
+      void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        if (p == _block) return;  // released along with the mapping
+        ::operator delete(p, std::align_val_t{alignment});
+      }
+      bool do_is_equal(const mr_t &o) const noexcept override { return this == &o; }
+
+      Shared<MappedFile> _file;
+      std::byte *_block;
+      size_t _bytes;
+      std::atomic<bool> _handedOut{false};
+    };
+
+    Shared<PrimContainerConcept> make_local_prim_container(PrimTypeIndex type) {
+      switch (type) {
+        case PrimitiveStorage::Poly_:
+          return std::make_shared<PolyPrimContainer>();
+        case PrimitiveStorage::Tri_:
+          return std::make_shared<TriPrimContainer>();
+        case PrimitiveStorage::Line_:
+          return std::make_shared<LinePrimContainer>();
+        case PrimitiveStorage::Point_:
+          return std::make_shared<PointPrimContainer>();
+        case PrimitiveStorage::Sdf_:
+          return std::make_shared<SdfPrimContainer>();
+        case PrimitiveStorage::Analytic_:
+          return std::make_shared<AnalyticPrimContainer>();
+        case PrimitiveStorage::Pack_:
+          return std::make_shared<PackPrimContainer>();
+        case PrimitiveStorage::Camera_:
+          return std::make_shared<CameraPrimContainer>();
+        case PrimitiveStorage::Light_:
+          return std::make_shared<LightPrimContainer>();
+        default:
+          return {};
+      }
+    }
+
+    /// chunked attribute vectors
+    constexpr char g_attr_vector_magic[8] = {'Z', 'S', 'A', 'T', 'T', 'R', 'V', '\0'};
+    constexpr u32 g_attr_vector_version = 1;
+
+    struct AttrVectorHeader {
+      char _magic[8];
+      u32 _version;
+      u32 _codec;
+      u64 _size;
+      u64 _manifestBytes;
+      u64 _numChunks;
+      u64 _payloadBytes;
+      u32 _owner;
+      u32 _reserved0;
+      u64 _reserved1;
+    };
+    static_assert(sizeof(AttrVectorHeader) == 64, "attr vector header layout changed");
+    struct AttrVectorChunk {
+      u64 _offset, _bytes;  // relative to the payload
+    };
+
+    /// @brief run [f](job) for all jobs in [0, numJobs), in parallel if OpenMP is enabled
+    template <typename F> void for_each_chunk(size_t numJobs, F &&f) {
+#if ZS_ENABLE_OPENMP
+      auto pol = omp_exec();
+#else
+      auto pol = seq_exec();
+#endif
+      pol(range(numJobs), f);
+    }
+
+    /// @brief a chunk covers up to g_column_chunk_size entries of one channel
+    /// @note both the primitive cache columns and serialize_attr_vector are laid out as the
+    /// chunks of channel 0, then those of channel 1, etc.
+    struct AttrChunkJob {
+      bool _is64;
+      size_t _chn, _start, _count;
+    };
+    void append_chunk_jobs(std::vector<AttrChunkJob> &jobs, size_t size, size_t numChannels,
+                           bool is64) {
+      const size_t numChunks = (size + g_column_chunk_size - 1) / g_column_chunk_size;
+      jobs.reserve(jobs.size() + numChannels * numChunks);
+      for (size_t chn = 0; chn != numChannels; ++chn)
+        for (size_t c = 0; c != numChunks; ++c) {
+          const size_t st = c * g_column_chunk_size;
+          jobs.push_back(AttrChunkJob{is64, chn, st, std::min(g_column_chunk_size, size - st)});
+        }
+    }
+    std::vector<AttrChunkJob> attr_chunk_jobs(size_t size, size_t numChannels32,
+                                              size_t numChannels64) {
+      std::vector<AttrChunkJob> ret;
+      append_chunk_jobs(ret, size, numChannels32, false);
+      append_chunk_jobs(ret, size, numChannels64, true);
+      return ret;
+    }
+
+    /// @note columns within the payload may be unaligned
+    template <typename T>
+    void gather_column(const TileVector<T> &tv, const AttrChunkJob &job, std::byte *dst) {
+      const T *data = tv.data();
+      const size_t numChannels = tv.numChannels();
+      for (size_t i = 0, run = 0; i != job._count; i += run) {
+        run = lane_run<T>(job._start + i, job._count - i);
+        std::memcpy(dst + i * sizeof(T),
+                    data + tile_vector_slot<T>(job._start + i, job._chn, numChannels),
+                    run * sizeof(T));
+      }
+    }
+    template <typename T>
+    void scatter_column(TileVector<T> &tv, const AttrChunkJob &job, const std::byte *src) {
+      T *data = tv.data();
+      const size_t numChannels = tv.numChannels();
+      for (size_t i = 0, run = 0; i != job._count; i += run) {
+        run = lane_run<T>(job._start + i, job._count - i);
+        std::memcpy(data + tile_vector_slot<T>(job._start + i, job._chn, numChannels),
+                    src + i * sizeof(T), run * sizeof(T));
+      }
+    }
+    template <typename T> void encode_chunk(const TileVector<T> &tv, const AttrChunkJob &job,
+                                            std::vector<std::byte> &encoded) {
+      std::vector<std::byte> column(job._count * sizeof(T));
+      gather_column(tv, job, column.data());
+      ColumnCodec::encode(column.data(), job._count, sizeof(T), column_predictor_of<T>(), encoded);
+    }
+    template <typename T> bool decode_chunk(TileVector<T> &tv, const AttrChunkJob &job,
+                                            bool compressed, const std::byte *src,
+                                            size_t bytes) {
+      if (!compressed) {
+        if (bytes != job._count * sizeof(T)) return false;
+        scatter_column(tv, job, src);
+        return true;
+      }
+      std::vector<std::byte> column(job._count * sizeof(T));
+      if (!ColumnCodec::decode(src, bytes, job._count, sizeof(T), column_predictor_of<T>(),
+                               column.data()))
+        return false;
+      scatter_column(tv, job, column.data());
+      return true;
+    }
+
+    /// @note the arrays of all three meshes in a fixed order
+    template <typename Bundle, typename F> void for_each_mesh_array(Bundle &meshes, F &&f) {
+      auto visit = [&f](auto &mesh) {
+        f(mesh.nodes);
+        f(mesh.uvs);
+        f(mesh.norms);
+        f(mesh.tans);
+        f(mesh.colors);
+        f(mesh.texids);
+        f(mesh.vids);
+        f(mesh.elems);
+      };
+      visit(meshes._triMesh);
+      visit(meshes._lineMesh);
+      visit(meshes._pointMesh);
+    }
+
+    template <typename T> void append_pod(SerializationBuffer &out, const T &v) {
+      const auto p = reinterpret_cast<const char *>(&v);
+      out.insert(out.end(), p, p + sizeof(T));
+    }
+    template <typename T> void append_tags(SerializationBuffer &out, const TileVector<T> &tv) {
+      const auto tags = tv.getPropertyTags();
+      append_pod(out, (u32)tags.size());
+      for (const auto &tag : tags) {
+        const auto name = tag.name.asString();
+        append_pod(out, (u64)name.size());
+        out.insert(out.end(), name.begin(), name.end());
+        append_pod(out, (u32)tag.numChannels);
+      }
+    }
+  }  // namespace
+
+  ///
+  /// writer
+  ///
+  /// @note blocks are streamed to the file as they come, the manifest is gathered in memory and
+  /// appended last
+  /// @note offsets are relative to the start of the image, i.e. the initial stream position
+  struct PrimitiveCacheWriter {
+    PrimitiveCacheWriter(std::ostream &os, bool compress,
+                         size_t alignment = g_primitive_cache_alignment)
+        : _os{os}, _base{(u64)os.tellp()}, _alignment{alignment}, _compress{compress} {
+      PrimitiveCacheHeader header{};
+      _os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      _offset = sizeof(header);
+    }
+
+    template <typename T> void write(const T &v) {
+      static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values");
+      const auto p = reinterpret_cast<const char *>(&v);
+      _manifest.insert(_manifest.end(), p, p + sizeof(T));
+    }
+    void writeBytes(const void *data, size_t bytes) {
+      const auto p = static_cast<const char *>(data);
+      _manifest.insert(_manifest.end(), p, p + bytes);
+    }
+    void writeString(std::string_view s) {
+      write((u64)s.size());
+      writeBytes(s.data(), s.size());
+    }
+
+    /// @return image offset of the block
+    u64 writeBlock(const void *data, size_t bytes) {
+      if (const auto rem = _offset % _alignment) {
+        static const char zeros[g_primitive_cache_alignment] = {};
+        _os.write(zeros, _alignment - rem);
+        _offset += _alignment - rem;
+      }
+      const u64 ret = _offset;
+      _os.write(static_cast<const char *>(data), bytes);
+      _offset += bytes;
+      return ret;
+    }
+
+    template <typename T> void writeTileVector(const TileVector<T> &tv) {
+      const auto tags = tv.getPropertyTags();
+      write((u32)tags.size());
+      for (const auto &tag : tags) {
+        writeString(tag.name.asString());
+        write((u32)tag.numChannels);
+      }
+      const size_t bytes = tags.size() ? tile_vector_bytes(tv, tv.size()) : 0;
+      if (_compress && bytes) {
+        writeColumns(tv);
+        return;
+      }
+      write(codec_Raw);
+      write(bytes ? writeBlock(tv.data(), bytes) : (u64)0);
+      write((u64)bytes);
+    }
+    /// @brief each channel is gathered and coded chunk by chunk, all chunks in parallel
+    /// @note the coded sizes are kept in the manifest, the payloads in a single block
+    template <typename T> void writeColumns(const TileVector<T> &tv) {
+      std::vector<AttrChunkJob> jobs;
+      append_chunk_jobs(jobs, tv.size(), tv.numChannels(), sizeof(T) == sizeof(u64));
+      std::vector<std::vector<std::byte>> encoded(jobs.size());
+      for_each_chunk(jobs.size(), [&](size_t j) { encode_chunk(tv, jobs[j], encoded[j]); });
+
+      std::vector<std::byte> payload;
+      size_t total = 0;
+      for (const auto &e : encoded) total += e.size();
+      payload.reserve(total);
+      for (const auto &e : encoded) payload.insert(payload.end(), e.begin(), e.end());
+
+      write(codec_Column);
+      write(writeBlock(payload.data(), payload.size()));
+      write((u64)payload.size());
+      for (const auto &e : encoded) write((u64)e.size());
+    }
+
+    void writeAttrVector(const AttrVector &attr) {
+      write((u64)attr.size());
+      write((u32)attr._owner);
+      writeTileVector(attr.attr32());
+      writeTileVector(attr.attr64());
+      write((u64)attr.strings().size());
+      for (const auto &str : attr.strings()) {
+        write((u64)str.size());
+        writeBytes(str.data(), str.size());
+      }
+    }
+    /// @note the first occurrence is written in place, later ones refer to it by index
+    void writeSharedAttrVector(const Shared<AttrVector> &attr) {
+      if (auto it = _sharedIds.find(attr.get()); it != _sharedIds.end()) {
+        write((*it).second);
+        return;
+      }
+      const auto id = (u32)_sharedIds.size();
+      _sharedIds.emplace(attr.get(), id);
+      write(id);
+      writeAttrVector(*attr);
+    }
+
+    void writeKeyFrames(PrimKeyFrames &keyframes) {
+      write((u32)keyframes._attribs.size());
+      for (auto &[label, frames] : keyframes._attribs) {
+        writeString(label);
+        const auto &defaultValue = frames.refDefaultValue();
+        write((u8)(defaultValue != nullptr));
+        if (defaultValue) writeSharedAttrVector(defaultValue);
+        write((u32)frames.refKeyframes().size());
+        for (const auto &[tc, frame] : frames.refKeyframes()) {
+          write(tc);
+          writeSharedAttrVector(frame);
+        }
+      }
+
+      auto &visibility = keyframes._visibility;
+      write((u8)visibility.hasDefaultValue());
+      if (visibility.hasDefaultValue()) write((u8)*visibility.refDefaultValue());
+      write((u32)visibility.refKeyframes().size());
+      for (const auto &[tc, v] : visibility.refKeyframes()) {
+        write(tc);
+        write((u8)*v);
+      }
+
+      write((u32)keyframes._transform.refKeyframes().size());
+      for (const auto &[tc, _] : keyframes._transform.refKeyframes()) write(tc);
+
+      write((u8)keyframes.hasSkelAnim());
+      if (keyframes.hasSkelAnim()) {
+        write(*keyframes._skelStartTimeCode);
+        write(*keyframes._skelEndTimeCode);
+      }
+      write((u32)keyframes._globalTimeCodes.size());
+      for (auto tc : keyframes._globalTimeCodes) write(tc);
+    }
+
+    /// @note meshes staged for any timecode (see stage_static_meshes) share one block, the
+    /// element counts of their arrays go to the manifest
+    void writeStaticMeshes(const PrimitiveDetail &details) {
+      const auto meshes = details.staticMeshes();
+      write((u8)(meshes != nullptr));
+      if (!meshes) return;
+      std::vector<std::byte> payload;
+      for_each_mesh_array(*meshes, [&](const auto &arr) {
+        write((u64)arr.size());
+        if (arr.size() == 0) return;
+        const auto p = reinterpret_cast<const std::byte *>(&arr[0]);
+        payload.insert(payload.end(), p, p + arr.size() * sizeof(arr[0]));
+      });
+      write(payload.size() ? writeBlock(payload.data(), payload.size()) : (u64)0);
+      write((u64)payload.size());
+    }
+
+    void writePrimitive(ZsPrimitive &prim, bool withChildren = true) {
+      auto &details = prim.details();
+      writeString(prim.label());
+      writeString(prim.path());
+      write((u32)details.getAssetOrigin());
+      write((u8)details.isYUpAxis());
+      write((u8)details.isRightHandedCoord());
+      write(details.getTransform(details.getCurrentTimeCode()));
+      writeString(details.texturePath());
+
+      writeAttrVector(prim.points());
+      writeAttrVector(prim.verts());
+
+      write((u64)prim._groups.size());
+      for (const auto &group : prim._groups) {
+        write((u64)group._ids.size());
+        for (auto id : group._ids) write(id);
+      }
+
+      /// @note custom containers are unknown to the format
+      PrimContainerSerializer serializer{*this};
+      u32 numContainers = 0;
+      for (const auto &[type, container] : prim._localPrims)
+        numContainers += container && type < PrimitiveStorage::Custom_;
+      write(numContainers);
+      for (auto &[type, container] : prim._localPrims) {
+        if (!container || type >= PrimitiveStorage::Custom_) continue;
+        write((u32)type);
+        container->accept(serializer);
+      }
+      write((u32)prim._primTagIndex.size());
+      for (const auto &[tag, type] : prim._primTagIndex) {
+        writeString(tag);
+        write((u32)type);
+      }
+      write((u64)prim._globalPrimMapping.size());
+      for (const auto &mapping : prim._globalPrimMapping) {
+        write((u32)zs::get<0>(mapping));
+        write(zs::get<1>(mapping));
+      }
+
+      writeKeyFrames(prim.keyframes());
+      writeStaticMeshes(details);
+
+      if (!withChildren) {
+        write((u32)0);
+        return;
+      }
+      write((u32)prim.numChildren());
+      for (const auto &child : prim.children()) writePrimitive(*child);
+    }
+
+    bool finish() {
+      if (const auto rem = _offset % sizeof(u64)) {
+        static const char zeros[sizeof(u64)] = {};
+        _os.write(zeros, sizeof(u64) - rem);
+        _offset += sizeof(u64) - rem;
+      }
+      PrimitiveCacheHeader header{};
+      std::memcpy(header._magic, g_primitive_cache_magic, sizeof(header._magic));
+      header._version = g_primitive_cache_version;
+      header._alignment = (u32)_alignment;
+      header._indexBytes = (u32)sizeof(PrimIndex);
+      header._manifestOffset = _offset;
+      header._manifestBytes = _manifest.size();
+      _os.write(_manifest.data(), _manifest.size());
+      _offset += _manifest.size();
+      _os.seekp(_base);
+      _os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      _os.seekp(_base + _offset);
+      return (bool)_os;
+    }
+    /// @brief bytes of the image, valid once finished
+    u64 bytes() const noexcept { return _offset; }
+
+    std::ostream &_os;
+    u64 _base;
+    size_t _alignment;
+    bool _compress;
+    u64 _offset{0};
+    SerializationBuffer _manifest;
+    std::unordered_map<const AttrVector *, u32> _sharedIds;
+  };
+
+  ///
+  /// reader
+  ///
+  /// @note any inconsistency marks the reader failed, reads then yield zeros
+  struct PrimitiveCacheReader {
+    /// @note the image spans [imageBytes] from [image] within the mapped file
+    PrimitiveCacheReader(Shared<MappedFile> file, std::byte *image, size_t imageBytes,
+                         const std::byte *manifest, size_t bytes)
+        : _file{zs::move(file)},
+          _image{image},
+          _imageBytes{imageBytes},
+          _cur{manifest},
+          _end{manifest + bytes} {}
+
+    template <typename T> T read() {
+      static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values");
+      T ret{};
+      if (_failed || (size_t)(_end - _cur) < sizeof(T)) {
+        _failed = true;
+        return ret;
+      }
+      std::memcpy(&ret, _cur, sizeof(T));
+      _cur += sizeof(T);
+      return ret;
+    }
+    const std::byte *readBytes(size_t bytes) {
+      if (_failed || (size_t)(_end - _cur) < bytes) {
+        _failed = true;
+        return nullptr;
+      }
+      auto ret = _cur;
+      _cur += bytes;
+      return ret;
+    }
+    /// @brief an entry count, failing if the rest of the manifest cannot hold that many entries
+    /// of at least [minEntryBytes] each, so that nothing is sized after a corrupted count
+    template <typename T> T readCount(size_t minEntryBytes) {
+      const auto ret = read<T>();
+      if (!_failed && (size_t)ret > (size_t)(_end - _cur) / minEntryBytes) _failed = true;
+      return _failed ? T{} : ret;
+    }
+    std::string readString() {
+      const auto size = read<u64>();
+      auto p = readBytes(size);
+      return p ? std::string(reinterpret_cast<const char *>(p), size) : std::string{};
+    }
+    /// @brief a block within the image
+    std::byte *block(u64 offset, u64 bytes) {
+      if (_failed || offset > _imageBytes || bytes > _imageBytes - offset) {
+        _failed = true;
+        return nullptr;
+      }
+      return _image + offset;
+    }
+
+    template <typename T> void readTileVector(TileVector<T> &tv, size_t size) {
+      std::vector<PropertyTag> tags(read<u32>());
+      for (auto &tag : tags) {
+        const auto name = readString();
+        tag.name = name.c_str();
+        tag.numChannels = read<u32>();
+      }
+      const auto codec = read<u8>();
+      const auto offset = read<u64>();
+      const auto bytes = read<u64>();
+      if (_failed) return;
+      if (codec == codec_Column) {
+        readColumns(tv, tags, size, block(offset, bytes), bytes);
+        return;
+      }
+      if (codec != codec_Raw) {
+        _failed = true;
+        return;
+      }
+      if (tags.empty()) {
+        tv.resize(size);
+        return;
+      }
+      auto src = block(offset, bytes);
+      if (!src) return;
+
+      auto allocator = get_memory_source(memsrc_e::host, -1);
+      allocator.res = std::make_shared<MappedBlockResource>(_file, src, bytes);
+      TileVector<T> ret{allocator, tags, size};
+      if (tile_vector_bytes(ret, size) != bytes) {
+        _failed = true;
+        return;
+      }
+      /// @note the storage is the mapped block unless the layout differs from the written one
+      if (reinterpret_cast<const std::byte *>(ret.data()) != src)
+        std::memcpy((void *)ret.data(), src, bytes);
+      else
+        _numMappedBlocks++;
+      tv = zs::move(ret);
+    }
+
+    /// @note decoded in parallel straight into freshly allocated tile storage
+    template <typename T>
+    void readColumns(TileVector<T> &tv, const std::vector<PropertyTag> &tags, size_t size,
+                     const std::byte *src, size_t bytes) {
+      TileVector<T> ret{tv.get_allocator(), tags, size};
+      std::vector<AttrChunkJob> jobs;
+      append_chunk_jobs(jobs, size, ret.numChannels(), sizeof(T) == sizeof(u64));
+      std::vector<size_t> sizes(jobs.size()), offsets(jobs.size() + 1, 0);
+      for (size_t j = 0; j != jobs.size(); ++j) {
+        sizes[j] = read<u64>();
+        offsets[j + 1] = offsets[j] + sizes[j];
+      }
+      if (_failed || !src || offsets.back() != bytes) {
+        _failed = true;
+        return;
+      }
+
+      std::atomic<bool> failed{false};
+      for_each_chunk(jobs.size(), [&](size_t j) {
+        if (!decode_chunk(ret, jobs[j], true, src + offsets[j], sizes[j])) failed = true;
+      });
+      if (failed) {
+        _failed = true;
+        return;
+      }
+      tv = zs::move(ret);
+    }
+
+    void readAttrVector(AttrVector &attr) {
+      const auto size = (size_t)read<u64>();
+      attr._owner = (prim_attrib_owner_e)read<u32>();
+      readTileVector(attr.attr32(), size);
+      readTileVector(attr.attr64(), size);
+      attr.strings().resize(read<u64>());
+      for (auto &str : attr.strings()) {
+        const auto len = read<u64>();
+        auto p = readBytes(len);
+        if (!p) return;
+        str = String(len);
+        std::memcpy(str.data(), p, len);
+      }
+    }
+    Shared<AttrVector> readSharedAttrVector() {
+      const auto id = read<u32>();
+      if (_failed) return {};
+      if (id < _shared.size()) return _shared[id];
+      if (id != _shared.size()) {
+        _failed = true;
+        return {};
+      }
+      auto attr = std::make_shared<AttrVector>();
+      /// @note decoded straight onto the keyframe memory, see set_keyframe_memory
+      if (_keyframeMemory) attr->relocate(_keyframeMemory->allocator());
+      _shared.push_back(attr);
+      readAttrVector(*attr);
+      return attr;
+    }
+
+    void readKeyFrames(PrimKeyFrames &keyframes) {
+      for (u32 n = read<u32>(), i = 0; i != n && !_failed; ++i) {
+        auto &frames = keyframes._attribs[readString()];
+        if (read<u8>()) frames.refDefaultValue() = readSharedAttrVector();
+        for (u32 m = read<u32>(), j = 0; j != m && !_failed; ++j) {
+          const auto tc = read<TimeCode>();
+          frames.refKeyframes().emplace(tc, readSharedAttrVector());
+        }
+        frames.refDirty() = true;
+      }
+
+      if (read<u8>()) keyframes.emplaceVisibilityDefault(read<u8>() != 0);
+      for (u32 n = read<u32>(), i = 0; i != n && !_failed; ++i) {
+        const auto tc = read<TimeCode>();
+        keyframes.emplaceVisibilityKeyFrame(tc, read<u8>() != 0);
+      }
+
+      for (u32 n = read<u32>(), i = 0; i != n && !_failed; ++i)
+        keyframes.emplaceTransformKeyFrame(read<TimeCode>());
+
+      if (read<u8>()) {
+        const auto st = read<TimeCode>();
+        keyframes.setSkelAnimTimeCodeInterval(st, read<TimeCode>());
+      }
+      keyframes._globalTimeCodes.clear();
+      for (u32 n = read<u32>(), i = 0; i != n && !_failed; ++i)
+        keyframes._globalTimeCodes.push_back(read<TimeCode>());
+      keyframes.markModified();
+    }
+
+    /// @note staged after the keyframes are read, see PrimitiveDetail::stageMeshes
+    void readStaticMeshes(PrimitiveDetail &details) {
+      if (!read<u8>()) return;
+      auto meshes = std::make_shared<ZsMeshBundle>();
+      std::vector<u64> sizes;
+      for_each_mesh_array(*meshes, [&](auto &) { sizes.push_back(read<u64>()); });
+      const auto offset = read<u64>();
+      const auto bytes = read<u64>();
+      if (_failed) return;
+      const std::byte *src = bytes ? block(offset, bytes) : nullptr;
+      if (bytes && !src) return;
+      size_t i = 0, consumed = 0;
+      for_each_mesh_array(*meshes, [&](auto &arr) {
+        const auto n = sizes[i++];
+        if (_failed || n == 0) return;
+        const auto elemBytes = sizeof(arr[0]);
+        if (n > (bytes - consumed) / elemBytes) {
+          _failed = true;
+          return;
+        }
+        arr.resize(n);
+        std::memcpy(&arr[0], src + consumed, n * elemBytes);
+        consumed += n * elemBytes;
+      });
+      if (_failed || consumed != bytes) {
+        _failed = true;
+        return;
+      }
+      details.stageMeshes(g_default_timecode(), zs::move(meshes));
+    }
+
+    void readPrimitive(ZsPrimitive &prim) {
+      auto &details = prim.details();
+      prim.label() = readString();
+      prim.path() = readString();
+      details.setAssetOrigin((asset_origin_e)read<u32>());
+      details.isYUpAxis() = read<u8>() != 0;
+      details.isRightHandedCoord() = read<u8>() != 0;
+      details.setTransform(read<glm::mat4>());
+      details.texturePath() = readString();
+
+      readAttrVector(prim.points());
+      readAttrVector(prim.verts());
+
+      prim._groups.resize(read<u64>());
+      for (auto &group : prim._groups)
+        for (u64 n = read<u64>(), i = 0; i != n && !_failed; ++i)
+          group._ids.insert(read<PrimIndex>());
+
+      PrimContainerDeserializer deserializer{*this};
+      for (u32 n = read<u32>(), i = 0; i != n && !_failed; ++i) {
+        const auto type = (PrimTypeIndex)read<u32>();
+        auto container = make_local_prim_container(type);
+        if (!container) {
+          _failed = true;
+          return;
+        }
+        container->accept(deserializer);
+        prim._localPrims[type] = zs::move(container);
+      }
+      for (u32 n = read<u32>(), i = 0; i != n && !_failed; ++i) {
+        auto tag = readString();
+        prim._primTagIndex[zs::move(tag)] = (PrimTypeIndex)read<u32>();
+      }
+      prim._globalPrimMapping.resize(read<u64>());
+      for (auto &mapping : prim._globalPrimMapping) {
+        const auto type = (PrimTypeIndex)read<u32>();
+        mapping = zs::make_tuple(type, read<PrimIndex>());
+      }
+
+      readKeyFrames(prim.keyframes());
+      readStaticMeshes(details);
+
+      for (u32 n = read<u32>(), i = 0; i != n && !_failed; ++i) {
+        auto child = std::make_unique<ZsPrimitive>();
+        readPrimitive(*child);
+        prim.appendChildPrimitve(child.release());
+      }
+      details.setDirty(PrimitiveDetail::dirty_All);
+    }
+
+    bool failed() const noexcept { return _failed; }
+
+    Shared<MappedFile> _file;
+    std::byte *_image;
+    size_t _imageBytes;
+    const std::byte *_cur, *_end;
+    std::vector<Shared<AttrVector>> _shared;
+    Shared<TrackedResource> _keyframeMemory{get_keyframe_memory()};
+    size_t _numMappedBlocks{0};
+    bool _failed{false};
+  };
+
+  ///
+  /// container payloads
+  ///
+  void PrimContainerSerializer::visit(PolyPrimContainer &prim) {
+    _writer.writeAttrVector(prim.prims());
+  }
+  void PrimContainerSerializer::visit(TriPrimContainer &prim) {
+    _writer.writeAttrVector(prim.prims());
+  }
+  void PrimContainerSerializer::visit(LinePrimContainer &prim) {
+    _writer.writeAttrVector(prim.prims());
+  }
+  void PrimContainerSerializer::visit(PointPrimContainer &prim) {
+    _writer.writeAttrVector(prim.prims());
+  }
+  void PrimContainerSerializer::visit(SdfPrimContainer &prim) {
+    const auto &volume = prim.volume();
+    _writer.write((u8)(volume != nullptr));
+    if (!volume) return;
+    _writer.write(volume->_voxelSize);
+    _writer.write(volume->_bandwidth);
+    _writer.write(volume->_origin);
+    const auto numBricks = (u64)volume->numBricks();
+    _writer.write(numBricks);
+    _writer.write(_writer.writeBlock(volume->_brickCoords.data(),
+                                     numBricks * sizeof(glm::ivec3)));
+    _writer.write(_writer.writeBlock(volume->_values.data(), volume->_values.size() * sizeof(f32)));
+  }
+  /// @note packed prims refer to other scene prims thus are not persisted
+  void PrimContainerSerializer::visit(PackPrimContainer &prim) {
+    _writer.write((u8)prim.isInstanced());
+    if (prim.isInstanced()) _writer.writePrimitive(*prim.prototype());
+    _writer.writeAttrVector(prim.instances());
+  }
+  void PrimContainerSerializer::visit(LightPrimContainer &prim) {
+    _writer.write((u32)prim.lightType());
+    _writer.write(prim.intensity());
+    _writer.write(prim.lightColor());
+    _writer.write(prim.lightVector());
+    _writer.write(prim.colorTemperature());
+    _writer.write(prim.exposure());
+    _writer.write((u8)prim.enableColorTemperature());
+  }
+
+  void PrimContainerDeserializer::visit(PolyPrimContainer &prim) {
+    _reader.readAttrVector(prim.prims());
+  }
+  void PrimContainerDeserializer::visit(TriPrimContainer &prim) {
+    _reader.readAttrVector(prim.prims());
+  }
+  void PrimContainerDeserializer::visit(LinePrimContainer &prim) {
+    _reader.readAttrVector(prim.prims());
+  }
+  void PrimContainerDeserializer::visit(PointPrimContainer &prim) {
+    _reader.readAttrVector(prim.prims());
+  }
+  void PrimContainerDeserializer::visit(SdfPrimContainer &prim) {
+    if (!_reader.read<u8>()) return;
+    auto volume = std::make_shared<SparseSdfVolume>();
+    volume->_voxelSize = _reader.read<f32>();
+    volume->_bandwidth = _reader.read<f32>();
+    volume->_origin = _reader.read<glm::vec3>();
+    const auto numBricks = _reader.read<u64>();
+    const auto coordBytes = numBricks * sizeof(glm::ivec3);
+    const auto valueBytes = numBricks * SparseSdfVolume::s_brick_size * sizeof(f32);
+    auto coords = _reader.block(_reader.read<u64>(), coordBytes);
+    auto values = _reader.block(_reader.read<u64>(), valueBytes);
+    if (!coords || !values) return;
+    volume->_brickCoords.resize(numBricks);
+    volume->_values.resize(numBricks * SparseSdfVolume::s_brick_size);
+    std::memcpy(volume->_brickCoords.data(), coords, coordBytes);
+    std::memcpy(volume->_values.data(), values, valueBytes);
+    volume->_brickIndex.reserve(numBricks);
+    for (u32 i = 0; i != numBricks; ++i)
+      volume->_brickIndex.insert(SparseSdfVolume::brick_key(volume->_brickCoords[i]), i);
+    prim.volume() = zs::move(volume);
+  }
+  void PrimContainerDeserializer::visit(PackPrimContainer &prim) {
+    if (_reader.read<u8>()) {
+      auto prototype = std::make_shared<ZsPrimitive>();
+      _reader.readPrimitive(*prototype);
+      prim.prototype() = zs::move(prototype);
+    }
+    _reader.readAttrVector(prim.instances());
+  }
+  void PrimContainerDeserializer::visit(LightPrimContainer &prim) {
+    prim.lightType() = (LightSourceType)_reader.read<u32>();
+    prim.intensity() = _reader.read<float>();
+    prim.lightColor() = _reader.read<glm::vec3>();
+    prim.lightVector() = _reader.read<glm::vec4>();
+    prim.colorTemperature() = _reader.read<float>();
+    prim.exposure() = _reader.read<float>();
+    prim.enableColorTemperature() = _reader.read<u8>() != 0;
+  }
+
+  ///
+  /// entries
+  ///
+  bool write_primitive_cache(const ZsPrimitive &root, std::ostream &os, bool compress,
+                             bool withChildren, size_t alignment) {
+    if (alignment == 0 || alignment > g_primitive_cache_alignment
+        || (alignment & (alignment - 1)) != 0)
+      return false;
+    PrimitiveCacheWriter writer{os, compress, alignment};
+    /// @note container visitors and keyframe accessors are non-const, nothing is modified
+    writer.writePrimitive(const_cast<ZsPrimitive &>(root), withChildren);
+    return writer.finish();
+  }
+
+  Shared<ZsPrimitive> read_primitive_cache(Shared<MappedFile> file, size_t offset, size_t bytes) {
+    if (!file || !file->valid() || offset > file->size() || bytes > file->size() - offset
+        || bytes < sizeof(PrimitiveCacheHeader))
+      return {};
+
+    const auto image = file->data() + offset;
+    PrimitiveCacheHeader header;
+    std::memcpy(&header, image, sizeof(header));
+    /// @note index channels and ids are laid out by the index width of the writer
+    const u32 indexBytes = header._indexBytes ? header._indexBytes : (u32)sizeof(i32);
+    if (std::memcmp(header._magic, g_primitive_cache_magic, sizeof(header._magic)) != 0
+        || header._version != g_primitive_cache_version || indexBytes != sizeof(PrimIndex)
+        || header._alignment == 0 || header._alignment > g_primitive_cache_alignment
+        || (header._alignment & (header._alignment - 1)) != 0 || header._manifestOffset > bytes
+        || header._manifestBytes > bytes - header._manifestOffset) {
+      zs_print_err_py_cstr("incompatible primitive cache.");
+      return {};
+    }
+
+    const auto manifest = image + header._manifestOffset;
+    PrimitiveCacheReader reader{zs::move(file), image, bytes, manifest, header._manifestBytes};
+    auto ret = std::make_shared<ZsPrimitive>();
+    reader.readPrimitive(*ret);
+    if (reader.failed()) {
+      zs_print_err_py_cstr("corrupted primitive cache.");
+      return {};
+    }
+    return ret;
+  }
+
+  bool save_primitive_cache(const ZsPrimitive &root, std::string_view fileName, bool compress) {
+    /// @note uniquely named temporary, made durable before renamed over [fileName]
+    ArchiveWriter writer{fileName, false};
+    auto os = writer.stream();
+    if (!os) {
+      zs_print_err_py_cstr("unable to open the primitive cache for writing.");
+      return false;
+    }
+    if (!write_primitive_cache(root, *os, compress)) {
+      writer.abort();
+      zs_print_err_py_cstr("failed writing the primitive cache.");
+      return false;
+    }
+    if (writer.commit() != 0) {
+      zs_print_err_py_cstr("unable to replace the primitive cache.");
+      return false;
+    }
+    return true;
+  }
+
+  Shared<ZsPrimitive> load_primitive_cache(std::string_view fileName) {
+    auto file = std::make_shared<MappedFile>(fileName);
+    if (!file->valid()) return {};
+    const auto bytes = file->size();
+    return read_primitive_cache(zs::move(file), 0, bytes);
+  }
+
+  bool serialize_attr_vector(const AttrVector &attr, SerializationBuffer &buffer, bool compress) {
+    const size_t size = attr.size();
+    const auto &attr32 = attr.attr32();
+    const auto &attr64 = attr.attr64();
+    const size_t numChannels32 = attr32.getPropertyTags().size() ? attr32.numChannels() : 0;
+    const size_t numChannels64 = attr64.getPropertyTags().size() ? attr64.numChannels() : 0;
+    const auto jobs = attr_chunk_jobs(size, numChannels32, numChannels64);
+    auto valueBytes = [](const AttrChunkJob &job) {
+      return job._count * (job._is64 ? sizeof(u64) : sizeof(f32));
+    };
+
+    SerializationBuffer manifest;
+    append_tags(manifest, attr32);
+    append_tags(manifest, attr64);
+    append_pod(manifest, (u64)attr.strings().size());
+    for (const auto &str : attr.strings()) {
+      append_pod(manifest, (u64)str.size());
+      const auto p = reinterpret_cast<const char *>(str.data());
+      manifest.insert(manifest.end(), p, p + str.size());
+    }
+
+    /// @note raw chunks are sized upfront and gathered straight into place, coded ones are
+    /// encoded into scratch buffers first, then stitched in parallel
+    std::vector<AttrVectorChunk> table(jobs.size());
+    std::vector<std::vector<std::byte>> encoded(compress ? jobs.size() : 0);
+    if (compress)
+      for_each_chunk(jobs.size(), [&](size_t j) {
+        const auto &job = jobs[j];
+        if (job._is64)
+          encode_chunk(attr64, job, encoded[j]);
+        else
+          encode_chunk(attr32, job, encoded[j]);
+      });
+    u64 payloadBytes = 0;
+    for (size_t j = 0; j != jobs.size(); ++j) {
+      table[j]._offset = payloadBytes;
+      table[j]._bytes = compress ? encoded[j].size() : valueBytes(jobs[j]);
+      payloadBytes += table[j]._bytes;
+    }
+
+    AttrVectorHeader header{};
+    std::memcpy(header._magic, g_attr_vector_magic, sizeof(header._magic));
+    header._version = g_attr_vector_version;
+    header._codec = compress ? codec_Column : codec_Raw;
+    header._size = size;
+    header._manifestBytes = manifest.size();
+    header._numChunks = jobs.size();
+    header._payloadBytes = payloadBytes;
+    header._owner = (u32)attr._owner;
+
+    const size_t base = buffer.size();
+    const size_t tableBytes = table.size() * sizeof(AttrVectorChunk);
+    const size_t payloadBase = base + sizeof(header) + manifest.size() + tableBytes;
+    buffer.resize(payloadBase + payloadBytes);
+    std::memcpy(buffer.data() + base, &header, sizeof(header));
+    std::memcpy(buffer.data() + base + sizeof(header), manifest.data(), manifest.size());
+    std::memcpy(buffer.data() + base + sizeof(header) + manifest.size(), table.data(), tableBytes);
+
+    auto payload = reinterpret_cast<std::byte *>(buffer.data() + payloadBase);
+    for_each_chunk(jobs.size(), [&](size_t j) {
+      const auto &job = jobs[j];
+      auto dst = payload + table[j]._offset;
+      if (compress) {
+        if (encoded[j].size()) std::memcpy(dst, encoded[j].data(), encoded[j].size());
+        std::vector<std::byte>{}.swap(encoded[j]);
+      } else if (job._is64)
+        gather_column(attr64, job, dst);
+      else
+        gather_column(attr32, job, dst);
+    });
+    return true;
+  }
+
+  bool deserialize_attr_vector(const void *data, size_t bytes, AttrVector &attr) {
+    auto fail = []() {
+      zs_print_err_py_cstr("corrupted attribute vector.");
+      return false;
+    };
+    const auto src = static_cast<const std::byte *>(data);
+    AttrVectorHeader header;
+    if (bytes < sizeof(header)) return fail();
+    std::memcpy(&header, src, sizeof(header));
+    if (std::memcmp(header._magic, g_attr_vector_magic, sizeof(header._magic)) != 0
+        || header._version != g_attr_vector_version
+        || (header._codec != codec_Raw && header._codec != codec_Column))
+      return fail();
+    const size_t available = bytes - sizeof(header);
+    if (header._manifestBytes > available
+        || header._numChunks > (available - header._manifestBytes) / sizeof(AttrVectorChunk))
+      return fail();
+    const size_t tableBytes = header._numChunks * sizeof(AttrVectorChunk);
+    if (header._payloadBytes > available - header._manifestBytes - tableBytes) return fail();
+
+    /// @note the manifest is parsed through a reader without image
+    const auto manifest = src + sizeof(header);
+    PrimitiveCacheReader reader{{}, nullptr, 0, manifest, header._manifestBytes};
+    auto readTags = [&reader]() {
+      std::vector<PropertyTag> tags(reader.readCount<u32>(sizeof(u64) + sizeof(u32)));
+      for (auto &tag : tags) {
+        const auto name = reader.readString();
+        tag.name = name.c_str();
+        tag.numChannels = reader.read<u32>();
+      }
+      return tags;
+    };
+    const auto tags32 = readTags();
+    const auto tags64 = readTags();
+    std::vector<String> strings(reader.readCount<u64>(sizeof(u64)));
+    for (auto &str : strings) {
+      const auto len = reader.read<u64>();
+      auto p = reader.readBytes(len);
+      if (!p) break;
+      str = String(len);
+      std::memcpy(str.data(), p, len);
+    }
+    if (reader.failed()) return fail();
+
+    /// @note the chunk count implied by the manifest must match the header before any storage
+    /// is sized after it
+    const size_t size = header._size;
+    auto channelCount = [](const std::vector<PropertyTag> &tags) {
+      size_t ret = 0;
+      for (const auto &tag : tags) ret += tag.numChannels;
+      return ret;
+    };
+    const size_t numChannels32 = channelCount(tags32), numChannels64 = channelCount(tags64);
+    const size_t numChannels = numChannels32 + numChannels64;
+    const size_t numChunks = size / g_column_chunk_size + (size % g_column_chunk_size != 0);
+    if (numChannels == 0 ? header._numChunks != 0
+                         : header._numChunks % numChannels != 0
+                               || header._numChunks / numChannels != numChunks)
+      return fail();
+
+    auto makeTileVector = [size](auto wrapper, const std::vector<PropertyTag> &tags) {
+      using T = typename decltype(wrapper)::type;
+      if (tags.empty()) {
+        TileVector<T> ret{};
+        ret.resize(size);
+        return ret;
+      }
+      return TileVector<T>{get_memory_source(memsrc_e::host, -1), tags, size};
+    };
+    auto attr32 = makeTileVector(wrapt<f32>{}, tags32);
+    auto attr64 = makeTileVector(wrapt<u64>{}, tags64);
+    const auto jobs = attr_chunk_jobs(size, numChannels32, numChannels64);
+    std::vector<AttrVectorChunk> table(jobs.size());
+    std::memcpy(table.data(), manifest + header._manifestBytes, tableBytes);
+    for (const auto &chunk : table)
+      if (chunk._offset > header._payloadBytes
+          || chunk._bytes > header._payloadBytes - chunk._offset)
+        return fail();
+
+    const auto payload = manifest + header._manifestBytes + tableBytes;
+    const bool compressed = header._codec == codec_Column;
+    std::atomic<bool> failed{false};
+    for_each_chunk(jobs.size(), [&](size_t j) {
+      const auto &job = jobs[j];
+      const auto chunk = payload + table[j]._offset;
+      const bool ok = job._is64 ? decode_chunk(attr64, job, compressed, chunk, table[j]._bytes)
+                                : decode_chunk(attr32, job, compressed, chunk, table[j]._bytes);
+      if (!ok) failed = true;
+    });
+    if (failed) return fail();
+
+    attr._attr32 = zs::move(attr32);
+    attr._attr64 = zs::move(attr64);
+    attr._strings = zs::move(strings);
+    attr._owner = (prim_attrib_owner_e)header._owner;
+    return true;
+  }
 
-}  // namespace zs
\ No newline at end of file
+}  // namespace zs
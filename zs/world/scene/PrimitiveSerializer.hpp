@@ -1,20 +1,91 @@
 #pragma once
+#include <iosfwd>
+
 #include "../WorldExport.hpp"
 #include "Primitive.hpp"
+#include "world/core/MappedFile.hpp"
+#include "world/core/Serialization.hpp"
 
 namespace zs {
 
+  /// @brief version of the on-disk primitive cache, bumped upon any layout change
+  constexpr u32 g_primitive_cache_version = 3;
+  /// @brief alignment (in bytes) of attribute blocks within the cache file, the largest one
+  /// supported
+  constexpr size_t g_primitive_cache_alignment = 4096;
+
+  struct PrimitiveCacheWriter;
+  struct PrimitiveCacheReader;
+
   /// serializer
+  /// @note writes the payload of local prim containers into a primitive cache
   struct ZS_WORLD_EXPORT PrimContainerSerializer : PrimContainerVisitor {
-    void visit(PolyPrimContainer& prim) override {}
-    void visit(TriPrimContainer& prim) override {}
-    void visit(LinePrimContainer& prim) override {}
-    void visit(PointPrimContainer& prim) override {}
-    void visit(SdfPrimContainer& prim) override {}
-    void visit(PackPrimContainer& prim) override {}
+    explicit PrimContainerSerializer(PrimitiveCacheWriter& writer) noexcept : _writer{writer} {}
+
+    void visit(PolyPrimContainer& prim) override;
+    void visit(TriPrimContainer& prim) override;
+    void visit(LinePrimContainer& prim) override;
+    void visit(PointPrimContainer& prim) override;
+    void visit(SdfPrimContainer& prim) override;
+    void visit(PackPrimContainer& prim) override;
     void visit(AnalyticPrimContainer& prim) override {}
     void visit(CameraPrimContainer& prim) override {}
-    void visit(LightPrimContainer& prim) override {}
+    void visit(LightPrimContainer& prim) override;
+
+  protected:
+    PrimitiveCacheWriter& _writer;
   };
 
-}  // namespace zs
\ No newline at end of file
+  /// deserializer
+  /// @note reads back into freshly created containers what the serializer wrote
+  struct ZS_WORLD_EXPORT PrimContainerDeserializer : PrimContainerVisitor {
+    explicit PrimContainerDeserializer(PrimitiveCacheReader& reader) noexcept : _reader{reader} {}
+
+    void visit(PolyPrimContainer& prim) override;
+    void visit(TriPrimContainer& prim) override;
+    void visit(LinePrimContainer& prim) override;
+    void visit(PointPrimContainer& prim) override;
+    void visit(SdfPrimContainer& prim) override;
+    void visit(PackPrimContainer& prim) override;
+    void visit(AnalyticPrimContainer& prim) override {}
+    void visit(CameraPrimContainer& prim) override {}
+    void visit(LightPrimContainer& prim) override;
+
+  protected:
+    PrimitiveCacheReader& _reader;
+  };
+
+  /// @brief write the hierarchy of [root] (attribute channels, local prim containers, groups,
+  /// keyframes and children) into a versioned binary cache
+  /// @note attribute channels are stored as their raw tile storage in page-aligned blocks,
+  /// followed by a manifest describing the hierarchy
+  /// @note keyframe geometry shared among prims is written once
+  /// @note zs meshes staged for any timecode (see stage_static_meshes) are persisted and staged
+  /// again upon loading, other derived data (bvhs, vk models), usd bindings and handles to other
+  /// scene prims are not
+  /// @note [compress] codes every channel with ColumnCodec (xor or delta prediction, byte
+  /// shuffle, lz), which trades the zero-copy loading of raw blocks for a smaller file
+  /// @note written to a temporary file first, then renamed over [fileName]
+  ZS_WORLD_EXPORT bool save_primitive_cache(const ZsPrimitive& root, std::string_view fileName,
+                                            bool compress = false);
+  /// @brief write the cache image of [root] at the current position of [os], which is left at
+  /// the end of the image
+  /// @note block offsets and alignment are relative to the start of the image, thus images
+  /// starting at aligned positions of a larger file (e.g. a journal) keep their blocks aligned
+  /// @note [withChildren] false writes [root] alone, as a leaf
+  /// @note [alignment] (a power of two up to g_primitive_cache_alignment) may be lowered for
+  /// images of small prims packed together, mapped blocks are then aligned to it only
+  ZS_WORLD_EXPORT bool write_primitive_cache(const ZsPrimitive& root, std::ostream& os,
+                                             bool compress = false, bool withChildren = true,
+                                             size_t alignment = g_primitive_cache_alignment);
+
+  /// @brief load a hierarchy written by save_primitive_cache, nullptr upon failure
+  /// @note the file is mapped and the tile storage of raw attribute channels points directly into
+  /// the mapping (copy-on-write), which is released once the last of them is freed, compressed
+  /// channels are decoded in parallel
+  ZS_WORLD_EXPORT Shared<ZsPrimitive> load_primitive_cache(std::string_view fileName);
+  /// @brief load the image of [bytes] written by write_primitive_cache at [offset] of [file]
+  ZS_WORLD_EXPORT Shared<ZsPrimitive> read_primitive_cache(Shared<MappedFile> file, size_t offset,
+                                                           size_t bytes);
+
+}  // namespace zs
@@ -0,0 +1,364 @@
+#include "PrimitiveSkinning.hpp"
+
+#include <glm/gtc/quaternion.hpp>
+
+#if ZS_ENABLE_OPENMP
+#  include "zensim/omp/execution/ExecutionPolicy.hpp"
+#else
+#  include "zensim/execution/ExecutionPolicy.hpp"
+#endif
+
+namespace zs {
+
+  namespace {
+    /// @brief translation, rotation and (signed) scale of an affine transform, shear dropped
+    struct JointTRS {
+      glm::vec3 _t;
+      glm::quat _r;
+      glm::vec3 _s;
+    };
+    JointTRS decompose_trs(const glm::mat4 &m) {
+      JointTRS ret;
+      ret._t = glm::vec3(m[3]);
+      glm::mat3 rot{glm::vec3(m[0]), glm::vec3(m[1]), glm::vec3(m[2])};
+      ret._s = {glm::length(rot[0]), glm::length(rot[1]), glm::length(rot[2])};
+      /// @note a mirroring transform keeps a proper rotation by flipping one axis
+      if (glm::determinant(rot) < 0) ret._s[0] = -ret._s[0];
+      for (int c = 0; c != 3; ++c)
+        if (ret._s[c] != 0) rot[c] /= ret._s[c];
+      ret._r = glm::normalize(glm::quat_cast(rot));
+      return ret;
+    }
+    glm::mat4 compose_trs(const JointTRS &trs) {
+      const auto rot = glm::mat3_cast(trs._r);
+      glm::mat4 ret{1.f};
+      for (int c = 0; c != 3; ++c) ret[c] = glm::vec4(rot[c] * trs._s[c], 0.f);
+      ret[3] = glm::vec4(trs._t, 1.f);
+      return ret;
+    }
+    /// @note blending matrices entry-wise shrinks rotating joints (candy-wrapper), components
+    /// are interpolated instead (lerp translation and scale, slerp rotation), as UsdSkel does
+    glm::mat4 interpolate_joint_transform(const glm::mat4 &a, const glm::mat4 &b, f32 t) {
+      const auto ta = decompose_trs(a), tb = decompose_trs(b);
+      return compose_trs(JointTRS{glm::mix(ta._t, tb._t, t), glm::slerp(ta._r, tb._r, t),
+                                  glm::mix(ta._s, tb._s, t)});
+    }
+  }  // namespace
+
+  Shared<SkinningBinding> build_skinning_binding(int numPoints, int numInfluences,
+                                                 const int *jointIndices,
+                                                 const float *jointWeights,
+                                                 const std::vector<glm::mat4> &jointBindTransforms,
+                                                 const glm::mat4 &geomBindTransform) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+    constexpr auto space = execspace_e::openmp;
+#else
+    auto pol = seq_exec();
+    constexpr auto space = execspace_e::host;
+#endif
+    auto ret = std::make_shared<SkinningBinding>();
+    ret->_numInfluences = numInfluences;
+    ret->_geomBindTransform = geomBindTransform;
+
+    /// influences
+    auto &influences = ret->_influences;
+    influences._owner = prim_attrib_owner_e::point;
+    influences.appendProperties32(pol, {{ATTRIB_SKIN_JOINT_INDEX_TAG, numInfluences},
+                                        {ATTRIB_SKIN_JOINT_WEIGHT_TAG, numInfluences}});
+    influences.resize(numPoints);
+    pol(range(numPoints),
+        [inflView = view<space>({}, influences.attr32()),
+         idxOffset = influences.getPropertyOffset(ATTRIB_SKIN_JOINT_INDEX_TAG),
+         wOffset = influences.getPropertyOffset(ATTRIB_SKIN_JOINT_WEIGHT_TAG), jointIndices,
+         jointWeights, numInfluences](PrimIndex i) mutable {
+          const auto base = (size_t)i * numInfluences;
+          f32 sum = 0;
+          for (int k = 0; k != numInfluences; ++k) sum += jointWeights[base + k];
+          /// @note weights are normalized here so that kernels can skip it
+          const f32 scale = sum > 0 ? (f32)1 / sum : (f32)0;
+          for (int k = 0; k != numInfluences; ++k) {
+            inflView(idxOffset + k, i, wrapt<i32>{}) = jointIndices[base + k];
+            inflView(wOffset + k, i) = jointWeights[base + k] * scale;
+          }
+        });
+
+    /// joints
+    auto &joints = ret->_joints;
+    joints._owner = prim_attrib_owner_e::prim;
+    joints.appendProperties32(pol, {{ATTRIB_JOINT_INV_BIND_TAG, 16}});
+    joints.resize(jointBindTransforms.size());
+    pol(range(jointBindTransforms.size()),
+        [jointView = view<space>({}, joints.attr32()),
+         offset = joints.getPropertyOffset(ATTRIB_JOINT_INV_BIND_TAG),
+         &jointBindTransforms](PrimIndex j) mutable {
+          auto invBind = glm::inverse(jointBindTransforms[j]);
+          for (int c = 0; c != 4; ++c)
+            for (int r = 0; r != 4; ++r) jointView(offset + c * 4 + r, j) = invBind[c][r];
+        });
+    return ret;
+  }
+
+  void emplace_joint_transforms(SkinningBinding &binding, TimeCode tc,
+                                const std::vector<glm::mat4> &jointTransforms) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+    constexpr auto space = execspace_e::openmp;
+#else
+    auto pol = seq_exec();
+    constexpr auto space = execspace_e::host;
+#endif
+    AttrVector frame;
+    frame._owner = prim_attrib_owner_e::prim;
+    frame.appendProperties32(pol, {{ATTRIB_JOINT_TRANSFORM_TAG, 16}});
+    frame.resize(jointTransforms.size());
+    pol(range(jointTransforms.size()),
+        [frameView = view<space>({}, frame.attr32()),
+         offset = frame.getPropertyOffset(ATTRIB_JOINT_TRANSFORM_TAG),
+         &jointTransforms](PrimIndex j) mutable {
+          const auto &m = jointTransforms[j];
+          for (int c = 0; c != 4; ++c)
+            for (int r = 0; r != 4; ++r) frameView(offset + c * 4 + r, j) = m[c][r];
+        });
+    if (std::isnan(tc))
+      binding._jointTransforms.emplace(zs::move(frame));
+    else
+      binding._jointTransforms.emplace(tc, zs::move(frame));
+  }
+
+  bool set_skinning_joint_parents(SkinningBinding &binding, std::vector<int> jointParents) {
+    const int numJoints = binding.numJoints();
+    if ((int)jointParents.size() != numJoints) return false;
+    for (auto p : jointParents)
+      if (p < -1 || p >= numJoints) return false;
+    /// @note each joint is ordered after the chain of its unordered ancestors
+    std::vector<int> order, chain;
+    order.reserve(numJoints);
+    std::vector<u8> state(numJoints, 0);  // 1: on the current chain, 2: ordered
+    for (int j = 0; j != numJoints; ++j) {
+      chain.clear();
+      for (int k = j; k != -1 && state[k] != 2; k = jointParents[k]) {
+        if (state[k] == 1) return false;
+        state[k] = 1;
+        chain.push_back(k);
+      }
+      for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        state[*it] = 2;
+        order.push_back(*it);
+      }
+    }
+    binding._jointParents = zs::move(jointParents);
+    binding._jointOrder = zs::move(order);
+    return true;
+  }
+
+  void attach_skinning_binding(PrimitiveStorage &prim, Shared<SkinningBinding> binding) {
+    auto &keyframes = prim.keyframes();
+    if (binding && !keyframes.hasSkelAnim()) {
+      const auto &tcs = binding->_jointTransforms.getTimeCodes();
+      if (tcs.size())
+        keyframes.setSkelAnimTimeCodeInterval(tcs[0], tcs.back());
+      else
+        keyframes.setSkelAnimTimeCodeInterval(g_default_timecode(), g_default_timecode());
+    }
+    /// @note settle the lazily sorted samples before concurrent evaluations read them
+    if (binding) binding->_jointTransforms.updateSequence();
+    prim.details().skinningBinding() = zs::move(binding);
+    keyframes.markModified();
+  }
+
+  void compute_skinning_transforms(const SkinningBinding &binding, TimeCode tc,
+                                   std::vector<glm::mat4> &skinningTransforms) {
+    const auto numJoints = binding.numJoints();
+    skinningTransforms.resize(numJoints);
+    const auto &kfs = binding._jointTransforms;
+
+    /// @note locate the enclosing samples
+    auto segNo = kfs.getTimeCodeSegmentIndex(tc);
+    auto frame = kfs.getSegmentFrame(segNo).lock();
+    Shared<AttrVector> nextFrame{};
+    f32 t = 0;
+    if (kfs.isTimeDependent() && !std::isnan(tc) && segNo >= 0 && segNo + 1 < kfs.getNumFrames()) {
+      auto st = kfs.getSegmentTimeCode(segNo);
+      auto ed = kfs.getSegmentTimeCode(segNo + 1);
+      if (ed > st && tc > st) {
+        nextFrame = kfs.getSegmentFrame(segNo + 1).lock();
+        t = static_cast<f32>((tc - st) / (ed - st));
+      }
+    }
+
+    auto jointView = view<execspace_e::host>({}, binding._joints.attr32());
+    const auto bindOffset = binding._joints.getPropertyOffset(ATTRIB_JOINT_INV_BIND_TAG);
+    auto readMat = [](const auto &v, int offset, PrimIndex j) {
+      glm::mat4 m;
+      for (int c = 0; c != 4; ++c)
+        for (int r = 0; r != 4; ++r) m[c][r] = v(offset + c * 4 + r, j);
+      return m;
+    };
+    const auto &geomBind = binding._geomBindTransform;
+    const auto geomBindInv = glm::inverse(geomBind);
+    if (!frame) {
+      for (auto &m : skinningTransforms) m = glm::mat4(1.f);
+      return;
+    }
+    auto frameView = view<execspace_e::host>({}, frame->attr32());
+    const auto xformOffset = frame->getPropertyOffset(ATTRIB_JOINT_TRANSFORM_TAG);
+    /// @note skeleton space joint transforms first
+    if (!nextFrame) {
+      for (PrimIndex j = 0; j != numJoints; ++j)
+        skinningTransforms[j] = readMat(frameView, xformOffset, j);
+    } else {
+      auto nextView = view<execspace_e::host>({}, nextFrame->attr32());
+      /// @note interpolating skeleton space transforms would let a child drift off the arc its
+      /// rotating parent sweeps, joints are thus interpolated relative to their parents
+      const auto &parents = binding._jointParents;
+      const auto &order = binding._jointOrder;
+      const bool hierarchical = (int)order.size() == numJoints;
+      for (PrimIndex k = 0; k != numJoints; ++k) {
+        const PrimIndex j = hierarchical ? order[k] : k;
+        const int p = hierarchical ? parents[j] : -1;
+        auto a = readMat(frameView, xformOffset, j), b = readMat(nextView, xformOffset, j);
+        if (p != -1) {
+          a = glm::inverse(readMat(frameView, xformOffset, p)) * a;
+          b = glm::inverse(readMat(nextView, xformOffset, p)) * b;
+        }
+        const auto local = interpolate_joint_transform(a, b, t);
+        skinningTransforms[j] = p != -1 ? skinningTransforms[p] * local : local;
+      }
+    }
+    for (PrimIndex j = 0; j != numJoints; ++j)
+      skinningTransforms[j]
+          = geomBindInv * skinningTransforms[j] * readMat(jointView, bindOffset, j) * geomBind;
+  }
+
+  bool apply_skinning(const SkinningBinding &binding,
+                      const std::vector<glm::mat4> &skinningTransforms, AttrVector &points,
+                      skinning_method_e method, const char *srcTag, const source_location &loc) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+    constexpr auto space = execspace_e::openmp;
+#else
+    auto pol = seq_exec();
+    constexpr auto space = execspace_e::host;
+#endif
+    const PrimIndex numPts = points.size();
+    if (numPts == 0 || numPts != binding.numPoints() || !points.hasProperty(srcTag)) return false;
+    const int numJoints = skinningTransforms.size();
+    const int numInfluences = binding.numInfluences();
+
+    /// @note normals are skinned aside as well, the source ones are reread every evaluation
+    const bool hasNormals = points.hasProperty(ATTRIB_NORMAL_TAG);
+    if (hasNormals)
+      points.appendProperties32(
+          pol, {{ATTRIB_SKINNING_POS_TAG, 3}, {ATTRIB_SKINNING_NORMAL_TAG, 3}}, loc);
+    else
+      points.appendProperties32(pol, {{ATTRIB_SKINNING_POS_TAG, 3}}, loc);
+    const auto srcOffset = points.getPropertyOffset(srcTag);
+    const auto dstOffset = points.getPropertyOffset(ATTRIB_SKINNING_POS_TAG);
+    const auto nrmOffset = points.getPropertyOffset(ATTRIB_NORMAL_TAG);
+    const auto dstNrmOffset = points.getPropertyOffset(ATTRIB_SKINNING_NORMAL_TAG);
+
+    const auto &influences = binding._influences;
+    const auto idxOffset = influences.getPropertyOffset(ATTRIB_SKIN_JOINT_INDEX_TAG);
+    const auto wOffset = influences.getPropertyOffset(ATTRIB_SKIN_JOINT_WEIGHT_TAG);
+
+    if (method == skinning_method_e::linear_blend) {
+      /// @note row-major 3x4 per joint, laid out contiguously for vectorized accumulation
+      std::vector<f32> xforms((size_t)numJoints * 12);
+      for (int j = 0; j != numJoints; ++j)
+        for (int r = 0; r != 3; ++r)
+          for (int c = 0; c != 4; ++c) xforms[j * 12 + r * 4 + c] = skinningTransforms[j][c][r];
+
+      pol(range(numPts), [ptsView = view<space>({}, points.attr32()),
+                          inflView = view<space>({}, influences.attr32()), xforms = xforms.data(),
+                          idxOffset, wOffset, numInfluences, numJoints, hasNormals,
+                          srcOffset, dstOffset, nrmOffset, dstNrmOffset](PrimIndex i) mutable {
+        f32 m[12] = {};
+        for (int k = 0; k != numInfluences; ++k) {
+          const f32 w = inflView(wOffset + k, i);
+          const auto j = inflView(idxOffset + k, i, wrapt<i32>{});
+          if (w == 0 || j < 0 || j >= numJoints) continue;
+          const f32 *x = xforms + (size_t)j * 12;
+          for (int e = 0; e != 12; ++e) m[e] += w * x[e];
+        }
+        auto p = ptsView.pack(dim_c<3>, srcOffset, i);
+        ptsView.tuple(dim_c<3>, dstOffset, i)
+            = zs::vec<f32, 3>{m[0] * p[0] + m[1] * p[1] + m[2] * p[2] + m[3],
+                              m[4] * p[0] + m[5] * p[1] + m[6] * p[2] + m[7],
+                              m[8] * p[0] + m[9] * p[1] + m[10] * p[2] + m[11]};
+        if (hasNormals) {
+          auto n = ptsView.pack(dim_c<3>, nrmOffset, i);
+          auto nn = zs::vec<f32, 3>{m[0] * n[0] + m[1] * n[1] + m[2] * n[2],
+                                    m[4] * n[0] + m[5] * n[1] + m[6] * n[2],
+                                    m[8] * n[0] + m[9] * n[1] + m[10] * n[2]};
+          if (auto len = nn.length(); len > detail::deduce_numeric_epsilon<f32>()) nn = nn / len;
+          ptsView.tuple(dim_c<3>, dstNrmOffset, i) = nn;
+        }
+      });
+    } else {
+      /// @note unit dual quaternions [real (x, y, z, w), dual (x, y, z, w)] per joint
+      /// @note scale and shear are not representable, thus dropped
+      std::vector<f32> dqs((size_t)numJoints * 8);
+      for (int j = 0; j != numJoints; ++j) {
+        const auto &m = skinningTransforms[j];
+        glm::mat3 rot{glm::normalize(glm::vec3(m[0])), glm::normalize(glm::vec3(m[1])),
+                      glm::normalize(glm::vec3(m[2]))};
+        auto q = glm::normalize(glm::quat_cast(rot));
+        glm::vec3 t{m[3]};
+        glm::vec3 qv{q.x, q.y, q.z};
+        auto dv = 0.5f * (q.w * t + glm::cross(t, qv));
+        auto dw = -0.5f * glm::dot(t, qv);
+        f32 *dq = dqs.data() + (size_t)j * 8;
+        dq[0] = q.x, dq[1] = q.y, dq[2] = q.z, dq[3] = q.w;
+        dq[4] = dv.x, dq[5] = dv.y, dq[6] = dv.z, dq[7] = dw;
+      }
+
+      pol(range(numPts), [ptsView = view<space>({}, points.attr32()),
+                          inflView = view<space>({}, influences.attr32()), dqs = dqs.data(),
+                          idxOffset, wOffset, numInfluences, numJoints, hasNormals,
+                          srcOffset, dstOffset, nrmOffset, dstNrmOffset](PrimIndex i) mutable {
+        f32 b[8] = {};
+        const f32 *pivot = nullptr;
+        for (int k = 0; k != numInfluences; ++k) {
+          const f32 w = inflView(wOffset + k, i);
+          const auto j = inflView(idxOffset + k, i, wrapt<i32>{});
+          if (w == 0 || j < 0 || j >= numJoints) continue;
+          const f32 *dq = dqs + (size_t)j * 8;
+          if (!pivot) pivot = dq;
+          /// @note keep all rotations within the same hemisphere (antipodality)
+          const f32 s = pivot[0] * dq[0] + pivot[1] * dq[1] + pivot[2] * dq[2] + pivot[3] * dq[3]
+                                < 0
+                            ? -w
+                            : w;
+          for (int e = 0; e != 8; ++e) b[e] += s * dq[e];
+        }
+        if (!pivot) {
+          ptsView.tuple(dim_c<3>, dstOffset, i) = ptsView.pack(dim_c<3>, srcOffset, i);
+          if (hasNormals)
+            ptsView.tuple(dim_c<3>, dstNrmOffset, i) = ptsView.pack(dim_c<3>, nrmOffset, i);
+          return;
+        }
+        const f32 len = zs::sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2] + b[3] * b[3]);
+        for (int e = 0; e != 8; ++e) b[e] /= len;
+        const auto r = zs::vec<f32, 3>{b[0], b[1], b[2]};
+        const auto d = zs::vec<f32, 3>{b[4], b[5], b[6]};
+        const f32 rw = b[3], dw = b[7];
+        auto rotate = [&r, rw](const auto &v) { return v + 2 * r.cross(r.cross(v) + rw * v); };
+        auto t = 2 * (rw * d - dw * r + r.cross(d));
+        auto p = ptsView.pack(dim_c<3>, srcOffset, i);
+        ptsView.tuple(dim_c<3>, dstOffset, i) = rotate(p) + t;
+        if (hasNormals)
+          ptsView.tuple(dim_c<3>, dstNrmOffset, i) = rotate(ptsView.pack(dim_c<3>, nrmOffset, i));
+      });
+    }
+    return true;
+  }
+
+  bool apply_skinning(const SkinningBinding &binding, TimeCode tc, AttrVector &points,
+                      const char *srcTag, const source_location &loc) {
+    std::vector<glm::mat4> skinningTransforms;
+    compute_skinning_transforms(binding, tc, skinningTransforms);
+    return apply_skinning(binding, skinningTransforms, points, binding._method, srcTag, loc);
+  }
+
+}  // namespace zs
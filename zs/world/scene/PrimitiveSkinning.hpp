@@ -0,0 +1,77 @@
+#pragma once
+#include "../WorldExport.hpp"
+#include "Primitive.hpp"
+
+namespace zs {
+
+/// @note used in SkinningBinding::_influences [points], numInfluences channels each
+#define ATTRIB_SKIN_JOINT_INDEX_TAG "__i_zs_jidx"
+#define ATTRIB_SKIN_JOINT_WEIGHT_TAG "zs_jw"
+/// @note used in SkinningBinding::_joints [joints], column-major 4x4
+#define ATTRIB_JOINT_INV_BIND_TAG "zs_jbind_inv"
+/// @note used in SkinningBinding::_jointTransforms [joints], column-major 4x4
+#define ATTRIB_JOINT_TRANSFORM_TAG "zs_jxform"
+
+  enum class skinning_method_e : u32 { linear_blend = 0, dual_quaternion };
+
+  /// @brief skeleton binding cached per prim at import, independent of any usd query
+  /// @note skinned = inv(geomBind) * sum_k(w_k * jointXform_k(tc) * invBind_k) * geomBind * rest
+  struct ZS_WORLD_EXPORT SkinningBinding {
+    int numPoints() const noexcept { return _influences.size(); }
+    int numJoints() const noexcept { return _joints.size(); }
+    int numInfluences() const noexcept { return _numInfluences; }
+
+    AttrVector _influences;  // owner: point
+    AttrVector _joints;      // owner: prim, one entry per joint
+    /// @note animated joint (skeleton space) transforms, sampled per timecode
+    KeyFrames<AttrVector> _jointTransforms;
+    /// @note nearest bound ancestor of each joint (-1 for roots), empty if unknown
+    std::vector<int> _jointParents;
+    /// @note joints in an order where parents precede their children
+    std::vector<int> _jointOrder;
+    glm::mat4 _geomBindTransform{1.f};
+    int _numInfluences{0};
+    skinning_method_e _method{skinning_method_e::linear_blend};
+  };
+
+  /// @brief build a binding from per-point influences (numPoints x numInfluences, row-major)
+  /// @note jointBindTransforms are the skeleton-space rest (bind) transforms of the joints
+  ZS_WORLD_EXPORT Shared<SkinningBinding> build_skinning_binding(
+      int numPoints, int numInfluences, const int* jointIndices, const float* jointWeights,
+      const std::vector<glm::mat4>& jointBindTransforms,
+      const glm::mat4& geomBindTransform = glm::mat4(1.f));
+
+  /// @brief cache the animated joint transforms of a timecode (default value if tc is NaN)
+  ZS_WORLD_EXPORT void emplace_joint_transforms(SkinningBinding& binding, TimeCode tc,
+                                                const std::vector<glm::mat4>& jointTransforms);
+
+  /// @brief set the joint hierarchy, [jointParents] being the parent of each joint (-1 for roots)
+  /// @note joints are then interpolated in their parent's space, see compute_skinning_transforms
+  /// @return false (leaving the binding untouched) if the size mismatches or parents form a cycle
+  ZS_WORLD_EXPORT bool set_skinning_joint_parents(SkinningBinding& binding,
+                                                  std::vector<int> jointParents);
+
+  /// @brief attach [binding] to [prim], its skeleton animation interval is set accordingly
+  ZS_WORLD_EXPORT void attach_skinning_binding(PrimitiveStorage& prim,
+                                               Shared<SkinningBinding> binding);
+
+  /// @brief per joint skinning transforms (geom bind transform folded in) at [tc]
+  /// @note between the cached samples, the joint-local translation, rotation and scale are
+  /// interpolated and then concatenated along the hierarchy (if set), as UsdSkel does
+  ZS_WORLD_EXPORT void compute_skinning_transforms(const SkinningBinding& binding, TimeCode tc,
+                                                   std::vector<glm::mat4>& skinningTransforms);
+
+  /// @brief skin [srcTag] of [points] into ATTRIB_SKINNING_POS_TAG
+  /// @note [srcTag] may as well be ATTRIB_SKINNING_POS_TAG for positions already deformed
+  /// @note normals (ATTRIB_NORMAL_TAG), if present, are skinned into ATTRIB_SKINNING_NORMAL_TAG
+  ZS_WORLD_EXPORT bool apply_skinning(const SkinningBinding& binding,
+                                      const std::vector<glm::mat4>& skinningTransforms,
+                                      AttrVector& points,
+                                      skinning_method_e method = skinning_method_e::linear_blend,
+                                      const char* srcTag = ATTRIB_POS_TAG,
+                                      const source_location& loc = source_location::current());
+  ZS_WORLD_EXPORT bool apply_skinning(const SkinningBinding& binding, TimeCode tc,
+                                      AttrVector& points, const char* srcTag = ATTRIB_POS_TAG,
+                                      const source_location& loc = source_location::current());
+
+}  // namespace zs
@@ -93,7 +93,7 @@ namespace zs {
             case PrimitiveStorage::Poly_: {
               const PolyPrimContainer& geomPolys = *geom.localPolyPrims();
               // auto polysView = view<space>({}, geomPolys.prims().attr32());
-              auto polySize = geomPolys.prims().attr32().begin(POLY_SIZE_TAG, dim_c<1>,
+              auto polySize = geomPolys.prims().attrIndex().begin(POLY_SIZE_TAG, dim_c<1>,
                                                                prim_id_c)[localPrimId];
               numTris = polySize >= 3 ? polySize - 2 : 0;
               break;
@@ -117,17 +117,17 @@ namespace zs {
       switch (zs::get<0>(entryNo)) {
         case PrimitiveStorage::Tri_: {
           const TriPrimContainer& geomTris = *geom.localTriPrims();
-          const auto& tri
-              = geomTris.prims().attr32().begin(ELEM_VERT_ID_TAG, dim_c<3>, prim_id_c)[localPrimId];
+          const auto& tri = geomTris.prims().attrIndex().begin(ELEM_VERT_ID_TAG, dim_c<3>,
+                                                               prim_id_c)[localPrimId];
           for (int d = 0; d != 3; ++d) elems[triSt][d] = tri[d];
           break;
         }
         case PrimitiveStorage::Poly_: {
           const PolyPrimContainer& geomPolys = *geom.localPolyPrims();
           // auto polysView = view<space>({}, geomPolys.prims().attr32());
-          auto polySt
-              = geomPolys.prims().attr32().begin(POLY_OFFSET_TAG, dim_c<1>, prim_id_c)[localPrimId];
-          auto loopPids = geom.verts().attr32().begin(POINT_ID_TAG, dim_c<1>, prim_id_c);
+          auto polySt = geomPolys.prims().attrIndex().begin(POLY_OFFSET_TAG, dim_c<1>,
+                                                            prim_id_c)[localPrimId];
+          auto loopPids = geom.verts().attrIndex().begin(POINT_ID_TAG, dim_c<1>, prim_id_c);
           int primVidSub = 1;  // subscript
 
           // triangle fan style conversion
@@ -254,7 +254,7 @@ namespace zs {
             case PrimitiveStorage::Poly_: {
               const PolyPrimContainer& geomPolys = *geom.localPolyPrims();
               numPoly = 1;
-              polySize = geomPolys.prims().attr32().begin(POLY_SIZE_TAG, dim_c<1>,
+              polySize = geomPolys.prims().attrIndex().begin(POLY_SIZE_TAG, dim_c<1>,
                                                           prim_id_c)[zs::get<1>(entryNo)];
               break;
             }
@@ -284,7 +284,7 @@ namespace zs {
 
     pol(enumerate(numPolys, polyDsts, polySizes, polyOffsets, geomPrims),
         [&usdPolyIndices, &usdPolySizes, &geom,
-         verts = verts.attr32().begin(POINT_ID_TAG, dim_c<1>, prim_id_c)](
+         verts = verts.attrIndex().begin(POINT_ID_TAG, dim_c<1>, prim_id_c)](
             u32 polyId, PrimIndex numPoly, PrimIndex polyDst, PrimIndex usdPolySize,
             PrimIndex usdPolyOffset, const zs::tuple<PrimTypeIndex, PrimIndex>& entryNo) mutable {
           if (numPoly == 0) return;
@@ -295,7 +295,7 @@ namespace zs {
           switch (zs::get<0>(entryNo)) {
             case PrimitiveStorage::Poly_: {
               const PolyPrimContainer& geomPolys = *geom.localPolyPrims();
-              auto localPolyOffset = geomPolys.prims().attr32().begin(POLY_OFFSET_TAG, dim_c<1>,
+              auto localPolyOffset = geomPolys.prims().attrIndex().begin(POLY_OFFSET_TAG, dim_c<1>,
                                                                       prim_id_c)[localPrimId];
               for (PrimIndex d = 0; d < usdPolySize; ++d)
                 usdPolyIndices[usdPolyOffset + d] = verts[localPolyOffset + d];
@@ -303,7 +303,7 @@ namespace zs {
             }
             case PrimitiveStorage::Tri_: {
               const TriPrimContainer& geomTris = *geom.localTriPrims();
-              auto tri = geomTris.prims().attr32().begin(ELEM_VERT_ID_TAG, dim_c<3>,
+              auto tri = geomTris.prims().attrIndex().begin(ELEM_VERT_ID_TAG, dim_c<3>,
                                                          prim_id_c)[localPrimId];
               assert(usdPolySize == 3);
               for (PrimIndex d = 0; d < 3; ++d) usdPolyIndices[usdPolyOffset + d] = tri[d];
@@ -311,7 +311,7 @@ namespace zs {
             }
             case PrimitiveStorage::Line_: {
               const LinePrimContainer& geomLines = *geom.localLinePrims();
-              auto line = geomLines.prims().attr32().begin(ELEM_VERT_ID_TAG, dim_c<2>,
+              auto line = geomLines.prims().attrIndex().begin(ELEM_VERT_ID_TAG, dim_c<2>,
                                                            prim_id_c)[localPrimId];
               assert(usdPolySize == 2);
               for (PrimIndex d = 0; d < 2; ++d) usdPolyIndices[usdPolyOffset + d] = line[d];
@@ -319,7 +319,7 @@ namespace zs {
             }
             case PrimitiveStorage::Point_: {
               const PointPrimContainer& geomPts = *geom.localPointPrims();
-              auto pt = geomPts.prims().attr32().begin(ELEM_VERT_ID_TAG, dim_c<1>,
+              auto pt = geomPts.prims().attrIndex().begin(ELEM_VERT_ID_TAG, dim_c<1>,
                                                        prim_id_c)[localPrimId];
               assert(usdPolySize == 1);
               usdPolyIndices[usdPolyOffset] = pt;
@@ -3,6 +3,8 @@
 #include <mutex>
 
 #include "Primitive.hpp"
+#include "world/core/FileBackedResource.hpp"
+#include "world/core/MemoryResource.hpp"
 #include "zensim/execution/ConcurrencyPrimitive.hpp"
 
 #if ZS_ENABLE_OPENMP
@@ -13,6 +15,30 @@
 
 namespace zs {
 
+  namespace {
+    /// @brief fresh outputs take after the storage of their source, e.g. stay file-backed
+    void inherit_allocator(AttrVector &dst, const AttrVector &src) {
+      if (dst.size() == 0) dst.relocate(src.get_allocator());
+    }
+
+    struct PrimContainerRelocator : PrimContainerVisitor {
+      explicit PrimContainerRelocator(const AttrVector::allocator_type &allocator) noexcept
+          : _allocator{allocator} {}
+
+      void visit(PolyPrimContainer &prim) override { prim.prims().relocate(_allocator); }
+      void visit(TriPrimContainer &prim) override { prim.prims().relocate(_allocator); }
+      void visit(LinePrimContainer &prim) override { prim.prims().relocate(_allocator); }
+      void visit(PointPrimContainer &prim) override { prim.prims().relocate(_allocator); }
+      void visit(SdfPrimContainer &prim) override {}
+      void visit(PackPrimContainer &prim) override { prim.instances().relocate(_allocator); }
+      void visit(AnalyticPrimContainer &prim) override {}
+      void visit(CameraPrimContainer &prim) override {}
+      void visit(LightPrimContainer &prim) override {}
+
+      const AttrVector::allocator_type &_allocator;
+    };
+  }  // namespace
+
   void assign_visual_mesh_to_pointmesh(const PrimitiveStorage &src, ZsPointMesh &dst,
                                        const source_location &loc) {
 #if ZS_ENABLE_OPENMP
@@ -61,7 +87,7 @@ namespace zs {
       }
     });
     /// assign tri prims
-    pol(zip(range(pointPrims->prims().attr32(), ELEM_VERT_ID_TAG, dim_c<1>, prim_id_c), elems),
+    pol(zip(range(pointPrims->prims().attrIndex(), ELEM_VERT_ID_TAG, dim_c<1>, prim_id_c), elems),
         [](const auto &src, auto &dst) { dst[0] = src; });
   }
 
@@ -113,7 +139,7 @@ namespace zs {
       }
     });
     /// assign tri prims
-    pol(zip(range(linePrims->prims().attr32(), ELEM_VERT_ID_TAG, dim_c<2>, prim_id_c), elems),
+    pol(zip(range(linePrims->prims().attrIndex(), ELEM_VERT_ID_TAG, dim_c<2>, prim_id_c), elems),
         [](const auto &src, auto &dst) {
           for (int d = 0; d < 2; ++d) dst[d] = src[d];
         });
@@ -174,7 +200,7 @@ namespace zs {
       }
     });
     /// assign tri prims
-    pol(zip(range(triPrims->prims().attr32(), ELEM_VERT_ID_TAG, dim_c<3>, prim_id_c), elems),
+    pol(zip(range(triPrims->prims().attrIndex(), ELEM_VERT_ID_TAG, dim_c<3>, prim_id_c), elems),
         [](const auto &src, auto &dst) {
           for (int d = 0; d < 3; ++d) dst[d] = src[d];
         });
@@ -236,10 +262,11 @@ namespace zs {
 
       /// iterate [pt, line, tri], with corresponding primDimC [1, 2, 3] to search divergent
       /// vertices directing to the same point
+      auto vertIdView = view<space>({}, verts.attrIndex());
       auto iteratePrims
           = [&, vertView = view<space>({}, verts.attr32())](const auto &localPrims, auto primDimC) {
               const auto &prims = localPrims->prims();
-              pol(enumerate(range(prims.attr32(), ELEM_VERT_ID_TAG,
+              pol(enumerate(range(prims.attrIndex(), ELEM_VERT_ID_TAG,
                                   dim_c<RM_CVREF_T(primDimC)::value>, prim_id_c)),
                   [&](PrimIndex ei, auto vids) {
                     constexpr int dime = RM_CVREF_T(primDimC)::value;
@@ -247,10 +274,10 @@ namespace zs {
                       PrimIndex vid, pid;
                       if constexpr (is_integral_v<RM_CVREF_T(vids)>) {
                         vid = vids;
-                        pid = vertView(POINT_ID_TAG, vid, prim_id_c);
+                        pid = vertIdView(POINT_ID_TAG, vid, prim_id_c);
                       } else {
                         vid = vids[d];
-                        pid = vertView(POINT_ID_TAG, vid, prim_id_c);
+                        pid = vertIdView(POINT_ID_TAG, vid, prim_id_c);
                       }
                       // prop on vert
                       Prop vProp = vertView.pack(dim_c<RM_CVREF_T(dimc)::value>, prop, vid, typec);
@@ -335,38 +362,38 @@ namespace zs {
     if (!hasVertUv && !hasVertNrm && !hasVertClr && !hasVertTan && !hasVertTexId) {
       /// iterate [pt, line, tri], with corresponding primDimC [1, 2, 3] to search divergent
       /// vertices directing to the same point
-      auto iteratePrims
-          = [&, vertView = view<space>({}, verts.attr32())](const auto &localPrims, auto primDimC) {
-              const auto &prims = localPrims->prims();
-              pol(enumerate(range(prims.attr32(), ELEM_VERT_ID_TAG,
-                                  dim_c<RM_CVREF_T(primDimC)::value>, prim_id_c)),
-                  [&](PrimIndex ei, auto vids) {
-                    constexpr int dime = RM_CVREF_T(primDimC)::value;
-                    for (int d = 0; d < dime; ++d) {
-                      PrimIndex vid, pid;
-                      if constexpr (is_integral_v<RM_CVREF_T(vids)>) {
-                        vid = vids;
-                        pid = vertView(POINT_ID_TAG, vid, prim_id_c);
-                      } else {
-                        vid = vids[d];
-                        pid = vertView(POINT_ID_TAG, vid, prim_id_c);
-                      }
-                      {
-                        ptLocks[pid].lock();
-                        auto &variantPts = vertIdsPerPoint[pid];
-                        auto numVariants = variantPts.size();
-                        PrimIndex j = 0;
-                        for (; j < numVariants; ++j)
-                          if (variantPts[j] == vid
-                              || vertView(POINT_ID_TAG, variantPts[j], prim_id_c) == pid)
-                            break;
-                        if (j == numVariants)  // no match, should insert as an candidate
-                          variantPts.push_back(vid);
-                        ptLocks[pid].unlock();
-                      }
-                    }
-                  });
-            };
+      auto vertIdView = view<space>({}, verts.attrIndex());
+      auto iteratePrims = [&](const auto &localPrims, auto primDimC) {
+        const auto &prims = localPrims->prims();
+        pol(enumerate(range(prims.attrIndex(), ELEM_VERT_ID_TAG,
+                            dim_c<RM_CVREF_T(primDimC)::value>, prim_id_c)),
+            [&](PrimIndex ei, auto vids) {
+              constexpr int dime = RM_CVREF_T(primDimC)::value;
+              for (int d = 0; d < dime; ++d) {
+                PrimIndex vid, pid;
+                if constexpr (is_integral_v<RM_CVREF_T(vids)>) {
+                  vid = vids;
+                  pid = vertIdView(POINT_ID_TAG, vid, prim_id_c);
+                } else {
+                  vid = vids[d];
+                  pid = vertIdView(POINT_ID_TAG, vid, prim_id_c);
+                }
+                {
+                  ptLocks[pid].lock();
+                  auto &variantPts = vertIdsPerPoint[pid];
+                  auto numVariants = variantPts.size();
+                  PrimIndex j = 0;
+                  for (; j < numVariants; ++j)
+                    if (variantPts[j] == vid
+                        || vertIdView(POINT_ID_TAG, variantPts[j], prim_id_c) == pid)
+                      break;
+                  if (j == numVariants)  // no match, should insert as an candidate
+                    variantPts.push_back(vid);
+                  ptLocks[pid].unlock();
+                }
+              }
+            });
+      };
       iteratePrims(pointPrims, wrapv<1>{});
       iteratePrims(linePrims, wrapv<2>{});
       iteratePrims(triPrims, wrapv<3>{});
@@ -385,6 +412,8 @@ namespace zs {
     /// @note skinning pos (if exist) should precede pos tag
     auto posLabel
         = points.hasProperty(ATTRIB_SKINNING_POS_TAG) ? ATTRIB_SKINNING_POS_TAG : ATTRIB_POS_TAG;
+    auto nrmLabel = points.hasProperty(ATTRIB_SKINNING_NORMAL_TAG) ? ATTRIB_SKINNING_NORMAL_TAG
+                                                                   : ATTRIB_NORMAL_TAG;
 
     auto setupZsMeshPoints = [&](auto &mesh) {
       mesh.nodes.resize(prevPointOffsets.back());
@@ -438,7 +467,7 @@ namespace zs {
                 auto v = vertView.pack(dim_c<3>, ATTRIB_NORMAL_TAG, vid);
                 mesh.norms[dstVid] = {v[0], v[1], v[2]};
               } else if (hasPointNrm) {
-                auto v = pointView.pack(dim_c<3>, ATTRIB_NORMAL_TAG, pid);
+                auto v = pointView.pack(dim_c<3>, nrmLabel, pid);
                 mesh.norms[dstVid] = {v[0], v[1], v[2]};
               }
 
@@ -459,10 +488,10 @@ namespace zs {
               }
 
               if (hasVertTexId) {
-                auto v = vertView.pack(dim_c<2>, ATTRIB_TEXTURE_ID_TAG, vid, prim_id_c);
+                auto v = vertView.pack(dim_c<2>, ATTRIB_TEXTURE_ID_TAG, vid, wrapt<i32>{});
                 mesh.texids[dstVid] = {v[0], v[1]};
               } else if (hasPointTexId) {
-                auto v = pointView.pack(dim_c<2>, ATTRIB_TEXTURE_ID_TAG, pid, prim_id_c);
+                auto v = pointView.pack(dim_c<2>, ATTRIB_TEXTURE_ID_TAG, pid, wrapt<i32>{});
                 mesh.texids[dstVid] = {v[0], v[1]};
               }
             }
@@ -480,10 +509,10 @@ namespace zs {
                     "element dimension mismatch");
       auto &srcPrims = srcLocalPrims->prims();
       prims.resize(srcPrims.size());
-      pol(enumerate(range(srcPrims.attr32(), ELEM_VERT_ID_TAG, dim_c<RM_CVREF_T(primDimC)::value>,
-                          prim_id_c),
+      pol(enumerate(range(srcPrims.attrIndex(), ELEM_VERT_ID_TAG,
+                          dim_c<RM_CVREF_T(primDimC)::value>, prim_id_c),
                     prims),
-          [&, vertView = view<space>({}, verts.attr32()),
+          [&, vertIdView = view<space>({}, verts.attrIndex()),
            points = view<space>({}, points.attr32())](PrimIndex ei, const auto &originalVids,
                                                       auto &vids) {
             constexpr int dime = RM_REF_T(primDimC)::value;
@@ -494,14 +523,14 @@ namespace zs {
                 vid = originalVids;
               else
                 vid = originalVids[d];
-              pid = vertView(POINT_ID_TAG, vid, prim_id_c);
+              pid = vertIdView(POINT_ID_TAG, vid, prim_id_c);
               const auto offset = prevPointOffsets[pid];
               const auto &ids = vertIdsPerPoint[pid];
               PrimIndex j = 0;
               for (; j < ids.size(); ++j)
                 /// @note find the candidate that is the exact same vert,
                 ///  or another vert pointing to the same point (pid)
-                if (ids[j] == vid || vertView(POINT_ID_TAG, ids[j], prim_id_c) == pid) break;
+                if (ids[j] == vid || vertIdView(POINT_ID_TAG, ids[j], prim_id_c) == pid) break;
               assert(j != ids.size());
 
               // [prims] indices update
@@ -569,7 +598,7 @@ namespace zs {
               /// @note be cautious about the possible divergence
               if (zsmesh.texids.size() == zsmesh.nodes.size())
                 for (int d = 0; d < 2; ++d)
-                  verts(ATTRIB_TEXTURE_ID_TAG, d, vid, prim_id_c) = zsmesh.texids[pid][d];
+                  verts(ATTRIB_TEXTURE_ID_TAG, d, vid, wrapt<i32>{}) = zsmesh.texids[pid][d];
             },
             loc);
       }
@@ -625,10 +654,11 @@ namespace zs {
                                 prims.getPropertyOffset(attrTag.name), attrTag.numChannels);
       }
       pol(range(prims.size()), [&, primView = view<space>(prims.attr32()),
-                                primIdOffset = prims.getPropertyOffset(ELEM_VERT_ID_TAG),
+                                primIdView = view<space>(prims.attrIndex()),
+                                primIdOffset = prims.getIndexPropertyOffset(ELEM_VERT_ID_TAG),
                                 vertView = view<space>({}, verts.attr32())](PrimIndex ei) mutable {
         constexpr int dime = RM_CVREF_T(primDimC)::value;
-        auto vids = primView.pack(dim_c<dime>, primIdOffset, ei, prim_id_c);
+        auto vids = primIdView.pack(dim_c<dime>, primIdOffset, ei, prim_id_c);
         for (int d = 0; d < dime; ++d) {
           auto vid = vids[d];
 
@@ -667,12 +697,12 @@ namespace zs {
                                 prims.getPropertyOffset(attrTag.name), attrTag.numChannels);
       }
       pol(range(prims.size()),
-          [&, polyView = view<space>(prims.attr32()),
-           polyOffsetChn = prims.getPropertyOffset(POLY_OFFSET_TAG),
-           polySizeChn = prims.getPropertyOffset(POLY_SIZE_TAG),
+          [&, polyView = view<space>(prims.attr32()), polyIdView = view<space>(prims.attrIndex()),
+           polyOffsetChn = prims.getIndexPropertyOffset(POLY_OFFSET_TAG),
+           polySizeChn = prims.getIndexPropertyOffset(POLY_SIZE_TAG),
            vertView = view<space>({}, verts.attr32())](PrimIndex polyI) mutable {
-            auto vid = polyView(polyOffsetChn, polyI, prim_id_c);
-            const auto ed = vid + polyView(polySizeChn, polyI, prim_id_c);
+            auto vid = polyIdView(polyOffsetChn, polyI, prim_id_c);
+            const auto ed = vid + polyIdView(polySizeChn, polyI, prim_id_c);
             for (; vid != ed; ++vid) {
               // prop on prim
               for (const auto &[vertPropOffset, primPropOffset, propSz] : attrTags) {
@@ -787,10 +817,11 @@ namespace zs {
 
       /// iterate [pt, line, tri], with corresponding primDimC [1, 2, 3] to search divergent
       /// vertices directing to the same point
+      auto vertIdView = view<space>({}, verts.attrIndex());
       auto iteratePrims
           = [&, vertView = view<space>({}, verts.attr32())](const auto &localPrims, auto primDimC) {
               const auto &prims = localPrims->prims();
-              pol(enumerate(range(prims.attr32(), ELEM_VERT_ID_TAG,
+              pol(enumerate(range(prims.attrIndex(), ELEM_VERT_ID_TAG,
                                   dim_c<RM_CVREF_T(primDimC)::value>, prim_id_c)),
                   [&](PrimIndex ei, auto vids) {
                     constexpr int dime = RM_CVREF_T(primDimC)::value;
@@ -798,10 +829,10 @@ namespace zs {
                       PrimIndex vid, pid;
                       if constexpr (is_integral_v<RM_CVREF_T(vids)>) {
                         vid = vids;
-                        pid = vertView(POINT_ID_TAG, vid, prim_id_c);
+                        pid = vertIdView(POINT_ID_TAG, vid, prim_id_c);
                       } else {
                         vid = vids[d];
-                        pid = vertView(POINT_ID_TAG, vid, prim_id_c);
+                        pid = vertIdView(POINT_ID_TAG, vid, prim_id_c);
                       }
                       // prop on vert
                       Prop vProp = vertView.pack(dim_c<RM_CVREF_T(dimc)::value>, prop, vid);
@@ -882,38 +913,38 @@ namespace zs {
     if (!hasVertUv && !hasVertNrm && !hasVertClr && !hasVertTan) {
       /// iterate [pt, line, tri], with corresponding primDimC [1, 2, 3] to search divergent
       /// vertices directing to the same point
-      auto iteratePrims
-          = [&, vertView = view<space>({}, verts.attr32())](const auto &localPrims, auto primDimC) {
-              const auto &prims = localPrims->prims();
-              pol(enumerate(range(prims.attr32(), ELEM_VERT_ID_TAG,
-                                  dim_c<RM_CVREF_T(primDimC)::value>, prim_id_c)),
-                  [&](PrimIndex ei, auto vids) {
-                    constexpr int dime = RM_CVREF_T(primDimC)::value;
-                    for (int d = 0; d < dime; ++d) {
-                      PrimIndex vid, pid;
-                      if constexpr (is_integral_v<RM_CVREF_T(vids)>) {
-                        vid = vids;
-                        pid = vertView(POINT_ID_TAG, vid, prim_id_c);
-                      } else {
-                        vid = vids[d];
-                        pid = vertView(POINT_ID_TAG, vid, prim_id_c);
-                      }
-                      {
-                        ptLocks[pid].lock();
-                        auto &variantPts = vertIdsPerPoint[pid];
-                        auto numVariants = variantPts.size();
-                        PrimIndex j = 0;
-                        for (; j < numVariants; ++j)
-                          if (variantPts[j] == vid
-                              || vertView(POINT_ID_TAG, variantPts[j], prim_id_c) == pid)
-                            break;
-                        if (j == numVariants)  // no match, should insert as an candidate
-                          variantPts.push_back(vid);
-                        ptLocks[pid].unlock();
-                      }
-                    }
-                  });
-            };
+      auto vertIdView = view<space>({}, verts.attrIndex());
+      auto iteratePrims = [&](const auto &localPrims, auto primDimC) {
+        const auto &prims = localPrims->prims();
+        pol(enumerate(range(prims.attrIndex(), ELEM_VERT_ID_TAG,
+                            dim_c<RM_CVREF_T(primDimC)::value>, prim_id_c)),
+            [&](PrimIndex ei, auto vids) {
+              constexpr int dime = RM_CVREF_T(primDimC)::value;
+              for (int d = 0; d < dime; ++d) {
+                PrimIndex vid, pid;
+                if constexpr (is_integral_v<RM_CVREF_T(vids)>) {
+                  vid = vids;
+                  pid = vertIdView(POINT_ID_TAG, vid, prim_id_c);
+                } else {
+                  vid = vids[d];
+                  pid = vertIdView(POINT_ID_TAG, vid, prim_id_c);
+                }
+                {
+                  ptLocks[pid].lock();
+                  auto &variantPts = vertIdsPerPoint[pid];
+                  auto numVariants = variantPts.size();
+                  PrimIndex j = 0;
+                  for (; j < numVariants; ++j)
+                    if (variantPts[j] == vid
+                        || vertIdView(POINT_ID_TAG, variantPts[j], prim_id_c) == pid)
+                      break;
+                  if (j == numVariants)  // no match, should insert as an candidate
+                    variantPts.push_back(vid);
+                  ptLocks[pid].unlock();
+                }
+              }
+            });
+      };
       iteratePrims(pointPrims, wrapv<1>{});
       iteratePrims(linePrims, wrapv<2>{});
       iteratePrims(triPrims, wrapv<3>{});
@@ -928,21 +959,25 @@ namespace zs {
 
     /// split [points] and assign [verts] attributes [uv, nrm, clr, tan] to [points]
     auto &dstPoints = dst.points();
+    inherit_allocator(dstPoints, points);
     dstPoints.appendProperties32(pol, ptProps, loc);
     dstPoints.resize(prevPointOffsets.back());
 
     auto &dstVerts = dst.verts();
-    dstVerts.appendProperties32(pol, {{POINT_ID_TAG, 1}}, loc);
+    inherit_allocator(dstVerts, verts);
+    dstVerts.appendIndexProperties(pol, {{POINT_ID_TAG, 1}}, loc);
     dstVerts.resize(prevPointOffsets.back());
 
     /// @brief initialize points of visual mesh
     /// @note skinning pos (if exist) should precede pos tag
     auto posLabel
         = points.hasProperty(ATTRIB_SKINNING_POS_TAG) ? ATTRIB_SKINNING_POS_TAG : ATTRIB_POS_TAG;
+    auto nrmLabel = points.hasProperty(ATTRIB_SKINNING_NORMAL_TAG) ? ATTRIB_SKINNING_NORMAL_TAG
+                                                                   : ATTRIB_NORMAL_TAG;
     pol(zip(range(points.size()), prevPointOffsets),
         [&, dstPtView = view<space>({}, dstPoints.attr32()),
-         dstVtView = view<space>(dstVerts.attr32()),
-         dstVtPidChn = dstVerts.getPropertyOffset(POINT_ID_TAG),
+         dstVtView = view<space>(dstVerts.attrIndex()),
+         dstVtPidChn = dstVerts.getIndexPropertyOffset(POINT_ID_TAG),
          pointView = view<space>({}, points.attr32()),
          vertView = view<space>({}, verts.attr32())](PrimIndex pid, PrimIndex offset) mutable {
           const auto &ids = vertIdsPerPoint[pid];
@@ -968,7 +1003,7 @@ namespace zs {
                   = vertView.pack(dim_c<3>, ATTRIB_NORMAL_TAG, vid);
             else if (hasPointNrm)
               dstPtView.tuple(dim_c<3>, ATTRIB_NORMAL_TAG, dstVid)
-                  = pointView.pack(dim_c<3>, ATTRIB_NORMAL_TAG, pid);
+                  = pointView.pack(dim_c<3>, nrmLabel, pid);
 
             if (hasVertClr)
               dstPtView.tuple(dim_c<3>, ATTRIB_COLOR_TAG, dstVid)
@@ -991,23 +1026,24 @@ namespace zs {
     auto remapPrimIndices = [&](const auto &srcLocalPrims, auto &localPrims, auto primDimC) {
       auto &srcPrims = srcLocalPrims->prims();
       auto &prims = localPrims->prims();
-      pol(enumerate(range(srcPrims.attr32(), ELEM_VERT_ID_TAG, dim_c<RM_CVREF_T(primDimC)::value>,
-                          prim_id_c),
-                    range(prims.attr32(), ELEM_VERT_ID_TAG, dim_c<RM_CVREF_T(primDimC)::value>,
+      pol(enumerate(range(srcPrims.attrIndex(), ELEM_VERT_ID_TAG,
+                          dim_c<RM_CVREF_T(primDimC)::value>, prim_id_c),
+                    range(prims.attrIndex(), ELEM_VERT_ID_TAG, dim_c<RM_CVREF_T(primDimC)::value>,
                           prim_id_c)),
-          [&, vertView = view<space>({}, verts.attr32()), points = view<space>({}, points.attr32()),
-           prims = view<space>(prims.attr32())](PrimIndex ei, const auto &originalVids,
-                                                auto &vids) {
+          [&, vertIdView = view<space>({}, verts.attrIndex()),
+           points = view<space>({}, points.attr32()),
+           prims = view<space>(prims.attrIndex())](PrimIndex ei, const auto &originalVids,
+                                                   auto &vids) {
             constexpr int dime = RM_CVREF_T(primDimC)::value;
 
             for (int d = 0; d < dime; ++d) {
               PrimIndex vid, pid;
               if constexpr (is_integral_v<RM_CVREF_T(originalVids)>) {
                 vid = originalVids;
-                pid = vertView(POINT_ID_TAG, vid, prim_id_c);
+                pid = vertIdView(POINT_ID_TAG, vid, prim_id_c);
               } else {
                 vid = originalVids[d];
-                pid = vertView(POINT_ID_TAG, vid, prim_id_c);
+                pid = vertIdView(POINT_ID_TAG, vid, prim_id_c);
               }
               const auto offset = prevPointOffsets[pid];
               const auto &ids = vertIdsPerPoint[pid];
@@ -1015,7 +1051,7 @@ namespace zs {
               for (; j < ids.size(); ++j)
                 /// @note find the candidate that is the same vert,
                 ///  or a vert pointing to the same point (pid)
-                if (ids[j] == vid || vertView(POINT_ID_TAG, ids[j], prim_id_c) == pid) break;
+                if (ids[j] == vid || vertIdView(POINT_ID_TAG, ids[j], prim_id_c) == pid) break;
               assert(j != ids.size());
 
               // [prims] indices update
@@ -1028,17 +1064,20 @@ namespace zs {
     };
 
     auto dstPointPrims = dst.localPointPrims();
-    dstPointPrims->prims().appendProperties32(pol, {{ELEM_VERT_ID_TAG, 1}});
+    inherit_allocator(dstPointPrims->prims(), pointPrims->prims());
+    dstPointPrims->prims().appendIndexProperties(pol, {{ELEM_VERT_ID_TAG, 1}});
     dstPointPrims->prims().resize(pointPrims->prims().size());
     remapPrimIndices(pointPrims, dstPointPrims, wrapv<1>{});
 
     auto dstLinePrims = dst.localLinePrims();
-    dstLinePrims->prims().appendProperties32(pol, {{ELEM_VERT_ID_TAG, 2}});
+    inherit_allocator(dstLinePrims->prims(), linePrims->prims());
+    dstLinePrims->prims().appendIndexProperties(pol, {{ELEM_VERT_ID_TAG, 2}});
     dstLinePrims->prims().resize(linePrims->prims().size());
     remapPrimIndices(linePrims, dstLinePrims, wrapv<2>{});
 
     auto dstTriPrims = dst.localTriPrims();
-    dstTriPrims->prims().appendProperties32(pol, {{ELEM_VERT_ID_TAG, 3}});
+    inherit_allocator(dstTriPrims->prims(), triPrims->prims());
+    dstTriPrims->prims().appendIndexProperties(pol, {{ELEM_VERT_ID_TAG, 3}});
     dstTriPrims->prims().resize(triPrims->prims().size());
     remapPrimIndices(triPrims, dstTriPrims, wrapv<3>{});
   }
@@ -1060,6 +1099,7 @@ namespace zs {
 
     auto &polyPrims = geom.localPolyPrims()->prims();
     const auto &polys = polyPrims.attr32();
+    const auto &polyIds = polyPrims.attrIndex();
     const auto numPolys = polys.size();
 
     if (numPolys == 0) return;
@@ -1070,7 +1110,7 @@ namespace zs {
         triPrimOffsets(numPolys + 1);
 
     // size
-    pol(enumerate(range(polys, POLY_SIZE_TAG, dim_c<1>, prim_id_c)),
+    pol(enumerate(range(polyIds, POLY_SIZE_TAG, dim_c<1>, prim_id_c)),
         [&](PrimIndex polyI, PrimIndex sz) {
           if (sz == 1)
             numPointPrimsPerPoly[polyI] = 1;
@@ -1099,9 +1139,7 @@ namespace zs {
     }
     const auto &polyTags = polys.getPropertyTags();
 
-    std::vector<PropertyTag> ptPrimTags{{ELEM_VERT_ID_TAG, 1}, {TO_POLY_ID_TAG, 1}},
-        linePrimTags{{ELEM_VERT_ID_TAG, 2}, {TO_POLY_ID_TAG, 1}},
-        triPrimTags{{ELEM_VERT_ID_TAG, 3}, {TO_POLY_ID_TAG, 1}};
+    std::vector<PropertyTag> ptPrimTags{}, linePrimTags{}, triPrimTags{};
     for (const auto &polyTag : polyTags)
       if (polyTag.name != POLY_OFFSET_TAG && polyTag.name != POLY_SIZE_TAG) {
         ptPrimTags.push_back(polyTag);
@@ -1109,12 +1147,18 @@ namespace zs {
         triPrimTags.push_back(polyTag);
       }
 
+    inherit_allocator(pointPrims, polyPrims);
+    inherit_allocator(linePrims, polyPrims);
+    inherit_allocator(triPrims, polyPrims);
+    pointPrims.appendIndexProperties(pol, {{ELEM_VERT_ID_TAG, 1}, {TO_POLY_ID_TAG, 1}}, loc);
     pointPrims.appendProperties32(pol, ptPrimTags, loc);
     pointPrims.resize(pointPrimOffset + pointPrimOffsets.back());
 
+    linePrims.appendIndexProperties(pol, {{ELEM_VERT_ID_TAG, 2}, {TO_POLY_ID_TAG, 1}}, loc);
     linePrims.appendProperties32(pol, linePrimTags, loc);
     linePrims.resize(linePrimOffset + linePrimOffsets.back());
 
+    triPrims.appendIndexProperties(pol, {{ELEM_VERT_ID_TAG, 3}, {TO_POLY_ID_TAG, 1}}, loc);
     triPrims.appendProperties32(pol, triPrimTags, loc);
     triPrims.resize(triPrimOffset + triPrimOffsets.back());
 
@@ -1122,18 +1166,22 @@ namespace zs {
     auto linePrimView = view<space>({}, linePrims.attr32());
     auto triPrimView = view<space>({}, triPrims.attr32());
     auto polyPrimView = view<space>({}, polys);
+    auto pointPrimIdView = view<space>({}, pointPrims.attrIndex());
+    auto linePrimIdView = view<space>({}, linePrims.attrIndex());
+    auto triPrimIdView = view<space>({}, triPrims.attrIndex());
+    auto polyIdView = view<space>({}, polyIds);
 
     pol(
         range(numPolys),
-        [&, polyOffsetChn = polys.getPropertyOffset(POLY_OFFSET_TAG),
-         polySizeChn = polys.getPropertyOffset(POLY_SIZE_TAG)](PrimIndex polyI) {
-          auto vertOffset = polyPrimView(polyOffsetChn, polyI, prim_id_c);
-          auto polySize = polyPrimView(polySizeChn, polyI, prim_id_c);
+        [&, polyOffsetChn = polyIds.getPropertyOffset(POLY_OFFSET_TAG),
+         polySizeChn = polyIds.getPropertyOffset(POLY_SIZE_TAG)](PrimIndex polyI) {
+          auto vertOffset = polyIdView(polyOffsetChn, polyI, prim_id_c);
+          auto polySize = polyIdView(polySizeChn, polyI, prim_id_c);
 
           if (polySize == 1) {
             auto dstPrimOffset = pointPrimOffset + pointPrimOffsets[polyI];
-            pointPrimView(ELEM_VERT_ID_TAG, dstPrimOffset, prim_id_c) = vertOffset;
-            pointPrimView(TO_POLY_ID_TAG, dstPrimOffset, prim_id_c) = polyI;
+            pointPrimIdView(ELEM_VERT_ID_TAG, dstPrimOffset, prim_id_c) = vertOffset;
+            pointPrimIdView(TO_POLY_ID_TAG, dstPrimOffset, prim_id_c) = polyI;
             // copy custom attribs
             for (const auto &prop : polyTags) {
               if (prop.name != POLY_OFFSET_TAG && prop.name != POLY_SIZE_TAG) {
@@ -1143,9 +1191,9 @@ namespace zs {
             }
           } else if (polySize == 2) {
             auto dstPrimOffset = linePrimOffset + linePrimOffsets[polyI];
-            linePrimView(ELEM_VERT_ID_TAG, 0, dstPrimOffset, prim_id_c) = vertOffset;
-            linePrimView(ELEM_VERT_ID_TAG, 1, dstPrimOffset, prim_id_c) = vertOffset + 1;
-            linePrimView(TO_POLY_ID_TAG, dstPrimOffset, prim_id_c) = polyI;
+            linePrimIdView(ELEM_VERT_ID_TAG, 0, dstPrimOffset, prim_id_c) = vertOffset;
+            linePrimIdView(ELEM_VERT_ID_TAG, 1, dstPrimOffset, prim_id_c) = vertOffset + 1;
+            linePrimIdView(TO_POLY_ID_TAG, dstPrimOffset, prim_id_c) = polyI;
             // copy custom attribs
             for (const auto &prop : polyTags) {
               if (prop.name != POLY_OFFSET_TAG && prop.name != POLY_SIZE_TAG) {
@@ -1156,10 +1204,10 @@ namespace zs {
           } else {
             auto dstPrimOffset = triPrimOffset + triPrimOffsets[polyI];
             for (int j = 0; j + 2 < polySize; ++j) {
-              triPrimView(ELEM_VERT_ID_TAG, 0, dstPrimOffset + j, prim_id_c) = vertOffset;
-              triPrimView(ELEM_VERT_ID_TAG, 1, dstPrimOffset + j, prim_id_c) = vertOffset + j + 1;
-              triPrimView(ELEM_VERT_ID_TAG, 2, dstPrimOffset + j, prim_id_c) = vertOffset + j + 2;
-              triPrimView(TO_POLY_ID_TAG, dstPrimOffset + j, prim_id_c) = polyI;
+              triPrimIdView(ELEM_VERT_ID_TAG, 0, dstPrimOffset + j, prim_id_c) = vertOffset;
+              triPrimIdView(ELEM_VERT_ID_TAG, 1, dstPrimOffset + j, prim_id_c) = vertOffset + j + 1;
+              triPrimIdView(ELEM_VERT_ID_TAG, 2, dstPrimOffset + j, prim_id_c) = vertOffset + j + 2;
+              triPrimIdView(TO_POLY_ID_TAG, dstPrimOffset + j, prim_id_c) = polyI;
               // copy custom attribs
               for (const auto &prop : polyTags) {
                 if (prop.name != POLY_OFFSET_TAG && prop.name != POLY_SIZE_TAG) {
@@ -1208,8 +1256,9 @@ namespace zs {
 
     auto iteratePrims = [&](auto &prims, const auto &tags) {
       pol(range(prims.size()),
-          [&, primView = view<space>({}, prims.attr32())](PrimIndex ei) mutable {
-            PrimIndex polyI = primView(TO_POLY_ID_TAG, ei, prim_id_c);
+          [&, primView = view<space>({}, prims.attr32()),
+           primIdView = view<space>({}, prims.attrIndex())](PrimIndex ei) mutable {
+            PrimIndex polyI = primIdView(TO_POLY_ID_TAG, ei, prim_id_c);
             for (const auto &prop : tags) {
               for (int d = 0; d < prop.numChannels; ++d)
                 primView(prop.name, d, ei) = polyPrimView(prop.name, d, polyI);
@@ -1252,6 +1301,7 @@ namespace zs {
     polyPrims.appendProperties32(pol, polyPrimTags, loc);
 
     auto polyPrimView = view<space>({}, polys);
+    auto polyIdView = view<space>({}, polyPrims.attrIndex());
 
     /// clear poly properties that are going to be written by simple prims
     pol(
@@ -1267,8 +1317,9 @@ namespace zs {
       const auto &primTags = prims.getProperties();
       pol(
           range(prims.size()),
-          [&, primView = view<space>({}, prims.attr32())](PrimIndex ei) {
-            PrimIndex polyI = primView(TO_POLY_ID_TAG, ei, prim_id_c);
+          [&, primView = view<space>({}, prims.attr32()),
+           primIdView = view<space>({}, prims.attrIndex())](PrimIndex ei) {
+            PrimIndex polyI = primIdView(TO_POLY_ID_TAG, ei, prim_id_c);
             for (const auto &prop : primTags) {
               if (prop.name == ELEM_VERT_ID_TAG || prop.name == TO_POLY_ID_TAG) continue;
               for (int d = 0; d < prop.numChannels; ++d)
@@ -1286,7 +1337,7 @@ namespace zs {
     pol(
         range(polys.size()),
         [&](PrimIndex polyI) {
-          auto polySize = polyPrimView(POLY_SIZE_TAG, polyI, prim_id_c);
+          auto polySize = polyIdView(POLY_SIZE_TAG, polyI, prim_id_c);
           int numSimplePrims = polySize > 2 ? polySize - 2 : 1;
           for (const auto &prop : polyPrimTags)
             for (int d = 0; d < prop.numChannels; ++d)
@@ -1295,4 +1346,49 @@ namespace zs {
         loc);
   }
 
-}  // namespace zs
\ No newline at end of file
+  void relocate_primitive_storage(PrimitiveStorage &geom,
+                                  const AttrVector::allocator_type &allocator) {
+    geom.points().relocate(allocator);
+    geom.verts().relocate(allocator);
+    PrimContainerRelocator relocator{allocator};
+    for (auto &[type, container] : geom._localPrims)
+      if (container) container->accept(relocator);
+    /// @note frames shared with other prims (see share_duplicate_meshes) move along once
+    std::set<const AttrVector *> relocated;
+    auto relocateFrame = [&](const Shared<AttrVector> &frame) {
+      if (frame && relocated.insert(frame.get()).second) frame->relocate(allocator);
+    };
+    for (auto &[label, frames] : geom.keyframes()._attribs) {
+      relocateFrame(frames.refDefaultValue());
+      for (auto &[tc, frame] : frames.refKeyframes()) relocateFrame(frame);
+    }
+  }
+
+  Shared<FileBackedResource> spill_primitive_storage(PrimitiveStorage &geom,
+                                                     std::string_view directory) {
+    auto resource = std::make_shared<FileBackedResource>(directory);
+    relocate_primitive_storage(geom, resource->allocator());
+    return resource;
+  }
+
+  Shared<TrackedResource> select_primitive_memory(PrimitiveStorage &geom, prim_memory_e kind,
+                                                  int numaNode) {
+    Shared<TrackedResource> resource;
+    switch (kind) {
+      case prim_memory_huge_pages:
+        resource = std::make_shared<PageResource>(PageResource::huge_page_transparent, numaNode);
+        break;
+      case prim_memory_explicit_huge_pages:
+        resource = std::make_shared<PageResource>(PageResource::huge_page_explicit, numaNode);
+        break;
+      default:
+        if (numaNode >= 0)
+          resource = std::make_shared<PageResource>(PageResource::huge_page_none, numaNode);
+        break;
+    }
+    relocate_primitive_storage(
+        geom, resource ? resource->allocator() : get_memory_source(memsrc_e::host, -1));
+    return resource;
+  }
+
+}  // namespace zs
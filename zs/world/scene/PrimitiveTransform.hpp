@@ -4,6 +4,9 @@
 
 namespace zs {
 
+  struct FileBackedResource;
+  struct TrackedResource;
+
   /// poly mesh to other forms
   /// @brief assign visual mesh (ZsPrimitive) to trimesh (zs::Mesh)
   ZS_WORLD_EXPORT void assign_visual_mesh_to_pointmesh(const PrimitiveStorage& src,
@@ -62,6 +65,35 @@ namespace zs {
                                                       const source_location& loc
                                                       = source_location::current());
 
+  /// out-of-core storage
+  /// @brief move the attributes of [geom] (points, verts, local prims and attrib keyframes)
+  /// onto [allocator]
+  /// @note outputs of the transforms above are allocated alike when derived from [geom]
+  ZS_WORLD_EXPORT void relocate_primitive_storage(PrimitiveStorage& geom,
+                                                  const AttrVector::allocator_type& allocator);
+  /// @brief relocate [geom] onto a FileBackedResource spilling into [directory], thus paged
+  /// to disk rather than held in RAM
+  /// @note the storage keeps the resource alive, the returned handle is for queries and hints
+  ZS_WORLD_EXPORT Shared<FileBackedResource> spill_primitive_storage(PrimitiveStorage& geom,
+                                                                     std::string_view directory
+                                                                     = {});
+
+  /// @brief memory resources the storage of a prim may be placed upon
+  enum prim_memory_e : u32 {
+    prim_memory_default = 0,         // default host allocator (small pages)
+    prim_memory_huge_pages,          // PageResource upon transparent huge pages
+    prim_memory_explicit_huge_pages  // PageResource upon the reserved huge page pool
+  };
+  /// @brief relocate [geom] onto a fresh resource of [kind], its pages bound to [numaNode] if
+  /// non-negative (see PageResource::current_numa_node())
+  /// @return the resource, for statistics (TrackedResource::getStats()), null if [geom] went
+  /// back to the default allocator
+  /// @note ArenaResource is meant for scratch storage within a single conversion instead, see
+  /// evaluate_primitive_to_zsmesh
+  ZS_WORLD_EXPORT Shared<TrackedResource> select_primitive_memory(PrimitiveStorage& geom,
+                                                                  prim_memory_e kind,
+                                                                  int numaNode = -1);
+
 #if 0
   ZS_WORLD_EXPORT void update_primitive_to_visual_mesh(const ZsPrimitive& src, ZsPrimitive& dst,
                                                        const source_location& loc
@@ -0,0 +1,138 @@
+#include "SceneBake.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+#include "SceneContext.hpp"
+#include "world/async/Executor.hpp"
+
+#if ZS_ENABLE_OPENMP
+#  include <omp.h>
+#endif
+
+namespace zs {
+
+  std::vector<TimeCode> make_timecode_range(TimeCode start, TimeCode end, TimeCode stride) {
+    std::vector<TimeCode> ret;
+    if (std::isnan(start) || std::isnan(end) || !(stride > 0) || end < start) return ret;
+    const auto n = (size_t)std::floor((end - start) / stride + 1e-6) + 1;
+    ret.reserve(n);
+    for (size_t i = 0; i != n; ++i) ret.push_back(start + stride * i);
+    return ret;
+  }
+
+  BakeStats bake_primitives(const std::vector<ZsPrimitive *> &prims,
+                            const std::vector<TimeCode> &tcs, BakeSink sink, int numThreads) {
+    BakeStats stats;
+    if (tcs.empty()) return stats;
+    auto start = std::chrono::steady_clock::now();
+
+    /// @note lazily maintained states (keyframe orders, time-varying caches) are settled here,
+    /// before any worker reads them
+    std::vector<std::pair<ZsPrimitive *, TimeCode>> tasks;
+    for (auto prim : prims) {
+      if (!prim) continue;
+      auto &keyframes = prim->keyframes();
+      keyframes.updateSequences();
+      if (keyframes.getAttribKeyFrame(KEYFRAME_ATTRIB_POS_LABEL, tcs[0]).expired()) continue;
+      if (prim->details().isMeshTimeVarying())
+        for (auto tc : tcs) tasks.emplace_back(prim, tc);
+      else
+        tasks.emplace_back(prim, tcs[0]);
+    }
+    stats._numTasks = tasks.size();
+    if (tasks.empty()) return stats;
+
+    if (numThreads <= 0) numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    numThreads = std::min((size_t)numThreads, tasks.size());
+    /// @note each task still runs its kernels on an OpenMP team of its own, capped so that all
+    /// teams together do not exceed the cores
+    /// @note omp_exec() sizes its team after omp_get_max_threads() of the calling thread
+    const int teamSize = std::max((int)std::thread::hardware_concurrency() / numThreads, 1);
+    const size_t maxPending = 2 * (size_t)numThreads;
+
+    /// @note timecodes are evaluated concurrently, while a single consumer drains the evaluated
+    /// frames into [sink]
+    struct PendingFrame {
+      ZsPrimitive *_prim;
+      TimeCode _tc;
+      ZsMeshBundle _meshes;
+    };
+    Mutex mutex;  // guards [pending] and [done]
+    std::condition_variable_any cv;
+    std::deque<PendingFrame> pending;
+    bool done = false;
+    std::atomic<size_t> numFailed{0};
+    std::thread consumer([&]() {
+      for (;;) {
+        std::unique_lock lk(mutex);
+        cv.wait(lk, [&]() { return !pending.empty() || done; });
+        if (pending.empty()) return;
+        auto frame = zs::move(pending.front());
+        pending.pop_front();
+        lk.unlock();
+        cv.notify_all();
+        try {
+          sink(*frame._prim, frame._tc, zs::move(frame._meshes));
+        } catch (const std::exception &e) {
+          fmt::print("baking prim [{}] at tc {} failed. [{}]\n", frame._prim->label(), frame._tc,
+                     e.what());
+          numFailed.fetch_add(1);
+        }
+      }
+    });
+    {
+      Scheduler scheduler(numThreads);
+      for (const auto &[prim, tc] : tasks)
+        scheduler.enqueue([prim = prim, tc = tc, teamSize, maxPending, &mutex, &cv, &pending,
+                           &numFailed]() {
+#if ZS_ENABLE_OPENMP
+          omp_set_num_threads(teamSize);
+#endif
+          ZsMeshBundle meshes;
+          try {
+            meshes._geometry = UniquePtr<PrimitiveStorage>(new PrimitiveStorage());
+            evaluate_primitive_to_zsmesh(*prim, tc, *meshes._geometry, &meshes._triMesh,
+                                         &meshes._lineMesh, &meshes._pointMesh);
+          } catch (const std::exception &e) {
+            fmt::print("baking prim [{}] at tc {} failed. [{}]\n", prim->label(), tc, e.what());
+            numFailed.fetch_add(1);
+            return;
+          }
+          {
+            std::unique_lock lk(mutex);
+            cv.wait(lk, [&]() { return pending.size() < maxPending; });
+            pending.push_back(PendingFrame{prim, tc, zs::move(meshes)});
+          }
+          cv.notify_all();
+        });
+      scheduler.wait();
+    }
+    {
+      std::lock_guard lk(mutex);
+      done = true;
+    }
+    cv.notify_all();
+    consumer.join();
+    stats._numFailed = numFailed.load();
+    stats._elapsedMs
+        = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+              .count();
+    return stats;
+  }
+
+  BakeStats bake_primitive(ZsPrimitive &prim, const std::vector<TimeCode> &tcs, BakeSink sink,
+                           int numThreads) {
+    return bake_primitives({&prim}, tcs, zs::move(sink), numThreads);
+  }
+
+  BakeStats bake_scene(const SceneContext &scene, const std::vector<TimeCode> &tcs, BakeSink sink,
+                       int numThreads) {
+    return bake_primitives(scene.getPrimitivesRecurse(), tcs, zs::move(sink), numThreads);
+  }
+
+}  // namespace zs
@@ -0,0 +1,37 @@
+#pragma once
+#include "../WorldExport.hpp"
+#include "Primitive.hpp"
+
+namespace zs {
+
+  struct SceneContext;
+
+  /// @brief receives the meshes of a prim evaluated at a timecode
+  /// @note invoked from a worker thread, never concurrently, in no particular order
+  using BakeSink = zs::function<void(const ZsPrimitive &, TimeCode, ZsMeshBundle &&)>;
+
+  struct BakeStats {
+    size_t _numTasks{0}, _numFailed{0};
+    double _elapsedMs{0.};
+  };
+
+  /// @brief [start, end] sampled every [stride]
+  ZS_WORLD_EXPORT std::vector<TimeCode> make_timecode_range(TimeCode start, TimeCode end,
+                                                            TimeCode stride = 1);
+
+  /// @brief evaluate [prims] at [tcs] concurrently, streaming results into [sink]
+  /// @note every (prim, timecode) task converts into its own scratch storage, the live buffers
+  /// of the prims are left untouched
+  /// @note [numThreads] (hardware concurrency if non-positive) bounds the frames in flight, the
+  /// OpenMP team of each is capped to its share of the cores
+  /// @note prims without time-varying meshes are evaluated once at the first timecode
+  ZS_WORLD_EXPORT BakeStats bake_primitives(const std::vector<ZsPrimitive *> &prims,
+                                            const std::vector<TimeCode> &tcs, BakeSink sink,
+                                            int numThreads = 0);
+  ZS_WORLD_EXPORT BakeStats bake_primitive(ZsPrimitive &prim, const std::vector<TimeCode> &tcs,
+                                           BakeSink sink, int numThreads = 0);
+  /// @brief bake all (nested) prims of [scene]
+  ZS_WORLD_EXPORT BakeStats bake_scene(const SceneContext &scene, const std::vector<TimeCode> &tcs,
+                                       BakeSink sink, int numThreads = 0);
+
+}  // namespace zs
@@ -0,0 +1,225 @@
+#include "SceneBvh.hpp"
+
+#include <algorithm>
+
+#include "PrimitiveInstancing.hpp"
+#include "PrimitiveQuery.hpp"
+
+#if ZS_ENABLE_OPENMP
+#  include "zensim/omp/execution/ExecutionPolicy.hpp"
+#else
+#  include "zensim/execution/ExecutionPolicy.hpp"
+#endif
+
+namespace zs {
+
+  namespace {
+    /// @note the box of the triangles actually traced, the local box of an instancing prim also
+    /// encloses its instances
+    PrimitiveBoundingBox tri_bvh_bounding_box(const PrimBvh &bvh) {
+      auto pol = seq_exec();
+      auto rootBv = bvh.getTotalBox(pol);
+      return PrimitiveBoundingBox{glm::vec3{rootBv._min[0], rootBv._min[1], rootBv._min[2]},
+                                  glm::vec3{rootBv._max[0], rootBv._max[1], rootBv._max[2]}};
+    }
+  }  // namespace
+
+  bool SceneBvh::refresh_instance(Instance &inst, AABBBox<3, f32> &bv) {
+    glm::mat4 xform = inst._prim->currentTimeVisualTransform();
+    if (inst._instanceId != -1)
+      xform = xform * get_instance_transform(*get_instancing(*inst._prim), inst._instanceId);
+    const auto &geomDetails = inst._geom->details();
+    PrimitiveBoundingBox localBox = inst._instanceId == -1
+                                        ? tri_bvh_bounding_box(geomDetails.triBvh())
+                                        : geomDetails.localBoundingBox();
+    /// @note own geometry with varying positions is bounded over the whole timeline, its mesh
+    /// is not updated while culled
+    /// @note the timeline box of an instancing prim encloses its instances too, loose yet
+    /// conservative
+    if (inst._instanceId == -1 && inst._geom == inst._prim
+        && (geomDetails.getTimeVaryingMask() & PrimitiveDetail::dirty_Pos)) {
+      PrimitiveBoundingBox timelineBox;
+      if (geomDetails.timelineBoundingBox(timelineBox)) {
+        localBox.merge(timelineBox.minPos);
+        localBox.merge(timelineBox.maxPos);
+      }
+    }
+    bool changed = xform != inst._transform || localBox.minPos != inst._localBox.minPos
+                   || localBox.maxPos != inst._localBox.maxPos;
+    if (changed) {
+      inst._transform = xform;
+      inst._transformInv = glm::inverse(xform);
+      inst._localBox = localBox;
+    }
+    /// @note prims drawing the meshes of another are bounded by the box of the latter
+    /// @note read-only on prims, as instances are refreshed in parallel, see publish_world_boxes
+    inst._worldBox = transform_bounding_box(inst._localBox, inst._transform);
+    const auto &worldBox = inst._worldBox;
+    bv = AABBBox<3, f32>{zs::vec<f32, 3>{worldBox.minPos.x, worldBox.minPos.y, worldBox.minPos.z},
+                         zs::vec<f32, 3>{worldBox.maxPos.x, worldBox.maxPos.y, worldBox.maxPos.z}};
+    return changed;
+  }
+
+  void SceneBvh::publish_world_boxes() {
+    /// @note the instances of a prim follow its own geometry, see gather_instances, the world box
+    /// of an instancing prim is thus the union of them all
+    ZsPrimitive *prim = nullptr;
+    for (const auto &inst : _instances) {
+      if (inst._instanceId == -1 && inst._geom != inst._prim) continue;
+      auto &box = inst._prim->details().worldBoundingBox();
+      if (inst._prim != prim) {
+        prim = inst._prim;
+        box = inst._worldBox;
+      } else {
+        box.merge(inst._worldBox.minPos);
+        box.merge(inst._worldBox.maxPos);
+      }
+    }
+  }
+
+  void SceneBvh::gather_instances(const std::vector<ZsPrimitive *> &prims,
+                                  std::vector<Instance> &instances) {
+    instances.clear();
+    for (auto prim : prims) {
+      if (!prim) continue;
+      if (instance_eligible(prim))
+        instances.push_back(Instance{prim, prim});
+      else if (auto source = prim->meshSource(); instance_eligible(source.get()))
+        instances.push_back(Instance{prim, source.get()});
+      if (auto pack = get_instancing(*prim); pack && instance_eligible(pack->prototype().get()))
+        for (PrimIndex i = 0; i != pack->numInstances(); ++i)
+          instances.push_back(Instance{prim, pack->prototype().get(), i});
+    }
+  }
+
+  void SceneBvh::build(const std::vector<ZsPrimitive *> &prims) {
+    std::vector<Instance> instances;
+    gather_instances(prims, instances);
+    rebuild(zs::move(instances));
+  }
+
+  void SceneBvh::rebuild(std::vector<Instance> &&instances) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    _instances = zs::move(instances);
+    _numLeaves = _instances.size();
+    _revision++;
+    if (_numLeaves == 0) return;
+
+    _bvs = Vector<AABBBox<3, f32>>{_numLeaves};
+    pol(range(_numLeaves), [this](size_t i) { refresh_instance(_instances[i], _bvs[i]); });
+    publish_world_boxes();
+    _bvh.buildRefit(pol, _bvs);
+  }
+
+  void SceneBvh::refit() {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    if (_numLeaves == 0) return;
+    pol(range(_numLeaves), [this](size_t i) { refresh_instance(_instances[i], _bvs[i]); });
+    publish_world_boxes();
+    _bvh.refit(pol, _bvs);
+    _revision++;
+  }
+
+  bool SceneBvh::update(const std::vector<ZsPrimitive *> &prims) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    /// @note the instance set changes once prims are (un)registered, their triBvh appears or
+    /// their instances are altered
+    std::vector<Instance> instances;
+    gather_instances(prims, instances);
+    bool sameSet = instances.size() == _instances.size();
+    for (size_t i = 0; sameSet && i != instances.size(); ++i)
+      sameSet = instances[i]._prim == _instances[i]._prim
+                && instances[i]._geom == _instances[i]._geom
+                && instances[i]._instanceId == _instances[i]._instanceId;
+    if (!sameSet) {
+      rebuild(zs::move(instances));
+      return true;
+    }
+    if (_numLeaves == 0) return false;
+
+    std::vector<u8> changed(_numLeaves);
+    pol(range(_numLeaves),
+        [this, &changed](size_t i) { changed[i] = refresh_instance(_instances[i], _bvs[i]); });
+    if (std::find(changed.begin(), changed.end(), (u8)1) == changed.end()) return false;
+    publish_world_boxes();
+    _bvh.refit(pol, _bvs);
+    _revision++;
+    return true;
+  }
+
+  bool SceneBvh::intersect(const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection,
+                           Hit &hit) const {
+    if (_numLeaves == 0) return false;
+    const auto rd = glm::normalize(rayDirection);
+    const auto invRd = 1.f / rd;
+
+    /// @note slab test, returns the entry distance or max if missed
+    auto entryDistance = [&rayOrigin, &invRd](const AABBBox<3, f32> &bv) {
+      f32 tmin = 0.f, tmax = detail::deduce_numeric_max<f32>();
+      for (int d = 0; d != 3; ++d) {
+        f32 t0 = (bv._min[d] - rayOrigin[d]) * invRd[d];
+        f32 t1 = (bv._max[d] - rayOrigin[d]) * invRd[d];
+        if (t0 > t1) std::swap(t0, t1);
+        tmin = std::max(tmin, t0);
+        tmax = std::min(tmax, t1);
+      }
+      return tmin <= tmax ? tmin : detail::deduce_numeric_max<f32>();
+    };
+
+    std::vector<std::pair<f32, size_t>> candidates;
+    auto bvhv = proxy<execspace_e::host>(_bvh);
+    bvhv.ray_intersect(zs::vec<f32, 3>{rayOrigin.x, rayOrigin.y, rayOrigin.z},
+                       zs::vec<f32, 3>{rd.x, rd.y, rd.z}, [&](size_t i) {
+                         if (auto t = entryDistance(_bvs[i]); t != detail::deduce_numeric_max<f32>())
+                           candidates.emplace_back(t, i);
+                       });
+    std::sort(candidates.begin(), candidates.end());
+
+    Hit ret{};
+    for (const auto &[t, i] : candidates) {
+      /// @note boxes farther than the closest hit so far cannot contribute
+      if (t > ret._dist) break;
+      const auto &inst = _instances[i];
+      glm::vec3 pos;
+      if (get_ray_intersection_with_prim(rayOrigin, rd, *inst._geom, inst._transform,
+                                         inst._transformInv, &pos)) {
+        if (auto dist = glm::length(pos - rayOrigin); dist < ret._dist) {
+          ret._prim = inst._prim;
+          ret._instanceId = inst._instanceId;
+          ret._pos = pos;
+          ret._dist = dist;
+        }
+      }
+    }
+    if (ret) hit = ret;
+    return static_cast<bool>(ret);
+  }
+
+  size_t SceneBvh::intersect(const glm::vec3 *rayOrigins, const glm::vec3 *rayDirections,
+                             size_t numRays, Hit *hits) const {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    if (_numLeaves == 0 || numRays == 0) return 0;
+    std::atomic<size_t> numHits{0};
+    pol(range(numRays), [&](size_t i) {
+      if (intersect(rayOrigins[i], rayDirections[i], hits[i])) numHits.fetch_add(1);
+    });
+    return numHits.load();
+  }
+
+}  // namespace zs
@@ -0,0 +1,85 @@
+#pragma once
+#include "../WorldExport.hpp"
+#include "Primitive.hpp"
+
+namespace zs {
+
+  /// @brief top-level acceleration structure over the world-space boxes of prims
+  /// @note each instance references the triBvh of its prim (bottom level) along with the
+  /// (visual) transform it was placed with
+  /// @note instanced prims (see PrimitiveInstancing.hpp) contribute one instance per placement,
+  /// all referencing the triBvh of the shared prototype
+  /// @note such instances are hit and culled here, yet not drawn, as gpu instancing is not
+  /// implemented
+  struct ZS_WORLD_EXPORT SceneBvh {
+    struct Instance {
+      ZsPrimitive *_prim{nullptr};
+      const ZsPrimitive *_geom{nullptr};  // owner of the bottom-level triBvh
+      PrimIndex _instanceId{-1};          // -1 for the prim's own (or its mesh source's) geometry
+      glm::mat4 _transform{1.f}, _transformInv{1.f};
+      PrimitiveBoundingBox _localBox{}, _worldBox{};
+    };
+    struct Hit {
+      ZsPrimitive *_prim{nullptr};
+      PrimIndex _instanceId{-1};
+      glm::vec3 _pos{};
+      f32 _dist{detail::deduce_numeric_max<f32>()};
+      explicit operator bool() const noexcept { return _prim != nullptr; }
+    };
+
+    /// @brief full rebuild over the prims with a built triBvh
+    void build(const std::vector<ZsPrimitive *> &prims);
+    /// @brief refresh instance transforms and boxes, then refit the hierarchy in place
+    void refit();
+    /// @brief rebuild if prims were added or removed, otherwise refit if any instance moved
+    /// @return whether the structure changed
+    bool update(const std::vector<ZsPrimitive *> &prims);
+    /// @brief invalidate, the next update() rebuilds
+    void reset() noexcept {
+      _instances.clear();
+      _numLeaves = 0;
+    }
+
+    /// @brief closest hit along the ray
+    /// @note candidates are visited in ascending order of their box entry distance
+    bool intersect(const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection, Hit &hit) const;
+    /// @brief closest hits of [numRays] rays, traced in parallel
+    /// @return number of rays that hit
+    size_t intersect(const glm::vec3 *rayOrigins, const glm::vec3 *rayDirections, size_t numRays,
+                     Hit *hits) const;
+
+    /// @brief visit instances whose world box overlaps [lo, hi]
+    template <typename F> void iterOverlaps(const glm::vec3 &lo, const glm::vec3 &hi, F &&f) const {
+      if (_numLeaves == 0) return;
+      auto bvhv = proxy<execspace_e::host>(_bvh);
+      bvhv.iter_neighbors(AABBBox<3, f32>{zs::vec<f32, 3>{lo.x, lo.y, lo.z},
+                                          zs::vec<f32, 3>{hi.x, hi.y, hi.z}},
+                          [&f](auto instNo) { f((size_t)instNo); });
+    }
+
+    size_t numInstances() const noexcept { return _instances.size(); }
+    const auto &getInstances() const noexcept { return _instances; }
+    /// @note bumped upon every rebuild or refit
+    u64 getRevision() const noexcept { return _revision; }
+
+  protected:
+    static bool instance_eligible(const ZsPrimitive *prim) noexcept {
+      return prim && prim->details().triBvh().getNumLeaves() != 0;
+    }
+    static void gather_instances(const std::vector<ZsPrimitive *> &prims,
+                                 std::vector<Instance> &instances);
+    void rebuild(std::vector<Instance> &&instances);
+    /// @brief recompute transform and world box of [inst]
+    /// @return whether anything changed
+    static bool refresh_instance(Instance &inst, AABBBox<3, f32> &bv);
+    /// @brief store the world boxes of the prims' own geometry back into their details
+    void publish_world_boxes();
+
+    std::vector<Instance> _instances;
+    Vector<AABBBox<3, f32>> _bvs;
+    LBvh<3> _bvh;
+    size_t _numLeaves{0};
+    u64 _revision{0};
+  };
+
+}  // namespace zs
@@ -1,34 +1,99 @@
 #include "SceneContext.hpp"
 
+#include <unordered_map>
+
 #include "../World.hpp"
+#include "Camera.hpp"
+#include "PrimitiveInstancing.hpp"
+
+#if ZS_ENABLE_OPENMP
+#  include "zensim/omp/execution/ExecutionPolicy.hpp"
+#else
+#  include "zensim/execution/ExecutionPolicy.hpp"
+#endif
 
 namespace zs {
 
+  namespace {
+    /// @note instanced prims are bounded by their instances, see setup_instancing, unless these
+    /// were moved through the pack alone since (see PackPrimContainer::_boundsStale)
+    /// @note prims drawing the meshes of another are bounded alike, see share_duplicate_meshes
+    bool has_known_bounds(const ZsPrimitive &prim) noexcept {
+      if (auto pack = get_instancing(prim)) return !pack->_boundsStale;
+      if (prim.details().triBvh().getNumLeaves() != 0) return true;
+      auto source = prim.meshSource();
+      return source && source->details().triBvh().getNumLeaves() != 0;
+    }
+    void append_path_component(std::string &path, std::string_view label) {
+      path += '/';
+      path += label;
+    }
+    /// @note whether the labels from [prim] up to its top-level ancestor [root] still spell [path]
+    bool label_path_matches(const ZsPrimitive *prim, std::string_view path,
+                            const ZsPrimitive *root) {
+      while (prim && prim != root) {
+        auto sep = path.rfind('/');
+        if (sep == std::string_view::npos || path.substr(sep + 1) != prim->label()) return false;
+        path = path.substr(0, sep);
+        prim = prim->getParent();
+      }
+      return prim && path.find('/') == std::string_view::npos;
+    }
+  }  // namespace
+
   Weak<ZsPrimitive> SceneContext::getPrimitive(std::string_view label) {
-    if (auto it = _primitives.find(label); it != _primitives.end()) return (*it).second;
+    if (auto prim = _primitives.find(label)) return *prim;
     return {};
   }
   Weak<ZsPrimitive> SceneContext::getPrimitiveByIdRecurse(PrimIndex id_) {
-#if 1
-    if (auto it = _idToPrim.find(id_); it != _idToPrim.end()) return (*it).second;
-    for (auto &entry : _orderedPrims)
-      if (auto r = entry.prim.lock()->getChildByIdRecurse(id_); r.lock()) return r;
-    return {};
-#else
-    for (const auto &[label, prim] : _primitives)
-      if (prim->id() == id_) return prim;
-    for (const auto &[label, prim] : _primitives)
-      if (auto ret = prim->getChildByIdRecurse(id_); ret.lock()) return ret;
+    if (auto entry = _idToPrim.find(id_)) {
+      if (auto prim = entry->lock(); prim && prim->id() == id_) return prim;
+      /// @note expired (e.g. removed from its parent)
+      _idToPrim.erase(id_);
+    }
+    for (auto &entry : _orderedPrims) {
+      auto root = entry.prim.lock();
+      if (!root) continue;
+      Shared<ZsPrimitive> ret{};
+      if (root->id() == id_)
+        ret = root;
+      else
+        ret = root->getChildByIdRecurse(id_).lock();
+      if (ret) {
+        _idToPrim.insert(id_, Weak<ZsPrimitive>{ret});
+        return ret;
+      }
+    }
     return {};
-#endif
   }
   Weak<ZsPrimitive> SceneContext::getPrimitiveByPath(const std::vector<std::string> &path) {
     if (!path.size()) return {};
-    Shared<ZsPrimitive> prim = getPrimitive(path[0]).lock();
-    for (size_t i = 1; i < path.size(); ++i) {
-      if (!prim) break;
-      prim = prim->getChild(path[i]).lock();
+    if (path.size() == 1) return getPrimitive(path[0]);
+    std::string key = path[0];
+    for (size_t i = 1; i < path.size(); ++i) append_path_component(key, path[i]);
+    return getPrimitiveByPath(key);
+  }
+  Weak<ZsPrimitive> SceneContext::getPrimitiveByPath(std::string_view path) {
+    auto sep = path.find('/');
+    if (sep == std::string_view::npos) return getPrimitive(path);
+    auto root = getPrimitive(path.substr(0, sep)).lock();
+    if (auto entry = _pathToPrim.find(path)) {
+      if (auto prim = entry->lock(); prim && label_path_matches(prim.get(), path, root.get()))
+        return prim;
+      /// @note stale, a label along the path was altered (or the prim moved) since indexed
+      _pathToPrim.erase(path);
     }
+    /// @note children appended after registration, or child labels altered since
+    Shared<ZsPrimitive> prim = root;
+    while (prim && sep != std::string_view::npos) {
+      auto next = path.find('/', sep + 1);
+      prim = prim->getChild(path.substr(sep + 1, next == std::string_view::npos
+                                                      ? std::string_view::npos
+                                                      : next - sep - 1))
+                 .lock();
+      sep = next;
+    }
+    if (prim) _pathToPrim.insert_or_assign(path, Weak<ZsPrimitive>{prim});
     return prim;
   }
   std::vector<std::string> SceneContext::getPrimitiveLabels() const {
@@ -47,8 +112,12 @@ namespace zs {
   }
   bool SceneContext::registerPrimitive(std::string_view label, Shared<ZsPrimitive> prim) {
     // first is iterator
-    auto ret = _primitives.emplace(label, prim).second;
+    auto ret = _primitives.insert(label, prim);
     if (ret) {
+      /// @note the visible set and the transform layout no longer cover all prims
+      _visiblePrimsValid = false;
+      _transformCache.invalidate();
+      _scenePrimsChanged = true;
       TimeCode st, ed;
       if (prim->queryStartEndTimeCodes(st, ed)) {
         auto originalSt = _timeline.getStartTimeCode();
@@ -95,10 +164,251 @@ namespace zs {
         }
       }
       _orderedPrims.emplace_back(label, prim);
-      _idToPrim.emplace(prim->id(), prim);
+      indexHierarchy(label, prim);
+      prim->setMeshProvider(this);
     }
     return ret;
   }
+  bool SceneContext::unregisterPrimitive(std::string_view label) {
+    auto entry = _primitives.find(label);
+    if (!entry) return false;
+    Shared<ZsPrimitive> prim = *entry;
+    /// @note prefetch tasks may still be evaluating (thus holding) prims of this hierarchy
+    if (_prefetcher) _prefetcher->drain();
+    std::vector<ZsPrimitive *> stack{prim.get()};
+    while (stack.size()) {
+      auto p = stack.back();
+      stack.pop_back();
+      if (!p->isStatusIdle()) return false;
+      for (const auto &ch : p->children()) stack.push_back(ch.get());
+    }
+    prim->setMeshProvider(nullptr);
+
+    unindexHierarchy(label, prim);
+    _primitives.erase(label);
+    for (int i = 0; i != (int)_orderedPrims.size(); ++i)
+      if (_orderedPrims[i].label == label) {
+        _orderedPrims.erase(_orderedPrims.begin() + i);
+        for (auto id : {&_focusId, &_hoveredId})
+          if (*id == i)
+            *id = -1;
+          else if (*id > i)
+            --*id;
+        break;
+      }
+    /// @note derived structures reference prims by raw pointers
+    _visiblePrims.clear();
+    _visiblePrimsValid = false;
+    _transformCache.invalidate();
+    _sceneBvh.reset();
+    _scenePrimsChanged = true;
+    return true;
+  }
+  void SceneContext::indexHierarchy(std::string_view label, const Shared<ZsPrimitive> &prim) {
+    std::vector<std::pair<Shared<ZsPrimitive>, std::string>> stack;
+    stack.emplace_back(prim, std::string(label));
+    while (stack.size()) {
+      auto [p, path] = zs::move(stack.back());
+      stack.pop_back();
+      _idToPrim.insert_or_assign(p->id(), Weak<ZsPrimitive>{p});
+      /// @note top-level prims are resolved by _primitives
+      if (p != prim) _pathToPrim.insert(path, Weak<ZsPrimitive>{p});
+      /// @note reversed, so that the first child of a duplicated label wins
+      const auto &childs = p->children();
+      for (auto it = childs.rbegin(); it != childs.rend(); ++it) {
+        auto childPath = path;
+        append_path_component(childPath, (*it)->label());
+        stack.emplace_back(*it, zs::move(childPath));
+      }
+    }
+  }
+  void SceneContext::unindexHierarchy(std::string_view label, const Shared<ZsPrimitive> &prim) {
+    std::vector<std::pair<ZsPrimitive *, std::string>> stack;
+    stack.emplace_back(prim.get(), std::string(label));
+    while (stack.size()) {
+      auto [p, path] = zs::move(stack.back());
+      stack.pop_back();
+      if (auto entry = _idToPrim.find(p->id()); entry && entry->lock().get() == p)
+        _idToPrim.erase(p->id());
+      if (auto entry = _pathToPrim.find(path); entry && entry->lock().get() == p)
+        _pathToPrim.erase(path);
+      for (const auto &ch : p->children()) {
+        auto childPath = path;
+        append_path_component(childPath, ch->label());
+        stack.emplace_back(ch.get(), zs::move(childPath));
+      }
+    }
+  }
+
+  std::vector<ZsPrimitive *> SceneContext::getPrimitivesRecurse() const {
+    std::vector<ZsPrimitive *> ret;
+    std::vector<ZsPrimitive *> stack;
+    for (auto it = _orderedPrims.rbegin(); it != _orderedPrims.rend(); ++it)
+      if (auto prim = (*it).prim.lock()) stack.push_back(prim.get());
+    while (stack.size()) {
+      auto prim = stack.back();
+      stack.pop_back();
+      ret.push_back(prim);
+      const auto &childs = prim->children();
+      for (auto it = childs.rbegin(); it != childs.rend(); ++it) stack.push_back((*it).get());
+    }
+    return ret;
+  }
+  size_t SceneContext::updateTransforms(TimeCode tc) {
+    if (!_transformCache.isValid()) {
+      std::vector<ZsPrimitive *> roots;
+      for (auto &entry : _orderedPrims)
+        if (auto prim = entry.prim.lock()) roots.push_back(prim.get());
+      _transformCache.build(roots);
+    }
+    const auto n = _transformCache.update(tc);
+    if (n) _sceneBvhDirty = true;
+    return n;
+  }
+  const std::vector<ZsPrimitive *> &SceneContext::cullPrimitives(const Camera &camera,
+                                                                 bool hierarchical) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    auto prims = getPrimitivesRecurse();
+    const auto numPrims = prims.size();
+    _visiblePrims.clear();
+    _visiblePrimsValid = true;
+    if (numPrims == 0) return _visiblePrims;
+
+    // mark
+    std::vector<u32> marks(numPrims), offsets(numPrims);
+    if (hierarchical) {
+      /// @note broad phase: boxes overlapping the bounding box of the (far-clipped) frustum
+      auto &sceneBvh = refSceneBvh();
+      const auto invView = glm::inverse(camera.matrices.view);
+      const f32 depths[2] = {camera.getNearClip(), camera.getFarClip()};
+      glm::vec3 lo{detail::deduce_numeric_max<f32>()}, hi{-detail::deduce_numeric_max<f32>()};
+      for (auto z : depths)
+        for (int sx = -1; sx <= 1; sx += 2)
+          for (int sy = -1; sy <= 1; sy += 2) {
+            auto corner = glm::vec3(invView * glm::vec4(sx * z * camera.tanFOV.x,
+                                                        sy * z * camera.tanFOV.y, -z, 1.f));
+            lo = glm::min(lo, corner);
+            hi = glm::max(hi, corner);
+          }
+      std::unordered_map<const ZsPrimitive *, size_t> primIndices;
+      for (size_t i = 0; i != numPrims; ++i) primIndices[prims[i]] = i;
+      /// @note prims absent from the scene bvh have unknown bounds, the scene bvh bounds prims of
+      /// varying positions over the whole timeline (see SceneBvh::refresh_instance), unless these
+      /// get deformed
+      pol(range(numPrims), [&](size_t i) {
+        PrimitiveBoundingBox box;
+        marks[i] = !has_known_bounds(*prims[i]) || !prims[i]->details().timelineBoundingBox(box);
+      });
+      const auto &instances = sceneBvh.getInstances();
+      sceneBvh.iterOverlaps(lo, hi, [&](size_t instNo) {
+        const auto &box = instances[instNo]._worldBox;
+        if (camera.isAABBVisible(box.minPos, box.maxPos))
+          if (auto it = primIndices.find(instances[instNo]._prim); it != primIndices.end())
+            marks[(*it).second] = 1;
+      });
+    } else {
+      pol(range(numPrims), [&](size_t i) {
+        auto &details = prims[i]->details();
+        PrimitiveBoundingBox localBox;
+        if (!has_known_bounds(*prims[i]) || !details.timelineBoundingBox(localBox)) {
+          marks[i] = 1;
+          return;
+        }
+        details.worldBoundingBox()
+            = transform_bounding_box(localBox, prims[i]->currentTimeVisualTransform());
+        const auto &box = details.worldBoundingBox();
+        marks[i] = camera.isAABBVisible(box.minPos, box.maxPos);
+      });
+    }
+    pol(range(numPrims), [&](size_t i) { prims[i]->details().setCulled(!marks[i]); });
+    // scan
+    exclusive_scan(pol, zs::begin(marks), zs::end(marks), zs::begin(offsets));
+    // gather
+    _visiblePrims.resize(offsets.back() + marks.back());
+    pol(range(numPrims), [&](size_t i) {
+      if (marks[i]) _visiblePrims[offsets[i]] = prims[i];
+    });
+    return _visiblePrims;
+  }
+  void SceneContext::resetCulling() {
+    for (auto prim : getPrimitivesRecurse()) prim->details().setCulled(false);
+    _visiblePrims.clear();
+    _visiblePrimsValid = false;
+  }
+
+  SceneBvh &SceneContext::refSceneBvh() {
+    /// @note edits may alter the instance set (e.g. a triBvh built, children appended), a mere
+    /// timecode change only moves the instances
+    const auto epoch = PrimitiveDetail::edit_epoch();
+    if (_scenePrimsChanged || epoch != _sceneBvhEpoch)
+      _sceneBvh.update(getPrimitivesRecurse());
+    else if (_sceneBvhDirty)
+      _sceneBvh.refit();
+    _sceneBvhEpoch = epoch;
+    _scenePrimsChanged = _sceneBvhDirty = false;
+    return _sceneBvh;
+  }
+  ZsPrimitive *SceneContext::pickPrimitive(const glm::vec3 &rayOrigin,
+                                           const glm::vec3 &rayDirection, glm::vec3 *hitPt,
+                                           PrimIndex *instanceId) {
+    SceneBvh::Hit hit;
+    if (!refSceneBvh().intersect(rayOrigin, rayDirection, hit)) return nullptr;
+    if (hitPt) *hitPt = hit._pos;
+    if (instanceId) *instanceId = hit._instanceId;
+    return hit._prim;
+  }
+  std::vector<ZsPrimitive *> SceneContext::gatherPrimitivesRequiringUpdate(TimeCode tc) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    auto prims = getPrimitivesRecurse();
+    const auto numPrims = prims.size();
+    if (numPrims == 0) return {};
+    // mark
+    std::vector<u32> marks(numPrims), offsets(numPrims);
+    pol(range(numPrims), [&](size_t i) {
+      auto prim = prims[i];
+      /// @note busy prims are left to be inspected once they turn idle
+      marks[i] = prim->isStatusIdle() && !prim->details().isCulled()
+                 && prim->details().meshRequireUpdate(tc);
+    });
+    // scan
+    exclusive_scan(pol, zs::begin(marks), zs::end(marks), zs::begin(offsets));
+    // gather
+    std::vector<ZsPrimitive *> ret(offsets.back() + marks.back());
+    pol(range(numPrims), [&](size_t i) {
+      if (marks[i]) ret[offsets[i]] = prims[i];
+    });
+    /// @note prefetched or baked frames are taken by the conversions themselves, see takeMeshes
+    return ret;
+  }
+
+  Shared<ZsMeshBundle> SceneContext::takeMeshes(const ZsPrimitive &prim, TimeCode tc) {
+    if (_prefetcher)
+      if (auto ret = _prefetcher->take(prim, tc)) return ret;
+    /// @note e.g. upon scrubbing, frames not prefetched yet are read from the baked cache, on the
+    /// worker converting [prim]
+    if (_geometryCache) {
+      auto ret = std::make_shared<ZsMeshBundle>();
+      if (_geometryCache->read(prim, tc, *ret)) return ret;
+    }
+    return {};
+  }
+
+  void SceneContext::setGeometryCache(Shared<GeometryCache> cache) {
+    if (_prefetcher) {
+      /// @note frames prefetched so far may stem from the previous cache
+      _prefetcher->drain();
+      _prefetcher->setGeometryCache(cache);
+    }
+    _geometryCache = zs::move(cache);
+  }
 
   ZsPrimitive *SceneContext::getPrimByIndex(int i) noexcept {
     if (i >= 0 && i < _orderedPrims.size()) return _orderedPrims[i].prim.lock().get();
@@ -3,20 +3,91 @@
 #include "Timeline.hpp"
 //
 #include <deque>
-#include <map>
 
+#include "GeometryCache.hpp"
 #include "Primitive.hpp"
+#include "SceneBvh.hpp"
+#include "SceneTransformCache.hpp"
+#include "TimelinePrefetcher.hpp"
+#include "world/core/HashIndex.hpp"
 #include "zensim/ZpcMeta.hpp"
 
+class Camera;
+
 namespace zs {
 
-  struct ZS_WORLD_EXPORT SceneContext {
+  /// @note registered prims (and their descendants) take their prefetched meshes from here
+  struct ZS_WORLD_EXPORT SceneContext : ZsMeshProvider {
     Weak<ZsPrimitive> getPrimitive(std::string_view label);
+    /// @note O(1) for prims (children included) indexed upon registration, descendants appended
+    /// afterwards are searched for once and indexed then
     Weak<ZsPrimitive> getPrimitiveByIdRecurse(PrimIndex id_);
+    /// @note [path] starts with the registered label, followed by child labels
     Weak<ZsPrimitive> getPrimitiveByPath(const std::vector<std::string> &path);
+    /// @brief same as above with labels joined by '/', e.g. "scene/geom/mesh"
+    /// @note cached lookups are checked against the current labels, thus renames are honored
+    Weak<ZsPrimitive> getPrimitiveByPath(std::string_view path);
     std::vector<std::string> getPrimitiveLabels() const;
     std::vector<Weak<ZsPrimitive>> getPrimitives();
     bool registerPrimitive(std::string_view label, Shared<ZsPrimitive> prim);
+    /// @brief remove a registered prim along with its children from the scene
+    /// @return false if absent, or if any prim of the hierarchy is still being processed
+    bool unregisterPrimitive(std::string_view label);
+
+    /// @brief all registered prims (children included) in depth-first order
+    std::vector<ZsPrimitive *> getPrimitivesRecurse() const;
+    /// @brief evaluate mesh dirtiness of every idle prim against [tc] in one parallel sweep
+    /// @note returns the compact list of prims that actually need an update, with dirty flags set
+    std::vector<ZsPrimitive *> gatherPrimitivesRequiringUpdate(TimeCode tc);
+
+    /// @brief speculative evaluation of upcoming frames during playback (disabled by default)
+    /// @note prefetched frames are taken by the conversions of prims, see takeMeshes
+    TimelinePrefetcher &refPrefetcher() noexcept { return *_prefetcher; }
+    /// @brief the prefetched frame of [prim] at [tc], otherwise the one baked in the geometry
+    /// cache, nullptr if neither
+    /// @note invoked by ZsPrimitive::zsMeshAsync on worker threads
+    Shared<ZsMeshBundle> takeMeshes(const ZsPrimitive &prim, TimeCode tc) override;
+    /// @brief frames baked in [cache] replace keyframe evaluation, both for the conversions of
+    /// prims (see takeMeshes) and for prefetches (nullptr detaches)
+    /// @note expected to be set while no conversion is in flight
+    void setGeometryCache(Shared<GeometryCache> cache);
+    const Shared<GeometryCache> &getGeometryCache() const noexcept { return _geometryCache; }
+
+    /// @brief resolve world (and visual) transforms of all prims at [tc] level by level
+    /// @return number of prims whose transforms were recomputed
+    size_t updateTransforms(TimeCode tc);
+    /// @brief O(1) lookup of the world transform resolved by the last updateTransforms()
+    /// @note prims not covered by it are resolved through their parents
+    glm::mat4 getWorldTransform(const ZsPrimitive *prim) const noexcept {
+      return _transformCache.worldTransform(prim);
+    }
+    SceneTransformCache &refTransformCache() noexcept { return _transformCache; }
+
+    /// @brief top-level bvh over all prims, rebuilt or refitted on demand
+    /// @note re-gathered once prims were edited (see PrimitiveDetail::edit_epoch), added or
+    /// removed, refitted once transforms moved along the timeline, otherwise returned as is
+    SceneBvh &refSceneBvh();
+    /// @brief closest prim hit by the ray, nullptr if none
+    /// @note [instanceId] receives the hit instance of an instanced prim, -1 otherwise
+    ZsPrimitive *pickPrimitive(const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection,
+                               glm::vec3 *hitPt = nullptr, PrimIndex *instanceId = nullptr);
+
+    /// @brief test all prims against the view frustum of [camera] in parallel
+    /// @note prims whose bounds are yet unknown (no triBvh built, nor instances) are deemed visible
+    /// @note [hierarchical] narrows the candidates down through the scene bvh first
+    /// @note culled prims are flagged so that their mesh updates are deferred, the visible set
+    /// then drives prefetching
+    /// @note as their meshes go stale meanwhile, prims with varying positions are tested with their
+    /// bounds over the whole timeline (see PrimitiveDetail::timelineBoundingBox), skinned or
+    /// blend-shaped ones are never culled
+    const std::vector<ZsPrimitive *> &cullPrimitives(const Camera &camera,
+                                                     bool hierarchical = false);
+    const std::vector<ZsPrimitive *> &getVisiblePrimitives() const noexcept {
+      return _visiblePrims;
+    }
+    bool hasVisibleSet() const noexcept { return _visiblePrimsValid; }
+    /// @brief drop the visible set and unflag all culled prims
+    void resetCulling();
 
     struct Entry {
       std::string label;
@@ -45,6 +116,11 @@ namespace zs {
     /// @note might be triggered by sequencer widget's signal
     void setCurrentTimeCode(TimeCode tc = g_default_timecode()) {
       _timeline.setCurrentTimeCode(tc);
+      /// @note animated transforms move along without any edit
+      _sceneBvhDirty = true;
+      if (_prefetcher && _prefetcher->isEnabled())
+        _prefetcher->advance(tc, _timeline,
+                             _visiblePrimsValid ? _visiblePrims : getPrimitivesRecurse());
       onTimelineSetupChanged().emit({TimelineEvent{sequencer_component_e::cur_tc, tc}});
     }
     /// @note timeline setup changed actions
@@ -66,8 +142,12 @@ namespace zs {
     }
 
   protected:
-    std::map<std::string, Shared<ZsPrimitive>, std::less<>> _primitives;
-    std::map<PrimIndex, Weak<ZsPrimitive>> _idToPrim;
+    void indexHierarchy(std::string_view label, const Shared<ZsPrimitive> &prim);
+    void unindexHierarchy(std::string_view label, const Shared<ZsPrimitive> &prim);
+
+    HashIndex<std::string, Shared<ZsPrimitive>> _primitives;  // label -> top-level prim
+    HashIndex<PrimIndex, Weak<ZsPrimitive>> _idToPrim;         // all prims
+    HashIndex<std::string, Weak<ZsPrimitive>> _pathToPrim;     // descendants, '/'-joined labels
     std::deque<Entry> _orderedPrims;
 
     // timeline
@@ -77,6 +157,18 @@ namespace zs {
     ///
     int _focusId{-1};    // corresponds to _orderedPrims
     int _hoveredId{-1};  // corresponds to _orderedPrims
+
+    SceneTransformCache _transformCache;
+    SceneBvh _sceneBvh;
+    u64 _sceneBvhEpoch{0};  // PrimitiveDetail::edit_epoch() as of the last refresh
+    bool _scenePrimsChanged{true}, _sceneBvhDirty{false};
+    std::vector<ZsPrimitive *> _visiblePrims;
+    bool _visiblePrimsValid{false};
+
+    Shared<GeometryCache> _geometryCache;
+    /// @note declared last so that in-flight prefetches are done before prims are released
+    /// @note created upfront, as conversion tasks consult it concurrently
+    UniquePtr<TimelinePrefetcher> _prefetcher{new TimelinePrefetcher()};
   };
 
 }  // namespace zs
\ No newline at end of file
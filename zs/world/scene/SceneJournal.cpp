@@ -0,0 +1,548 @@
+#include "SceneJournal.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "PrimitiveSerializer.hpp"
+#include "SceneContext.hpp"
+#include "interface/details/PyHelper.hpp"
+#include "world/core/Archive.hpp"
+#include "world/core/AssetCache.hpp"
+#include "world/core/MappedFile.hpp"
+#include "world/system/ZsExecSystem.hpp"
+
+namespace zs {
+
+  namespace fs = std::filesystem;
+
+  namespace {
+    constexpr u32 g_journal_magic = 0x524a535a;  // "ZSJR"
+    constexpr u16 g_journal_version = 1;
+    /// @note mapped attribute blocks of prim images are aligned to it as well
+    constexpr size_t g_record_alignment = 64;
+    /// @brief bytes copied at once during compaction
+    constexpr size_t g_copy_chunk = (size_t)1 << 20;
+
+    enum journal_record_e : u16 { record_Prim = 1, record_Roots, record_Commit };
+
+    /// @note [_bytes] spans the whole record (header and padding included)
+    struct JournalRecordHeader {
+      u32 _magic;
+      u16 _version;
+      u16 _type;
+      u64 _key;  // prim key, or the batch sequence of commit records
+      u64 _bytes;
+      u64 _checksum;  // of the fields above
+    };
+    static_assert(sizeof(JournalRecordHeader) == 32, "journal record header layout changed");
+
+    u64 header_checksum(const JournalRecordHeader &header) noexcept {
+      return AssetCache::hash_bytes(&header, offsetof(JournalRecordHeader, _checksum));
+    }
+    u64 align_up(u64 v) noexcept {
+      return (v + g_record_alignment - 1) / g_record_alignment * g_record_alignment;
+    }
+    /// @brief the image of a prim record follows its children keys, at the next aligned offset
+    u64 prim_image_offset(u64 recordOffset, u64 numChildren) noexcept {
+      return align_up(recordOffset + sizeof(JournalRecordHeader) + sizeof(u64) * (1 + numChildren));
+    }
+
+    template <typename T> void write_value(std::ostream &os, const T &v) {
+      os.write(reinterpret_cast<const char *>(&v), sizeof(T));
+    }
+    void write_padding(std::ostream &os, u64 pos) {
+      static const char zeros[g_record_alignment] = {};
+      if (const auto rem = pos % g_record_alignment) os.write(zeros, g_record_alignment - rem);
+    }
+    /// @brief write the header of the record spanning [offset, end) and seek to its end
+    bool finish_record(std::ostream &os, u64 offset, u16 type, u64 key) {
+      const u64 end = (u64)os.tellp();
+      write_padding(os, end);
+      JournalRecordHeader header{g_journal_magic, g_journal_version, type, key,
+                                 align_up(end) - offset, 0};
+      header._checksum = header_checksum(header);
+      os.seekp(offset);
+      write_value(os, header);
+      os.seekp(offset + header._bytes);
+      return (bool)os;
+    }
+
+    /// @return record bytes, 0 upon failure
+    u64 append_prim_record(std::ostream &os, u64 offset, u64 key, const ZsPrimitive &prim,
+                           const std::vector<u64> &children) {
+      os.seekp(offset);
+      write_value(os, JournalRecordHeader{});
+      write_value(os, (u64)children.size());
+      for (auto ch : children) write_value(os, ch);
+      write_padding(os, (u64)os.tellp());
+      if (!write_primitive_cache(prim, os, false, false, g_record_alignment)) return 0;
+      if (!finish_record(os, offset, record_Prim, key)) return 0;
+      return (u64)os.tellp() - offset;
+    }
+    template <typename Roots>
+    u64 append_roots_record(std::ostream &os, u64 offset, const Roots &roots) {
+      os.seekp(offset);
+      write_value(os, JournalRecordHeader{});
+      write_value(os, (u64)roots.size());
+      for (const auto &root : roots) {
+        write_value(os, root._key);
+        write_value(os, (u64)root._label.size());
+        os.write(root._label.data(), root._label.size());
+      }
+      if (!finish_record(os, offset, record_Roots, 0)) return 0;
+      return (u64)os.tellp() - offset;
+    }
+    u64 append_commit_record(std::ostream &os, u64 offset, u64 sequence) {
+      os.seekp(offset);
+      write_value(os, JournalRecordHeader{});
+      if (!finish_record(os, offset, record_Commit, sequence)) return 0;
+      return (u64)os.tellp() - offset;
+    }
+
+    bool copy_range(std::ifstream &is, std::ostream &os, u64 offset, u64 bytes,
+                    std::vector<char> &buffer) {
+      is.clear();
+      is.seekg(offset);
+      buffer.resize(g_copy_chunk);
+      while (bytes) {
+        const auto n = std::min<u64>(bytes, g_copy_chunk);
+        if (!is.read(buffer.data(), n)) return false;
+        os.write(buffer.data(), n);
+        bytes -= n;
+      }
+      return (bool)os;
+    }
+  }  // namespace
+
+  SceneJournal::~SceneJournal() { close(); }
+
+  void SceneJournal::close() {
+    /// @note the compaction task references this journal
+    {
+      std::unique_lock lk(_compactionMutex);
+      _compactionDone.wait(lk, [this]() { return !_compacting.load(); });
+    }
+    std::lock_guard lk(_mutex);
+    if (_os.is_open()) _os.close();
+    _fileName.clear();
+    _fileBytes = _liveBytes = 0;
+    _records.clear();
+    _keys.clear();
+    _roots.clear();
+    _rootsOffset = _rootsBytes = 0;
+    _dirtyPrims.clear();
+    _nextKey = 1;
+    _sequence = 0;
+    _stats = Stats{};
+  }
+
+  bool SceneJournal::open(std::string_view fileName, SceneContext &scene,
+                          std::vector<std::string> *restored) {
+    close();
+    std::lock_guard lk(_mutex);
+    const std::string fn{fileName};
+    std::error_code ec;
+    if (!fs::exists(fn, ec)) std::ofstream{fn, std::ios::out | std::ios::binary};
+    const auto fileSize = (size_t)fs::file_size(fn, ec);
+    if (ec) {
+      zs_print_err_py_cstr("unable to open the scene journal.");
+      return false;
+    }
+
+    /// @brief locate the end of the last complete batch
+    size_t committedEnd = 0;
+    if (fileSize) {
+      MappedFile file{fn};
+      if (!file.valid()) {
+        zs_print_err_py_cstr("unable to map the scene journal.");
+        return false;
+      }
+      size_t offset = 0;
+      for (; offset + sizeof(JournalRecordHeader) <= fileSize;) {
+        JournalRecordHeader header;
+        std::memcpy(&header, file.data() + offset, sizeof(header));
+        if (header._magic != g_journal_magic || header._version != g_journal_version
+            || header._checksum != header_checksum(header) || header._bytes == 0
+            || header._bytes % g_record_alignment || header._bytes > fileSize - offset)
+          break;
+        offset += header._bytes;
+        if (header._type == record_Commit) committedEnd = offset;
+      }
+      /// @note a first record torn before its header was finalized is all zeros, anything else
+      /// is not a journal and left untouched
+      if (offset == 0 && fileSize >= sizeof(JournalRecordHeader)) {
+        const JournalRecordHeader zeros{};
+        if (std::memcmp(file.data(), &zeros, sizeof(zeros)) != 0) {
+          zs_print_err_py_cstr("not a scene journal (or of an incompatible version).");
+          return false;
+        }
+      }
+    }
+    /// @note a torn batch is dropped before the journal is mapped for good
+    if (committedEnd != fileSize) {
+      fs::resize_file(fn, committedEnd, ec);
+      if (ec) {
+        zs_print_err_py_cstr("unable to truncate the torn tail of the scene journal.");
+        return false;
+      }
+    }
+
+    /// @brief replay committed batches, the latest record of each key wins
+    Shared<MappedFile> file;
+    if (committedEnd) {
+      file = std::make_shared<MappedFile>(fn);
+      if (!file->valid()) {
+        zs_print_err_py_cstr("unable to map the scene journal.");
+        return false;
+      }
+      struct Pending {
+        JournalRecordHeader _header;
+        u64 _offset;
+      };
+      std::vector<Pending> batch;
+      auto readU64 = [&](u64 &cur, u64 end, u64 &v) {
+        if (cur + sizeof(u64) > end) return false;
+        std::memcpy(&v, file->data() + cur, sizeof(u64));
+        cur += sizeof(u64);
+        return true;
+      };
+      for (size_t offset = 0; offset < committedEnd;) {
+        JournalRecordHeader header;
+        std::memcpy(&header, file->data() + offset, sizeof(header));
+        if (header._type != record_Commit) {
+          batch.push_back(Pending{header, offset});
+          offset += header._bytes;
+          continue;
+        }
+        for (const auto &[h, off] : batch) {
+          u64 cur = off + sizeof(JournalRecordHeader), end = off + h._bytes, n = 0;
+          if (!readU64(cur, end, n) || n > (end - cur) / sizeof(u64)) continue;
+          if (h._type == record_Prim) {
+            Record rec{off, h._bytes, 0, 0, std::vector<u64>(n)};
+            for (auto &ch : rec._children) readU64(cur, end, ch);
+            _records.insert_or_assign(h._key, zs::move(rec));
+            _nextKey = std::max(_nextKey, h._key + 1);
+          } else if (h._type == record_Roots) {
+            std::vector<RootEntry> roots(n);
+            bool ok = true;
+            for (auto &root : roots) {
+              u64 len = 0;
+              ok = ok && readU64(cur, end, root._key) && readU64(cur, end, len) && len <= end - cur;
+              if (!ok) break;
+              root._label.assign(reinterpret_cast<const char *>(file->data() + cur), len);
+              cur += len;
+            }
+            if (!ok) continue;
+            _roots = zs::move(roots);
+            _rootsOffset = off;
+            _rootsBytes = h._bytes;
+          }
+        }
+        batch.clear();
+        _sequence = header._key;
+        offset += header._bytes;
+      }
+    }
+
+    /// @brief rebuild the hierarchies reachable from the roots, the rest is garbage
+    std::unordered_set<u64> reachable;
+    auto build = [&](auto &&self, u64 key) -> Shared<ZsPrimitive> {
+      auto rec = _records.find(key);
+      if (!rec || !reachable.insert(key).second) return {};
+      const auto imageOffset = prim_image_offset(rec->_offset, rec->_children.size());
+      const auto recordEnd = rec->_offset + rec->_bytes;
+      if (imageOffset >= recordEnd) return {};
+      auto prim = read_primitive_cache(file, imageOffset, recordEnd - imageOffset);
+      if (!prim) return {};
+      /// @note [_records] is not inserted into meanwhile, [rec] stays valid
+      for (auto ch : rec->_children)
+        if (auto child = self(self, ch)) prim->appendChildPrimitve(zs::move(child));
+      rec->_revision = prim->keyframes().getRevision();
+      rec->_modifications = prim->details().getModificationCount();
+      rec->_prim = prim;
+      rec->_id = prim->id();
+      _keys.insert_or_assign(prim->id(), key);
+      _liveBytes += rec->_bytes;
+      return prim;
+    };
+    for (const auto &root : _roots) {
+      auto prim = build(build, root._key);
+      if (!prim) {
+        fmt::print("scene journal [{}]: prim [{}] could not be restored.\n", fn, root._label);
+        continue;
+      }
+      scene.registerPrimitive(root._label, prim);
+      if (restored) restored->push_back(root._label);
+    }
+    std::vector<u64> dropped;
+    _records.forEach([&](u64 key, const Record &) {
+      if (!reachable.count(key)) dropped.push_back(key);
+    });
+    for (auto key : dropped) _records.erase(key);
+    _liveBytes += _rootsBytes;
+
+    _os.open(fn, std::ios::in | std::ios::out | std::ios::binary);
+    if (!_os.is_open()) {
+      zs_print_err_py_cstr("unable to open the scene journal for writing.");
+      _records.clear();
+      _keys.clear();
+      _roots.clear();
+      return false;
+    }
+    _fileName = fn;
+    _fileBytes = committedEnd;
+    return true;
+  }
+
+  void SceneJournal::markDirty(const ZsPrimitive &prim) {
+    std::lock_guard lk(_mutex);
+    _dirtyPrims.insert(prim.id());
+  }
+
+  u64 SceneJournal::keyOf(const Shared<ZsPrimitive> &prim, bool &isNew) {
+    /// @note prim ids are recycled, the record must still refer to this very prim
+    if (auto key = _keys.find(prim->id()))
+      if (auto rec = _records.find(*key); rec && rec->_prim.lock() == prim) {
+        isNew = false;
+        return *key;
+      }
+    isNew = true;
+    const auto key = _nextKey++;
+    _keys.insert_or_assign(prim->id(), key);
+    return key;
+  }
+
+  bool SceneJournal::save(SceneContext &scene) {
+    bool shouldCompact = false;
+    const bool ret = saveImpl(scene, shouldCompact);
+    /// @note outside the lock, which the compaction task acquires
+    if (shouldCompact) compact();
+    return ret;
+  }
+
+  bool SceneJournal::saveImpl(SceneContext &scene, bool &shouldCompact) {
+    std::lock_guard lk(_mutex);
+    if (!valid()) return false;
+
+    /// @brief gather dirty prims, children first
+    struct Pending {
+      Shared<ZsPrimitive> _prim;
+      u64 _key;
+      std::vector<u64> _children;
+      u64 _offset{0}, _bytes{0};
+    };
+    std::vector<Pending> pending;
+    std::unordered_set<u64> reachable;
+    auto visit = [&](auto &&self, const Shared<ZsPrimitive> &prim) -> u64 {
+      bool isNew;
+      const auto key = keyOf(prim, isNew);
+      reachable.insert(key);
+      std::vector<u64> children;
+      children.reserve(prim->numChildren());
+      for (const auto &ch : prim->children()) children.push_back(self(self, ch));
+      const auto rec = isNew ? nullptr : _records.find(key);
+      if (!rec || _dirtyPrims.count(prim->id())
+          || rec->_revision != prim->keyframes().getRevision()
+          || rec->_modifications != prim->details().getModificationCount()
+          || rec->_children != children)
+        pending.push_back(Pending{prim, key, zs::move(children)});
+      return key;
+    };
+    std::vector<RootEntry> roots;
+    for (const auto &entry : scene)
+      if (auto prim = entry.prim.lock())
+        roots.push_back(RootEntry{entry.label, visit(visit, prim)});
+    const bool rootsDirty = roots != _roots;
+    std::vector<u64> dropped;
+    _records.forEach([&](u64 key, const Record &) {
+      if (!reachable.count(key)) dropped.push_back(key);
+    });
+    if (pending.empty() && !rootsDirty && dropped.empty()) {
+      _dirtyPrims.clear();
+      return true;
+    }
+
+    /// @brief append the batch, make it durable, then commit
+    u64 offset = _fileBytes, rootsOffset = 0, rootsBytes = 0;
+    bool ok = true;
+    for (auto &p : pending) {
+      p._offset = offset;
+      p._bytes = append_prim_record(_os, offset, p._key, *p._prim, p._children);
+      if (!(ok = p._bytes != 0)) break;
+      offset += p._bytes;
+    }
+    if (ok && rootsDirty) {
+      rootsOffset = offset;
+      rootsBytes = append_roots_record(_os, offset, roots);
+      ok = rootsBytes != 0;
+      offset += rootsBytes;
+    }
+    ok = ok && _os.flush() && ArchiveWriter::sync_file(_fileName);
+    if (ok) {
+      const auto commitBytes = append_commit_record(_os, offset, _sequence + 1);
+      ok = commitBytes != 0 && _os.flush() && ArchiveWriter::sync_file(_fileName);
+      offset += commitBytes;
+    }
+    if (!ok) {
+      /// @note the partial batch is uncommitted anyway, trimmed to keep the file tidy
+      _os.clear();
+      std::error_code ec;
+      fs::resize_file(_fileName, _fileBytes, ec);
+      zs_print_err_py_cstr("failed appending to the scene journal.");
+      return false;
+    }
+
+    /// @brief the batch is committed, update the index
+    for (auto &p : pending) {
+      if (auto old = _records.find(p._key)) _liveBytes -= old->_bytes;
+      _records.insert_or_assign(
+          p._key, Record{p._offset, p._bytes, p._prim->keyframes().getRevision(),
+                         p._prim->details().getModificationCount(), zs::move(p._children),
+                         p._prim, p._prim->id()});
+      _liveBytes += p._bytes;
+    }
+    if (rootsDirty) {
+      _liveBytes -= _rootsBytes;
+      _roots = zs::move(roots);
+      _rootsOffset = rootsOffset;
+      _rootsBytes = rootsBytes;
+      _liveBytes += rootsBytes;
+    }
+    for (auto key : dropped) {
+      auto rec = _records.find(key);
+      _liveBytes -= rec->_bytes;
+      if (auto k = _keys.find(rec->_id); k && *k == key) _keys.erase(rec->_id);
+      _records.erase(key);
+    }
+    _fileBytes = offset;
+    _sequence++;
+    _dirtyPrims.clear();
+    _stats._numSaves++;
+    _stats._numRecords += pending.size() + rootsDirty;
+
+    const auto garbage = _fileBytes - _liveBytes;
+    shouldCompact
+        = garbage > _minCompactionBytes && (f64)garbage > _garbageRatio * (f64)_fileBytes;
+    return true;
+  }
+
+  void SceneJournal::compact() {
+    if (_compacting.exchange(true)) return;
+    ZS_BACKGROUND_SCHEDULER().enqueue([this]() {
+      compactImpl();
+      std::lock_guard lk(_compactionMutex);
+      _compacting.store(false);
+      _compactionDone.notify_all();
+    });
+    ZS_BACKGROUND_SCHEDULER().tick();
+  }
+
+  void SceneJournal::compactImpl() {
+    /// @brief snapshot the live records, which are immutable from then on
+    struct Live {
+      u64 _offset, _bytes;
+    };
+    std::vector<Live> live;
+    std::string fileName;
+    u64 snapshotEnd, sequence;
+    {
+      std::lock_guard lk(_mutex);
+      if (!valid()) return;
+      fileName = _fileName;
+      snapshotEnd = _fileBytes;
+      sequence = _sequence;
+      live.reserve(_records.size() + 1);
+      _records.forEach(
+          [&](u64, const Record &rec) { live.push_back(Live{rec._offset, rec._bytes}); });
+      if (_rootsBytes) live.push_back(Live{_rootsOffset, _rootsBytes});
+    }
+    std::sort(live.begin(), live.end(),
+              [](const Live &a, const Live &b) { return a._offset < b._offset; });
+
+    /// @brief copy them into a fresh journal, committed as a single batch, without blocking saves
+    const auto tmp = fileName + ".compact.tmp";
+    std::ifstream is(fileName, std::ios::in | std::ios::binary);
+    std::ofstream os(tmp, std::ios::out | std::ios::binary | std::ios::trunc);
+    std::unordered_map<u64, u64> moved;
+    std::vector<char> buffer;
+    u64 pos = 0;
+    bool ok = is.is_open() && os.is_open();
+    for (const auto &rec : live) {
+      if (!(ok = ok && copy_range(is, os, rec._offset, rec._bytes, buffer))) break;
+      moved.emplace(rec._offset, pos);
+      pos += rec._bytes;
+    }
+    if (ok) {
+      const auto commitBytes = append_commit_record(os, pos, sequence);
+      ok = commitBytes != 0;
+      pos += commitBytes;
+    }
+    auto abort = [&](const char *reason) {
+      os.close();
+      std::error_code ec;
+      fs::remove(tmp, ec);
+      fmt::print("scene journal [{}]: compaction aborted, {}.\n", fileName, reason);
+    };
+    if (!ok) {
+      abort("copying live records failed");
+      return;
+    }
+
+    /// @brief carry over the batches saved meanwhile, then swap the files
+    std::lock_guard lk(_mutex);
+    if (_fileName != fileName) {
+      abort("the journal was closed");
+      return;
+    }
+    const u64 tailBytes = _fileBytes - snapshotEnd;
+    if (!copy_range(is, os, snapshotEnd, tailBytes, buffer) || !os.flush()) {
+      abort("copying recent batches failed");
+      return;
+    }
+    os.close();
+    is.close();
+    if (!ArchiveWriter::sync_file(tmp)) {
+      abort("syncing the compacted journal failed");
+      return;
+    }
+    _os.close();
+    std::error_code ec;
+    fs::rename(tmp, fileName, ec);
+    if (ec) {
+      /// @note e.g. the journal is still mapped by restored prims on windows
+      _os.open(fileName, std::ios::in | std::ios::out | std::ios::binary);
+      abort("the journal could not be replaced");
+      return;
+    }
+    ArchiveWriter::sync_parent_directory(fileName);
+    _os.open(fileName, std::ios::in | std::ios::out | std::ios::binary);
+
+    /// @note the tail keeps its relative alignment since [pos] is aligned
+    auto relocate = [&](u64 offset) {
+      return offset >= snapshotEnd ? pos + (offset - snapshotEnd) : moved.at(offset);
+    };
+    std::vector<u64> keys;
+    keys.reserve(_records.size());
+    _records.forEach([&](u64 key, const Record &) { keys.push_back(key); });
+    for (auto key : keys) {
+      auto rec = _records.find(key);
+      rec->_offset = relocate(rec->_offset);
+    }
+    if (_rootsBytes) _rootsOffset = relocate(_rootsOffset);
+    _fileBytes = pos + tailBytes;
+    _stats._numCompactions++;
+  }
+
+  SceneJournal::Stats SceneJournal::getStats() const {
+    std::lock_guard lk(_mutex);
+    auto ret = _stats;
+    ret._fileBytes = _fileBytes;
+    ret._liveBytes = _liveBytes;
+    return ret;
+  }
+
+}  // namespace zs
@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../WorldExport.hpp"
+#include "Primitive.hpp"
+#include "world/core/HashIndex.hpp"
+
+namespace zs {
+
+  struct SceneContext;
+
+  /**
+  @brief  Append-only store of the prims of a scene context, saved incrementally
+  @note   a save appends one record per dirty prim (the prim alone as a primitive cache image,
+          plus the journal keys of its children), a roots record if the top-level prims changed,
+          then a commit record; an index maps every prim to its latest record, thus saving costs
+          O(changes) rather than O(scene)
+  @note   records are made durable before their commit record is written, upon opening anything
+          after the last valid commit (a batch torn by a crash) is truncated, the journal always
+          reflects the last completed save
+  @note   superseded or unreachable records are garbage, once they exceed the threshold the live
+          records are copied into a fresh journal on ZS_BACKGROUND_SCHEDULER(), which is then
+          renamed over the current one; saves proceed meanwhile and are carried over
+  @note   prims are dirty if marked so, newly seen, their keyframe revision or modification
+          count (see PrimitiveDetail::getModificationCount) changed or their children changed,
+          thus any edit raising a dirty flag or setting a transform is picked up
+  @note   usd bindings and packed prims are not persisted (see save_primitive_cache)
+   */
+  struct ZS_WORLD_EXPORT SceneJournal {
+    static constexpr f64 s_default_garbage_ratio = 0.5;
+    static constexpr size_t s_default_min_compaction_bytes = (size_t)64 << 20;  // 64 MiB
+
+    struct Stats {
+      u64 _numSaves{0}, _numRecords{0}, _numCompactions{0};
+      size_t _fileBytes{0}, _liveBytes{0};
+      size_t garbageBytes() const noexcept { return _fileBytes - _liveBytes; }
+    };
+
+    SceneJournal() = default;
+    ~SceneJournal();
+    SceneJournal(const SceneJournal &) = delete;
+    SceneJournal &operator=(const SceneJournal &) = delete;
+
+    /// @brief open (or create) the journal at [fileName] and register the prims stored therein
+    /// into [scene], their labels are appended to [restored] if provided
+    bool open(std::string_view fileName, SceneContext &scene,
+              std::vector<std::string> *restored = nullptr);
+    /// @brief wait for any compaction in flight, then release the file
+    void close();
+    bool valid() const noexcept { return !_fileName.empty(); }
+    std::string_view fileName() const noexcept { return _fileName; }
+
+    void markDirty(const ZsPrimitive &prim);
+    /// @brief append the changes of [scene] since the last save
+    bool save(SceneContext &scene);
+
+    /// @brief compaction starts once garbage exceeds both [ratio] of the file and [minBytes]
+    void setCompactionThreshold(f64 ratio, size_t minBytes) noexcept {
+      _garbageRatio = ratio;
+      _minCompactionBytes = minBytes;
+    }
+    /// @brief rewrite the journal with live records only, in the background
+    void compact();
+    bool isCompacting() const noexcept { return _compacting.load(); }
+
+    Stats getStats() const;
+
+  protected:
+    struct Record {
+      u64 _offset{0}, _bytes{0};
+      u64 _revision{0}, _modifications{0};
+      std::vector<u64> _children{};
+      Weak<ZsPrimitive> _prim{};
+      PrimIndex _id{};
+    };
+    struct RootEntry {
+      std::string _label;
+      u64 _key;
+      bool operator==(const RootEntry &o) const noexcept {
+        return _key == o._key && _label == o._label;
+      }
+    };
+
+    u64 keyOf(const Shared<ZsPrimitive> &prim, bool &isNew);
+    bool saveImpl(SceneContext &scene, bool &shouldCompact);
+    void compactImpl();
+
+    mutable Mutex _mutex;  // guards everything below but the compaction flag
+    std::string _fileName{};
+    std::fstream _os;
+    size_t _fileBytes{0}, _liveBytes{0};
+
+    HashIndex<u64, Record> _records;  // journal key -> latest record
+    HashIndex<PrimIndex, u64> _keys;   // prim id -> journal key
+    std::vector<RootEntry> _roots;
+    u64 _rootsOffset{0}, _rootsBytes{0};
+    std::set<PrimIndex> _dirtyPrims;
+    u64 _nextKey{1};
+    u64 _sequence{0};
+
+    f64 _garbageRatio{s_default_garbage_ratio};
+    size_t _minCompactionBytes{s_default_min_compaction_bytes};
+    Mutex _compactionMutex;  // guards the clearing of [_compacting]
+    std::condition_variable_any _compactionDone;
+    std::atomic<bool> _compacting{false};
+    Stats _stats;
+  };
+
+}  // namespace zs
@@ -0,0 +1,93 @@
+#include "SceneTransformCache.hpp"
+
+#include <cmath>
+
+#if ZS_ENABLE_OPENMP
+#  include "zensim/omp/execution/ExecutionPolicy.hpp"
+#else
+#  include "zensim/execution/ExecutionPolicy.hpp"
+#endif
+
+namespace zs {
+
+  void SceneTransformCache::build(const std::vector<ZsPrimitive *> &roots) {
+    /// @note read first, so that children appended meanwhile outdate this layout
+    _hierarchyEpoch = PrimitiveDetail::hierarchy_epoch();
+    _prims.clear();
+    _parents.clear();
+    _levelOffsets.clear();
+    _indices.clear();
+
+    for (auto root : roots)
+      if (root) {
+        _prims.push_back(root);
+        _parents.push_back(-1);
+      }
+    _levelOffsets.push_back(0);
+    size_t levelBegin = 0, levelEnd = _prims.size();
+    while (levelBegin != levelEnd) {
+      _levelOffsets.push_back(levelEnd);
+      for (auto i = levelBegin; i != levelEnd; ++i)
+        for (const auto &ch : _prims[i]->children()) {
+          _prims.push_back(ch.get());
+          _parents.push_back((int)i);
+        }
+      levelBegin = levelEnd;
+      levelEnd = _prims.size();
+    }
+
+    const auto n = _prims.size();
+    _indices.reserve(n);
+    for (size_t i = 0; i != n; ++i) _indices[_prims[i]] = (int)i;
+    _worldTransforms.assign(n, glm::mat4(1.f));
+    /// @note everything is resolved in the first update
+    _dirty.assign(n, 1);
+    _deferred.assign(n, 0);
+    _modifications.assign(n, 0);
+    _editEpoch = PrimitiveDetail::edit_epoch();
+    _tc = g_default_timecode();
+    _valid = true;
+  }
+
+  size_t SceneTransformCache::update(TimeCode tc) {
+#if ZS_ENABLE_OPENMP
+    auto pol = omp_exec();
+#else
+    auto pol = seq_exec();
+#endif
+    const bool tcChanged = !(tc == _tc || (std::isnan(tc) && std::isnan(_tc)));
+    /// @note prims edited since (e.g. transforms set) are spotted by their modification counts,
+    /// only looked at if any prim was edited at all
+    const auto editEpoch = PrimitiveDetail::edit_epoch();
+    const bool edited = editEpoch != _editEpoch;
+    std::atomic<size_t> numUpdated{0};
+    for (size_t l = 0; l + 1 < _levelOffsets.size(); ++l) {
+      const auto st = _levelOffsets[l], ed = _levelOffsets[l + 1];
+      pol(range(ed - st), [&, st, tcChanged](size_t k) {
+        const auto i = st + k;
+        auto prim = _prims[i];
+        auto &details = prim->details();
+        const auto parent = _parents[i];
+        bool dirty = _dirty[i] || (parent != -1 && _dirty[parent]);
+        if (tcChanged && details.transformRequireUpdate(tc)) dirty = true;
+        if (edited && details.getModificationCount() != _modifications[i]) dirty = true;
+        if (!dirty) return;
+        _modifications[i] = details.getModificationCount();
+        /// @note getTransform() refreshes the local transform only when it varies
+        const auto local = details.getTransform(tc);
+        _worldTransforms[i] = parent != -1 ? _worldTransforms[parent] * local : local;
+        _deferred[i] = !prim->updateTransform(tc, _worldTransforms[i]);
+        _dirty[i] = 1;
+        numUpdated.fetch_add(1);
+      });
+    }
+    /// @note flags are kept during the sweep so that children observe their parents'
+    /// @note busy prims are revisited in the next update
+    _dirty.swap(_deferred);
+    std::fill(_deferred.begin(), _deferred.end(), (u8)0);
+    _tc = tc;
+    _editEpoch = editEpoch;
+    return numUpdated.load();
+  }
+
+}  // namespace zs
@@ -0,0 +1,64 @@
+#pragma once
+#include <cmath>
+#include <unordered_map>
+
+#include "../WorldExport.hpp"
+#include "Primitive.hpp"
+
+namespace zs {
+
+  /// @brief world transforms of a prim hierarchy flattened in breadth-first order
+  /// @note parents always precede their children, thus levels are resolved one after another
+  /// with the nodes of a level updated in parallel
+  struct ZS_WORLD_EXPORT SceneTransformCache {
+    /// @brief lay out the hierarchies under [roots]
+    void build(const std::vector<ZsPrimitive *> &roots);
+    /// @brief the layout no longer matches the hierarchy (e.g. prims added or removed)
+    void invalidate() noexcept { _valid = false; }
+    /// @note children appended or removed anywhere since the build outdate the layout as well,
+    /// see PrimitiveDetail::hierarchy_epoch
+    bool isValid() const noexcept {
+      return _valid && _hierarchyEpoch == PrimitiveDetail::hierarchy_epoch();
+    }
+
+    /// @brief flag [prim] (and thus its descendants) for recomputation in the next update
+    void markDirty(const ZsPrimitive *prim) noexcept {
+      if (auto id = indexOf(prim); id != -1) _dirty[id] = 1;
+    }
+    /// @brief resolve world transforms at [tc]
+    /// @note local transforms are refetched only where they vary or were edited since (e.g.
+    /// setTransform, see PrimitiveDetail::getModificationCount), dirtiness then propagates
+    /// down to descendants; visual transforms of the affected prims are updated as well
+    /// @return number of prims recomputed
+    size_t update(TimeCode tc);
+
+    /// @brief O(1) lookup of the world transform resolved by the last update
+    /// @note prims not laid out (yet) are resolved through their parents instead
+    glm::mat4 worldTransform(const ZsPrimitive *prim) const noexcept {
+      if (auto id = indexOf(prim); id != -1) return _worldTransforms[id];
+      if (!prim) return glm::mat4(1.f);
+      return std::isnan(_tc) ? prim->worldTransform() : prim->worldTransform(_tc);
+    }
+    int indexOf(const ZsPrimitive *prim) const noexcept {
+      if (auto it = _indices.find(prim); it != _indices.end()) return (*it).second;
+      return -1;
+    }
+
+    size_t size() const noexcept { return _prims.size(); }
+    size_t numLevels() const noexcept { return _levelOffsets.size() ? _levelOffsets.size() - 1 : 0; }
+    TimeCode getTimeCode() const noexcept { return _tc; }
+
+  protected:
+    std::vector<ZsPrimitive *> _prims;  // breadth-first
+    std::vector<int> _parents;          // -1 for roots
+    std::vector<size_t> _levelOffsets;  // numLevels + 1 entries
+    std::vector<glm::mat4> _worldTransforms;
+    std::vector<u8> _dirty, _deferred;
+    std::vector<u64> _modifications;  // as of the last recomputation
+    std::unordered_map<const ZsPrimitive *, int> _indices;
+    TimeCode _tc{g_default_timecode()};
+    u64 _editEpoch{0}, _hierarchyEpoch{0};
+    bool _valid{false};
+  };
+
+}  // namespace zs
@@ -0,0 +1,221 @@
+#include "TimelinePrefetcher.hpp"
+
+#include <cmath>
+
+#include "GeometryCache.hpp"
+#include "world/system/ZsExecSystem.hpp"
+
+namespace zs {
+
+  TimelinePrefetcher::~TimelinePrefetcher() {
+    /// @note in-flight tasks still reference this prefetcher
+    drain();
+  }
+
+  int TimelinePrefetcher::numLookaheadFrames() const noexcept {
+    if (_lookaheadMs > 0. && _stepMs > 0.)
+      return std::max((int)std::ceil(_lookaheadMs / _stepMs), 1);
+    return _lookaheadFrames;
+  }
+  TimelinePrefetcher::FrameIndex TimelinePrefetcher::frameIndex(TimeCode tc) const noexcept {
+    return (FrameIndex)std::llround(tc / _grid);
+  }
+  bool TimelinePrefetcher::matchesFrame(const Frame &frame, TimeCode tc) const noexcept {
+    /// @note sub-frame playback lands on timecodes off the grid, which are told apart here
+    return std::abs(frame._tc - tc) <= std::abs(_grid) * 1e-3;
+  }
+
+  void TimelinePrefetcher::advance(TimeCode tc, const Timeline &timeline,
+                                   const std::vector<ZsPrimitive *> &candidates) {
+    if (!_enabled || std::isnan(tc)) return;
+
+    auto now = std::chrono::steady_clock::now();
+    TimeCode frameStride = 1;
+    if (auto fps = timeline.getFps(), tcps = timeline.getTcps();
+        !std::isnan(fps) && !std::isnan(tcps) && fps > 0)
+      frameStride = tcps / fps;
+    if (std::isnan(_stride)) _stride = frameStride;
+    /// @note frames cached so far are keyed on the previous grid
+    if (_grid != frameStride) {
+      if (!std::isnan(_grid)) discard();
+      _grid = frameStride;
+    }
+
+    /// @brief playback direction, rate and seek detection
+    if (!std::isnan(_lastTimeCode)) {
+      auto delta = tc - _lastTimeCode;
+      auto eps = std::abs(_stride) * 1e-3;
+      if (std::abs(delta) <= eps) {
+        ;  // paused, nothing new to predict
+      } else if (delta * _stride > 0 && std::abs(delta) <= 2 * std::abs(_stride) + eps) {
+        // continuous playback, possibly at a different rate
+        auto ms = std::chrono::duration<double, std::milli>(now - _lastAdvance).count();
+        _stepMs = _stepMs > 0. ? _stepMs * 0.75 + ms * 0.25 : ms;
+        _stride = delta;
+      } else if (delta * _stride < 0 && std::abs(delta) <= 2 * std::abs(_stride) + eps) {
+        // direction reversed, in-flight tasks ahead of the old direction are stale
+        _epoch.fetch_add(1);
+        _stride = delta;
+      } else {
+        // seek
+        discard();
+        _stepMs = 0.;
+      }
+    }
+    _lastTimeCode = tc;
+    _lastAdvance = now;
+
+    /// @brief release frames no longer reachable, then schedule the upcoming ones
+    evict();
+    const int numFrames = numLookaheadFrames();
+    for (auto prim : candidates) {
+      if (!prim || !prim->details().isMeshTimeVarying()) continue;
+      /// @note keyframe sequences are lazily sorted, do it here before worker threads read them
+      prim->keyframes().updateSequences();
+      for (int i = 1; i <= numFrames; ++i) schedule(prim, tc + _stride * i);
+    }
+    ZS_BACKGROUND_SCHEDULER().tick();
+  }
+
+  void TimelinePrefetcher::schedule(ZsPrimitive *prim, TimeCode tc) {
+    const auto index = frameIndex(tc);
+    FrameKey key{prim, index};
+    {
+      std::lock_guard lk(_mutex);
+      if (auto it = _frames.find(index); it != _frames.end() && (*it).second._meshes.count(prim))
+        return;
+      /// @note prims being converted (or edited) elsewhere are left alone
+      auto hold = _holds.find(prim);
+      if (hold == _holds.end() && !prim->isStatusIdle()) return;
+      if (!_pending.insert(key).second) return;
+      if (hold == _holds.end()) {
+        prim->markStatusProcessing();
+        _holds.emplace(prim, 1);
+      } else
+        (*hold).second++;
+      _stats._issued++;
+      _numInflight++;
+    }
+    auto epoch = _epoch.load();
+    /// @note prims are owned by the scene, which outlives in-flight tasks (see the destructor)
+    ZS_BACKGROUND_SCHEDULER().enqueue([this, prim, tc, index, epoch, key,
+                                       cache = _geometryCache]() {
+      Shared<ZsMeshBundle> meshes;
+      if (epoch == _epoch.load()) {
+        try {
+          meshes = std::make_shared<ZsMeshBundle>();
+          /// @note baked frames only cost one chunk read
+          if (!cache || !cache->read(*prim, tc, *meshes)) {
+            meshes->_geometry = UniquePtr<PrimitiveStorage>(new PrimitiveStorage());
+            evaluate_primitive_to_zsmesh(*prim, tc, *meshes->_geometry, &meshes->_triMesh,
+                                         &meshes->_lineMesh, &meshes->_pointMesh);
+          }
+        } catch (const std::exception &e) {
+          fmt::print("prefetching prim [{}] at tc {} failed. [{}]\n", prim->label(), tc, e.what());
+          meshes.reset();
+        }
+      }
+      {
+        std::lock_guard lk(_mutex);
+        _pending.erase(key);
+        auto &frame = _frames[index];
+        if (frame._meshes.empty()) frame._tc = tc;
+        if (meshes && epoch == _epoch.load() && matchesFrame(frame, tc)) {
+          auto bytes = meshes->bytes();
+          frame._meshes[prim] = zs::move(meshes);
+          frame._bytes += bytes;
+          _stats._cachedBytes += bytes;
+          _stats._completed++;
+        } else {
+          if (frame._meshes.empty()) _frames.erase(index);
+          _stats._discarded++;
+        }
+        if (auto hold = _holds.find(prim); --(*hold).second == 0) {
+          _holds.erase(hold);
+          prim->markStatusIdle();
+        }
+        if (--_numInflight == 0) _drained.notify_all();
+      }
+    });
+  }
+
+  Shared<ZsMeshBundle> TimelinePrefetcher::take(const ZsPrimitive &prim, TimeCode tc) {
+    if (!_enabled || std::isnan(tc) || !prim.details().isMeshTimeVarying()) return {};
+    std::lock_guard lk(_mutex);
+    Shared<ZsMeshBundle> ret;
+    if (std::isnan(_grid)) {
+      _stats._misses++;
+      return ret;
+    }
+    auto it = _frames.find(frameIndex(tc));
+    if (it != _frames.end() && matchesFrame((*it).second, tc)) {
+      auto &frame = (*it).second;
+      if (auto mit = frame._meshes.find(&prim); mit != frame._meshes.end()) {
+        auto bytes = (*mit).second->bytes();
+        ret = zs::move((*mit).second);
+        frame._meshes.erase(mit);
+        frame._bytes -= bytes;
+        _stats._cachedBytes -= bytes;
+        if (frame._meshes.empty()) _frames.erase(it);
+      }
+    }
+    if (ret)
+      _stats._hits++;
+    else
+      _stats._misses++;
+    return ret;
+  }
+
+  void TimelinePrefetcher::evict() {
+    std::lock_guard lk(_mutex);
+    if (_frames.empty()) return;
+    const auto tc = _lastTimeCode;
+    const int numFrames = numLookaheadFrames();
+    auto release = [this](std::map<FrameIndex, Frame>::iterator it) {
+      _stats._cachedBytes -= (*it).second._bytes;
+      _stats._evicted += (*it).second._meshes.size();
+      return _frames.erase(it);
+    };
+    /// @note frames already passed or beyond the lookahead window are of no use
+    /// @note the frame at the playhead is kept for the upcoming take()
+    for (auto it = _frames.begin(); it != _frames.end();) {
+      auto steps = ((*it).second._tc - tc) / _stride;
+      if (steps < -0.5 || steps > numFrames + 0.5)
+        it = release(it);
+      else
+        ++it;
+    }
+    /// @note then the farthest frames go first once over capacity
+    while (_stats._cachedBytes > _capacity && !_frames.empty()) {
+      if (_stride > 0)
+        release(std::prev(_frames.end()));
+      else
+        release(_frames.begin());
+    }
+  }
+
+  void TimelinePrefetcher::drain() {
+    discard();
+    std::unique_lock lk(_mutex);
+    _drained.wait(lk, [this]() { return _numInflight == 0; });
+  }
+  void TimelinePrefetcher::discard() {
+    _epoch.fetch_add(1);
+    std::lock_guard lk(_mutex);
+    for (auto &[_, frame] : _frames) _stats._evicted += frame._meshes.size();
+    _frames.clear();
+    _stats._cachedBytes = 0;
+  }
+
+  TimelinePrefetcher::Stats TimelinePrefetcher::getStats() const {
+    std::lock_guard lk(_mutex);
+    return _stats;
+  }
+  void TimelinePrefetcher::resetStats() {
+    std::lock_guard lk(_mutex);
+    auto cachedBytes = _stats._cachedBytes;
+    _stats = Stats{};
+    _stats._cachedBytes = cachedBytes;
+  }
+
+}  // namespace zs
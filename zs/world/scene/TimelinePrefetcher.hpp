@@ -0,0 +1,121 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+#include "../WorldExport.hpp"
+#include "Primitive.hpp"
+#include "Timeline.hpp"
+
+namespace zs {
+
+  struct GeometryCache;
+
+  /// @brief speculatively evaluates upcoming frames of time-varying prims during playback
+  /// @note conversions run on ZS_BACKGROUND_SCHEDULER() into fresh scratch storages, the results
+  /// are kept in a bounded cache keyed by frame index on the timeline grid, and taken by the
+  /// conversion of a prim once its frame is requested (see ZsMeshProvider)
+  /// @note a prim is held busy (see ZsPrimitive::markStatusProcessing) while any of its frames is
+  /// being evaluated, so that it is neither converted nor edited concurrently
+  /// @note all member functions but take() are expected to be called from the main (event) thread
+  struct ZS_WORLD_EXPORT TimelinePrefetcher {
+    static constexpr size_t s_default_capacity = (size_t)1 << 30;  // 1 GiB
+    static constexpr int s_default_lookahead_frames = 4;
+
+    struct Stats {
+      u64 _hits{0}, _misses{0};
+      u64 _issued{0}, _completed{0}, _discarded{0}, _evicted{0};
+      size_t _cachedBytes{0};
+      double hitRate() const noexcept {
+        return _hits + _misses ? (double)_hits / (double)(_hits + _misses) : 0.;
+      }
+    };
+
+    TimelinePrefetcher() = default;
+    ~TimelinePrefetcher();
+    TimelinePrefetcher(const TimelinePrefetcher &) = delete;
+    TimelinePrefetcher &operator=(const TimelinePrefetcher &) = delete;
+
+    void enable(bool enabled) {
+      if (!enabled) discard();
+      _enabled = enabled;
+    }
+    bool isEnabled() const noexcept { return _enabled; }
+
+    /// @brief lookahead measured in frames
+    void setLookaheadFrames(int numFrames) noexcept {
+      _lookaheadFrames = numFrames;
+      _lookaheadMs = 0.;
+    }
+    /// @brief lookahead measured in wall-clock time, converted with the observed playback rate
+    void setLookaheadDuration(double ms) noexcept { _lookaheadMs = ms; }
+    void setCapacity(size_t bytes) noexcept { _capacity = bytes; }
+    /// @brief frames baked in [cache] are read from it rather than evaluated
+    /// @note expected to be set while no task is in flight (see drain)
+    void setGeometryCache(Shared<const GeometryCache> cache) noexcept {
+      _geometryCache = zs::move(cache);
+    }
+    size_t getCapacity() const noexcept { return _capacity; }
+
+    /// @brief playhead moved to [tc]
+    /// @note detects direction/rate changes and seeks, then schedules upcoming frames of the
+    /// time-varying ones among [candidates] (e.g. visible prims)
+    void advance(TimeCode tc, const Timeline &timeline,
+                 const std::vector<ZsPrimitive *> &candidates);
+    /// @brief hand over the cached result of [prim] at [tc], nullptr if not ready
+    /// @note each time-varying prim counts as a hit if its frame is ready, otherwise a miss
+    /// @note thread-safe
+    Shared<ZsMeshBundle> take(const ZsPrimitive &prim, TimeCode tc);
+
+    /// @brief drop all cached frames and invalidate in-flight tasks
+    void discard();
+    /// @brief discard, then block until in-flight tasks no longer reference any prim
+    void drain();
+
+    Stats getStats() const;
+    void resetStats();
+
+  protected:
+    /// @note timecodes are snapped to the timeline grid, thus looked up regardless of rounding
+    using FrameIndex = i64;
+    using FrameKey = std::pair<const ZsPrimitive *, FrameIndex>;
+    struct Frame {
+      std::unordered_map<const ZsPrimitive *, Shared<ZsMeshBundle>> _meshes;
+      size_t _bytes{0};
+      TimeCode _tc{g_default_timecode()};  // evaluated timecode
+    };
+
+    int numLookaheadFrames() const noexcept;
+    FrameIndex frameIndex(TimeCode tc) const noexcept;
+    bool matchesFrame(const Frame &frame, TimeCode tc) const noexcept;
+    void schedule(ZsPrimitive *prim, TimeCode tc);
+    void evict();
+
+    /// @note guards [_frames], [_pending], [_holds], [_stats] and [_numInflight]
+    mutable Mutex _mutex;
+    std::map<FrameIndex, Frame> _frames;
+    std::set<FrameKey> _pending;
+    std::unordered_map<ZsPrimitive *, u32> _holds;  // number of in-flight tasks per busy prim
+    Stats _stats;
+    u32 _numInflight{0};
+    std::condition_variable_any _drained;  // signalled once [_numInflight] drops to 0
+
+    std::atomic<u64> _epoch{0};  // bumped upon seeks, stale tasks are dropped
+
+    /// playback estimation
+    TimeCode _lastTimeCode{g_default_timecode()};
+    TimeCode _stride{g_default_timecode()};  // signed timecode delta per step
+    TimeCode _grid{g_default_timecode()};    // timecode delta per timeline frame
+    std::chrono::steady_clock::time_point _lastAdvance{};
+    double _stepMs{0.};  // smoothed wall-clock interval between steps
+
+    Shared<const GeometryCache> _geometryCache;
+    size_t _capacity{s_default_capacity};
+    int _lookaheadFrames{s_default_lookahead_frames};
+    double _lookaheadMs{0.};
+    std::atomic<bool> _enabled{false};
+  };
+
+}  // namespace zs
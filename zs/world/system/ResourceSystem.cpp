@@ -1,10 +1,16 @@
 #include "ResourceSystem.hpp"
 
+#include <chrono>
+#include <cstring>
 #include <filesystem>
+#include <optional>
 
 #include "world/World.hpp"
+#include "world/core/FileBackedResource.hpp"
 //
 #include "world/scene/PrimitiveConversion.hpp"
+#include "world/scene/PrimitiveInstancing.hpp"
+#include "world/scene/PrimitiveSerializer.hpp"
 //
 #include "zensim/vulkan/Vulkan.hpp"
 #include "zensim/zpc_tpls/fmt/format.h"
@@ -15,6 +21,82 @@
 
 namespace zs {
 
+  namespace {
+    /// @note bump whenever the output of the usd conversion (or the post-processing applied in
+    /// load_usd) changes, which retires every cached hierarchy
+    constexpr u32 g_usd_conversion_version = 1;
+    constexpr u32 g_texture_decoding_version = 1;
+    constexpr std::string_view g_asset_cache_subdir = "zs_world_assets";
+
+#if ZS_ENABLE_USD
+    /// @brief attrib keyframes created within the scope are placed upon [resource]
+    struct KeyframeMemoryScope {
+      explicit KeyframeMemoryScope(Shared<TrackedResource> resource)
+          : _previous{get_keyframe_memory()} {
+        set_keyframe_memory(zs::move(resource));
+      }
+      ~KeyframeMemoryScope() { set_keyframe_memory(zs::move(_previous)); }
+      Shared<TrackedResource> _previous;
+    };
+
+    /// @note skinning and blend shape bindings are not part of the primitive cache
+    bool primitive_cacheable(const ZsPrimitive &prim) {
+      if (prim.keyframes().hasSkelAnim()) return false;
+      for (const auto &ch : prim.children())
+        if (!primitive_cacheable(*ch)) return false;
+      return true;
+    }
+
+    /// @brief relink a cached hierarchy to the usd prims it was converted from
+    /// @note children were appended in the order of their usd counterparts, a mismatch means the
+    /// composed stage no longer corresponds to the cached conversion
+    bool relink_usd_prims(ZsPrimitive &prim, const ScenePrimConcept *usdPrim) {
+      if (!usdPrim || prim.path() != usdPrim->getPath()) return false;
+      size_t nChilds = 0;
+      usdPrim->getAllChilds(&nChilds, nullptr);
+      if (nChilds != prim.numChildren()) return false;
+      std::vector<ScenePrimHolder> childs(nChilds);
+      if (nChilds) usdPrim->getAllChilds(&nChilds, childs.data());
+      prim.details().setUsdPrim(usdPrim);
+      for (size_t i = 0; i != nChilds; ++i)
+        if (!relink_usd_prims(*prim.children()[i], childs[i].get())) return false;
+      return true;
+    }
+#endif
+
+    /// @brief rgba8 pixels of the image at [path], decoded once then served from the asset cache
+    /// @note cached entries hold the extent (two u32) followed by the pixels
+    const std::byte *decode_texture_rgba8(const std::string &path, int &w, int &h,
+                                          std::vector<std::byte> &storage) {
+      constexpr size_t headerBytes = sizeof(u32) * 2;
+      auto &cache = ResourceSystem::asset_cache();
+      const auto key = cache.valid() ? AssetCache::make_key(path, "tex", g_texture_decoding_version,
+                                                           "rgba8")
+                                     : std::string{};
+      if (cache.load(key, storage) && storage.size() >= headerBytes) {
+        u32 extent[2];
+        std::memcpy(extent, storage.data(), headerBytes);
+        if (storage.size() == headerBytes + (size_t)extent[0] * extent[1] * STBI_rgb_alpha) {
+          w = (int)extent[0];
+          h = (int)extent[1];
+          return storage.data() + headerBytes;
+        }
+      }
+
+      int nchns;
+      unsigned char *img = stbi_load(path.data(), &w, &h, &nchns, STBI_rgb_alpha);
+      if (!img) return nullptr;
+      const size_t numBytes = (size_t)w * h * STBI_rgb_alpha;
+      storage.resize(headerBytes + numBytes);
+      const u32 extent[2] = {(u32)w, (u32)h};
+      std::memcpy(storage.data(), extent, headerBytes);
+      std::memcpy(storage.data() + headerBytes, img, numBytes);
+      stbi_image_free(img);
+      if (!key.empty()) cache.store(key, storage.data(), storage.size());
+      return storage.data() + headerBytes;
+    }
+  }  // namespace
+
   const std::string ResourceSystem::_missingTextureRelPath
       = "/resource/textures/missing_texture.png";
 
@@ -22,10 +104,11 @@ namespace zs {
   ResourceSystem::ResourceSystem() {
     // e.g. "/tmp, C:/tmp"
     _rootCachePath = std::filesystem::temp_directory_path().string();
+    _assetCache.open((std::filesystem::path{_rootCachePath} / g_asset_cache_subdir).string());
 
     auto fn = zs::abs_exe_directory() + "/resource/scripts/" + g_textEditorFile;
     _scripts[g_textEditorLabel] = Archive{fn};
-    _scripts[g_textEditorLabel].loadFromFileAscii(fn);
+    _scripts[g_textEditorLabel].mapFromFileAscii(fn);
 
     _sceneContexts[g_defaultSceneLabel] = SceneContext();
 
@@ -59,6 +142,7 @@ namespace zs {
     // shaders
     instance()._shaders.clear();
     // scene contexts
+    instance()._sceneJournals.clear();  // waits for compactions in flight
     instance()._sceneContexts.clear();
     // scripts
     {
@@ -67,6 +151,7 @@ namespace zs {
         close_script(label);
       }
       instance()._scripts.clear();  // close script files
+      Archive::wait_for_pending_saves();
     }
     // usd
 #if ZS_ENABLE_USD
@@ -81,6 +166,30 @@ namespace zs {
   }
   void ResourceSystem::initialize() { (void)instance(); }
 
+  bool ResourceSystem::open_scene_journal(std::string_view sceneLabel, std::string_view fileName) {
+    auto scene = get_scene_context_ptr(sceneLabel);
+    if (!scene) return false;
+    const auto fn = fileName.empty()
+                        ? (std::filesystem::path{instance()._rootCachePath} / g_defaultSceneFile)
+                              .string()
+                        : std::string(fileName);
+    auto &journal = instance()._sceneJournals.try_emplace(std::string(sceneLabel)).first->second;
+    journal.close();
+    std::vector<std::string> restored;
+    if (!journal.open(fn, *scene, &restored)) {
+      instance()._sceneJournals.erase(instance()._sceneJournals.find(sceneLabel));
+      return false;
+    }
+    if (!restored.empty()) onSceneContextPrimitiveCreation().emit(restored);
+    return true;
+  }
+  bool ResourceSystem::save_scene(std::string_view sceneLabel) {
+    auto scene = get_scene_context_ptr(sceneLabel);
+    auto journal = get_scene_journal_ptr(sceneLabel);
+    if (!scene || !journal) return false;
+    return journal->save(*scene);
+  }
+
   std::string ResourceSystem::root_directory() { return abs_module_directory(); }
   std::string ResourceSystem::cache_directory() { return root_directory() + "/.cache"; }
 
@@ -136,8 +245,9 @@ namespace zs {
   ) {
     fmt::print("loading texture at {}\n", label.data());
 
-    int w = 0, h = 0, nchns;
-    unsigned char *img = stbi_load(label.data(), &w, &h, &nchns, STBI_rgb_alpha);
+    int w = 0, h = 0;
+    std::vector<std::byte> storage;
+    auto img = decode_texture_rgba8(label, w, h, storage);
     if (!img) {
       fmt::print("failed to load missing texture {}\n", label.data());
       return false;
@@ -160,8 +270,6 @@ namespace zs {
     writer.overwrite(set);
     texEntry.bindlessId = ctx.registerImage(tex);
 
-    stbi_image_free(img);
-
     onTexturesAdded().emit({label});
 
     return true;
@@ -247,7 +355,7 @@ namespace zs {
       fmt::print("script [{}] already exists! reloading!\n", filename);
     }
     Archive archive;
-    int ret = archive.loadFromFileAscii(filename) == 0;
+    int ret = archive.mapFromFileAscii(filename) == 0;
     inst._scripts[std::string(label)] = zs::move(archive);
     onScriptFilesOpened().emit({std::string(label)});
     return ret;
@@ -273,10 +381,52 @@ namespace zs {
       onUsdFilesOpened().emit({l});
       // register_widget(label, ui::build_usd_tree_node(scene->getRootPrim().get()));
 
+      const auto start = std::chrono::steady_clock::now();
+      /// @note keyframes are file-backed from the start, rather than relocated once in RAM
+      std::optional<KeyframeMemoryScope> keyframeMemory;
+      if (const auto &directory = instance()._keyframeSpillDirectory)
+        keyframeMemory.emplace(std::make_shared<FileBackedResource>(*directory));
       auto rt = scene->getPrim("/");
-      // Shared<ZsPrimitive> ret{build_primitive_from_usdprim(rt.get(), 0.)};
-      Shared<ZsPrimitive> ret{build_primitive_from_usdprim(rt.get())};
+      /// @note every layer the stage composes (sublayers, references, payloads) is hashed,
+      /// editing any of them yields another key
+      auto &cache = asset_cache();
+      auto layers = scene->getUsedLayerPaths();
+      if (layers.empty()) layers.emplace_back(filename);
+      const auto key = cache.valid()
+                           ? AssetCache::make_key(zs::move(layers), "usd",
+                                                  (g_usd_conversion_version << 16)
+                                                      | g_primitive_cache_version,
+                                                  "share_duplicate_meshes")
+                           : std::string{};
+      Shared<ZsPrimitive> ret;
+      if (cache.lookup(key)) {
+        ret = load_primitive_cache(cache.entryPath(key));
+        if (ret && !relink_usd_prims(*ret, rt.get())) ret.reset();
+        /// @note the cache keeps the keyframes shared, only the mesh sources are re-established
+        if (ret) link_mesh_sources(*ret);
+      }
+      const bool warm = ret != nullptr;
+      if (!warm) {
+        // ret = Shared<ZsPrimitive>{build_primitive_from_usdprim(rt.get(), 0.)};
+        ret = Shared<ZsPrimitive>{build_primitive_from_usdprim(rt.get())};
+        /// @note meshes duplicated (rather than instanced) in the asset share their geometry
+        if (auto stats = share_duplicate_meshes(*ret); stats._numShared)
+          fmt::print(
+              "[{}] {} of {} meshes share {} prototypes, {} keyframe bytes saved, {} draw the "
+              "meshes of their prototype.\n",
+              label, stats._numShared, stats._numCandidates, stats._numGroups, stats._bytesSaved,
+              stats._numMeshSources);
+        /// @note persisted along, warm loads then skip evaluating and triangulating these
+        stage_static_meshes(*ret);
+        if (!key.empty() && primitive_cacheable(*ret)
+            && save_primitive_cache(*ret, cache.entryPath(key)))
+          cache.commit(key);
+      }
       ret->label() = label;  // overwrite the "/" root label
+      fmt::print("[{}] primitives {} in {:.1f} ms.\n", label,
+                 warm ? "loaded from the asset cache" : "converted",
+                 std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                     .count());
       register_scene_primitive(g_defaultSceneLabel, label, ret);
       return scene;
     } else {
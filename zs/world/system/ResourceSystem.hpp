@@ -2,11 +2,13 @@
 
 #include <deque>
 #include <map>
+#include <optional>
 #include <set>
 #include <string_view>
 
 #include "world/WorldExport.hpp"
 #include "world/core/Archive.hpp"
+#include "world/core/AssetCache.hpp"
 #include "world/core/ConsoleHelper.hpp"
 //
 #include "world/core/Signal.hpp"
@@ -14,6 +16,7 @@
 #include "zensim/ui/Widget.hpp"
 //
 #include "world/scene/SceneContext.hpp"
+#include "world/scene/SceneJournal.hpp"
 //
 #include "zensim/ZpcImplPattern.hpp"
 #include "zensim/io/Filesystem.hpp"
@@ -125,6 +128,7 @@ namespace zs {
 
     // scene context
     std::map<std::string, SceneContext> _sceneContexts;
+    std::map<std::string, SceneJournal, std::less<>> _sceneJournals;  // scene label -> journal
     Signal<void(const std::vector<std::string> &)> _sceneContextPrimitiveChanged;
     Signal<void(const std::vector<std::string> &)> _sceneContextPrimitiveCreation;
     Signal<void(const std::vector<std::string> &)> _sceneContextPrimitiveRemoval;
@@ -149,6 +153,8 @@ namespace zs {
 
     /// cache
     std::string _rootCachePath;
+    AssetCache _assetCache;
+    std::optional<std::string> _keyframeSpillDirectory;  // see enable_keyframe_spilling
 
     /// status
     std::atomic<u32> _primInFlight{0};
@@ -157,6 +163,17 @@ namespace zs {
   public:
     /// cache
     std::string_view get_cache_path() noexcept { return instance()._rootCachePath; }
+    /// @brief derived assets (converted usd hierarchies, decoded textures) kept across launches
+    static AssetCache &asset_cache() noexcept { return instance()._assetCache; }
+    /// @brief let load_usd place the attrib keyframes of assets on a FileBackedResource spilling
+    /// into [directory] (FileBackedResource::default_directory() if empty), for scenes
+    /// exceeding RAM
+    static void enable_keyframe_spilling(bool enable, std::string_view directory = {}) {
+      if (enable)
+        instance()._keyframeSpillDirectory = std::string{directory};
+      else
+        instance()._keyframeSpillDirectory.reset();
+    }
 
     /// signals
     static auto &onTexturesChanged() { return instance()._textureModified; }
@@ -239,6 +256,20 @@ namespace zs {
       onSceneContextPrimitiveCreation().emit({std::string(primLabel)});
       return ret;
     }
+    /// @brief attach a journal to the scene [sceneLabel] and restore the prims it holds
+    /// @note [fileName] defaults to g_defaultSceneFile under the cache path
+    static ZS_WORLD_EXPORT bool open_scene_journal(std::string_view sceneLabel
+                                                   = g_defaultSceneLabel,
+                                                   std::string_view fileName = {});
+    /// @brief incrementally save the scene [sceneLabel] to its journal
+    /// @note prims edited since the last save are found by their modification count
+    static ZS_WORLD_EXPORT bool save_scene(std::string_view sceneLabel = g_defaultSceneLabel);
+    static SceneJournal *get_scene_journal_ptr(std::string_view sceneLabel = g_defaultSceneLabel) {
+      if (auto it = instance()._sceneJournals.find(sceneLabel);
+          it != instance()._sceneJournals.end())
+        return &(*it).second;
+      return nullptr;
+    }
 
     ///
     static ZS_WORLD_EXPORT ResourceSystem &instance();
@@ -28,6 +28,7 @@ namespace zs {
     _scheduler = UniquePtr<Scheduler>(new Scheduler(4));
     _eventLoop = UniquePtr<Scheduler>(new Scheduler(1));
     _dedicatedWorker = UniquePtr<Scheduler>(new Scheduler(1));
+    _backgroundWorker = UniquePtr<Scheduler>(new Scheduler(1));
   }
 
 }  // namespace zs
\ No newline at end of file
@@ -27,6 +27,7 @@ namespace zs {
     static Scheduler &ref_task_scheduler() { return *instance()._scheduler; }
     static Scheduler &ref_event_scheduler() { return *instance()._eventLoop; }
     static Scheduler &ref_dedicated_scheduler() { return *instance()._dedicatedWorker; }
+    static Scheduler &ref_background_scheduler() { return *instance()._backgroundWorker; }
 
     /// compute
     static auto schedule_as_task() { return ref_task_scheduler().schedule(); }
@@ -46,14 +47,21 @@ namespace zs {
     static void sync_process_dedicated() { ref_dedicated_scheduler().wait(); }
     static void issue_dedicated() { ref_dedicated_scheduler().start(); }
 
+    /// background worker
+    static auto schedule_as_background() { return ref_background_scheduler().schedule(); }
+    static void sync_process_background() { ref_background_scheduler().wait(); }
+    static void issue_background() { ref_background_scheduler().start(); }
+
     static void tick() {
       ref_task_scheduler().tick();
       ref_dedicated_scheduler().tick();
+      ref_background_scheduler().tick();
       ref_event_scheduler().tick();
     }
     /// @note tasks may only be rescheduled to events or itself
     /// @note dedicated may only be rescheduled to events or itself
     /// @note flush events in the end
+    /// @note speculative background work is not waited here
     static void flush() {
       sync_process_tasks();
       sync_process_dedicated();
@@ -70,6 +78,8 @@ namespace zs {
     UniquePtr<Scheduler> _eventLoop;        // waited at every event loop
     UniquePtr<Scheduler> _dedicatedWorker;  // for tasks where data is only accessible by at most
                                             // one thread simultaneously.
+    UniquePtr<Scheduler> _backgroundWorker;  // for speculative low-priority tasks (e.g. prefetch)
+                                             // that should not compete with the task workers
     // cppcoro::io_service _ioService;
     stop_source _ioStopSource;
   };
@@ -77,10 +87,12 @@ namespace zs {
 #define ZS_TASK_SCHEDULER() ::zs::ZsExecSystem::ref_task_scheduler()
 #define ZS_EVENT_SCHEDULER() ::zs::ZsExecSystem::ref_event_scheduler()
 #define ZS_DEDICATED_SCHEDULER() ::zs::ZsExecSystem::ref_dedicated_scheduler()
+#define ZS_BACKGROUND_SCHEDULER() ::zs::ZsExecSystem::ref_background_scheduler()
 
 #define ZS_FLUSH_TASK_SCHEDULER() zs::ZsExecSystem::sync_process_tasks()
 #define ZS_FLUSH_EVENT_SCHEDULER() zs::ZsExecSystem::sync_process_events()
 #define ZS_FLUSH_DEDICATED_SCHEDULER() zs::ZsExecSystem::sync_process_dedicated()
+#define ZS_FLUSH_BACKGROUND_SCHEDULER() zs::ZsExecSystem::sync_process_background()
 
   inline auto &zs_execution() { return ZsExecSystem::instance(); }
 
@@ -1,4 +1,5 @@
 #include <pxr/pxr.h>
+#include <pxr/usd/sdf/layer.h>
 #include <pxr/usd/usd/attribute.h>
 #include <pxr/usd/usd/prim.h>
 #include <pxr/usd/usd/primRange.h>
@@ -323,6 +324,21 @@ namespace zs {
   }
 
   std::any USDSceneDesc::getRawScene() const { return mRootStage; }
+
+  std::vector<std::string> USDSceneDesc::getUsedLayerPaths() const {
+    std::vector<std::string> ret;
+    if (!mRootStage.has_value()) {
+      return ret;
+    }
+
+    auto stage = std::any_cast<UsdStageRefPtr>(mRootStage);
+    for (const auto& layer : stage->GetUsedLayers()) {
+      /// @note anonymous (in-memory) layers have no file to hash
+      if (!layer || layer->IsAnonymous()) continue;
+      if (auto path = layer->GetRealPath(); !path.empty()) ret.push_back(path);
+    }
+    return ret;
+  }
 }  // namespace zs
 
 #undef GET_STAGE
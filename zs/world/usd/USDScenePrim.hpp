@@ -121,6 +121,7 @@ namespace zs {
 
     virtual void onRender() const override {}  // TODO
     virtual std::any getRawScene() const override;
+    virtual std::vector<std::string> getUsedLayerPaths() const override;
 
     // TODO: set/get custom data?
     unsigned long long getTransformCount() const;